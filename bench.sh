@@ -0,0 +1,8 @@
+
+mkdir -p ./bin/
+clang -ObjC -O2 -g ./src/bench.c \
+	-I ./src/ \
+	-o bin/bench \
+
+
+./bin/bench bin/bench_results.json
@@ -0,0 +1,689 @@
+
+#include "math/basic_math.h"
+#include "math/matrix.h"
+#include "math/quat.h"
+#include "math/conversions.h"
+#include "math/trs.h"
+#include "math/affine.h"
+#include "math/vec_wide.h"
+#include "basic_types.h"
+#include "stdio.h"
+#include "stdlib.h"
+#include "stretchy_buffer.h"
+#include "math/lcp.h"
+#include "math/jacobian.h"
+#include "memory/arena.h"
+#include "physics/broad_phase.h"
+#include "timer.h"
+
+/*
+	Micro-benchmarks for core math and container primitives.
+	Each benchmark function performs ops_per_sample operations per call. A sample is the wall time of one call.
+	After warmup_samples untimed calls, num_samples calls are timed and reduced to min / median / p99.
+	ns_per_op is median / ops_per_sample, which is the number to track between revisions.
+
+	Usage: bench [output_path]
+	Results are printed as a table and written as JSON to output_path (default: bin/bench_results.json)
+*/
+
+typedef void (*BenchFunction)(void* user_data);
+
+typedef struct BenchDesc
+{
+	const char* name;
+	BenchFunction function;
+	void* user_data;
+	i32 ops_per_sample;
+	i32 warmup_samples;
+	i32 num_samples;
+} BenchDesc;
+
+typedef struct BenchResult
+{
+	const char* name;
+	i32 ops_per_sample;
+	i32 num_samples;
+	double min_ns;
+	double median_ns;
+	double p99_ns;
+	double ns_per_op;
+} BenchResult;
+
+enum { BENCH_DEFAULT_WARMUP_SAMPLES = 16 };
+enum { BENCH_DEFAULT_NUM_SAMPLES = 201 };
+
+// Benchmarks write their results here so the compiler can't discard the work
+volatile f32 bench_sink_f32;
+volatile u64 bench_sink_u64;
+
+int bench_compare_f64(const void* a, const void* b)
+{
+	const double lhs = *(const double*)a;
+	const double rhs = *(const double*)b;
+	return (lhs > rhs) - (lhs < rhs);
+}
+
+BenchResult bench_run(const BenchDesc* in_desc)
+{
+	const i32 warmup_samples = in_desc->warmup_samples > 0 ? in_desc->warmup_samples : BENCH_DEFAULT_WARMUP_SAMPLES;
+	const i32 num_samples = in_desc->num_samples > 0 ? in_desc->num_samples : BENCH_DEFAULT_NUM_SAMPLES;
+
+	for (i32 sample_idx = 0; sample_idx < warmup_samples; ++sample_idx)
+	{
+		in_desc->function(in_desc->user_data);
+	}
+
+	double* samples = FCS_MEM_ALLOC(sizeof(double) * num_samples);
+	for (i32 sample_idx = 0; sample_idx < num_samples; ++sample_idx)
+	{
+		const u64 start_time = time_now();
+		in_desc->function(in_desc->user_data);
+		const u64 end_time = time_now();
+		samples[sample_idx] = time_nanoseconds(end_time - start_time);
+	}
+
+	qsort(samples, num_samples, sizeof(double), bench_compare_f64);
+
+	const i32 p99_idx = MIN(num_samples - 1, (i32)((num_samples - 1) * 0.99 + 0.5));
+	BenchResult result = {
+		.name = in_desc->name,
+		.ops_per_sample = in_desc->ops_per_sample,
+		.num_samples = num_samples,
+		.min_ns = samples[0],
+		.median_ns = samples[num_samples / 2],
+		.p99_ns = samples[p99_idx],
+		.ns_per_op = samples[num_samples / 2] / (double) MAX(in_desc->ops_per_sample, 1),
+	};
+
+	FCS_MEM_FREE(samples);
+	return result;
+}
+
+void bench_print_header()
+{
+	printf("%-32s %10s %12s %12s %12s %10s\n", "benchmark", "ops", "min ns", "median ns", "p99 ns", "ns/op");
+}
+
+void bench_print_result(const BenchResult* in_result)
+{
+	printf(
+		"%-32s %10i %12.0f %12.0f %12.0f %10.3f\n",
+		in_result->name,
+		in_result->ops_per_sample,
+		in_result->min_ns,
+		in_result->median_ns,
+		in_result->p99_ns,
+		in_result->ns_per_op
+	);
+}
+
+bool bench_write_json(const char* in_path, const BenchResult* in_results, const i32 in_num_results)
+{
+	FILE* file = fopen(in_path, "w");
+	if (!file)
+	{
+		printf("Failed to open %s for writing\n", in_path);
+		return false;
+	}
+
+	fprintf(file, "{\n");
+	fprintf(file, "\t\"simd_backend\": \"%s\",\n", math_simd_backend_name());
+	fprintf(file, "\t\"results\": [\n");
+	for (i32 result_idx = 0; result_idx < in_num_results; ++result_idx)
+	{
+		const BenchResult* result = &in_results[result_idx];
+		fprintf(
+			file,
+			"\t\t{ \"name\": \"%s\", \"ops_per_sample\": %i, \"samples\": %i, \"min_ns\": %.1f, \"median_ns\": %.1f, \"p99_ns\": %.1f, \"ns_per_op\": %.4f }%s\n",
+			result->name,
+			result->ops_per_sample,
+			result->num_samples,
+			result->min_ns,
+			result->median_ns,
+			result->p99_ns,
+			result->ns_per_op,
+			result_idx + 1 < in_num_results ? "," : ""
+		);
+	}
+	fprintf(file, "\t]\n");
+	fprintf(file, "}\n");
+
+	fclose(file);
+	return true;
+}
+
+// ---- Benchmark Data ---- //
+
+enum { BENCH_MATH_COUNT = 1024 };
+
+typedef struct MathBenchData
+{
+	Mat4 matrices_a[BENCH_MATH_COUNT];
+	Mat4 matrices_b[BENCH_MATH_COUNT];
+	Mat4 matrices_out[BENCH_MATH_COUNT];
+	Quat quats_a[BENCH_MATH_COUNT];
+	Quat quats_b[BENCH_MATH_COUNT];
+	TRS transforms[BENCH_MATH_COUNT];
+	Affine3 affines[BENCH_MATH_COUNT];			// transforms as Affine3
+	Affine3 rigid_affines[BENCH_MATH_COUNT];	// transforms without their scale
+	Vec3 points[BENCH_MATH_COUNT];
+	Vec3 points_out[BENCH_MATH_COUNT];
+} MathBenchData;
+
+Quat bench_random_quat()
+{
+	const Vec3 axis = vec3_normalize(vec3_new(rand_f32(-1.0f, 1.0f), rand_f32(-1.0f, 1.0f), rand_f32(-1.0f, 1.0f) + 2.0f));
+	return quat_new(axis, rand_f32(-3.0f, 3.0f));
+}
+
+void math_bench_data_init(MathBenchData* out_data)
+{
+	for (i32 idx = 0; idx < BENCH_MATH_COUNT; ++idx)
+	{
+		out_data->quats_a[idx] = bench_random_quat();
+		out_data->quats_b[idx] = bench_random_quat();
+		out_data->transforms[idx] = (TRS) {
+			.scale = vec3_new(rand_f32(0.5f, 2.0f), rand_f32(0.5f, 2.0f), rand_f32(0.5f, 2.0f)),
+			.rotation = out_data->quats_a[idx],
+			.translation = vec3_new(rand_f32(-10.0f, 10.0f), rand_f32(-10.0f, 10.0f), rand_f32(-10.0f, 10.0f)),
+		};
+		out_data->affines[idx] = affine3_from_trs(out_data->transforms[idx]);
+		out_data->rigid_affines[idx] = affine3_from_quat_translation(out_data->transforms[idx].rotation, out_data->transforms[idx].translation);
+		out_data->matrices_a[idx] = trs_to_mat4(out_data->transforms[idx]);
+		out_data->matrices_b[idx] = quat_to_mat4(out_data->quats_b[idx]);
+		out_data->points[idx] = vec3_new(rand_f32(-10.0f, 10.0f), rand_f32(-10.0f, 10.0f), rand_f32(-10.0f, 10.0f));
+	}
+}
+
+// ---- Math Benchmarks ---- //
+
+void bench_mat4_mul_mat4(void* user_data)
+{
+	MathBenchData* data = user_data;
+	for (i32 idx = 0; idx < BENCH_MATH_COUNT; ++idx)
+	{
+		data->matrices_out[idx] = mat4_mul_mat4(data->matrices_a[idx], data->matrices_b[idx]);
+	}
+	bench_sink_f32 = data->matrices_out[BENCH_MATH_COUNT - 1].d[3][0];
+}
+
+void bench_mat4_inverse(void* user_data)
+{
+	MathBenchData* data = user_data;
+	f32 sum = 0.0f;
+	for (i32 idx = 0; idx < BENCH_MATH_COUNT; ++idx)
+	{
+		// A non-affine last row forces the general adjoint path
+		Mat4 matrix = data->matrices_a[idx];
+		matrix.d[0][3] = 0.25f;
+		optional(Mat4) inverse = mat4_inverse(matrix);
+		sum += optional_get(inverse).d[3][0];
+	}
+	bench_sink_f32 = sum;
+}
+
+void bench_mat4_inverse_affine(void* user_data)
+{
+	MathBenchData* data = user_data;
+	f32 sum = 0.0f;
+	for (i32 idx = 0; idx < BENCH_MATH_COUNT; ++idx)
+	{
+		optional(Mat4) inverse = mat4_inverse(data->matrices_a[idx]);
+		sum += optional_get(inverse).d[3][0];
+	}
+	bench_sink_f32 = sum;
+}
+
+void bench_affine3_inverse(void* user_data)
+{
+	MathBenchData* data = user_data;
+	f32 sum = 0.0f;
+	for (i32 idx = 0; idx < BENCH_MATH_COUNT; ++idx)
+	{
+		optional(Affine3) inverse = affine3_inverse(data->affines[idx]);
+		sum += optional_get(inverse).d[3][0];
+	}
+	bench_sink_f32 = sum;
+}
+
+void bench_affine3_inverse_rigid(void* user_data)
+{
+	MathBenchData* data = user_data;
+	f32 sum = 0.0f;
+	for (i32 idx = 0; idx < BENCH_MATH_COUNT; ++idx)
+	{
+		sum += affine3_inverse_rigid(data->rigid_affines[idx]).d[3][0];
+	}
+	bench_sink_f32 = sum;
+}
+
+void bench_trs_to_mat4_array(void* user_data)
+{
+	MathBenchData* data = user_data;
+	trs_to_mat4_array(data->transforms, data->matrices_out, BENCH_MATH_COUNT);
+	bench_sink_f32 = data->matrices_out[BENCH_MATH_COUNT - 1].d[3][0];
+}
+
+void bench_quat_slerp(void* user_data)
+{
+	MathBenchData* data = user_data;
+	f32 sum = 0.0f;
+	for (i32 idx = 0; idx < BENCH_MATH_COUNT; ++idx)
+	{
+		const f32 t = (f32) idx / (f32) BENCH_MATH_COUNT;
+		sum += quat_slerp(t, data->quats_a[idx], data->quats_b[idx]).w;
+	}
+	bench_sink_f32 = sum;
+}
+
+void bench_quat_nlerp(void* user_data)
+{
+	MathBenchData* data = user_data;
+	f32 sum = 0.0f;
+	for (i32 idx = 0; idx < BENCH_MATH_COUNT; ++idx)
+	{
+		const f32 t = (f32) idx / (f32) BENCH_MATH_COUNT;
+		sum += quat_nlerp(t, data->quats_a[idx], data->quats_b[idx]).w;
+	}
+	bench_sink_f32 = sum;
+}
+
+void bench_quat_rotate_vec3(void* user_data)
+{
+	MathBenchData* data = user_data;
+	for (i32 idx = 0; idx < BENCH_MATH_COUNT; ++idx)
+	{
+		data->points_out[idx] = quat_rotate_vec3(data->quats_a[idx], data->points[idx]);
+	}
+	bench_sink_f32 = data->points_out[BENCH_MATH_COUNT - 1].x;
+}
+
+void bench_vec3_normalize(void* user_data)
+{
+	MathBenchData* data = user_data;
+	for (i32 idx = 0; idx < BENCH_MATH_COUNT; ++idx)
+	{
+		data->points_out[idx] = vec3_normalize(data->points[idx]);
+	}
+	bench_sink_f32 = data->points_out[BENCH_MATH_COUNT - 1].x;
+}
+
+void bench_rsqrt_libm(void* user_data)
+{
+	MathBenchData* data = user_data;
+	f32 sum = 0.0f;
+	for (i32 idx = 0; idx < BENCH_MATH_COUNT; ++idx)
+	{
+		sum += 1.0f / sqrtf(vec3_length_squared(data->points[idx]));
+	}
+	bench_sink_f32 = sum;
+}
+
+void bench_rsqrt_approx(void* user_data)
+{
+	MathBenchData* data = user_data;
+	f32 sum = 0.0f;
+	for (i32 idx = 0; idx < BENCH_MATH_COUNT; ++idx)
+	{
+		sum += f32_rsqrt_approx(vec3_length_squared(data->points[idx]));
+	}
+	bench_sink_f32 = sum;
+}
+
+void bench_sincos_libm(void* user_data)
+{
+	MathBenchData* data = user_data;
+	f32 sum = 0.0f;
+	for (i32 idx = 0; idx < BENCH_MATH_COUNT; ++idx)
+	{
+		const f32 angle = data->points[idx].x;
+		sum += sinf(angle) + cosf(angle);
+	}
+	bench_sink_f32 = sum;
+}
+
+void bench_sincos_approx(void* user_data)
+{
+	MathBenchData* data = user_data;
+	f32 sum = 0.0f;
+	for (i32 idx = 0; idx < BENCH_MATH_COUNT; ++idx)
+	{
+		f32 s, c;
+		f32_sincos_approx(data->points[idx].x, &s, &c);
+		sum += s + c;
+	}
+	bench_sink_f32 = sum;
+}
+
+void bench_atan2_libm(void* user_data)
+{
+	MathBenchData* data = user_data;
+	f32 sum = 0.0f;
+	for (i32 idx = 0; idx < BENCH_MATH_COUNT; ++idx)
+	{
+		sum += atan2f(data->points[idx].y, data->points[idx].x);
+	}
+	bench_sink_f32 = sum;
+}
+
+void bench_atan2_approx(void* user_data)
+{
+	MathBenchData* data = user_data;
+	f32 sum = 0.0f;
+	for (i32 idx = 0; idx < BENCH_MATH_COUNT; ++idx)
+	{
+		sum += f32_atan2_approx(data->points[idx].y, data->points[idx].x);
+	}
+	bench_sink_f32 = sum;
+}
+
+// ---- Container / Memory Benchmarks ---- //
+
+enum { BENCH_CONTAINER_COUNT = 4096 };
+
+void bench_sb_push_growth(void* user_data)
+{
+	sbuffer(u64) buffer = NULL;
+	for (i32 idx = 0; idx < BENCH_CONTAINER_COUNT; ++idx)
+	{
+		sb_push(buffer, (u64) idx);
+	}
+	bench_sink_u64 = buffer[BENCH_CONTAINER_COUNT - 1];
+	sb_free(buffer);
+}
+
+void bench_sb_push_reserved(void* user_data)
+{
+	sbuffer(u64) buffer = NULL;
+	sb_reserve(buffer, BENCH_CONTAINER_COUNT);
+	for (i32 idx = 0; idx < BENCH_CONTAINER_COUNT; ++idx)
+	{
+		sb_push(buffer, (u64) idx);
+	}
+	bench_sink_u64 = buffer[BENCH_CONTAINER_COUNT - 1];
+	sb_free(buffer);
+}
+
+void bench_arena_alloc(void* user_data)
+{
+	Arena* arena = arena_create(&default_arena_desc);
+	u64 sum = 0;
+	for (i32 idx = 0; idx < BENCH_CONTAINER_COUNT; ++idx)
+	{
+		// Mix of sizes so the arena has to grow a few times
+		u64* allocation = arena_alloc(arena, 8 + (idx & 7) * 8);
+		*allocation = idx;
+		sum += *allocation;
+	}
+	bench_sink_u64 = sum;
+	arena_destroy(arena);
+}
+
+// ---- LCP Benchmarks ---- //
+
+enum { BENCH_LCP_SIZE = 64 };
+
+typedef struct LcpBenchData
+{
+	Arena* arena;
+	MatN mat_n;
+	VecN vec_n;
+	VecN lambda;
+	LcpBodyInverseMass bodies[BENCH_LCP_SIZE + 1];
+	Jacobian1x12 jacobians[BENCH_LCP_SIZE];
+	InverseMass12 inverse_masses[BENCH_LCP_SIZE];
+} LcpBenchData;
+
+void lcp_bench_data_init(LcpBenchData* out_data)
+{
+	out_data->arena = arena_create(&(ArenaDesc) {
+		.size = 256 KiB,
+		.allow_growth = true,
+	});
+
+	// Diagonally dominant system so Gauss-Seidel converges
+	out_data->mat_n = matn_new(out_data->arena, BENCH_LCP_SIZE);
+	out_data->vec_n = vecn_new(out_data->arena, BENCH_LCP_SIZE);
+	out_data->lambda = vecn_new(out_data->arena, BENCH_LCP_SIZE);
+	for (i32 row = 0; row < BENCH_LCP_SIZE; ++row)
+	{
+		for (i32 col = 0; col < BENCH_LCP_SIZE; ++col)
+		{
+			MATN_AT(&out_data->mat_n, row, col) = row == col ? (f32) BENCH_LCP_SIZE : rand_f32(-0.5f, 0.5f);
+		}
+		out_data->vec_n.data[row] = rand_f32(-1.0f, 1.0f);
+	}
+
+	// A chain of bodies, each row linking body i to body i + 1
+	for (i32 body_idx = 0; body_idx < BENCH_LCP_SIZE + 1; ++body_idx)
+	{
+		out_data->bodies[body_idx] = (LcpBodyInverseMass) {
+			.inverse_mass = 1.0f,
+			.inverse_inertia = mat3_identity,
+		};
+	}
+	for (i32 row_idx = 0; row_idx < BENCH_LCP_SIZE; ++row_idx)
+	{
+		for (i32 i = 0; i < 12; ++i)
+		{
+			out_data->jacobians[row_idx].d[i] = rand_f32(-1.0f, 1.0f);
+		}
+		out_data->inverse_masses[row_idx] = (InverseMass12) {
+			.body_a = out_data->bodies[row_idx],
+			.body_b = out_data->bodies[row_idx + 1],
+		};
+	}
+}
+
+void bench_lcp_gauss_seidel(void* user_data)
+{
+	LcpBenchData* data = user_data;
+	lcp_gauss_seidel_into(&data->mat_n, &data->vec_n, &data->lambda);
+	bench_sink_f32 = data->lambda.data[0];
+}
+
+// J * W * J^T for each row, with W expanded to a dense 12x12 matrix
+void bench_effective_mass_dense(void* user_data)
+{
+	LcpBenchData* data = user_data;
+	f32 sum = 0.0f;
+	for (i32 row_idx = 0; row_idx < BENCH_LCP_SIZE; ++row_idx)
+	{
+		f32 inv_mass_matrix_data[12 * 12] = {};
+		f32 jacobian_transpose_data[12];
+		f32 j_inv_mass_data[12];
+		f32 j_w_jt_data[1];
+
+		const InverseMass12* inverse_mass = &data->inverse_masses[row_idx];
+		MatMN inv_mass_matrix = matmn_view(inv_mass_matrix_data, 12, 12, 12);
+		for (i32 i = 0; i < 3; ++i)
+		{
+			MATMN_AT(&inv_mass_matrix, i, i) = inverse_mass->body_a.inverse_mass;
+			MATMN_AT(&inv_mass_matrix, 6 + i, 6 + i) = inverse_mass->body_b.inverse_mass;
+			for (i32 j = 0; j < 3; ++j)
+			{
+				MATMN_AT(&inv_mass_matrix, 3 + i, 3 + j) = inverse_mass->body_a.inverse_inertia.d[j][i];
+				MATMN_AT(&inv_mass_matrix, 9 + i, 9 + j) = inverse_mass->body_b.inverse_inertia.d[j][i];
+			}
+		}
+
+		const MatMN jacobian = matmn_view(data->jacobians[row_idx].d, 1, 12, 12);
+		MatMN jacobian_transpose = matmn_view(jacobian_transpose_data, 12, 1, 1);
+		matmn_transpose_into(&jacobian, &jacobian_transpose);
+		MatMN j_inv_mass = matmn_view(j_inv_mass_data, 1, 12, 12);
+		matmn_mul_matmn_into(&jacobian, &inv_mass_matrix, &j_inv_mass);
+		MatMN j_w_jt = matmn_view(j_w_jt_data, 1, 1, 1);
+		matmn_mul_matmn_into(&j_inv_mass, &jacobian_transpose, &j_w_jt);
+		sum += j_w_jt_data[0];
+	}
+	bench_sink_f32 = sum;
+}
+
+void bench_effective_mass_fixed(void* user_data)
+{
+	LcpBenchData* data = user_data;
+	f32 sum = 0.0f;
+	for (i32 row_idx = 0; row_idx < BENCH_LCP_SIZE; ++row_idx)
+	{
+		sum += jacobian1x12_effective_mass(data->jacobians[row_idx], &data->inverse_masses[row_idx]);
+	}
+	bench_sink_f32 = sum;
+}
+
+// ---- Broadphase Benchmarks ---- //
+
+enum { BENCH_BROAD_PHASE_COUNT = 1024 };
+
+typedef struct BroadPhaseBenchData
+{
+	Bounds bounds[BENCH_BROAD_PHASE_COUNT];
+	Vec3 velocities[BENCH_BROAD_PHASE_COUNT];
+	i32 step;
+	SweepAndPrune sweep_and_prune;
+	AabbTree aabb_tree;
+	SpatialHashGrid spatial_hash_grid;
+} BroadPhaseBenchData;
+
+void broad_phase_bench_data_init(BroadPhaseBenchData* out_data)
+{
+	*out_data = (BroadPhaseBenchData) {};
+	for (i32 idx = 0; idx < BENCH_BROAD_PHASE_COUNT; ++idx)
+	{
+		const Vec3 center = vec3_new(rand_f32(-100.0f, 100.0f), rand_f32(-100.0f, 100.0f), rand_f32(-100.0f, 100.0f));
+		const Vec3 half_extents = vec3_new(rand_f32(0.5f, 2.0f), rand_f32(0.5f, 2.0f), rand_f32(0.5f, 2.0f));
+		out_data->bounds[idx] = (Bounds) {
+			.min = vec3_sub(center, half_extents),
+			.max = vec3_add(center, half_extents),
+		};
+		out_data->velocities[idx] = vec3_new(rand_f32(-0.1f, 0.1f), rand_f32(-0.1f, 0.1f), rand_f32(-0.1f, 0.1f));
+	}
+	sweep_and_prune_init(&out_data->sweep_and_prune);
+	sweep_and_prune_update(&out_data->sweep_and_prune, out_data->bounds, BENCH_BROAD_PHASE_COUNT);
+	aabb_tree_init(&out_data->aabb_tree);
+	aabb_tree_update(&out_data->aabb_tree, out_data->bounds, BENCH_BROAD_PHASE_COUNT);
+	spatial_hash_grid_init(&out_data->spatial_hash_grid, 4.0f);
+	spatial_hash_grid_update(&out_data->spatial_hash_grid, out_data->bounds, BENCH_BROAD_PHASE_COUNT, NULL);
+}
+
+// A quarter of the bodies move each step, oscillating so the scene stays in the same region
+void broad_phase_bench_data_step(BroadPhaseBenchData* in_data)
+{
+	const f32 direction = ((in_data->step / 64) % 2) == 0 ? 1.0f : -1.0f;
+	for (i32 idx = in_data->step % 4; idx < BENCH_BROAD_PHASE_COUNT; idx += 4)
+	{
+		const Vec3 delta = vec3_scale(in_data->velocities[idx], direction);
+		in_data->bounds[idx].min = vec3_add(in_data->bounds[idx].min, delta);
+		in_data->bounds[idx].max = vec3_add(in_data->bounds[idx].max, delta);
+	}
+	in_data->step++;
+}
+
+void bench_broad_phase_sweep_and_prune(void* user_data)
+{
+	BroadPhaseBenchData* data = user_data;
+	broad_phase_bench_data_step(data);
+	sweep_and_prune_update(&data->sweep_and_prune, data->bounds, BENCH_BROAD_PHASE_COUNT);
+	bench_sink_u64 = sb_count(data->sweep_and_prune.pair_set.pairs);
+}
+
+void bench_broad_phase_aabb_tree(void* user_data)
+{
+	BroadPhaseBenchData* data = user_data;
+	broad_phase_bench_data_step(data);
+	aabb_tree_update(&data->aabb_tree, data->bounds, BENCH_BROAD_PHASE_COUNT);
+	bench_sink_u64 = sb_count(data->aabb_tree.pair_set.pairs);
+}
+
+void bench_broad_phase_spatial_hash_grid(void* user_data)
+{
+	BroadPhaseBenchData* data = user_data;
+	broad_phase_bench_data_step(data);
+	spatial_hash_grid_update(&data->spatial_hash_grid, data->bounds, BENCH_BROAD_PHASE_COUNT, NULL);
+	bench_sink_u64 = sb_count(data->spatial_hash_grid.pair_set.pairs);
+}
+
+void bench_broad_phase_brute_force(void* user_data)
+{
+	BroadPhaseBenchData* data = user_data;
+	broad_phase_bench_data_step(data);
+	u64 num_pairs = 0;
+	for (i32 a = 0; a < BENCH_BROAD_PHASE_COUNT; ++a)
+	{
+		for (i32 b = a + 1; b < BENCH_BROAD_PHASE_COUNT; ++b)
+		{
+			num_pairs += bounds_intersect(data->bounds[a], data->bounds[b]) ? 1 : 0;
+		}
+	}
+	bench_sink_u64 = num_pairs;
+}
+
+int main(int argc, char** argv)
+{
+	const char* output_path = argc > 1 ? argv[1] : "bin/bench_results.json";
+
+	srand(1234);
+
+	MathBenchData* math_data = FCS_MEM_ALLOC(sizeof(MathBenchData));
+	math_bench_data_init(math_data);
+
+	LcpBenchData lcp_data = {};
+	lcp_bench_data_init(&lcp_data);
+
+	BroadPhaseBenchData* broad_phase_data = FCS_MEM_ALLOC(sizeof(BroadPhaseBenchData));
+	broad_phase_bench_data_init(broad_phase_data);
+
+	const BenchDesc benches[] = {
+		{ .name = "mat4_mul_mat4",				.function = bench_mat4_mul_mat4,				.user_data = math_data,	.ops_per_sample = BENCH_MATH_COUNT },
+		{ .name = "mat4_inverse",				.function = bench_mat4_inverse,					.user_data = math_data,	.ops_per_sample = BENCH_MATH_COUNT },
+		{ .name = "mat4_inverse_affine",		.function = bench_mat4_inverse_affine,			.user_data = math_data,	.ops_per_sample = BENCH_MATH_COUNT },
+		{ .name = "affine3_inverse",			.function = bench_affine3_inverse,				.user_data = math_data,	.ops_per_sample = BENCH_MATH_COUNT },
+		{ .name = "affine3_inverse_rigid",		.function = bench_affine3_inverse_rigid,		.user_data = math_data,	.ops_per_sample = BENCH_MATH_COUNT },
+		{ .name = "trs_to_mat4_array",			.function = bench_trs_to_mat4_array,			.user_data = math_data,	.ops_per_sample = BENCH_MATH_COUNT },
+		{ .name = "quat_slerp",					.function = bench_quat_slerp,					.user_data = math_data,	.ops_per_sample = BENCH_MATH_COUNT },
+		{ .name = "quat_nlerp",					.function = bench_quat_nlerp,					.user_data = math_data,	.ops_per_sample = BENCH_MATH_COUNT },
+		{ .name = "quat_rotate_vec3",			.function = bench_quat_rotate_vec3,				.user_data = math_data,	.ops_per_sample = BENCH_MATH_COUNT },
+		{ .name = "vec3_normalize",				.function = bench_vec3_normalize,				.user_data = math_data,	.ops_per_sample = BENCH_MATH_COUNT },
+		{ .name = "rsqrt_libm",					.function = bench_rsqrt_libm,					.user_data = math_data,	.ops_per_sample = BENCH_MATH_COUNT },
+		{ .name = "rsqrt_approx",				.function = bench_rsqrt_approx,					.user_data = math_data,	.ops_per_sample = BENCH_MATH_COUNT },
+		{ .name = "sincos_libm",				.function = bench_sincos_libm,					.user_data = math_data,	.ops_per_sample = BENCH_MATH_COUNT },
+		{ .name = "sincos_approx",				.function = bench_sincos_approx,				.user_data = math_data,	.ops_per_sample = BENCH_MATH_COUNT },
+		{ .name = "atan2_libm",					.function = bench_atan2_libm,					.user_data = math_data,	.ops_per_sample = BENCH_MATH_COUNT },
+		{ .name = "atan2_approx",				.function = bench_atan2_approx,					.user_data = math_data,	.ops_per_sample = BENCH_MATH_COUNT },
+		{ .name = "sb_push_growth",				.function = bench_sb_push_growth,				.user_data = NULL,		.ops_per_sample = BENCH_CONTAINER_COUNT },
+		{ .name = "sb_push_reserved",			.function = bench_sb_push_reserved,				.user_data = NULL,		.ops_per_sample = BENCH_CONTAINER_COUNT },
+		{ .name = "arena_alloc",				.function = bench_arena_alloc,					.user_data = NULL,		.ops_per_sample = BENCH_CONTAINER_COUNT },
+		{ .name = "lcp_gauss_seidel_64",		.function = bench_lcp_gauss_seidel,				.user_data = &lcp_data,	.ops_per_sample = 1 },
+		{ .name = "effective_mass_dense",		.function = bench_effective_mass_dense,			.user_data = &lcp_data,	.ops_per_sample = BENCH_LCP_SIZE },
+		{ .name = "effective_mass_fixed",		.function = bench_effective_mass_fixed,			.user_data = &lcp_data,	.ops_per_sample = BENCH_LCP_SIZE },
+		{ .name = "broad_phase_sap_1024",		.function = bench_broad_phase_sweep_and_prune,	.user_data = broad_phase_data,	.ops_per_sample = 1 },
+		{ .name = "broad_phase_tree_1024",		.function = bench_broad_phase_aabb_tree,		.user_data = broad_phase_data,	.ops_per_sample = 1 },
+		{ .name = "broad_phase_grid_1024",		.function = bench_broad_phase_spatial_hash_grid,	.user_data = broad_phase_data,	.ops_per_sample = 1 },
+		{ .name = "broad_phase_brute_1024",		.function = bench_broad_phase_brute_force,		.user_data = broad_phase_data,	.ops_per_sample = 1 },
+	};
+	const i32 num_benches = ARRAY_COUNT(benches);
+
+	printf("SIMD backend: %s\n", math_simd_backend_name());
+	bench_print_header();
+
+	BenchResult results[ARRAY_COUNT(benches)];
+	for (i32 bench_idx = 0; bench_idx < num_benches; ++bench_idx)
+	{
+		results[bench_idx] = bench_run(&benches[bench_idx]);
+		bench_print_result(&results[bench_idx]);
+	}
+
+	const bool wrote_output = bench_write_json(output_path, results, num_benches);
+	if (wrote_output)
+	{
+		printf("Wrote %s\n", output_path);
+	}
+
+	arena_destroy(lcp_data.arena);
+	sweep_and_prune_destroy(&broad_phase_data->sweep_and_prune);
+	aabb_tree_destroy(&broad_phase_data->aabb_tree);
+	spatial_hash_grid_destroy(&broad_phase_data->spatial_hash_grid);
+	FCS_MEM_FREE(broad_phase_data);
+	FCS_MEM_FREE(math_data);
+
+	return wrote_output ? 0 : 1;
+}
@@ -368,8 +368,10 @@ void debug_draw_sphere(DebugDrawContext* debug_draw_context, const DebugDrawSphe
 	for (i32 i = 0; i <= latitudes; ++i)
 	{
 		f32 latitudeAngle = PI / 2.0f - i * deltaLatitude;	/* Starting -pi/2 to pi/2 */
-		f32 xz = radius * cosf(latitudeAngle);				/* r * cos(phi) */
-		f32 y = radius * sinf(latitudeAngle);				/* r * sin(phi )*/
+		f32 sin_latitude, cos_latitude;
+		f32_sincos_approx(latitudeAngle, &sin_latitude, &cos_latitude);
+		f32 xz = radius * cos_latitude;						/* r * cos(phi) */
+		f32 y = radius * sin_latitude;						/* r * sin(phi )*/
 
 		/*
 			* We add (latitudes + 1) vertices per longitude because of equator,
@@ -380,13 +382,15 @@ void debug_draw_sphere(DebugDrawContext* debug_draw_context, const DebugDrawSphe
 		for (i32 j = 0; j <= longitudes; ++j)
 		{
 			f32 longitudeAngle = j * deltaLongitude;
+			f32 sin_longitude, cos_longitude;
+			f32_sincos_approx(longitudeAngle, &sin_longitude, &cos_longitude);
 
 			DebugDrawVertex vertex = {};
 
 			Vec3 local_position = vec3_zero;		
-			local_position.x += xz * cosf(longitudeAngle);	
+			local_position.x += xz * cos_longitude;	
 			local_position.y += y;
-			local_position.z += xz * sinf(longitudeAngle);		/* z = r * sin(phi) */
+			local_position.z += xz * sin_longitude;				/* z = r * sin(phi) */
 			local_position = mat3_mul_vec3(orientation_matrix, local_position);
 
 			Vec3 world_position = vec3_add(sphere_center, local_position);
@@ -717,6 +717,24 @@ Mat4 gltf_transform_to_mat4(const GltfTransform* in_transform)
 	}
 }
 
+Affine3 gltf_transform_to_affine3(const GltfTransform* in_transform)
+{
+	if (in_transform->type == GLTF_TRANSFORM_TYPE_MATRIX)
+	{
+		// glTF requires node matrices to be decomposable into TRS, so the last row is always (0, 0, 0, 1)
+		return affine3_from_mat4(in_transform->matrix);
+	}
+	else
+	{
+		assert(in_transform->type == GLTF_TRANSFORM_TYPE_TRS);
+		return affine3_from_trs((TRS) {
+			.scale = in_transform->scale,
+			.rotation = in_transform->rotation,
+			.translation = in_transform->translation,
+		});
+	}
+}
+
 typedef struct GltfNode
 {
     const char* name;
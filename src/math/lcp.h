@@ -3,8 +3,19 @@
 // Linear Complementarity Problem (LCP) solver using Gaussian-Seidel method
 
 #include "math/basic_math.h"
+#include "math/matrix.h"
 #include "memory/arena.h"
 
+/*
+	Storage:
+	VecN is a contiguous array of n floats.
+	MatN / MatMN are a single contiguous row-major block. Element (row, col) lives at data[row * stride + col].
+	stride is the leading dimension (>= number of columns), so a view can address a sub-block of a larger matrix.
+
+	Functions that take an Arena allocate their result. The *_into / *_in_place variants write to caller-provided
+	storage and never allocate, so they can be used on stack buffers via vecn_view / matmn_view / matn_view.
+*/
+
 typedef struct VecN
 {
 	f32* data;
@@ -13,17 +24,26 @@ typedef struct VecN
 
 typedef struct MatN
 {
-	VecN* rows;
+	f32* data;
 	i32 n;
+	i32 stride; // Leading dimension (floats between the start of consecutive rows)
 } MatN;
 
 typedef struct MatMN
 {
-	VecN* rows;
-	i32 m; // Num Rows 
-	i32 n; // Num Columns 
+	f32* data;
+	i32 m; // Num Rows
+	i32 n; // Num Columns
+	i32 stride; // Leading dimension (floats between the start of consecutive rows)
 } MatMN;
 
+// Element access. Evaluates to an lvalue
+#define MATN_AT(in_mat_ptr, in_row, in_col) ((in_mat_ptr)->data[(in_row) * (in_mat_ptr)->stride + (in_col)])
+#define MATMN_AT(in_mat_ptr, in_row, in_col) ((in_mat_ptr)->data[(in_row) * (in_mat_ptr)->stride + (in_col)])
+
+// Block size used by matmn_mul_matmn_into. 32x32 floats is 4 KiB per tile, so the three active tiles stay in L1
+enum { LCP_MATMUL_BLOCK_SIZE = 32 };
+
 // VecN Functions
 
 i32 vecn_count(const VecN* in_vec_n)
@@ -32,25 +52,34 @@ i32 vecn_count(const VecN* in_vec_n)
 	return in_vec_n->n;
 }
 
+// Wraps existing storage. Does not allocate or clear
+VecN vecn_view(f32* in_data, const i32 in_num_elements)
+{
+	return (VecN) {
+		.data = in_data,
+		.n = in_num_elements,
+	};
+}
+
 VecN vecn_new(Arena* arena, const i32 in_num_elements)
 {
 	f32* data = (f32*) arena_alloc(arena, in_num_elements * sizeof(f32));
 	assert(data);
 	memset(data, 0, in_num_elements * sizeof(f32));
 
-	VecN out_vec_n = {
-		.data = data,
-		.n = in_num_elements,
-	};
+	return vecn_view(data, in_num_elements);
+}
 
-	return out_vec_n;
+void vecn_copy_into(const VecN* in_vec_n, VecN* out_vec_n)
+{
+	assert(vecn_count(out_vec_n) == vecn_count(in_vec_n));
+	memmove(out_vec_n->data, in_vec_n->data, vecn_count(in_vec_n) * sizeof(f32));
 }
 
 VecN vecn_copy(Arena* arena, const VecN* in_vec_n)
 {
-	const i32 num_elements = vecn_count(in_vec_n);
-	VecN out_vec_n = vecn_new(arena, num_elements);
-	memcpy(out_vec_n.data, in_vec_n->data, num_elements * sizeof(f32));
+	VecN out_vec_n = vecn_new(arena, vecn_count(in_vec_n));
+	vecn_copy_into(in_vec_n, &out_vec_n);
 
 	return out_vec_n;
 }
@@ -72,7 +101,7 @@ VecN vecn_scale(Arena* arena, const VecN* in_vec_n, const f32 in_scale_factor)
 }
 
 void vecn_add_in_place(VecN* in_vec_lhs, const VecN* in_vec_rhs)
-{	
+{
 	for (i32 idx = 0; idx < in_vec_lhs->n; ++idx)
 	{
 		in_vec_lhs->data[idx] += in_vec_rhs->data[idx];
@@ -80,7 +109,7 @@ void vecn_add_in_place(VecN* in_vec_lhs, const VecN* in_vec_rhs)
 }
 
 VecN vecn_add(Arena* arena, const VecN* in_vec_lhs, const VecN* in_vec_rhs)
-{	
+{
 	VecN out_vec_n = vecn_copy(arena, in_vec_lhs);
 	vecn_add_in_place(&out_vec_n, in_vec_rhs);
 
@@ -88,7 +117,7 @@ VecN vecn_add(Arena* arena, const VecN* in_vec_lhs, const VecN* in_vec_rhs)
 }
 
 void vecn_sub_in_place(VecN* in_vec_lhs, const VecN* in_vec_rhs)
-{		
+{
 	for (i32 idx = 0; idx < in_vec_lhs->n; ++idx)
 	{
 		in_vec_lhs->data[idx] -= in_vec_rhs->data[idx];
@@ -96,299 +125,437 @@ void vecn_sub_in_place(VecN* in_vec_lhs, const VecN* in_vec_rhs)
 }
 
 VecN vecn_sub(Arena* arena, const VecN* in_vec_lhs, const VecN* in_vec_rhs)
-{	
+{
 	VecN out_vec_n = vecn_copy(arena, in_vec_lhs);
 	vecn_sub_in_place(&out_vec_n, in_vec_rhs);
 
 	return out_vec_n;
 }
 
-f32 vecn_dot(const VecN* in_vec_lhs, const VecN* in_vec_rhs)
+// Dot product of two contiguous float arrays
+f32 f32_array_dot(const f32* in_lhs, const f32* in_rhs, const i32 in_count)
 {
-	f32 result = 0;	
-	for (i32 idx = 0; idx < in_vec_lhs->n; ++idx)
+	f32 result = 0;
+	for (i32 idx = 0; idx < in_count; ++idx)
 	{
-		result += in_vec_lhs->data[idx] * in_vec_rhs->data[idx];
+		result += in_lhs[idx] * in_rhs[idx];
 	}
 	return result;
 }
 
+f32 vecn_dot(const VecN* in_vec_lhs, const VecN* in_vec_rhs)
+{
+	return f32_array_dot(in_vec_lhs->data, in_vec_rhs->data, in_vec_lhs->n);
+}
+
 void vecn_zero_in_place(VecN* in_vec_n)
-{	
+{
 	u64 data_size = sizeof(f32) * vecn_count(in_vec_n);
 	memset(in_vec_n->data, 0, data_size);
 }
 
-// MatN Functions
+// MatMN Functions
 
-MatN matn_new(Arena* arena, i32 in_num_elements)
+// Wraps existing row-major storage with leading dimension in_stride. Does not allocate or clear
+MatMN matmn_view(f32* in_data, const i32 in_m, const i32 in_n, const i32 in_stride)
 {
-	MatN out_mat_n = {
-		.rows = (VecN*) arena_alloc(arena, in_num_elements * sizeof(VecN)),
-		.n = in_num_elements,
+	assert(in_stride >= in_n);
+	return (MatMN) {
+		.data = in_data,
+		.m = in_m,
+		.n = in_n,
+		.stride = in_stride,
 	};
-	assert(out_mat_n.rows);
+}
 
-	for (i32 i = 0; i < in_num_elements; ++i)
-	{
-		out_mat_n.rows[i] = vecn_new(arena, in_num_elements);
-	}
+MatMN matmn_new(Arena* arena, i32 in_m, i32 in_n)
+{
+	f32* data = (f32*) arena_alloc(arena, in_m * in_n * sizeof(f32));
+	assert(data);
+	memset(data, 0, in_m * in_n * sizeof(f32));
 
-	return out_mat_n;
+	return matmn_view(data, in_m, in_n, in_n);
 }
 
-i32 matn_num_dims(const MatN* in_mat_n)
+// Returns a view of row in_row. Rows are contiguous so this never copies
+VecN matmn_row(const MatMN* in_mat_mn, const i32 in_row)
 {
-	return in_mat_n->n;
+	assert(in_row < in_mat_mn->m);
+	return vecn_view(&in_mat_mn->data[in_row * in_mat_mn->stride], in_mat_mn->n);
 }
 
-MatN matn_copy(Arena* arena, const MatN* in_mat_n)
+void matmn_zero_in_place(MatMN* in_mat_mn)
 {
-	MatN out_mat_n = {
-		.rows = (VecN*) arena_alloc(arena, in_mat_n->n * sizeof(VecN)),
-		.n = in_mat_n->n,
-	};
-	assert(out_mat_n.rows);
+	if (in_mat_mn->stride == in_mat_mn->n)
+	{
+		memset(in_mat_mn->data, 0, in_mat_mn->m * in_mat_mn->n * sizeof(f32));
+		return;
+	}
 
-	for (i32 i = 0; i < in_mat_n->n; ++i)
+	for (i32 i = 0; i < in_mat_mn->m; ++i)
 	{
-		out_mat_n.rows[i] = in_mat_n->rows[i];
-	}	
+		memset(&in_mat_mn->data[i * in_mat_mn->stride], 0, in_mat_mn->n * sizeof(f32));
+	}
+}
 
-	return out_mat_n;
+MatMN matmn_zero(Arena* arena, i32 in_m, i32 in_n)
+{
+	return matmn_new(arena, in_m, in_n);
 }
 
-void matn_zero_in_place(MatN* in_mat_n)
+void matmn_copy_into(const MatMN* in_mat_mn, MatMN* out_mat_mn)
 {
-	const i32 num_dims = matn_num_dims(in_mat_n);
-	for (i32 i = 0; i < num_dims; ++i)
+	assert(out_mat_mn->m == in_mat_mn->m && out_mat_mn->n == in_mat_mn->n);
+	for (i32 i = 0; i < in_mat_mn->m; ++i)
 	{
-		vecn_zero_in_place(&in_mat_n->rows[i]);
-	}	
+		memmove(&out_mat_mn->data[i * out_mat_mn->stride], &in_mat_mn->data[i * in_mat_mn->stride], in_mat_mn->n * sizeof(f32));
+	}
 }
 
-MatN matn_zero(Arena* arena, const i32 in_dimensions)
+MatMN matmn_copy(Arena* arena, const MatMN* in_mat_mn)
 {
-	MatN out_mat = matn_new(arena, in_dimensions);
-	matn_zero_in_place(&out_mat);
-	return out_mat;
+	MatMN out_mat_mn = matmn_new(arena, in_mat_mn->m, in_mat_mn->n);
+	matmn_copy_into(in_mat_mn, &out_mat_mn);
+	return out_mat_mn;
 }
 
-void matn_identity(MatN* in_mat_n)
+void matmn_scale_in_place(MatMN* in_mat_mn, const f32 in_scale)
 {
-	const i32 num_dims = matn_num_dims(in_mat_n);
-	for (i32 i = 0; i < num_dims; ++i)
+	for (i32 i = 0; i < in_mat_mn->m; ++i)
 	{
-		vecn_zero_in_place(&in_mat_n->rows[i]);
-		in_mat_n->rows[i].data[i] = 1.0f;
-	}	
+		VecN row = matmn_row(in_mat_mn, i);
+		vecn_scale_in_place(&row, in_scale);
+	}
 }
 
-void matn_transpose(Arena* arena, MatN* in_mat_n)
+// out_vec_n = in_mat_mn * in_vec_n. out_vec_n must not alias in_vec_n
+void matmn_mul_vecn_into(const MatMN* in_mat_mn, const VecN* in_vec_n, VecN* out_vec_n)
 {
-	MatN tmp = matn_copy(arena, in_mat_n);
+	assert(in_mat_mn->n == vecn_count(in_vec_n));
+	assert(in_mat_mn->m == vecn_count(out_vec_n));
+	assert(out_vec_n->data != in_vec_n->data);
 
-	const i32 num_dimensions = matn_num_dims(in_mat_n);
-	for (i32 i = 0; i < num_dimensions; ++i)
+	for (i32 m = 0; m < in_mat_mn->m; ++m)
 	{
-		for (i32 j = 0; j < num_dimensions; ++j)
-		{
-			in_mat_n->rows[j].data[i] = tmp.rows[i].data[j];
-		}
+		out_vec_n->data[m] = f32_array_dot(&in_mat_mn->data[m * in_mat_mn->stride], in_vec_n->data, in_mat_mn->n);
 	}
 }
 
-void matn_scale_in_place(MatN* in_mat_n, const f32 in_scale)
+VecN matmn_mul_vecn(Arena* arena, const MatMN* in_mat_mn, const VecN* in_vec_n)
 {
-	i32 num_dims = matn_num_dims(in_mat_n);
-	for (i32 i = 0; i < num_dims; ++i)
+	if (in_mat_mn->n != vecn_count(in_vec_n))
 	{
-		vecn_scale_in_place(&in_mat_n->rows[i], in_scale);
-	}	
+		assert(false);
+		return vecn_copy(arena, in_vec_n);
+	}
+
+	VecN out_vec_n = vecn_new(arena, in_mat_mn->m);
+	matmn_mul_vecn_into(in_mat_mn, in_vec_n, &out_vec_n);
+	return out_vec_n;
 }
 
-VecN matn_mul_vecn(Arena* arena, const MatN* in_mat_n, const VecN* in_vec_n)
-{	
-	const i32 num_dims = matn_num_dims(in_mat_n);
-	assert(num_dims == vecn_count(in_vec_n));
+// out_mat_mn = transpose(in_mat_mn). out_mat_mn must be n x m and must not alias in_mat_mn
+void matmn_transpose_into(const MatMN* in_mat_mn, MatMN* out_mat_mn)
+{
+	assert(out_mat_mn->m == in_mat_mn->n && out_mat_mn->n == in_mat_mn->m);
+	assert(out_mat_mn->data != in_mat_mn->data);
 
-	VecN out_vec_n = vecn_new(arena, num_dims);
-	for (i32 i = 0; i < num_dims; ++i)
+	for (i32 m = 0; m < in_mat_mn->m; ++m)
 	{
-		out_vec_n.data[i] = vecn_dot(&in_mat_n->rows[i], in_vec_n);
+		for (i32 n = 0; n < in_mat_mn->n; ++n)
+		{
+			MATMN_AT(out_mat_mn, n, m) = MATMN_AT(in_mat_mn, m, n);
+		}
 	}
+}
 
-	return out_vec_n;
+MatMN matmn_transpose(Arena* arena, const MatMN* in_mat_mn)
+{
+	MatMN out_mat_mn = matmn_new(arena, in_mat_mn->n, in_mat_mn->m);
+	matmn_transpose_into(in_mat_mn, &out_mat_mn);
+	return out_mat_mn;
 }
 
-MatN matn_mul_matn(Arena* arena, const MatN* in_lhs, const MatN* in_rhs)
+// out_mat_mn = in_lhs * in_rhs. out_mat_mn must be lhs.m x rhs.n and must not alias either input
+// Blocked i-k-j loop: the innermost loop walks contiguous rows of rhs and out, and each tile stays cache resident
+void matmn_mul_matmn_into(const MatMN* in_lhs, const MatMN* in_rhs, MatMN* out_mat_mn)
 {
-	const i32 n = matn_num_dims(in_lhs);
-	assert(n == matn_num_dims(in_rhs));
+	assert(in_lhs->n == in_rhs->m);
+	assert(out_mat_mn->m == in_lhs->m && out_mat_mn->n == in_rhs->n);
+	assert(out_mat_mn->data != in_lhs->data && out_mat_mn->data != in_rhs->data);
+
+	const i32 M = in_lhs->m;
+	const i32 K = in_lhs->n;
+	const i32 N = in_rhs->n;
 
-	MatN out_mat_n = matn_zero(arena, n);
+	matmn_zero_in_place(out_mat_mn);
 
-	for (i32 i = 0; i < n; ++i)
+	for (i32 i_block = 0; i_block < M; i_block += LCP_MATMUL_BLOCK_SIZE)
 	{
-		for (i32 j = 0; j < n; ++j)
+		const i32 i_end = MIN(i_block + LCP_MATMUL_BLOCK_SIZE, M);
+		for (i32 k_block = 0; k_block < K; k_block += LCP_MATMUL_BLOCK_SIZE)
 		{
-			f32 sum = 0.0f;
-			for (i32 k = 0; k < n; ++k)
+			const i32 k_end = MIN(k_block + LCP_MATMUL_BLOCK_SIZE, K);
+			for (i32 j_block = 0; j_block < N; j_block += LCP_MATMUL_BLOCK_SIZE)
 			{
-				sum += in_lhs->rows[i].data[k] * in_rhs->rows[k].data[j];
+				const i32 j_end = MIN(j_block + LCP_MATMUL_BLOCK_SIZE, N);
+				for (i32 i = i_block; i < i_end; ++i)
+				{
+					f32* out_row = &out_mat_mn->data[i * out_mat_mn->stride];
+					for (i32 k = k_block; k < k_end; ++k)
+					{
+						const f32 lhs_ik = MATMN_AT(in_lhs, i, k);
+						if (lhs_ik == 0.0f)
+						{
+							continue;
+						}
+
+						const f32* rhs_row = &in_rhs->data[k * in_rhs->stride];
+						for (i32 j = j_block; j < j_end; ++j)
+						{
+							out_row[j] += lhs_ik * rhs_row[j];
+						}
+					}
+				}
 			}
-			out_mat_n.rows[i].data[j] = sum;
 		}
 	}
+}
 
-	return out_mat_n;
+MatMN matmn_mul_matmn(Arena* arena, const MatMN* in_lhs, const MatMN* in_rhs)
+{
+	assert(in_lhs->n == in_rhs->m);
+
+	MatMN out_mat_mn = matmn_new(arena, in_lhs->m, in_rhs->n);
+	matmn_mul_matmn_into(in_lhs, in_rhs, &out_mat_mn);
+	return out_mat_mn;
 }
 
-// MatMN Functions
+// MatN Functions
 
-MatMN matmn_new(Arena* arena, i32 in_m, i32 in_n)
+// Wraps existing row-major storage with leading dimension in_stride. Does not allocate or clear
+MatN matn_view(f32* in_data, const i32 in_num_elements, const i32 in_stride)
 {
-	MatMN out_mat_mn = {
-		.rows = (VecN*) arena_alloc(arena, in_m * sizeof(VecN)),
-		.m = in_m,
-		.n = in_n,
+	assert(in_stride >= in_num_elements);
+	return (MatN) {
+		.data = in_data,
+		.n = in_num_elements,
+		.stride = in_stride,
 	};
-	assert(out_mat_mn.rows);
+}
 
-	for (i32 i = 0; i < in_m; ++i)
-	{
-		out_mat_mn.rows[i] = vecn_new(arena, in_n);
-	}
+MatN matn_new(Arena* arena, i32 in_num_elements)
+{
+	f32* data = (f32*) arena_alloc(arena, in_num_elements * in_num_elements * sizeof(f32));
+	assert(data);
+	memset(data, 0, in_num_elements * in_num_elements * sizeof(f32));
 
-	return out_mat_mn;
+	return matn_view(data, in_num_elements, in_num_elements);
 }
 
-void matmn_zero_in_place(MatMN* in_mat_mn)
+i32 matn_num_dims(const MatN* in_mat_n)
 {
-	for (i32 i = 0; i < in_mat_mn->m; ++i)
-	{
-		vecn_zero_in_place(&in_mat_mn->rows[i]);
-	}
+	return in_mat_n->n;
 }
 
-MatMN matmn_zero(Arena* arena, i32 in_m, i32 in_n)
+// MatN and MatMN share a layout, so these convert views without copying
+MatMN matmn_from_matn_view(const MatN* in_mat_n)
 {
-	MatMN out_mat_mn = matmn_new(arena, in_m, in_n);
-	matmn_zero_in_place(&out_mat_mn);
-	return out_mat_mn;
+	return matmn_view(in_mat_n->data, in_mat_n->n, in_mat_n->n, in_mat_n->stride);
 }
 
-MatMN matmn_copy(Arena* arena, const MatMN* in_mat_mn)
+MatN matn_from_matmn_view(const MatMN* in_mat_mn)
 {
-	MatMN out_mat_mn = {
-		.rows = (VecN*) arena_alloc(arena, in_mat_mn->m * sizeof(VecN)),
-		.m = in_mat_mn->m,
-		.n = in_mat_mn->n,
-	};
-	assert(out_mat_mn.rows);
+	assert(in_mat_mn->m == in_mat_mn->n); // must be square
+	return matn_view(in_mat_mn->data, in_mat_mn->m, in_mat_mn->stride);
+}
 
-	for (i32 i = 0; i < in_mat_mn->m; ++i)
-	{	
-		out_mat_mn.rows[i] = vecn_copy(arena, &in_mat_mn->rows[i]);
-	}
+VecN matn_row(const MatN* in_mat_n, const i32 in_row)
+{
+	assert(in_row < in_mat_n->n);
+	return vecn_view(&in_mat_n->data[in_row * in_mat_n->stride], in_mat_n->n);
+}
 
-	return out_mat_mn;
+MatN matn_copy(Arena* arena, const MatN* in_mat_n)
+{
+	MatN out_mat_n = matn_new(arena, in_mat_n->n);
+	const MatMN src = matmn_from_matn_view(in_mat_n);
+	MatMN dst = matmn_from_matn_view(&out_mat_n);
+	matmn_copy_into(&src, &dst);
+
+	return out_mat_n;
 }
 
-void matmn_scale_in_place(MatMN* in_mat_mn, const f32 in_scale)
+void matn_zero_in_place(MatN* in_mat_n)
 {
-	for (i32 i = 0; i < in_mat_mn->m; ++i)
-	{
-		vecn_scale_in_place(&in_mat_mn->rows[i], in_scale);
-	}	
+	MatMN as_mat_mn = matmn_from_matn_view(in_mat_n);
+	matmn_zero_in_place(&as_mat_mn);
 }
 
-VecN matmn_mul_vecn(Arena* arena, const MatMN* in_mat_mn, const VecN* in_vec_n)
+MatN matn_zero(Arena* arena, const i32 in_dimensions)
 {
-	if (in_mat_mn->n != vecn_count(in_vec_n))	
-	{
-		assert(false);
-		return vecn_copy(arena, in_vec_n);
-	}
+	return matn_new(arena, in_dimensions);
+}
 
-	VecN out_vec_n = vecn_new(arena, in_mat_mn->m);
-	for (i32 m = 0; m < in_mat_mn->m; ++m)
+void matn_identity(MatN* in_mat_n)
+{
+	matn_zero_in_place(in_mat_n);
+
+	const i32 num_dims = matn_num_dims(in_mat_n);
+	for (i32 i = 0; i < num_dims; ++i)
 	{
-		out_vec_n.data[m] = vecn_dot(in_vec_n, &in_mat_mn->rows[m]);
+		MATN_AT(in_mat_n, i, i) = 1.0f;
 	}
-	return out_vec_n;
 }
 
-MatMN matmn_transpose(Arena* arena, const MatMN* in_mat_mn)
+void matn_transpose_in_place(MatN* in_mat_n)
 {
-	MatMN out_mat_mn = matmn_new(arena, in_mat_mn->n, in_mat_mn->m);
-		
-	for (i32 m = 0; m < in_mat_mn->m; ++m)
+	const i32 num_dimensions = matn_num_dims(in_mat_n);
+	for (i32 i = 0; i < num_dimensions; ++i)
 	{
-		for (i32 n = 0; n < in_mat_mn->n; ++n)
+		for (i32 j = i + 1; j < num_dimensions; ++j)
 		{
-			out_mat_mn.rows[n].data[m] = in_mat_mn->rows[m].data[n];
+			const f32 tmp = MATN_AT(in_mat_n, i, j);
+			MATN_AT(in_mat_n, i, j) = MATN_AT(in_mat_n, j, i);
+			MATN_AT(in_mat_n, j, i) = tmp;
 		}
 	}
+}
 
-	return out_mat_mn;
+void matn_scale_in_place(MatN* in_mat_n, const f32 in_scale)
+{
+	MatMN as_mat_mn = matmn_from_matn_view(in_mat_n);
+	matmn_scale_in_place(&as_mat_mn, in_scale);
 }
 
-MatMN matmn_mul_matmn(Arena* arena, const MatMN* in_lhs, const MatMN* in_rhs)
+void matn_mul_vecn_into(const MatN* in_mat_n, const VecN* in_vec_n, VecN* out_vec_n)
 {
-	assert(in_lhs->n == in_rhs->m);
+	const MatMN as_mat_mn = matmn_from_matn_view(in_mat_n);
+	matmn_mul_vecn_into(&as_mat_mn, in_vec_n, out_vec_n);
+}
 
-	MatMN out_mat_mn = matmn_new(arena, in_lhs->m, in_rhs->n);
+VecN matn_mul_vecn(Arena* arena, const MatN* in_mat_n, const VecN* in_vec_n)
+{
+	const i32 num_dims = matn_num_dims(in_mat_n);
+	assert(num_dims == vecn_count(in_vec_n));
 
-	MatMN transposed_rhs = matmn_transpose(arena, in_rhs);
-	for (i32 m = 0; m < in_lhs->m; ++m)
-	{
-		for (i32 n = 0; n < in_rhs->n; ++n)
-		{
-			out_mat_mn.rows[m].data[n] = vecn_dot(&in_lhs->rows[m], &transposed_rhs.rows[n]);
-		}
-	}
+	VecN out_vec_n = vecn_new(arena, num_dims);
+	matn_mul_vecn_into(in_mat_n, in_vec_n, &out_vec_n);
 
-	return out_mat_mn;
+	return out_vec_n;
+}
+
+void matn_mul_matn_into(const MatN* in_lhs, const MatN* in_rhs, MatN* out_mat_n)
+{
+	const MatMN lhs = matmn_from_matn_view(in_lhs);
+	const MatMN rhs = matmn_from_matn_view(in_rhs);
+	MatMN out = matmn_from_matn_view(out_mat_n);
+	matmn_mul_matmn_into(&lhs, &rhs, &out);
+}
+
+MatN matn_mul_matn(Arena* arena, const MatN* in_lhs, const MatN* in_rhs)
+{
+	const i32 n = matn_num_dims(in_lhs);
+	assert(n == matn_num_dims(in_rhs));
+
+	MatN out_mat_n = matn_new(arena, n);
+	matn_mul_matn_into(in_lhs, in_rhs, &out_mat_n);
+
+	return out_mat_n;
 }
 
 MatN matn_from_matmn(Arena* arena, const MatMN* in_mat_mn)
 {
 	assert(in_mat_mn->m == in_mat_mn->n); // must be square
-	const i32 out_dimensions = in_mat_mn->m;
-	MatN out_mat_n = {
-		.rows = (VecN*) arena_alloc(arena, out_dimensions * sizeof(VecN)),
-		.n = out_dimensions,
-	};
-	assert(out_mat_n.rows);
-
-	for (i32 i = 0; i < out_dimensions; ++i)
-	{
-		out_mat_n.rows[i] = vecn_copy(arena, &in_mat_mn->rows[i]);
-	}
+	MatN out_mat_n = matn_new(arena, in_mat_mn->m);
+	MatMN dst = matmn_from_matn_view(&out_mat_n);
+	matmn_copy_into(in_mat_mn, &dst);
 
 	return out_mat_n;
 }
 
-// Gaussian-Seidel solver
-VecN lcp_gauss_seidel(Arena* arena, const MatN* in_mat_n, const VecN* in_vec_n)
+// ---- Projected Gauss-Seidel ---- //
+
+typedef struct LcpSolveDesc
+{
+	const VecN* lower_bounds;	// Per-row lower clamp on lambda. NULL means unbounded
+	const VecN* upper_bounds;	// Per-row upper clamp on lambda. NULL means unbounded
+	i32 max_iterations;			// Full sweeps over all rows
+	f32 tolerance;				// Stop once the largest change to any lambda in a sweep is <= tolerance
+} LcpSolveDesc;
+
+const LcpSolveDesc lcp_solve_desc_default = {
+	.lower_bounds = NULL,
+	.upper_bounds = NULL,
+	.max_iterations = 10,
+	.tolerance = 1e-4f,
+};
+
+static inline f32 lcp_clamp_lambda(const LcpSolveDesc* in_desc, const i32 in_row, const f32 in_lambda)
+{
+	f32 lambda = in_lambda;
+	if (in_desc->lower_bounds) { lambda = MAX(lambda, in_desc->lower_bounds->data[in_row]); }
+	if (in_desc->upper_bounds) { lambda = MIN(lambda, in_desc->upper_bounds->data[in_row]); }
+	return lambda;
+}
+
+// Solves in_mat_n * lambda = in_vec_n with per-row bounds on lambda, using a dense matrix
+// in_out_lambda is the initial guess (warm start) and receives the result. Returns the number of sweeps performed
+i32 lcp_projected_gauss_seidel(const MatN* in_mat_n, const VecN* in_vec_n, const LcpSolveDesc* in_desc, VecN* in_out_lambda)
 {
 	const i32 n = vecn_count(in_vec_n);
-	VecN out_vec_n = vecn_new(arena, n);
-	vecn_zero_in_place(&out_vec_n);
+	assert(vecn_count(in_out_lambda) == n);
 
-	for (i32 iter = 0; iter < n; ++iter)
+	i32 iteration = 0;
+	while (iteration < in_desc->max_iterations)
 	{
+		++iteration;
+
+		f32 max_delta = 0.0f;
 		for (i32 i = 0; i < n; ++i)
 		{
-			f32 dot_result = vecn_dot(&in_mat_n->rows[i], &out_vec_n);
-			f32 dx = (in_vec_n->data[i] - dot_result) / in_mat_n->rows[i].data[i];
+			const f32* row = &in_mat_n->data[i * in_mat_n->stride];
+			const f32 dot_result = f32_array_dot(row, in_out_lambda->data, n);
+			const f32 dx = (in_vec_n->data[i] - dot_result) / row[i];
 			if (dx * 0.f == dx * 0.f)
 			{
-				out_vec_n.data[i] += dx;
+				const f32 old_lambda = in_out_lambda->data[i];
+				in_out_lambda->data[i] = lcp_clamp_lambda(in_desc, i, old_lambda + dx);
+				max_delta = MAX(max_delta, fabsf(in_out_lambda->data[i] - old_lambda));
 			}
 		}
+
+		if (max_delta <= in_desc->tolerance)
+		{
+			break;
+		}
 	}
 
+	return iteration;
+}
+
+// Block-diagonal inverse mass of one body: a scalar for linear and a 3x3 world-space inverse inertia for angular
+typedef struct LcpBodyInverseMass
+{
+	f32 inverse_mass;
+	Mat3 inverse_inertia;
+} LcpBodyInverseMass;
+
+// Gaussian-Seidel solver. Writes the solution of in_mat_n * x = in_vec_n to out_vec_n
+void lcp_gauss_seidel_into(const MatN* in_mat_n, const VecN* in_vec_n, VecN* out_vec_n)
+{
+	// Unbounded, cold-started, n sweeps with no early exit
+	const LcpSolveDesc desc = {
+		.max_iterations = vecn_count(in_vec_n),
+		.tolerance = -1.0f,
+	};
+	vecn_zero_in_place(out_vec_n);
+	lcp_projected_gauss_seidel(in_mat_n, in_vec_n, &desc, out_vec_n);
+}
+
+VecN lcp_gauss_seidel(Arena* arena, const MatN* in_mat_n, const VecN* in_vec_n)
+{
+	VecN out_vec_n = vecn_new(arena, vecn_count(in_vec_n));
+	lcp_gauss_seidel_into(in_mat_n, in_vec_n, &out_vec_n);
 	return out_vec_n;
 }
@@ -4,5 +4,7 @@
 #include "math/matrix.h"
 #include "math/quat.h"
 #include "math/vec.h"
+#include "math/vec_wide.h"
 #include "math/trs.h"
+#include "math/affine.h"
 #include "math/conversions.h"
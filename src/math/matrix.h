@@ -6,6 +6,7 @@
 #define _USE_MATH_DEFINES
 #include "vec.h"
 #include "quat.h"
+#include "math/simd.h"
 #include <math.h>
 
 typedef struct Mat3
@@ -147,15 +148,29 @@ Mat3 mat3_adjoint(const Mat3 m_in)
     return res;
 }
 
-optional(Mat3) mat3_inverse(Mat3 in_mat)
+// Closed form: each row of the inverse is the cross product of the other two columns, divided by the determinant
+// Inline so the affine inverses below, which call this for their basis, don't pass the matrix through the stack
+static inline optional(Mat3) mat3_inverse(Mat3 in_mat)
 {
     optional(Mat3) out_matrix = {};
 
-    const float determinant = mat3_determinant(in_mat);
+    const Vec3 row_0 = vec3_cross(in_mat.columns[1], in_mat.columns[2]);
+    const Vec3 row_1 = vec3_cross(in_mat.columns[2], in_mat.columns[0]);
+    const Vec3 row_2 = vec3_cross(in_mat.columns[0], in_mat.columns[1]);
+    const float determinant = vec3_dot(in_mat.columns[0], row_0);
     if (determinant != 0.0f)
     {
         const float inverse_determinant = 1.0f / determinant;
-        Mat3 result = mat3_mul_f32(mat3_adjoint(in_mat), inverse_determinant);
+        const Vec3 r0 = vec3_scale(row_0, inverse_determinant);
+        const Vec3 r1 = vec3_scale(row_1, inverse_determinant);
+        const Vec3 r2 = vec3_scale(row_2, inverse_determinant);
+        const Mat3 result = {
+            .d = {
+                r0.x, r1.x, r2.x,
+                r0.y, r1.y, r2.y,
+                r0.z, r1.z, r2.z,
+            },
+        };
         optional_set(out_matrix, result);
     }
 
@@ -267,7 +282,8 @@ static inline void mat4_print(const Mat4 m)
     printf("]\n");
 }
 
-Mat4 mat4_mul_mat4(const Mat4 a, const Mat4 b)
+// Scalar reference implementation. mat4_mul_mat4 uses this when no SIMD backend is available
+Mat4 mat4_mul_mat4_scalar(const Mat4 a, const Mat4 b)
 {
     Mat4 result = {0};
 
@@ -285,7 +301,53 @@ Mat4 mat4_mul_mat4(const Mat4 a, const Mat4 b)
     return result;
 }
 
-Vec4 mat4_mul_vec4(const Mat4 m, const Vec4 v)
+Mat4 mat4_mul_mat4(const Mat4 a, const Mat4 b)
+{
+#if MATH_SIMD_ENABLED
+    // Each result column is a linear combination of b's columns, weighted by the matching column of a
+    Mat4 result;
+
+    const f32x4 b0 = f32x4_load(b.d[0]);
+    const f32x4 b1 = f32x4_load(b.d[1]);
+    const f32x4 b2 = f32x4_load(b.d[2]);
+    const f32x4 b3 = f32x4_load(b.d[3]);
+
+  #if defined(MATH_SIMD_SSE) && defined(__AVX__)
+    // Two result columns per iteration: the low lane holds column col, the high lane holds column col + 1
+    const __m256 b00 = _mm256_insertf128_ps(_mm256_castps128_ps256(b0), b0, 1);
+    const __m256 b11 = _mm256_insertf128_ps(_mm256_castps128_ps256(b1), b1, 1);
+    const __m256 b22 = _mm256_insertf128_ps(_mm256_castps128_ps256(b2), b2, 1);
+    const __m256 b33 = _mm256_insertf128_ps(_mm256_castps128_ps256(b3), b3, 1);
+
+    for (i32 col = 0; col < 4; col += 2)
+    {
+        const __m256 a_cols = _mm256_loadu_ps(a.d[col]);
+        __m256 r = _mm256_mul_ps(_mm256_permute_ps(a_cols, _MM_SHUFFLE(0, 0, 0, 0)), b00);
+        r = _mm256_add_ps(r, _mm256_mul_ps(_mm256_permute_ps(a_cols, _MM_SHUFFLE(1, 1, 1, 1)), b11));
+        r = _mm256_add_ps(r, _mm256_mul_ps(_mm256_permute_ps(a_cols, _MM_SHUFFLE(2, 2, 2, 2)), b22));
+        r = _mm256_add_ps(r, _mm256_mul_ps(_mm256_permute_ps(a_cols, _MM_SHUFFLE(3, 3, 3, 3)), b33));
+        _mm256_storeu_ps(result.d[col], r);
+    }
+  #else
+    for (i32 col = 0; col < 4; ++col)
+    {
+        const f32x4 a_col = f32x4_load(a.d[col]);
+        f32x4 r = f32x4_mul(f32x4_splat_lane(a_col, 0), b0);
+        r = f32x4_madd(f32x4_splat_lane(a_col, 1), b1, r);
+        r = f32x4_madd(f32x4_splat_lane(a_col, 2), b2, r);
+        r = f32x4_madd(f32x4_splat_lane(a_col, 3), b3, r);
+        f32x4_store(result.d[col], r);
+    }
+  #endif
+
+    return result;
+#else
+    return mat4_mul_mat4_scalar(a, b);
+#endif // MATH_SIMD_ENABLED
+}
+
+// Scalar reference implementation. mat4_mul_vec4 uses this when no SIMD backend is available
+Vec4 mat4_mul_vec4_scalar(const Mat4 m, const Vec4 v)
 {
     return (Vec4){
         .x = m.d[0][0] * v.x + m.d[1][0] * v.y + m.d[2][0] * v.z + m.d[3][0] * v.w,
@@ -295,6 +357,22 @@ Vec4 mat4_mul_vec4(const Mat4 m, const Vec4 v)
     };
 }
 
+Vec4 mat4_mul_vec4(const Mat4 m, const Vec4 v)
+{
+#if MATH_SIMD_ENABLED
+    f32x4 r = f32x4_mul(f32x4_load(m.d[0]), f32x4_splat(v.x));
+    r = f32x4_madd(f32x4_load(m.d[1]), f32x4_splat(v.y), r);
+    r = f32x4_madd(f32x4_load(m.d[2]), f32x4_splat(v.z), r);
+    r = f32x4_madd(f32x4_load(m.d[3]), f32x4_splat(v.w), r);
+
+    Vec4 result;
+    f32x4_store(result.v, r);
+    return result;
+#else
+    return mat4_mul_vec4_scalar(m, v);
+#endif // MATH_SIMD_ENABLED
+}
+
 Mat4 mat4_mul_f32(const Mat4 m, const float f)
 {
 	Mat4 result = m;
@@ -435,8 +513,52 @@ Mat4 mat4_adjoint(const Mat4 m_in)
     return res;
 }
 
+// True when the last row is (0, 0, 0, 1), i.e. the matrix is a 3x3 basis plus a translation
+bool mat4_is_affine(const Mat4 in_mat)
+{
+    return in_mat.d[0][3] == 0.0f && in_mat.d[1][3] == 0.0f && in_mat.d[2][3] == 0.0f && in_mat.d[3][3] == 1.0f;
+}
+
+// Inverse of an affine matrix. Only the upper 3x3 needs inverting, and the translation is then -inverse(basis) * translation
+optional(Mat4) mat4_inverse_affine(Mat4 in_mat)
+{
+    assert(mat4_is_affine(in_mat));
+    optional(Mat4) out_matrix = {};
+
+    const Mat3 basis = {
+        .columns = {
+            vec4_xyz(in_mat.columns[0]),
+            vec4_xyz(in_mat.columns[1]),
+            vec4_xyz(in_mat.columns[2]),
+        },
+    };
+    optional(Mat3) inverse_basis = mat3_inverse(basis);
+    if (optional_is_set(inverse_basis))
+    {
+        const Mat3 inverse = optional_get(inverse_basis);
+        const Vec3 translation = vec3_negate(mat3_mul_vec3(inverse, vec4_xyz(in_mat.columns[3])));
+        const Mat4 result = {
+            .columns = {
+                vec4_from_vec3(inverse.columns[0], 0.0f),
+                vec4_from_vec3(inverse.columns[1], 0.0f),
+                vec4_from_vec3(inverse.columns[2], 0.0f),
+                vec4_from_vec3(translation, 1.0f),
+            },
+        };
+        optional_set(out_matrix, result);
+    }
+
+    return out_matrix;
+}
+
 optional(Mat4) mat4_inverse(Mat4 in_mat)
 {
+    // Nearly every matrix we invert is a TRS or rigid transform, which doesn't need the full 4x4 adjoint
+    if (mat4_is_affine(in_mat))
+    {
+        return mat4_inverse_affine(in_mat);
+    }
+
     optional(Mat4) out_matrix = {};
 
     const float determinant = mat4_determinant(in_mat);
@@ -490,7 +612,8 @@ bool mat4_nearly_equal(const Mat4 a, const Mat4 b)
 	return true;
 }
 
-Mat4 mat4_lerp(float t, const Mat4 a, const Mat4 b)
+// Scalar reference implementation. mat4_lerp uses this when no SIMD backend is available
+Mat4 mat4_lerp_scalar(float t, const Mat4 a, const Mat4 b)
 {
 	t = CLAMP(t, 0.0f, 1.0f);
 	Mat4 result = {};
@@ -501,6 +624,69 @@ Mat4 mat4_lerp(float t, const Mat4 a, const Mat4 b)
 	return result;
 }
 
+Mat4 mat4_lerp(float t, const Mat4 a, const Mat4 b)
+{
+#if MATH_SIMD_ENABLED
+	t = CLAMP(t, 0.0f, 1.0f);
+	const f32x4 weight_a = f32x4_splat(1.0f - t);
+	const f32x4 weight_b = f32x4_splat(t);
+
+	Mat4 result;
+	for (i32 col = 0; col < 4; ++col)
+	{
+		const f32x4 r = f32x4_madd(f32x4_load(b.d[col]), weight_b, f32x4_mul(f32x4_load(a.d[col]), weight_a));
+		f32x4_store(result.d[col], r);
+	}
+	return result;
+#else
+	return mat4_lerp_scalar(t, a, b);
+#endif // MATH_SIMD_ENABLED
+}
+
+// Batches smaller than this are written with regular stores. They're cheap to keep in cache, and are often read back soon after
+enum { MAT4_ARRAY_STREAMING_MIN_COUNT = 64 };
+
+// Computes out_results[i] = mat4_lerp(t, in_a[i], in_b[i]) for in_count matrices
+// Large batches into 16-byte aligned out_results are written with streaming stores, as the destination is usually write-once memory (i.e. a mapped GPU buffer)
+void mat4_lerp_array(float t, const Mat4* in_a, const Mat4* in_b, Mat4* out_results, const i32 in_count)
+{
+#if MATH_SIMD_ENABLED
+	t = CLAMP(t, 0.0f, 1.0f);
+	const f32x4 weight_a = f32x4_splat(1.0f - t);
+	const f32x4 weight_b = f32x4_splat(t);
+
+	const bool use_streaming_stores = in_count >= MAT4_ARRAY_STREAMING_MIN_COUNT && ((uintptr_t) out_results & 15) == 0;
+	for (i32 idx = 0; idx < in_count; ++idx)
+	{
+		const f32* a = &in_a[idx].d[0][0];
+		const f32* b = &in_b[idx].d[0][0];
+		f32* out = &out_results[idx].d[0][0];
+		for (i32 offset = 0; offset < 16; offset += 4)
+		{
+			const f32x4 r = f32x4_madd(f32x4_load(b + offset), weight_b, f32x4_mul(f32x4_load(a + offset), weight_a));
+			if (use_streaming_stores)
+			{
+				f32x4_store_stream(out + offset, r);
+			}
+			else
+			{
+				f32x4_store(out + offset, r);
+			}
+		}
+	}
+
+	if (use_streaming_stores)
+	{
+		f32x4_stream_fence();
+	}
+#else
+	for (i32 idx = 0; idx < in_count; ++idx)
+	{
+		out_results[idx] = mat4_lerp_scalar(t, in_a[idx], in_b[idx]);
+	}
+#endif // MATH_SIMD_ENABLED
+}
+
 Mat4 mat3_to_mat4(const Mat3 m)
 {
     return (Mat4) {
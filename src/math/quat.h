@@ -4,6 +4,7 @@
 
 #include "vec.h"
 #include "math/basic_math.h"
+#include "math/simd.h"
 
 typedef struct Quat
 {
@@ -176,7 +177,8 @@ bool quat_nearly_equal(const Quat a, const Quat b)
 		&&	f32_nearly_equal(a.w, b.w);
 }
 
-Vec3 quat_rotate_vec3(const Quat q, const Vec3 v)
+// Scalar reference implementation. quat_rotate_vec3 uses this when no SIMD backend is available
+Vec3 quat_rotate_vec3_scalar(const Quat q, const Vec3 v)
 {
 	const Quat vector_quat = {
 		.x = v.x,
@@ -192,3 +194,20 @@ Vec3 quat_rotate_vec3(const Quat q, const Vec3 v)
 	return vec3_new(result_quat.x, result_quat.y, result_quat.z);
 }
 
+Vec3 quat_rotate_vec3(const Quat q, const Vec3 v)
+{
+#if MATH_SIMD_ENABLED
+	// Expanded form of q * v * q^-1 for unit quaternions: v' = v + w * t + cross(q.xyz, t), where t = 2 * cross(q.xyz, v)
+	const f32x4 q_xyz = f32x4_set(q.x, q.y, q.z, 0.0f);
+	const f32x4 vec = f32x4_set(v.x, v.y, v.z, 0.0f);
+
+	const f32x4 t = f32x4_mul(f32x4_cross3(q_xyz, vec), f32x4_splat(2.0f));
+	const f32x4 r = f32x4_add(f32x4_madd(t, f32x4_splat(q.w), vec), f32x4_cross3(q_xyz, t));
+
+	f32 result[4];
+	f32x4_store(result, r);
+	return vec3_new(result[0], result[1], result[2]);
+#else
+	return quat_rotate_vec3_scalar(q, v);
+#endif // MATH_SIMD_ENABLED
+}
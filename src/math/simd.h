@@ -0,0 +1,228 @@
+#pragma once
+
+#include "basic_types.h"
+
+// ---- SIMD Backend Selection ---- //
+// One backend is picked at compile time. Define MATH_SIMD_DISABLE to force the scalar reference paths.
+//   MATH_SIMD_SSE:  x86/x64 with SSE2 (AVX is used for a few wide paths when compiled with -mavx)
+//   MATH_SIMD_NEON: arm64 (Apple Silicon)
+//   neither:        scalar reference code in vec.h / matrix.h / quat.h
+
+#if !defined(MATH_SIMD_DISABLE) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+	#define MATH_SIMD_SSE 1
+	#include <immintrin.h>
+#elif !defined(MATH_SIMD_DISABLE) && defined(__aarch64__) && defined(__ARM_NEON)
+	#define MATH_SIMD_NEON 1
+	#include <arm_neon.h>
+#endif
+
+#if defined(MATH_SIMD_SSE) || defined(MATH_SIMD_NEON)
+	#define MATH_SIMD_ENABLED 1
+#endif
+
+const char* math_simd_backend_name()
+{
+	#if defined(MATH_SIMD_SSE) && defined(__AVX__)
+	return "SSE+AVX";
+	#elif defined(MATH_SIMD_SSE)
+	return "SSE";
+	#elif defined(MATH_SIMD_NEON)
+	return "NEON";
+	#else
+	return "Scalar";
+	#endif
+}
+
+#if MATH_SIMD_ENABLED
+
+// ---- f32x4: 4 lanes of f32 ---- //
+// All loads and stores are unaligned so they can be used directly on Vec4/Quat/Mat4 unions
+
+#if defined(MATH_SIMD_SSE)
+typedef __m128 f32x4;
+#elif defined(MATH_SIMD_NEON)
+typedef float32x4_t f32x4;
+#endif
+
+static inline f32x4 f32x4_load(const f32* in_ptr)
+{
+	#if defined(MATH_SIMD_SSE)
+	return _mm_loadu_ps(in_ptr);
+	#elif defined(MATH_SIMD_NEON)
+	return vld1q_f32(in_ptr);
+	#endif
+}
+
+static inline void f32x4_store(f32* out_ptr, const f32x4 in_v)
+{
+	#if defined(MATH_SIMD_SSE)
+	_mm_storeu_ps(out_ptr, in_v);
+	#elif defined(MATH_SIMD_NEON)
+	vst1q_f32(out_ptr, in_v);
+	#endif
+}
+
+// Non-temporal store that bypasses the cache. in_ptr must be 16-byte aligned. Call f32x4_stream_fence once a batch of streaming stores is done
+static inline void f32x4_store_stream(f32* out_ptr, const f32x4 in_v)
+{
+	#if defined(MATH_SIMD_SSE)
+	_mm_stream_ps(out_ptr, in_v);
+	#elif defined(MATH_SIMD_NEON)
+	vst1q_f32(out_ptr, in_v);
+	#endif
+}
+
+static inline void f32x4_stream_fence()
+{
+	#if defined(MATH_SIMD_SSE)
+	_mm_sfence();
+	#endif
+}
+
+static inline f32x4 f32x4_set(const f32 x, const f32 y, const f32 z, const f32 w)
+{
+	#if defined(MATH_SIMD_SSE)
+	return _mm_setr_ps(x, y, z, w);
+	#elif defined(MATH_SIMD_NEON)
+	const f32 values[4] = { x, y, z, w };
+	return vld1q_f32(values);
+	#endif
+}
+
+static inline f32x4 f32x4_splat(const f32 in_value)
+{
+	#if defined(MATH_SIMD_SSE)
+	return _mm_set1_ps(in_value);
+	#elif defined(MATH_SIMD_NEON)
+	return vdupq_n_f32(in_value);
+	#endif
+}
+
+static inline f32x4 f32x4_zero()
+{
+	#if defined(MATH_SIMD_SSE)
+	return _mm_setzero_ps();
+	#elif defined(MATH_SIMD_NEON)
+	return vdupq_n_f32(0.0f);
+	#endif
+}
+
+static inline f32x4 f32x4_add(const f32x4 a, const f32x4 b)
+{
+	#if defined(MATH_SIMD_SSE)
+	return _mm_add_ps(a, b);
+	#elif defined(MATH_SIMD_NEON)
+	return vaddq_f32(a, b);
+	#endif
+}
+
+static inline f32x4 f32x4_sub(const f32x4 a, const f32x4 b)
+{
+	#if defined(MATH_SIMD_SSE)
+	return _mm_sub_ps(a, b);
+	#elif defined(MATH_SIMD_NEON)
+	return vsubq_f32(a, b);
+	#endif
+}
+
+static inline f32x4 f32x4_mul(const f32x4 a, const f32x4 b)
+{
+	#if defined(MATH_SIMD_SSE)
+	return _mm_mul_ps(a, b);
+	#elif defined(MATH_SIMD_NEON)
+	return vmulq_f32(a, b);
+	#endif
+}
+
+// Returns (a * b) + c
+static inline f32x4 f32x4_madd(const f32x4 a, const f32x4 b, const f32x4 c)
+{
+	#if defined(MATH_SIMD_SSE) && defined(__FMA__)
+	return _mm_fmadd_ps(a, b, c);
+	#elif defined(MATH_SIMD_SSE)
+	return _mm_add_ps(_mm_mul_ps(a, b), c);
+	#elif defined(MATH_SIMD_NEON)
+	return vfmaq_f32(c, a, b);
+	#endif
+}
+
+static inline f32x4 f32x4_div(const f32x4 a, const f32x4 b)
+{
+	#if defined(MATH_SIMD_SSE)
+	return _mm_div_ps(a, b);
+	#elif defined(MATH_SIMD_NEON)
+	return vdivq_f32(a, b);
+	#endif
+}
+
+static inline f32x4 f32x4_min(const f32x4 a, const f32x4 b)
+{
+	#if defined(MATH_SIMD_SSE)
+	return _mm_min_ps(a, b);
+	#elif defined(MATH_SIMD_NEON)
+	return vminq_f32(a, b);
+	#endif
+}
+
+static inline f32x4 f32x4_max(const f32x4 a, const f32x4 b)
+{
+	#if defined(MATH_SIMD_SSE)
+	return _mm_max_ps(a, b);
+	#elif defined(MATH_SIMD_NEON)
+	return vmaxq_f32(a, b);
+	#endif
+}
+
+// Sum of all 4 lanes
+static inline f32 f32x4_sum(const f32x4 in_v)
+{
+	#if defined(MATH_SIMD_SSE)
+	const f32x4 pairs = _mm_add_ps(in_v, _mm_shuffle_ps(in_v, in_v, _MM_SHUFFLE(2, 3, 0, 1)));
+	return _mm_cvtss_f32(_mm_add_ss(pairs, _mm_movehl_ps(pairs, pairs)));
+	#elif defined(MATH_SIMD_NEON)
+	return vaddvq_f32(in_v);
+	#endif
+}
+
+// Broadcasts lane in_lane of in_v to all 4 lanes. in_lane must be a compile-time constant
+#if defined(MATH_SIMD_SSE)
+	#define f32x4_splat_lane(in_v, in_lane) _mm_shuffle_ps((in_v), (in_v), _MM_SHUFFLE(in_lane, in_lane, in_lane, in_lane))
+#elif defined(MATH_SIMD_NEON)
+	#define f32x4_splat_lane(in_v, in_lane) vdupq_laneq_f32((in_v), (in_lane))
+#endif
+
+// Transposes the 4x4 matrix whose rows are the 4 registers, e.g. to convert 4 AoS elements to SoA and back
+static inline void f32x4_transpose4(f32x4* io_r0, f32x4* io_r1, f32x4* io_r2, f32x4* io_r3)
+{
+	#if defined(MATH_SIMD_SSE)
+	_MM_TRANSPOSE4_PS(*io_r0, *io_r1, *io_r2, *io_r3);
+	#elif defined(MATH_SIMD_NEON)
+	const float32x4x2_t t01 = vtrnq_f32(*io_r0, *io_r1);
+	const float32x4x2_t t23 = vtrnq_f32(*io_r2, *io_r3);
+	*io_r0 = vcombine_f32(vget_low_f32(t01.val[0]), vget_low_f32(t23.val[0]));
+	*io_r1 = vcombine_f32(vget_low_f32(t01.val[1]), vget_low_f32(t23.val[1]));
+	*io_r2 = vcombine_f32(vget_high_f32(t01.val[0]), vget_high_f32(t23.val[0]));
+	*io_r3 = vcombine_f32(vget_high_f32(t01.val[1]), vget_high_f32(t23.val[1]));
+	#endif
+}
+
+// Returns (y, z, x, ?). The w lane is unspecified
+static inline f32x4 f32x4_shuffle_yzx(const f32x4 in_v)
+{
+	#if defined(MATH_SIMD_SSE)
+	return _mm_shuffle_ps(in_v, in_v, _MM_SHUFFLE(3, 0, 2, 1));
+	#elif defined(MATH_SIMD_NEON)
+	const f32x4 yzwx = vextq_f32(in_v, in_v, 1);
+	return vsetq_lane_f32(vgetq_lane_f32(in_v, 0), yzwx, 2);
+	#endif
+}
+
+// 3 component cross product of the xyz lanes. The w lane is unspecified
+static inline f32x4 f32x4_cross3(const f32x4 a, const f32x4 b)
+{
+	const f32x4 a_yzx = f32x4_shuffle_yzx(a);
+	const f32x4 b_yzx = f32x4_shuffle_yzx(b);
+	return f32x4_shuffle_yzx(f32x4_sub(f32x4_mul(a, b_yzx), f32x4_mul(a_yzx, b)));
+}
+
+#endif // MATH_SIMD_ENABLED
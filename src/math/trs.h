@@ -41,10 +41,84 @@ TRS mat4_to_trs(Mat4 in_mat)
 
 Mat4 trs_to_mat4(const TRS trs)
 {
-	return mat4_mul_mat4(
-		mat4_mul_mat4(mat4_scale(trs.scale), quat_to_mat4(trs.rotation)), 
-		mat4_translation(trs.translation)
-	);
+	// Closed form of scale * rotation * translation: rotation columns scaled per-axis, translation in the last column
+	const Mat3 rotation = quat_to_mat3(trs.rotation);
+	const f32 scale[3] = { trs.scale.x, trs.scale.y, trs.scale.z };
+
+	Mat4 result;
+	for (i32 col = 0; col < 3; ++col)
+	{
+		result.d[col][0] = rotation.d[col][0] * scale[col];
+		result.d[col][1] = rotation.d[col][1] * scale[col];
+		result.d[col][2] = rotation.d[col][2] * scale[col];
+		result.d[col][3] = 0.0f;
+	}
+	result.columns[3] = vec4_new(trs.translation.x, trs.translation.y, trs.translation.z, 1.0f);
+	return result;
+}
+
+// Computes out_matrices[i] = trs_to_mat4(in_trs[i]) for in_count transforms
+void trs_to_mat4_array(const TRS* in_trs, Mat4* out_matrices, const i32 in_count)
+{
+	i32 idx = 0;
+
+#if MATH_SIMD_ENABLED
+	// 4 transforms at a time in SoA form: lane i of each register belongs to in_trs[idx + i].
+	// Dividing by the squared length folds the quaternion normalization into the rotation terms
+	for (; idx + 4 <= in_count; idx += 4)
+	{
+		const TRS* trs = in_trs + idx;
+
+		f32x4 x = f32x4_load(&trs[0].rotation.x);
+		f32x4 y = f32x4_load(&trs[1].rotation.x);
+		f32x4 z = f32x4_load(&trs[2].rotation.x);
+		f32x4 w = f32x4_load(&trs[3].rotation.x);
+		f32x4_transpose4(&x, &y, &z, &w);
+
+		const f32x4 length_squared = f32x4_madd(w, w, f32x4_madd(z, z, f32x4_madd(y, y, f32x4_mul(x, x))));
+		const f32x4 s = f32x4_div(f32x4_splat(2.0f), length_squared);
+		const f32x4 xs = f32x4_mul(x, s), ys = f32x4_mul(y, s), zs = f32x4_mul(z, s);
+		const f32x4 xx = f32x4_mul(x, xs), xy = f32x4_mul(x, ys), xz = f32x4_mul(x, zs);
+		const f32x4 yy = f32x4_mul(y, ys), yz = f32x4_mul(y, zs), zz = f32x4_mul(z, zs);
+		const f32x4 wx = f32x4_mul(w, xs), wy = f32x4_mul(w, ys), wz = f32x4_mul(w, zs);
+		const f32x4 one = f32x4_splat(1.0f);
+
+		const f32x4 scale[3] = {
+			f32x4_set(trs[0].scale.x, trs[1].scale.x, trs[2].scale.x, trs[3].scale.x),
+			f32x4_set(trs[0].scale.y, trs[1].scale.y, trs[2].scale.y, trs[3].scale.y),
+			f32x4_set(trs[0].scale.z, trs[1].scale.z, trs[2].scale.z, trs[3].scale.z),
+		};
+		const f32x4 rotation[3][3] = {
+			{ f32x4_sub(one, f32x4_add(yy, zz)), f32x4_add(xy, wz), f32x4_sub(xz, wy) },
+			{ f32x4_sub(xy, wz), f32x4_sub(one, f32x4_add(xx, zz)), f32x4_add(yz, wx) },
+			{ f32x4_add(xz, wy), f32x4_sub(yz, wx), f32x4_sub(one, f32x4_add(xx, yy)) },
+		};
+
+		for (i32 col = 0; col < 3; ++col)
+		{
+			f32x4 c0 = f32x4_mul(rotation[col][0], scale[col]);
+			f32x4 c1 = f32x4_mul(rotation[col][1], scale[col]);
+			f32x4 c2 = f32x4_mul(rotation[col][2], scale[col]);
+			f32x4 c3 = f32x4_zero();
+			f32x4_transpose4(&c0, &c1, &c2, &c3);
+			f32x4_store(out_matrices[idx + 0].d[col], c0);
+			f32x4_store(out_matrices[idx + 1].d[col], c1);
+			f32x4_store(out_matrices[idx + 2].d[col], c2);
+			f32x4_store(out_matrices[idx + 3].d[col], c3);
+		}
+
+		for (i32 lane = 0; lane < 4; ++lane)
+		{
+			const Vec3 translation = trs[lane].translation;
+			out_matrices[idx + lane].columns[3] = vec4_new(translation.x, translation.y, translation.z, 1.0f);
+		}
+	}
+#endif // MATH_SIMD_ENABLED
+
+	for (; idx < in_count; ++idx)
+	{
+		out_matrices[idx] = trs_to_mat4(in_trs[idx]);
+	}
 }
 
 TRS trs_lerp(float t, const TRS a, const TRS b)
@@ -65,7 +65,7 @@ f32 vec2_length_squared(const Vec2 v)
 
 f32 vec2_length(const Vec2 v)
 {
-    return sqrt(vec2_length_squared(v));
+    return sqrtf(vec2_length_squared(v));
 }
 
 Vec2 vec2_normalize(const Vec2 v)
@@ -219,7 +219,7 @@ f32 vec3_length_squared(const Vec3 v)
 
 f32 vec3_length(const Vec3 v)
 {
-    return sqrt(vec3_length_squared(v));
+    return sqrtf(vec3_length_squared(v));
 }
 
 Vec3 vec3_normalize(const Vec3 v)
@@ -352,50 +352,88 @@ Vec4 vec4_from_vec3(const Vec3 v, const f32 w)
     };
 }
 
+// Vec4 fills an f32x4 exactly, so its arithmetic uses the SIMD backend when there is one. Vec3 stays scalar: packed to 12 bytes, it can't be loaded or stored as one register
+
 Vec4 vec4_negate(const Vec4 v)
 {
+#if MATH_SIMD_ENABLED
+    Vec4 result;
+    f32x4_store(result.v, f32x4_sub(f32x4_zero(), f32x4_load(v.v)));
+    return result;
+#else
     return (Vec4){
         .x = -v.x,
         .y = -v.y,
         .z = -v.z,
         .w = -v.w,
     };
+#endif // MATH_SIMD_ENABLED
 }
 
 Vec4 vec4_scale(const Vec4 v, f32 a)
 {
+#if MATH_SIMD_ENABLED
+    Vec4 result;
+    f32x4_store(result.v, f32x4_mul(f32x4_load(v.v), f32x4_splat(a)));
+    return result;
+#else
     return (Vec4){
         .x = v.x * a,
         .y = v.y * a,
         .z = v.z * a,
         .w = v.w * a,
     };
+#endif // MATH_SIMD_ENABLED
 }
 
 Vec4 vec4_add(const Vec4 a, const Vec4 b)
 {
+#if MATH_SIMD_ENABLED
+    Vec4 result;
+    f32x4_store(result.v, f32x4_add(f32x4_load(a.v), f32x4_load(b.v)));
+    return result;
+#else
     return (Vec4){
         .x = a.x + b.x,
         .y = a.y + b.y,
         .z = a.z + b.z,
         .w = a.w + b.w,
     };
+#endif // MATH_SIMD_ENABLED
 }
 
 Vec4 vec4_sub(const Vec4 a, const Vec4 b)
 {
+#if MATH_SIMD_ENABLED
+    Vec4 result;
+    f32x4_store(result.v, f32x4_sub(f32x4_load(a.v), f32x4_load(b.v)));
+    return result;
+#else
     return vec4_add(a, vec4_negate(b));
+#endif // MATH_SIMD_ENABLED
 }
 
 f32 vec4_dot(const Vec4 a, const Vec4 b)
 {
+#if MATH_SIMD_ENABLED
+    return f32x4_sum(f32x4_mul(f32x4_load(a.v), f32x4_load(b.v)));
+#else
     f32 result = a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w;
     return result;
+#endif // MATH_SIMD_ENABLED
 }
 
 Vec4 vec4_lerp(const f32 t, const Vec4 a, const Vec4 b)
 {
+#if MATH_SIMD_ENABLED
+    // a + (b - a) * t
+    const f32x4 a_v = f32x4_load(a.v);
+    Vec4 result;
+    f32x4_store(result.v, f32x4_madd(f32x4_sub(f32x4_load(b.v), a_v), f32x4_splat(t), a_v));
+    return result;
+#else
     return vec4_add(vec4_scale(a, 1.0f - t), vec4_scale(b, t));
+#endif // MATH_SIMD_ENABLED
 }
 
 Vec3 vec4_xyz(const Vec4 v)
@@ -442,22 +480,34 @@ bool vec4_nearly_equal(const Vec4 a, const Vec4 b)
 
 Vec4 vec4_componentwise_min(const Vec4 a, const Vec4 b)
 {
+#if MATH_SIMD_ENABLED
+	Vec4 result;
+	f32x4_store(result.v, f32x4_min(f32x4_load(a.v), f32x4_load(b.v)));
+	return result;
+#else
 	return (Vec4) {
 		.x = a.x < b.x ? a.x : b.x,
 		.y = a.y < b.y ? a.y : b.y,
 		.z = a.z < b.z ? a.z : b.z,
 		.w = a.w < b.w ? a.w : b.w,
 	};
+#endif // MATH_SIMD_ENABLED
 }
 
 Vec4 vec4_componentwise_max(const Vec4 a, const Vec4 b)
 {
+#if MATH_SIMD_ENABLED
+	Vec4 result;
+	f32x4_store(result.v, f32x4_max(f32x4_load(a.v), f32x4_load(b.v)));
+	return result;
+#else
 	return (Vec4) {
 		.x = a.x > b.x ? a.x : b.x,
 		.y = a.y > b.y ? a.y : b.y,
 		.z = a.z > b.z ? a.z : b.z,
 		.w = a.w > b.w ? a.w : b.w,
 	};
+#endif // MATH_SIMD_ENABLED
 }
 
 bool vec4_equals(const Vec4 a, const Vec4 b)
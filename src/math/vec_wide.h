@@ -0,0 +1,467 @@
+#pragma once
+
+#include "basic_types.h"
+#include "math/basic_math.h"
+#include "math/vec.h"
+#include "math/simd.h"
+#include <float.h>
+
+// ---- Wide SoA Vectors ---- //
+// Vec3x4 / Vec3x8 store 4 or 8 Vec3s as separate x, y and z lanes, so "one direction against many points" style queries
+// (support searches, bounds tests, culling) can test 4 or 8 candidates per operation.
+// Lane masks are plain bitmasks (bit i set => lane i), so they behave the same with every SIMD backend.
+// There is no alignment requirement on any of these types.
+
+typedef struct Vec1x4 { f32 v[4]; } Vec1x4;
+typedef struct Vec1x8 { f32 v[8]; } Vec1x8;
+
+typedef struct Vec3x4
+{
+	f32 x[4];
+	f32 y[4];
+	f32 z[4];
+} Vec3x4;
+
+typedef struct Vec3x8
+{
+	f32 x[8];
+	f32 y[8];
+	f32 z[8];
+} Vec3x8;
+
+// ---- Lane Kernels ---- //
+// Shared by the 4 and 8 wide types. in_num_lanes must be a multiple of 4
+
+static inline void lanes_add(const f32* a, const f32* b, f32* out, const i32 in_num_lanes)
+{
+	for (i32 i = 0; i < in_num_lanes; i += 4)
+	{
+	#if MATH_SIMD_ENABLED
+		f32x4_store(out + i, f32x4_add(f32x4_load(a + i), f32x4_load(b + i)));
+	#else
+		for (i32 j = i; j < i + 4; ++j) { out[j] = a[j] + b[j]; }
+	#endif
+	}
+}
+
+static inline void lanes_sub(const f32* a, const f32* b, f32* out, const i32 in_num_lanes)
+{
+	for (i32 i = 0; i < in_num_lanes; i += 4)
+	{
+	#if MATH_SIMD_ENABLED
+		f32x4_store(out + i, f32x4_sub(f32x4_load(a + i), f32x4_load(b + i)));
+	#else
+		for (i32 j = i; j < i + 4; ++j) { out[j] = a[j] - b[j]; }
+	#endif
+	}
+}
+
+static inline void lanes_min(const f32* a, const f32* b, f32* out, const i32 in_num_lanes)
+{
+	for (i32 i = 0; i < in_num_lanes; i += 4)
+	{
+	#if defined(MATH_SIMD_SSE)
+		_mm_storeu_ps(out + i, _mm_min_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+	#elif defined(MATH_SIMD_NEON)
+		vst1q_f32(out + i, vminq_f32(vld1q_f32(a + i), vld1q_f32(b + i)));
+	#else
+		for (i32 j = i; j < i + 4; ++j) { out[j] = MIN(a[j], b[j]); }
+	#endif
+	}
+}
+
+static inline void lanes_max(const f32* a, const f32* b, f32* out, const i32 in_num_lanes)
+{
+	for (i32 i = 0; i < in_num_lanes; i += 4)
+	{
+	#if defined(MATH_SIMD_SSE)
+		_mm_storeu_ps(out + i, _mm_max_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+	#elif defined(MATH_SIMD_NEON)
+		vst1q_f32(out + i, vmaxq_f32(vld1q_f32(a + i), vld1q_f32(b + i)));
+	#else
+		for (i32 j = i; j < i + 4; ++j) { out[j] = MAX(a[j], b[j]); }
+	#endif
+	}
+}
+
+// out = (ax * bx) + (ay * by) + (az * bz)
+static inline void lanes_dot3(
+	const f32* ax, const f32* ay, const f32* az,
+	const f32* bx, const f32* by, const f32* bz,
+	f32* out, const i32 in_num_lanes
+)
+{
+	for (i32 i = 0; i < in_num_lanes; i += 4)
+	{
+	#if MATH_SIMD_ENABLED
+		f32x4 r = f32x4_mul(f32x4_load(ax + i), f32x4_load(bx + i));
+		r = f32x4_madd(f32x4_load(ay + i), f32x4_load(by + i), r);
+		r = f32x4_madd(f32x4_load(az + i), f32x4_load(bz + i), r);
+		f32x4_store(out + i, r);
+	#else
+		for (i32 j = i; j < i + 4; ++j) { out[j] = ax[j] * bx[j] + ay[j] * by[j] + az[j] * bz[j]; }
+	#endif
+	}
+}
+
+// out = (a * b) - (c * d)
+static inline void lanes_mul_sub_mul(const f32* a, const f32* b, const f32* c, const f32* d, f32* out, const i32 in_num_lanes)
+{
+	for (i32 i = 0; i < in_num_lanes; i += 4)
+	{
+	#if MATH_SIMD_ENABLED
+		f32x4_store(out + i, f32x4_sub(f32x4_mul(f32x4_load(a + i), f32x4_load(b + i)), f32x4_mul(f32x4_load(c + i), f32x4_load(d + i))));
+	#else
+		for (i32 j = i; j < i + 4; ++j) { out[j] = a[j] * b[j] - c[j] * d[j]; }
+	#endif
+	}
+}
+
+// Returns a bitmask with bit i set where a[i] > b[i]
+static inline i32 lanes_greater(const f32* a, const f32* b, const i32 in_num_lanes)
+{
+	i32 mask = 0;
+	for (i32 i = 0; i < in_num_lanes; i += 4)
+	{
+	#if defined(MATH_SIMD_SSE)
+		mask |= _mm_movemask_ps(_mm_cmpgt_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i))) << i;
+	#elif defined(MATH_SIMD_NEON)
+		const uint32x4_t lane_bits = { 1, 2, 4, 8 };
+		mask |= (i32) vaddvq_u32(vandq_u32(vcgtq_f32(vld1q_f32(a + i), vld1q_f32(b + i)), lane_bits)) << i;
+	#else
+		for (i32 j = i; j < i + 4; ++j) { mask |= (a[j] > b[j]) << j; }
+	#endif
+	}
+	return mask;
+}
+
+// out[i] = (in_mask bit i) ? a[i] : b[i]
+static inline void lanes_select(const i32 in_mask, const f32* a, const f32* b, f32* out, const i32 in_num_lanes)
+{
+	for (i32 i = 0; i < in_num_lanes; i += 4)
+	{
+	#if defined(MATH_SIMD_SSE)
+		const __m128i lane_bits = _mm_setr_epi32(1, 2, 4, 8);
+		const __m128i bits = _mm_and_si128(_mm_set1_epi32(in_mask >> i), lane_bits);
+		const __m128 select_a = _mm_castsi128_ps(_mm_cmpeq_epi32(bits, lane_bits));
+		const __m128 r = _mm_or_ps(_mm_and_ps(select_a, _mm_loadu_ps(a + i)), _mm_andnot_ps(select_a, _mm_loadu_ps(b + i)));
+		_mm_storeu_ps(out + i, r);
+	#elif defined(MATH_SIMD_NEON)
+		const uint32x4_t lane_bits = { 1, 2, 4, 8 };
+		const uint32x4_t select_a = vtstq_u32(vdupq_n_u32((u32)(in_mask >> i)), lane_bits);
+		vst1q_f32(out + i, vbslq_f32(select_a, vld1q_f32(a + i), vld1q_f32(b + i)));
+	#else
+		for (i32 j = i; j < i + 4; ++j) { out[j] = (in_mask & (1 << j)) ? a[j] : b[j]; }
+	#endif
+	}
+}
+
+// Returns the index of the largest of the first in_num_valid lanes. Ties resolve to the lowest index
+static inline i32 lanes_argmax(const f32* in_values, const i32 in_num_lanes, const i32 in_num_valid)
+{
+	assert(in_num_valid > 0 && in_num_valid <= in_num_lanes);
+
+#if MATH_SIMD_ENABLED
+	if (in_num_valid == in_num_lanes)
+	{
+		// Horizontal max, then find the first lane that matches it
+		f32x4 max_v = f32x4_load(in_values);
+		for (i32 i = 4; i < in_num_lanes; i += 4)
+		{
+		#if defined(MATH_SIMD_SSE)
+			max_v = _mm_max_ps(max_v, _mm_loadu_ps(in_values + i));
+		#elif defined(MATH_SIMD_NEON)
+			max_v = vmaxq_f32(max_v, vld1q_f32(in_values + i));
+		#endif
+		}
+	#if defined(MATH_SIMD_SSE)
+		max_v = _mm_max_ps(max_v, _mm_shuffle_ps(max_v, max_v, _MM_SHUFFLE(2, 3, 0, 1)));
+		max_v = _mm_max_ps(max_v, _mm_shuffle_ps(max_v, max_v, _MM_SHUFFLE(1, 0, 3, 2)));
+		const f32 max_value = _mm_cvtss_f32(max_v);
+	#elif defined(MATH_SIMD_NEON)
+		const f32 max_value = vmaxvq_f32(max_v);
+	#endif
+		for (i32 i = 0; i < in_num_lanes; ++i)
+		{
+			if (in_values[i] == max_value)
+			{
+				return i;
+			}
+		}
+		// Only reachable with NaN lanes, fall through to the scalar search
+	}
+#endif // MATH_SIMD_ENABLED
+
+	i32 max_idx = 0;
+	for (i32 i = 1; i < in_num_valid; ++i)
+	{
+		if (in_values[i] > in_values[max_idx])
+		{
+			max_idx = i;
+		}
+	}
+	return max_idx;
+}
+
+// ---- Vec3x4 ---- //
+
+Vec3x4 vec3x4_splat(const Vec3 in_v)
+{
+	Vec3x4 out;
+	for (i32 i = 0; i < 4; ++i)
+	{
+		out.x[i] = in_v.x;
+		out.y[i] = in_v.y;
+		out.z[i] = in_v.z;
+	}
+	return out;
+}
+
+Vec3 vec3x4_get(const Vec3x4* in_v, const i32 in_lane)
+{
+	return vec3_new(in_v->x[in_lane], in_v->y[in_lane], in_v->z[in_lane]);
+}
+
+void vec3x4_set(Vec3x4* in_v, const i32 in_lane, const Vec3 in_value)
+{
+	in_v->x[in_lane] = in_value.x;
+	in_v->y[in_lane] = in_value.y;
+	in_v->z[in_lane] = in_value.z;
+}
+
+Vec3x4 vec3x4_add(const Vec3x4 a, const Vec3x4 b)
+{
+	Vec3x4 out;
+	lanes_add(a.x, b.x, out.x, 4);
+	lanes_add(a.y, b.y, out.y, 4);
+	lanes_add(a.z, b.z, out.z, 4);
+	return out;
+}
+
+Vec3x4 vec3x4_sub(const Vec3x4 a, const Vec3x4 b)
+{
+	Vec3x4 out;
+	lanes_sub(a.x, b.x, out.x, 4);
+	lanes_sub(a.y, b.y, out.y, 4);
+	lanes_sub(a.z, b.z, out.z, 4);
+	return out;
+}
+
+Vec1x4 vec3x4_dot(const Vec3x4 a, const Vec3x4 b)
+{
+	Vec1x4 out;
+	lanes_dot3(a.x, a.y, a.z, b.x, b.y, b.z, out.v, 4);
+	return out;
+}
+
+Vec3x4 vec3x4_cross(const Vec3x4 a, const Vec3x4 b)
+{
+	Vec3x4 out;
+	lanes_mul_sub_mul(a.y, b.z, a.z, b.y, out.x, 4);
+	lanes_mul_sub_mul(a.z, b.x, a.x, b.z, out.y, 4);
+	lanes_mul_sub_mul(a.x, b.y, a.y, b.x, out.z, 4);
+	return out;
+}
+
+Vec3x4 vec3x4_min(const Vec3x4 a, const Vec3x4 b)
+{
+	Vec3x4 out;
+	lanes_min(a.x, b.x, out.x, 4);
+	lanes_min(a.y, b.y, out.y, 4);
+	lanes_min(a.z, b.z, out.z, 4);
+	return out;
+}
+
+Vec3x4 vec3x4_max(const Vec3x4 a, const Vec3x4 b)
+{
+	Vec3x4 out;
+	lanes_max(a.x, b.x, out.x, 4);
+	lanes_max(a.y, b.y, out.y, 4);
+	lanes_max(a.z, b.z, out.z, 4);
+	return out;
+}
+
+// Lane i comes from a if bit i of in_mask is set, otherwise from b
+Vec3x4 vec3x4_select(const i32 in_mask, const Vec3x4 a, const Vec3x4 b)
+{
+	Vec3x4 out;
+	lanes_select(in_mask, a.x, b.x, out.x, 4);
+	lanes_select(in_mask, a.y, b.y, out.y, 4);
+	lanes_select(in_mask, a.z, b.z, out.z, 4);
+	return out;
+}
+
+// Returns a lane bitmask of a > b
+i32 vec1x4_greater(const Vec1x4 a, const Vec1x4 b)
+{
+	return lanes_greater(a.v, b.v, 4);
+}
+
+// Returns the lane holding the largest of the first in_num_valid values
+i32 vec1x4_argmax(const Vec1x4 in_values, const i32 in_num_valid)
+{
+	return lanes_argmax(in_values.v, 4, in_num_valid);
+}
+
+// ---- Vec3x8 ---- //
+
+Vec3x8 vec3x8_splat(const Vec3 in_v)
+{
+	Vec3x8 out;
+	for (i32 i = 0; i < 8; ++i)
+	{
+		out.x[i] = in_v.x;
+		out.y[i] = in_v.y;
+		out.z[i] = in_v.z;
+	}
+	return out;
+}
+
+Vec3 vec3x8_get(const Vec3x8* in_v, const i32 in_lane)
+{
+	return vec3_new(in_v->x[in_lane], in_v->y[in_lane], in_v->z[in_lane]);
+}
+
+void vec3x8_set(Vec3x8* in_v, const i32 in_lane, const Vec3 in_value)
+{
+	in_v->x[in_lane] = in_value.x;
+	in_v->y[in_lane] = in_value.y;
+	in_v->z[in_lane] = in_value.z;
+}
+
+Vec3x8 vec3x8_add(const Vec3x8 a, const Vec3x8 b)
+{
+	Vec3x8 out;
+	lanes_add(a.x, b.x, out.x, 8);
+	lanes_add(a.y, b.y, out.y, 8);
+	lanes_add(a.z, b.z, out.z, 8);
+	return out;
+}
+
+Vec3x8 vec3x8_sub(const Vec3x8 a, const Vec3x8 b)
+{
+	Vec3x8 out;
+	lanes_sub(a.x, b.x, out.x, 8);
+	lanes_sub(a.y, b.y, out.y, 8);
+	lanes_sub(a.z, b.z, out.z, 8);
+	return out;
+}
+
+Vec1x8 vec3x8_dot(const Vec3x8 a, const Vec3x8 b)
+{
+	Vec1x8 out;
+	lanes_dot3(a.x, a.y, a.z, b.x, b.y, b.z, out.v, 8);
+	return out;
+}
+
+// Dot product of every lane against a single direction
+Vec1x8 vec3x8_dot_vec3(const Vec3x8* in_points, const Vec3 in_dir)
+{
+	const Vec3x8 dir = vec3x8_splat(in_dir);
+	Vec1x8 out;
+	lanes_dot3(in_points->x, in_points->y, in_points->z, dir.x, dir.y, dir.z, out.v, 8);
+	return out;
+}
+
+Vec3x8 vec3x8_cross(const Vec3x8 a, const Vec3x8 b)
+{
+	Vec3x8 out;
+	lanes_mul_sub_mul(a.y, b.z, a.z, b.y, out.x, 8);
+	lanes_mul_sub_mul(a.z, b.x, a.x, b.z, out.y, 8);
+	lanes_mul_sub_mul(a.x, b.y, a.y, b.x, out.z, 8);
+	return out;
+}
+
+Vec3x8 vec3x8_min(const Vec3x8 a, const Vec3x8 b)
+{
+	Vec3x8 out;
+	lanes_min(a.x, b.x, out.x, 8);
+	lanes_min(a.y, b.y, out.y, 8);
+	lanes_min(a.z, b.z, out.z, 8);
+	return out;
+}
+
+Vec3x8 vec3x8_max(const Vec3x8 a, const Vec3x8 b)
+{
+	Vec3x8 out;
+	lanes_max(a.x, b.x, out.x, 8);
+	lanes_max(a.y, b.y, out.y, 8);
+	lanes_max(a.z, b.z, out.z, 8);
+	return out;
+}
+
+// Lane i comes from a if bit i of in_mask is set, otherwise from b
+Vec3x8 vec3x8_select(const i32 in_mask, const Vec3x8 a, const Vec3x8 b)
+{
+	Vec3x8 out;
+	lanes_select(in_mask, a.x, b.x, out.x, 8);
+	lanes_select(in_mask, a.y, b.y, out.y, 8);
+	lanes_select(in_mask, a.z, b.z, out.z, 8);
+	return out;
+}
+
+// Returns a lane bitmask of a > b
+i32 vec1x8_greater(const Vec1x8 a, const Vec1x8 b)
+{
+	return lanes_greater(a.v, b.v, 8);
+}
+
+// Returns the lane holding the largest of the first in_num_valid values
+i32 vec1x8_argmax(const Vec1x8 in_values, const i32 in_num_valid)
+{
+	return lanes_argmax(in_values.v, 8, in_num_valid);
+}
+
+// ---- AoS -> SoA Transpose ---- //
+
+// Number of Vec3x4 / Vec3x8 needed to hold in_num_points points
+i32 vec3x4_count_for(const i32 in_num_points) { return (in_num_points + 3) / 4; }
+i32 vec3x8_count_for(const i32 in_num_points) { return (in_num_points + 7) / 8; }
+
+// Transposes in_num_points Vec3s into out_wide, which must hold vec3x4_count_for(in_num_points) elements
+// Unused trailing lanes repeat the last point, so min/max/argmax over the padded lanes give the same results as over the source points
+void vec3x4_from_aos(const Vec3* in_points, const i32 in_num_points, Vec3x4* out_wide)
+{
+	assert(in_num_points > 0);
+	const i32 num_wide = vec3x4_count_for(in_num_points);
+	for (i32 lane_idx = 0; lane_idx < num_wide * 4; ++lane_idx)
+	{
+		const Vec3 point = in_points[MIN(lane_idx, in_num_points - 1)];
+		vec3x4_set(&out_wide[lane_idx / 4], lane_idx % 4, point);
+	}
+}
+
+// Transposes in_num_points Vec3s into out_wide, which must hold vec3x8_count_for(in_num_points) elements
+// Unused trailing lanes repeat the last point, so min/max/argmax over the padded lanes give the same results as over the source points
+void vec3x8_from_aos(const Vec3* in_points, const i32 in_num_points, Vec3x8* out_wide)
+{
+	assert(in_num_points > 0);
+	const i32 num_wide = vec3x8_count_for(in_num_points);
+	for (i32 lane_idx = 0; lane_idx < num_wide * 8; ++lane_idx)
+	{
+		const Vec3 point = in_points[MIN(lane_idx, in_num_points - 1)];
+		vec3x8_set(&out_wide[lane_idx / 8], lane_idx % 8, point);
+	}
+}
+
+// Returns the index (into the original AoS array) of the point furthest along in_dir. Ties resolve to the lowest index
+i32 vec3x8_array_support_index(const Vec3x8* in_wide_points, const i32 in_num_points, const Vec3 in_dir)
+{
+	assert(in_num_points > 0);
+	const i32 num_wide = vec3x8_count_for(in_num_points);
+
+	i32 best_idx = 0;
+	f32 best_distance = -FLT_MAX;
+	for (i32 wide_idx = 0; wide_idx < num_wide; ++wide_idx)
+	{
+		const Vec1x8 distances = vec3x8_dot_vec3(&in_wide_points[wide_idx], in_dir);
+		const i32 num_valid = MIN(8, in_num_points - wide_idx * 8);
+		const i32 lane = vec1x8_argmax(distances, num_valid);
+		if (distances.v[lane] > best_distance)
+		{
+			best_distance = distances.v[lane];
+			best_idx = wide_idx * 8 + lane;
+		}
+	}
+	return best_idx;
+}
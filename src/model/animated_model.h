@@ -89,7 +89,7 @@ typedef struct NodeAnimData
 	optional(Vec3) translation;
 	optional(Quat) rotation;
 	optional(Vec3) scale;
-	optional(Mat4) cached_transform;
+	optional(Affine3) cached_transform;
 } NodeAnimData;
 
 void anim_data_set(NodeAnimData* anim_data, GltfAnimationPath path, SourceAnimationKeyframe* in_keyframe)
@@ -189,7 +189,7 @@ void anim_data_compute_from_channel(NodeAnimData* anim_data, SourceAnimationChan
 }
 
 // nodes_array and anim_data_array are of length num_nodes 
-Mat4 compute_animated_node_transform(GltfNode* target_node, GltfNode* nodes_array, NodeAnimData* anim_data_array, i32 num_nodes)
+Affine3 compute_animated_node_transform(GltfNode* target_node, GltfNode* nodes_array, NodeAnimData* anim_data_array, i32 num_nodes)
 {
 	const size_t node_index = (target_node - nodes_array);
 	assert(node_index < num_nodes && &nodes_array[node_index] == target_node);
@@ -203,7 +203,7 @@ Mat4 compute_animated_node_transform(GltfNode* target_node, GltfNode* nodes_arra
 	else
 	{
 		// Compute Parent Transform
-		Mat4 parent_transform = mat4_identity;
+		Affine3 parent_transform = affine3_identity;
 		if (target_node->parent)
 		{
 			parent_transform = compute_animated_node_transform(target_node->parent, nodes_array, anim_data_array, num_nodes);
@@ -229,8 +229,8 @@ Mat4 compute_animated_node_transform(GltfNode* target_node, GltfNode* nodes_arra
 			local_transform.translation = optional_get(anim_data->translation);
 		}
 	
-		Mat4 local_transform_matrix = gltf_transform_to_mat4(&local_transform); 
-		Mat4 computed_transform = mat4_mul_mat4(local_transform_matrix, parent_transform); 
+		Affine3 local_transform_affine = gltf_transform_to_affine3(&local_transform); 
+		Affine3 computed_transform = affine3_mul(local_transform_affine, parent_transform); 
 		optional_set(anim_data->cached_transform, computed_transform);
 		return computed_transform;
 	}
@@ -491,8 +491,8 @@ bool animated_model_load(const char* gltf_path, GpuDevice* in_gpu_device, Animat
 			{
 				GltfNode* joint = skin->joints[joint_idx];
 
-				Mat4 global_joint_transform = compute_animated_node_transform(joint, out_model->gltf_asset.nodes, node_anim_data_array, num_gltf_nodes);
-				keyframe->joint_matrices[joint_idx] = global_joint_transform;
+				Affine3 global_joint_transform = compute_animated_node_transform(joint, out_model->gltf_asset.nodes, node_anim_data_array, num_gltf_nodes);
+				keyframe->joint_matrices[joint_idx] = affine3_to_mat4(global_joint_transform);
 			}
 
 			FCS_MEM_FREE(node_anim_data_array);
@@ -595,10 +595,7 @@ void animated_model_update_animation(AnimatedModel* in_model, float in_anim_time
 			const float t = numerator / denominator;
 	
 			// Matrix Lerp. Not ideal but should be acceptable at our sampling rate
-			for (i32 joint_idx = 0; joint_idx < in_model->num_joints; ++joint_idx)
-			{
-				out_joint_matrices[joint_idx] = mat4_lerp(t, keyframe->joint_matrices[joint_idx], next_keyframe->joint_matrices[joint_idx]);
-			}
+			mat4_lerp_array(t, keyframe->joint_matrices, next_keyframe->joint_matrices, out_joint_matrices, in_model->num_joints);
 
 			break;
 		}
@@ -31,17 +31,17 @@ typedef struct StaticModel
     GpuBuffer index_buffer;
 } StaticModel;
 
-Mat4 compute_static_node_transform(GltfNode* target_node, GltfNode* nodes_array, i32 num_nodes)
+Affine3 compute_static_node_transform(GltfNode* target_node, GltfNode* nodes_array, i32 num_nodes)
 {
 	assert(target_node);
 
-	const Mat4 parent_transform = target_node->parent != NULL 
+	const Affine3 parent_transform = target_node->parent != NULL 
 								? compute_static_node_transform(target_node->parent, nodes_array, num_nodes) 
-								: mat4_identity;
+								: affine3_identity;
 
 	const GltfTransform local_transform = target_node->transform;	
-	const Mat4 local_transform_matrix = gltf_transform_to_mat4(&local_transform);
-	const Mat4 computed_transform = mat4_mul_mat4(local_transform_matrix, parent_transform); 
+	const Affine3 local_transform_affine = gltf_transform_to_affine3(&local_transform);
+	const Affine3 computed_transform = affine3_mul(local_transform_affine, parent_transform); 
 	return computed_transform;
 }
 
@@ -91,7 +91,7 @@ bool static_model_load(const char* gltf_path, GpuDevice* in_gpu_device, StaticMo
 		GltfMesh* mesh = current_node->mesh;
         if (mesh)
 		{
-			Mat4 transform = compute_static_node_transform(current_node, out_model->gltf_asset.nodes, out_model->gltf_asset.num_nodes);
+			Affine3 transform = compute_static_node_transform(current_node, out_model->gltf_asset.nodes, out_model->gltf_asset.num_nodes);
 
 			// Flatten all primitives into a single vertex/index array pair
 			for (i32 prim_idx = 0; prim_idx < mesh->num_primitives; ++prim_idx)
@@ -120,13 +120,13 @@ bool static_model_load(const char* gltf_path, GpuDevice* in_gpu_device, StaticMo
 
 					Vec4 position = vec4_new(0,0,0,1);
 					memcpy(&position, positions_buffer, positions_byte_stride);
-					out_model->vertices[out_index].position = mat4_mul_vec4(transform, position);
-					out_model->vertices[out_index].position.w = 1.0f;
+					const Vec3 transformed_position = affine3_transform_point(transform, vec4_xyz(position));
+					out_model->vertices[out_index].position = vec4_new(transformed_position.x, transformed_position.y, transformed_position.z, 1.0f);
 
 					Vec4 normal = vec4_new(0,0,0,0);
 					memcpy(&normal, normals_buffer, normals_byte_stride);
-					out_model->vertices[out_index].normal = mat4_mul_vec4(transform, normal);
-					out_model->vertices[out_index].normal.w = 0.0f;
+					const Vec3 transformed_normal = affine3_transform_vector(transform, vec4_xyz(normal));
+					out_model->vertices[out_index].normal = vec4_new(transformed_normal.x, transformed_normal.y, transformed_normal.z, 0.0f);
 
 					memcpy(&out_model->vertices[out_index].color, (float[4]){0.8f, 0.2f, 0.2f, 1.0f}, sizeof(float) * 4);
 					memcpy(&out_model->vertices[out_index].uv, uvs_buffer, uvs_byte_stride);
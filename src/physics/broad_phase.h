@@ -0,0 +1,948 @@
+#pragma once
+
+#include "basic_types.h"
+#include "stretchy_buffer.h"
+#include "physics/convex_helpers.h"
+#include "physics/pair_map.h"
+#include "task/task.h"
+
+// Pair of body indices whose bounds overlap. Broadphases store idx_a < idx_b
+typedef struct CollisionPair
+{
+	i32 idx_a;
+	i32 idx_b;
+} CollisionPair;
+
+bool collision_pair_equals(CollisionPair* in_lhs, CollisionPair* in_rhs)
+{
+	return	(		(in_lhs->idx_a == in_rhs->idx_a)
+				&&	(in_lhs->idx_b == in_rhs->idx_b))
+		||	(		(in_lhs->idx_a == in_rhs->idx_b)
+				&&	(in_lhs->idx_b == in_rhs->idx_a));
+}
+
+/* ------------------------------------------------ Pair Set ------------------------------------------------ */
+
+// Persistent set of overlapping pairs shared by the broadphases, with the changes from the last update reported as add/remove events
+typedef struct BroadPhasePairSet
+{
+	sbuffer(CollisionPair) pairs;			// All overlapping pairs
+	PairMap pair_indices;					// pair_map_key -> index into pairs
+	sbuffer(CollisionPair) added_pairs;		// Pairs that started overlapping during the last update
+	sbuffer(CollisionPair) removed_pairs;	// Pairs that stopped overlapping during the last update
+} BroadPhasePairSet;
+
+void broad_phase_pair_set_init(BroadPhasePairSet* out_pair_set)
+{
+	*out_pair_set = (BroadPhasePairSet) {};
+	pair_map_init(&out_pair_set->pair_indices);
+}
+
+void broad_phase_pair_set_destroy(BroadPhasePairSet* in_pair_set)
+{
+	sb_free(in_pair_set->pairs);
+	pair_map_free(&in_pair_set->pair_indices);
+	sb_free(in_pair_set->added_pairs);
+	sb_free(in_pair_set->removed_pairs);
+}
+
+// Called at the start of each update so events only cover that update
+void broad_phase_pair_set_clear_events(BroadPhasePairSet* in_pair_set)
+{
+	sb_clear(in_pair_set->added_pairs);
+	sb_clear(in_pair_set->removed_pairs);
+}
+
+void broad_phase_pair_set_add(BroadPhasePairSet* in_pair_set, const i32 in_body_a, const i32 in_body_b)
+{
+	const u64 key = pair_map_key(in_body_a, in_body_b);
+	if (pair_map_insert(&in_pair_set->pair_indices, key, sb_count(in_pair_set->pairs)))
+	{
+		const CollisionPair pair = {
+			.idx_a = MIN(in_body_a, in_body_b),
+			.idx_b = MAX(in_body_a, in_body_b),
+		};
+		sb_push(in_pair_set->pairs, pair);
+		sb_push(in_pair_set->added_pairs, pair);
+	}
+}
+
+void broad_phase_pair_set_remove(BroadPhasePairSet* in_pair_set, const i32 in_body_a, const i32 in_body_b)
+{
+	i32 pair_idx;
+	if (!pair_map_remove(&in_pair_set->pair_indices, pair_map_key(in_body_a, in_body_b), &pair_idx))
+	{
+		return;
+	}
+
+	sb_push(in_pair_set->removed_pairs, in_pair_set->pairs[pair_idx]);
+
+	// Swap the last pair into the hole and point its map entry at the new slot
+	const i32 last_idx = sb_count(in_pair_set->pairs) - 1;
+	if (pair_idx != last_idx)
+	{
+		const CollisionPair moved_pair = in_pair_set->pairs[last_idx];
+		in_pair_set->pairs[pair_idx] = moved_pair;
+		*pair_map_find(&in_pair_set->pair_indices, pair_map_key(moved_pair.idx_a, moved_pair.idx_b)) = pair_idx;
+	}
+	sb_del(in_pair_set->pairs, last_idx);
+}
+
+/* ------------------------------------------------ Sweep and Prune ------------------------------------------------ */
+
+/*
+	Persistent, incremental sweep and prune on all three axes.
+	Endpoint lists stay sorted across updates, so each update is an insertion sort that only does work for endpoints that moved past each other.
+	Every swap of a min past a max is the only way two bodies can start or stop overlapping, so the overlapping pair set is maintained from
+	those swaps alone and changes are reported as add/remove events.
+*/
+
+typedef struct SapEndpoint
+{
+	f32 value;
+	u32 data; // (body index << 1) | is_max
+} SapEndpoint;
+
+static inline SapEndpoint sap_endpoint_new(const i32 in_body_idx, const bool in_is_max)
+{
+	return (SapEndpoint) {
+		.value = 0.0f,
+		.data = ((u32) in_body_idx << 1) | (in_is_max ? 1u : 0u),
+	};
+}
+
+static inline i32 sap_endpoint_body(const SapEndpoint in_endpoint)
+{
+	return (i32) (in_endpoint.data >> 1);
+}
+
+static inline bool sap_endpoint_is_max(const SapEndpoint in_endpoint)
+{
+	return (in_endpoint.data & 1u) != 0;
+}
+
+// Min endpoints sort before max endpoints with the same value, so touching bounds overlap just as they do in bounds_intersect
+static inline bool sap_endpoint_less(const SapEndpoint a, const SapEndpoint b)
+{
+	return a.value < b.value || (a.value == b.value && !sap_endpoint_is_max(a) && sap_endpoint_is_max(b));
+}
+
+typedef struct SweepAndPrune
+{
+	sbuffer(Bounds) bounds;					// Per body, from the last update
+	sbuffer(SapEndpoint) endpoints[3];		// Per axis, sorted by sap_endpoint_less
+	BroadPhasePairSet pair_set;				// Pairs whose bounds overlap
+} SweepAndPrune;
+
+void sweep_and_prune_init(SweepAndPrune* out_sap)
+{
+	*out_sap = (SweepAndPrune) {};
+	broad_phase_pair_set_init(&out_sap->pair_set);
+}
+
+void sweep_and_prune_destroy(SweepAndPrune* in_sap)
+{
+	sb_free(in_sap->bounds);
+	for (i32 axis = 0; axis < 3; ++axis)
+	{
+		sb_free(in_sap->endpoints[axis]);
+	}
+	broad_phase_pair_set_destroy(&in_sap->pair_set);
+}
+
+// Insertion sort of one axis. Emits pair events for every min/max swap
+void sweep_and_prune_sort_axis(SweepAndPrune* in_sap, const i32 in_axis)
+{
+	SapEndpoint* endpoints = in_sap->endpoints[in_axis];
+	const i32 num_endpoints = sb_count(endpoints);
+
+	for (i32 i = 1; i < num_endpoints; ++i)
+	{
+		const SapEndpoint endpoint = endpoints[i];
+		const i32 body = sap_endpoint_body(endpoint);
+		const bool is_max = sap_endpoint_is_max(endpoint);
+
+		i32 j = i;
+		while (j > 0 && sap_endpoint_less(endpoint, endpoints[j - 1]))
+		{
+			const SapEndpoint other = endpoints[j - 1];
+			const i32 other_body = sap_endpoint_body(other);
+			const bool other_is_max = sap_endpoint_is_max(other);
+
+			if (!is_max && other_is_max)
+			{
+				// Min moved below the other body's max: they now overlap on this axis, check the other two
+				if (bounds_intersect(in_sap->bounds[body], in_sap->bounds[other_body]))
+				{
+					broad_phase_pair_set_add(&in_sap->pair_set, body, other_body);
+				}
+			}
+			else if (is_max && !other_is_max)
+			{
+				// Max moved below the other body's min: separated on this axis
+				broad_phase_pair_set_remove(&in_sap->pair_set, body, other_body);
+			}
+
+			endpoints[j] = other;
+			--j;
+		}
+		endpoints[j] = endpoint;
+	}
+}
+
+// Updates body bounds and the overlapping pair set. Bodies are identified by index, and new bodies may be appended between updates
+void sweep_and_prune_update(SweepAndPrune* in_sap, const Bounds* in_bounds, const i32 in_num_bodies)
+{
+	const i32 num_existing_bodies = sb_count(in_sap->bounds);
+	assert(in_num_bodies >= num_existing_bodies);
+
+	broad_phase_pair_set_clear_events(&in_sap->pair_set);
+
+	// New bodies start with both endpoints at the end of each axis, as if they were beyond every other body. Sorting moves them into place
+	for (i32 body_idx = num_existing_bodies; body_idx < in_num_bodies; ++body_idx)
+	{
+		sb_push(in_sap->bounds, in_bounds[body_idx]);
+		for (i32 axis = 0; axis < 3; ++axis)
+		{
+			sb_push(in_sap->endpoints[axis], sap_endpoint_new(body_idx, false));
+			sb_push(in_sap->endpoints[axis], sap_endpoint_new(body_idx, true));
+		}
+	}
+	memcpy(in_sap->bounds, in_bounds, sizeof(Bounds) * in_num_bodies);
+
+	for (i32 axis = 0; axis < 3; ++axis)
+	{
+		SapEndpoint* endpoints = in_sap->endpoints[axis];
+		for (i32 endpoint_idx = 0; endpoint_idx < sb_count(endpoints); ++endpoint_idx)
+		{
+			SapEndpoint* endpoint = &endpoints[endpoint_idx];
+			const Bounds* bounds = &in_sap->bounds[sap_endpoint_body(*endpoint)];
+			endpoint->value = sap_endpoint_is_max(*endpoint) ? bounds->max.v[axis] : bounds->min.v[axis];
+		}
+
+		sweep_and_prune_sort_axis(in_sap, axis);
+	}
+}
+
+/* ------------------------------------------------ Dynamic AABB Tree ------------------------------------------------ */
+
+/*
+	Bounding volume hierarchy with one leaf per body.
+	Leaves store fattened bounds (the body's bounds plus fat_margin on every side), and a body is only reinserted once its bounds leave its fat bounds,
+	so slow or resting bodies cost a containment test per update. Inserts pick a sibling with the surface area heuristic, and every node on the way
+	back up is rebalanced with AVL style rotations so the tree stays shallow however bodies come and go.
+	The pair set holds pairs whose fat bounds overlap, which is a superset of the pairs whose actual bounds overlap.
+*/
+
+enum { AABB_TREE_NULL_NODE = -1 };
+
+typedef struct AabbTreeNode
+{
+	Bounds bounds;		// Fat bounds for leaves, union of children otherwise
+	i32 parent;			// Next free node while on the free list
+	i32 children[2];	// AABB_TREE_NULL_NODE for leaves
+	i32 height;			// 0 for leaves, -1 while on the free list
+	i32 body_idx;		// Leaves only
+} AabbTreeNode;
+
+typedef struct AabbTree
+{
+	sbuffer(AabbTreeNode) nodes;
+	i32 root;
+	i32 free_list;
+	f32 fat_margin;
+	sbuffer(i32) body_leaves;		// Per body, its leaf node
+	sbuffer(i32) moved_bodies;		// Bodies reinserted during the current update
+	sbuffer(i32) query_stack;		// Scratch for traversals
+	sbuffer(i32) query_results;		// Scratch for traversals
+	BroadPhasePairSet pair_set;		// Pairs whose fat bounds overlap
+} AabbTree;
+
+void aabb_tree_init(AabbTree* out_tree)
+{
+	*out_tree = (AabbTree) {
+		.root = AABB_TREE_NULL_NODE,
+		.free_list = AABB_TREE_NULL_NODE,
+		.fat_margin = 0.5f,
+	};
+	broad_phase_pair_set_init(&out_tree->pair_set);
+}
+
+void aabb_tree_destroy(AabbTree* in_tree)
+{
+	sb_free(in_tree->nodes);
+	sb_free(in_tree->body_leaves);
+	sb_free(in_tree->moved_bodies);
+	sb_free(in_tree->query_stack);
+	sb_free(in_tree->query_results);
+	broad_phase_pair_set_destroy(&in_tree->pair_set);
+}
+
+static inline bool aabb_tree_node_is_leaf(const AabbTreeNode* in_node)
+{
+	return in_node->children[0] == AABB_TREE_NULL_NODE;
+}
+
+// May grow nodes, so callers must not hold node pointers across this
+i32 aabb_tree_allocate_node(AabbTree* in_tree)
+{
+	i32 node_idx = in_tree->free_list;
+	if (node_idx != AABB_TREE_NULL_NODE)
+	{
+		in_tree->free_list = in_tree->nodes[node_idx].parent;
+	}
+	else
+	{
+		node_idx = sb_count(in_tree->nodes);
+		sb_push(in_tree->nodes, (AabbTreeNode) {});
+	}
+
+	in_tree->nodes[node_idx] = (AabbTreeNode) {
+		.bounds = bounds_init(),
+		.parent = AABB_TREE_NULL_NODE,
+		.children = { AABB_TREE_NULL_NODE, AABB_TREE_NULL_NODE },
+		.height = 0,
+		.body_idx = -1,
+	};
+	return node_idx;
+}
+
+void aabb_tree_free_node(AabbTree* in_tree, const i32 in_node_idx)
+{
+	in_tree->nodes[in_node_idx].parent = in_tree->free_list;
+	in_tree->nodes[in_node_idx].height = -1;
+	in_tree->free_list = in_node_idx;
+}
+
+// Points whatever referenced in_old_child (a parent's child slot, or the root) at in_new_child
+void aabb_tree_replace_child(AabbTree* in_tree, const i32 in_parent, const i32 in_old_child, const i32 in_new_child)
+{
+	if (in_parent == AABB_TREE_NULL_NODE)
+	{
+		in_tree->root = in_new_child;
+		return;
+	}
+
+	AabbTreeNode* parent = &in_tree->nodes[in_parent];
+	parent->children[parent->children[0] == in_old_child ? 0 : 1] = in_new_child;
+}
+
+// If in_node_idx is unbalanced, rotates its taller child up into its place. Returns the node now at in_node_idx's old position
+i32 aabb_tree_balance(AabbTree* in_tree, const i32 in_node_idx)
+{
+	AabbTreeNode* nodes = in_tree->nodes;
+	AabbTreeNode* node = &nodes[in_node_idx];
+	if (aabb_tree_node_is_leaf(node) || node->height < 2)
+	{
+		return in_node_idx;
+	}
+
+	const i32 balance = nodes[node->children[1]].height - nodes[node->children[0]].height;
+	if (balance >= -1 && balance <= 1)
+	{
+		return in_node_idx;
+	}
+
+	// The taller child is promoted, node takes its place below it, and node keeps the promoted child's shorter child
+	const i32 tall_slot = balance > 1 ? 1 : 0;
+	const i32 tall_idx = node->children[tall_slot];
+	const i32 short_idx = node->children[1 - tall_slot];
+	AabbTreeNode* tall = &nodes[tall_idx];
+
+	const i32 grandchild_a = tall->children[0];
+	const i32 grandchild_b = tall->children[1];
+	const bool a_is_taller = nodes[grandchild_a].height > nodes[grandchild_b].height;
+	const i32 kept_idx = a_is_taller ? grandchild_a : grandchild_b;
+	const i32 moved_idx = a_is_taller ? grandchild_b : grandchild_a;
+
+	tall->parent = node->parent;
+	aabb_tree_replace_child(in_tree, tall->parent, in_node_idx, tall_idx);
+	tall->children[0] = in_node_idx;
+	tall->children[1] = kept_idx;
+	node->parent = tall_idx;
+
+	node->children[tall_slot] = moved_idx;
+	nodes[moved_idx].parent = in_node_idx;
+
+	node->bounds = bounds_union(nodes[short_idx].bounds, nodes[moved_idx].bounds);
+	node->height = 1 + MAX(nodes[short_idx].height, nodes[moved_idx].height);
+	tall->bounds = bounds_union(node->bounds, nodes[kept_idx].bounds);
+	tall->height = 1 + MAX(node->height, nodes[kept_idx].height);
+
+	return tall_idx;
+}
+
+// Rebalances and refits every ancestor from in_node_idx to the root
+void aabb_tree_refit(AabbTree* in_tree, i32 in_node_idx)
+{
+	while (in_node_idx != AABB_TREE_NULL_NODE)
+	{
+		in_node_idx = aabb_tree_balance(in_tree, in_node_idx);
+
+		AabbTreeNode* node = &in_tree->nodes[in_node_idx];
+		const AabbTreeNode* child_a = &in_tree->nodes[node->children[0]];
+		const AabbTreeNode* child_b = &in_tree->nodes[node->children[1]];
+		node->bounds = bounds_union(child_a->bounds, child_b->bounds);
+		node->height = 1 + MAX(child_a->height, child_b->height);
+
+		in_node_idx = node->parent;
+	}
+}
+
+void aabb_tree_insert_leaf(AabbTree* in_tree, const i32 in_leaf_idx)
+{
+	if (in_tree->root == AABB_TREE_NULL_NODE)
+	{
+		in_tree->root = in_leaf_idx;
+		in_tree->nodes[in_leaf_idx].parent = AABB_TREE_NULL_NODE;
+		return;
+	}
+
+	// Descend towards the sibling that minimizes the total surface area added to the tree
+	const Bounds leaf_bounds = in_tree->nodes[in_leaf_idx].bounds;
+	i32 sibling_idx = in_tree->root;
+	while (!aabb_tree_node_is_leaf(&in_tree->nodes[sibling_idx]))
+	{
+		const AabbTreeNode* node = &in_tree->nodes[sibling_idx];
+		const f32 area = bounds_get_surface_area(&node->bounds);
+		const Bounds combined_bounds = bounds_union(node->bounds, leaf_bounds);
+		const f32 combined_area = bounds_get_surface_area(&combined_bounds);
+
+		// Cost of pairing with this node directly, and the area every node below it would inherit if we kept descending
+		const f32 cost_here = 2.0f * combined_area;
+		const f32 inherited_cost = 2.0f * (combined_area - area);
+
+		f32 child_costs[2];
+		for (i32 child_slot = 0; child_slot < 2; ++child_slot)
+		{
+			const AabbTreeNode* child = &in_tree->nodes[node->children[child_slot]];
+			const Bounds child_combined_bounds = bounds_union(child->bounds, leaf_bounds);
+			const f32 child_combined_area = bounds_get_surface_area(&child_combined_bounds);
+			child_costs[child_slot] = inherited_cost + (aabb_tree_node_is_leaf(child)
+				? child_combined_area
+				: child_combined_area - bounds_get_surface_area(&child->bounds));
+		}
+
+		if (cost_here < child_costs[0] && cost_here < child_costs[1])
+		{
+			break;
+		}
+		sibling_idx = node->children[child_costs[0] < child_costs[1] ? 0 : 1];
+	}
+
+	// Replace the sibling with a new parent of the sibling and the leaf
+	const i32 new_parent_idx = aabb_tree_allocate_node(in_tree);
+	AabbTreeNode* sibling = &in_tree->nodes[sibling_idx];
+	AabbTreeNode* new_parent = &in_tree->nodes[new_parent_idx];
+	const i32 old_parent_idx = sibling->parent;
+
+	new_parent->parent = old_parent_idx;
+	new_parent->bounds = bounds_union(sibling->bounds, leaf_bounds);
+	new_parent->height = sibling->height + 1;
+	new_parent->children[0] = sibling_idx;
+	new_parent->children[1] = in_leaf_idx;
+	aabb_tree_replace_child(in_tree, old_parent_idx, sibling_idx, new_parent_idx);
+
+	sibling->parent = new_parent_idx;
+	in_tree->nodes[in_leaf_idx].parent = new_parent_idx;
+
+	aabb_tree_refit(in_tree, old_parent_idx);
+}
+
+void aabb_tree_remove_leaf(AabbTree* in_tree, const i32 in_leaf_idx)
+{
+	if (in_leaf_idx == in_tree->root)
+	{
+		in_tree->root = AABB_TREE_NULL_NODE;
+		return;
+	}
+
+	// The leaf's sibling takes its parent's place
+	const i32 parent_idx = in_tree->nodes[in_leaf_idx].parent;
+	const AabbTreeNode* parent = &in_tree->nodes[parent_idx];
+	const i32 grandparent_idx = parent->parent;
+	const i32 sibling_idx = parent->children[parent->children[0] == in_leaf_idx ? 1 : 0];
+
+	aabb_tree_replace_child(in_tree, grandparent_idx, parent_idx, sibling_idx);
+	in_tree->nodes[sibling_idx].parent = grandparent_idx;
+	aabb_tree_free_node(in_tree, parent_idx);
+
+	aabb_tree_refit(in_tree, grandparent_idx);
+}
+
+// Writes the body index of every leaf whose fat bounds overlap in_bounds to query_results
+void aabb_tree_query(AabbTree* in_tree, const Bounds in_bounds)
+{
+	sb_clear(in_tree->query_results);
+	if (in_tree->root == AABB_TREE_NULL_NODE)
+	{
+		return;
+	}
+
+	sb_clear(in_tree->query_stack);
+	sb_push(in_tree->query_stack, in_tree->root);
+	while (sb_count(in_tree->query_stack) > 0)
+	{
+		const i32 node_idx = in_tree->query_stack[sb_count(in_tree->query_stack) - 1];
+		sb_del(in_tree->query_stack, sb_count(in_tree->query_stack) - 1);
+
+		const AabbTreeNode* node = &in_tree->nodes[node_idx];
+		if (!bounds_intersect(node->bounds, in_bounds))
+		{
+			continue;
+		}
+
+		if (aabb_tree_node_is_leaf(node))
+		{
+			sb_push(in_tree->query_results, node->body_idx);
+		}
+		else
+		{
+			sb_push(in_tree->query_stack, node->children[0]);
+			sb_push(in_tree->query_stack, node->children[1]);
+		}
+	}
+}
+
+// Updates body bounds and the overlapping pair set. Bodies are identified by index, and new bodies may be appended between updates
+void aabb_tree_update(AabbTree* in_tree, const Bounds* in_bounds, const i32 in_num_bodies)
+{
+	const i32 num_existing_bodies = sb_count(in_tree->body_leaves);
+	assert(in_num_bodies >= num_existing_bodies);
+
+	broad_phase_pair_set_clear_events(&in_tree->pair_set);
+	sb_clear(in_tree->moved_bodies);
+
+	// Reinsert bodies that escaped their fat bounds
+	for (i32 body_idx = 0; body_idx < num_existing_bodies; ++body_idx)
+	{
+		const i32 leaf_idx = in_tree->body_leaves[body_idx];
+		if (bounds_contains(in_tree->nodes[leaf_idx].bounds, in_bounds[body_idx]))
+		{
+			continue;
+		}
+
+		aabb_tree_remove_leaf(in_tree, leaf_idx);
+		in_tree->nodes[leaf_idx].bounds = bounds_inflate(in_bounds[body_idx], in_tree->fat_margin);
+		aabb_tree_insert_leaf(in_tree, leaf_idx);
+		sb_push(in_tree->moved_bodies, body_idx);
+	}
+
+	for (i32 body_idx = num_existing_bodies; body_idx < in_num_bodies; ++body_idx)
+	{
+		const i32 leaf_idx = aabb_tree_allocate_node(in_tree);
+		in_tree->nodes[leaf_idx].bounds = bounds_inflate(in_bounds[body_idx], in_tree->fat_margin);
+		in_tree->nodes[leaf_idx].body_idx = body_idx;
+		aabb_tree_insert_leaf(in_tree, leaf_idx);
+		sb_push(in_tree->body_leaves, leaf_idx);
+		sb_push(in_tree->moved_bodies, body_idx);
+	}
+
+	if (sb_count(in_tree->moved_bodies) == 0)
+	{
+		return;
+	}
+
+	// Fat bounds only change on reinsertion, so only pairs involving a moved body can stop overlapping. Walk backwards as removal swaps in the last pair
+	for (i32 pair_idx = sb_count(in_tree->pair_set.pairs) - 1; pair_idx >= 0; --pair_idx)
+	{
+		const CollisionPair pair = in_tree->pair_set.pairs[pair_idx];
+		const Bounds fat_a = in_tree->nodes[in_tree->body_leaves[pair.idx_a]].bounds;
+		const Bounds fat_b = in_tree->nodes[in_tree->body_leaves[pair.idx_b]].bounds;
+		if (!bounds_intersect(fat_a, fat_b))
+		{
+			broad_phase_pair_set_remove(&in_tree->pair_set, pair.idx_a, pair.idx_b);
+		}
+	}
+
+	// Likewise only moved bodies can start new pairs
+	for (i32 moved_idx = 0; moved_idx < sb_count(in_tree->moved_bodies); ++moved_idx)
+	{
+		const i32 body_idx = in_tree->moved_bodies[moved_idx];
+		aabb_tree_query(in_tree, in_tree->nodes[in_tree->body_leaves[body_idx]].bounds);
+		for (i32 result_idx = 0; result_idx < sb_count(in_tree->query_results); ++result_idx)
+		{
+			const i32 other_body_idx = in_tree->query_results[result_idx];
+			if (other_body_idx != body_idx)
+			{
+				broad_phase_pair_set_add(&in_tree->pair_set, body_idx, other_body_idx);
+			}
+		}
+	}
+}
+
+/* ------------------------------------------------ Spatial Hash Grid ------------------------------------------------ */
+
+/*
+	Uniform grid hashed into buckets, rebuilt every update.
+	Bodies are inserted into every cell their bounds touch, and bodies that would touch more than max_cells_per_body cells go in an oversized list
+	that is tested against everything instead. A pair that shares several cells is only reported from the cell containing the max of the two
+	bounds' mins, so each pair is found exactly once. Buckets and oversized bodies are split into contiguous ranges and processed as tasks,
+	each writing its own pair buffers. Buffers are merged in range order, so results don't depend on the number of threads.
+	Works best when bodies are of similar size and cell_size is around their extents.
+*/
+
+enum
+{
+	SPATIAL_HASH_GRID_MIN_BUCKETS = 64,
+	SPATIAL_HASH_GRID_MIN_ENTRIES_PER_JOB = 1024,	// Below this, splitting work across tasks costs more than it saves
+	SPATIAL_HASH_GRID_MAX_CELL_COORD = 1 << 30,		// Cells past this in any axis are treated as oversized
+};
+
+typedef struct SpatialHashEntry
+{
+	i32 cell[3];
+	i32 body_idx;
+	u32 bucket;
+} SpatialHashEntry;
+
+typedef struct SpatialHashGrid SpatialHashGrid;
+
+typedef struct SpatialHashGridJob
+{
+	const SpatialHashGrid* grid;
+	i32 entry_begin;	// Always the first entry of a bucket
+	i32 entry_end;
+	i32 oversized_begin;
+	i32 oversized_end;
+	sbuffer(CollisionPair) cell_pairs;		// Pairs found in this job's buckets, reused across updates
+	sbuffer(CollisionPair) oversized_pairs;	// Pairs found for this job's oversized bodies, reused across updates
+} SpatialHashGridJob;
+
+struct SpatialHashGrid
+{
+	f32 cell_size;							// Can be changed between updates
+	f32 inverse_cell_size;
+	i32 max_cells_per_body;
+	sbuffer(Bounds) bounds;					// Per body, from the last update
+	sbuffer(SpatialHashEntry) entries;		// One per (body, cell), sorted by bucket
+	sbuffer(SpatialHashEntry) scratch_entries;
+	sbuffer(i32) bucket_starts;				// Per bucket, its first entry. Has one extra element holding the entry count
+	sbuffer(i32) oversized_bodies;
+	sbuffer(bool) body_is_oversized;
+	sbuffer(Boundsx8) wide_bounds;			// All bodies, 8 at a time, for testing oversized bodies
+	sbuffer(SpatialHashGridJob) jobs;
+	BroadPhasePairSet pair_set;				// Pairs whose bounds overlap
+};
+
+void spatial_hash_grid_init(SpatialHashGrid* out_grid, const f32 in_cell_size)
+{
+	assert(in_cell_size > 0.0f);
+	*out_grid = (SpatialHashGrid) {
+		.cell_size = in_cell_size,
+		.inverse_cell_size = 1.0f / in_cell_size,
+		.max_cells_per_body = 8,
+	};
+	broad_phase_pair_set_init(&out_grid->pair_set);
+}
+
+void spatial_hash_grid_destroy(SpatialHashGrid* in_grid)
+{
+	sb_free(in_grid->bounds);
+	sb_free(in_grid->entries);
+	sb_free(in_grid->scratch_entries);
+	sb_free(in_grid->bucket_starts);
+	sb_free(in_grid->oversized_bodies);
+	sb_free(in_grid->body_is_oversized);
+	sb_free(in_grid->wide_bounds);
+	for (i32 job_idx = 0; job_idx < sb_count(in_grid->jobs); ++job_idx)
+	{
+		sb_free(in_grid->jobs[job_idx].cell_pairs);
+		sb_free(in_grid->jobs[job_idx].oversized_pairs);
+	}
+	sb_free(in_grid->jobs);
+	broad_phase_pair_set_destroy(&in_grid->pair_set);
+}
+
+// Only valid for values less than SPATIAL_HASH_GRID_MAX_CELL_COORD cells from the origin
+static inline i32 spatial_hash_grid_cell_coord(const SpatialHashGrid* in_grid, const f32 in_value)
+{
+	// Truncate and correct negative values, as floorf is a libm call without SSE4.1 and this is the hottest part of a rebuild
+	const f32 scaled_value = in_value * in_grid->inverse_cell_size;
+	const i32 truncated_value = (i32) scaled_value;
+	return truncated_value - (scaled_value < (f32) truncated_value ? 1 : 0);
+}
+
+static inline u32 spatial_hash_grid_bucket(const i32 in_cell[3], const u32 in_bucket_mask)
+{
+	return (((u32) in_cell[0] * 73856093u) ^ ((u32) in_cell[1] * 19349663u) ^ ((u32) in_cell[2] * 83492791u)) & in_bucket_mask;
+}
+
+// Tests a slice of entries and a slice of oversized bodies. Only reads grid state, so jobs can run concurrently
+void spatial_hash_grid_job_run(void* in_job)
+{
+	SpatialHashGridJob* job = (SpatialHashGridJob*) in_job;
+	const SpatialHashGrid* grid = job->grid;
+	sb_clear(job->cell_pairs);
+	sb_clear(job->oversized_pairs);
+
+	// Entries are sorted by bucket, so walk them directly rather than visiting every bucket, most of which are empty
+	for (i32 i = job->entry_begin; i < job->entry_end; ++i)
+	{
+		const SpatialHashEntry* entry_a = &grid->entries[i];
+		for (i32 j = i + 1; j < job->entry_end && grid->entries[j].bucket == entry_a->bucket; ++j)
+		{
+			// Different cells can hash to the same bucket
+			const SpatialHashEntry* entry_b = &grid->entries[j];
+			if (memcmp(entry_a->cell, entry_b->cell, sizeof(entry_a->cell)) != 0)
+			{
+				continue;
+			}
+
+			const Bounds bounds_a = grid->bounds[entry_a->body_idx];
+			const Bounds bounds_b = grid->bounds[entry_b->body_idx];
+			if (!bounds_intersect(bounds_a, bounds_b))
+			{
+				continue;
+			}
+
+			// Only the cell holding the max of both mins reports the pair
+			const Vec3 overlap_min = vec3_componentwise_max(bounds_a.min, bounds_b.min);
+			if (	spatial_hash_grid_cell_coord(grid, overlap_min.x) != entry_a->cell[0]
+				||	spatial_hash_grid_cell_coord(grid, overlap_min.y) != entry_a->cell[1]
+				||	spatial_hash_grid_cell_coord(grid, overlap_min.z) != entry_a->cell[2])
+			{
+				continue;
+			}
+
+			sb_push(job->cell_pairs, ((CollisionPair) {
+				.idx_a = MIN(entry_a->body_idx, entry_b->body_idx),
+				.idx_b = MAX(entry_a->body_idx, entry_b->body_idx),
+			}));
+		}
+	}
+
+	// Oversized bodies aren't in any cell, so test them against every body
+	const i32 num_bodies = sb_count(grid->bounds);
+	for (i32 oversized_idx = job->oversized_begin; oversized_idx < job->oversized_end; ++oversized_idx)
+	{
+		const i32 body_idx = grid->oversized_bodies[oversized_idx];
+		const Bounds bounds = grid->bounds[body_idx];
+		for (i32 wide_idx = 0; wide_idx < sb_count(grid->wide_bounds); ++wide_idx)
+		{
+			const i32 hit_mask = bounds_x8_intersect(&grid->wide_bounds[wide_idx], bounds);
+			if (hit_mask == 0)
+			{
+				continue;
+			}
+
+			for (i32 lane = 0; lane < 8; ++lane)
+			{
+				const i32 other_body_idx = wide_idx * 8 + lane;
+				if ((hit_mask & (1 << lane)) == 0 || other_body_idx >= num_bodies || other_body_idx == body_idx)
+				{
+					continue;
+				}
+
+				// Pairs of two oversized bodies are only reported by the lower index
+				if (grid->body_is_oversized[other_body_idx] && other_body_idx < body_idx)
+				{
+					continue;
+				}
+
+				sb_push(job->oversized_pairs, ((CollisionPair) {
+					.idx_a = MIN(body_idx, other_body_idx),
+					.idx_b = MAX(body_idx, other_body_idx),
+				}));
+			}
+		}
+	}
+}
+
+// Bins every body into its cells, or the oversized list if it covers too many
+void spatial_hash_grid_build(SpatialHashGrid* in_grid)
+{
+	const i32 num_bodies = sb_count(in_grid->bounds);
+
+	sb_clear(in_grid->scratch_entries);
+	sb_clear(in_grid->oversized_bodies);
+	sb_clear(in_grid->body_is_oversized);
+	(void) sb_add(in_grid->body_is_oversized, num_bodies);
+
+	for (i32 body_idx = 0; body_idx < num_bodies; ++body_idx)
+	{
+		const Bounds* bounds = &in_grid->bounds[body_idx];
+
+		// Huge, infinite or NaN bounds can't be converted to cells without overflowing
+		bool is_oversized = false;
+		for (i32 axis = 0; axis < 3; ++axis)
+		{
+			is_oversized |= !(fabsf(bounds->min.v[axis] * in_grid->inverse_cell_size) < SPATIAL_HASH_GRID_MAX_CELL_COORD);
+			is_oversized |= !(fabsf(bounds->max.v[axis] * in_grid->inverse_cell_size) < SPATIAL_HASH_GRID_MAX_CELL_COORD);
+		}
+
+		i32 cell_min[3] = {};
+		i32 cell_max[3] = {};
+		if (!is_oversized)
+		{
+			// Counted in floating point, as the product of three spans can overflow an i32
+			f32 num_cells = 1.0f;
+			for (i32 axis = 0; axis < 3; ++axis)
+			{
+				cell_min[axis] = spatial_hash_grid_cell_coord(in_grid, bounds->min.v[axis]);
+				cell_max[axis] = spatial_hash_grid_cell_coord(in_grid, bounds->max.v[axis]);
+				num_cells *= (f32) (cell_max[axis] - cell_min[axis] + 1);
+			}
+			is_oversized = num_cells > (f32) in_grid->max_cells_per_body;
+		}
+
+		in_grid->body_is_oversized[body_idx] = is_oversized;
+		if (is_oversized)
+		{
+			sb_push(in_grid->oversized_bodies, body_idx);
+			continue;
+		}
+
+		for (i32 x = cell_min[0]; x <= cell_max[0]; ++x)
+		{
+			for (i32 y = cell_min[1]; y <= cell_max[1]; ++y)
+			{
+				for (i32 z = cell_min[2]; z <= cell_max[2]; ++z)
+				{
+					sb_push(in_grid->scratch_entries, ((SpatialHashEntry) {
+						.cell = { x, y, z },
+						.body_idx = body_idx,
+					}));
+				}
+			}
+		}
+	}
+
+	// Size the table to at least the entry count. Buckets that collide are rare and cheap, as entries are compared by cell before bounds
+	const i32 num_entries = sb_count(in_grid->scratch_entries);
+	i32 num_buckets = SPATIAL_HASH_GRID_MIN_BUCKETS;
+	while (num_buckets < num_entries)
+	{
+		num_buckets *= 2;
+	}
+	const u32 bucket_mask = (u32) (num_buckets - 1);
+
+	// Counting sort of entries by bucket: count, then turn counts into each bucket's end
+	sb_clear(in_grid->bucket_starts);
+	memset(sb_add(in_grid->bucket_starts, num_buckets + 1), 0, sizeof(i32) * (num_buckets + 1));
+	for (i32 entry_idx = 0; entry_idx < num_entries; ++entry_idx)
+	{
+		SpatialHashEntry* entry = &in_grid->scratch_entries[entry_idx];
+		entry->bucket = spatial_hash_grid_bucket(entry->cell, bucket_mask);
+		in_grid->bucket_starts[entry->bucket]++;
+	}
+	for (i32 bucket = 1; bucket <= num_buckets; ++bucket)
+	{
+		in_grid->bucket_starts[bucket] += in_grid->bucket_starts[bucket - 1];
+	}
+
+	// Scatter back to front, decrementing each bucket's end until it's the bucket's start. Keeps entries within a bucket in body order
+	sb_clear(in_grid->entries);
+	(void) sb_add(in_grid->entries, num_entries);
+	for (i32 entry_idx = num_entries - 1; entry_idx >= 0; --entry_idx)
+	{
+		const SpatialHashEntry entry = in_grid->scratch_entries[entry_idx];
+		in_grid->entries[--in_grid->bucket_starts[entry.bucket]] = entry;
+	}
+
+	sb_clear(in_grid->wide_bounds);
+	if (sb_count(in_grid->oversized_bodies) > 0)
+	{
+		for (i32 body_idx = 0; body_idx < num_bodies; body_idx += 8)
+		{
+			sb_push(in_grid->wide_bounds, bounds_x8_from_aos(&in_grid->bounds[body_idx], MIN(8, num_bodies - body_idx)));
+		}
+	}
+}
+
+// Updates body bounds and the overlapping pair set. Bodies are identified by index, and new bodies may be appended between updates
+// If in_task_system is non-null, cells are processed across its threads
+void spatial_hash_grid_update(SpatialHashGrid* in_grid, const Bounds* in_bounds, const i32 in_num_bodies, TaskSystem* in_task_system)
+{
+	assert(in_num_bodies >= sb_count(in_grid->bounds));
+
+	assert(in_grid->cell_size > 0.0f);
+
+	broad_phase_pair_set_clear_events(&in_grid->pair_set);
+
+	in_grid->inverse_cell_size = 1.0f / in_grid->cell_size;
+	sb_clear(in_grid->bounds);
+	memcpy(sb_add(in_grid->bounds, in_num_bodies), in_bounds, sizeof(Bounds) * in_num_bodies);
+
+	spatial_hash_grid_build(in_grid);
+
+	// One job per thread, plus one for this thread, if there's enough work to go around
+	const i32 num_entries = sb_count(in_grid->entries);
+	const i32 max_jobs = in_task_system ? task_system_num_threads(in_task_system) + 1 : 1;
+	const i32 num_jobs = CLAMP(num_entries / SPATIAL_HASH_GRID_MIN_ENTRIES_PER_JOB, 1, max_jobs);
+	while (sb_count(in_grid->jobs) < num_jobs)
+	{
+		sb_push(in_grid->jobs, (SpatialHashGridJob) {});
+	}
+
+	// Split entries evenly, moving each split forward to the next bucket boundary so no bucket spans two jobs
+	const i32 num_oversized = sb_count(in_grid->oversized_bodies);
+	i32 entry_begin = 0;
+	for (i32 job_idx = 0; job_idx < num_jobs; ++job_idx)
+	{
+		i32 entry_end = (i32) (((i64) num_entries * (job_idx + 1)) / num_jobs);
+		while (entry_end < num_entries && entry_end > 0 && in_grid->entries[entry_end].bucket == in_grid->entries[entry_end - 1].bucket)
+		{
+			++entry_end;
+		}
+		entry_end = MAX(entry_end, entry_begin);
+
+		SpatialHashGridJob* job = &in_grid->jobs[job_idx];
+		job->grid = in_grid;
+		job->entry_begin = entry_begin;
+		job->entry_end = entry_end;
+		job->oversized_begin = (num_oversized * job_idx) / num_jobs;
+		job->oversized_end = (num_oversized * (job_idx + 1)) / num_jobs;
+
+		entry_begin = entry_end;
+	}
+
+	if (num_jobs > 1)
+	{
+		sbuffer(Task*) tasks = NULL;
+		for (i32 job_idx = 1; job_idx < num_jobs; ++job_idx)
+		{
+			sb_push(tasks, task_system_add_task(in_task_system, &(TaskDesc) {
+				.task_function = spatial_hash_grid_job_run,
+				.argument = &in_grid->jobs[job_idx],
+			}));
+		}
+		spatial_hash_grid_job_run(&in_grid->jobs[0]);
+		task_system_wait_tasks(in_task_system, tasks);
+	}
+	else
+	{
+		spatial_hash_grid_job_run(&in_grid->jobs[0]);
+	}
+
+	// Merge cell pairs then oversized pairs, each in job order, which is the order a single job would find them in
+	// Each pair is found exactly once, so any pairs beyond that count are stale
+	i32 num_found_pairs = 0;
+	for (i32 pass = 0; pass < 2; ++pass)
+	{
+		for (i32 job_idx = 0; job_idx < num_jobs; ++job_idx)
+		{
+			const SpatialHashGridJob* job = &in_grid->jobs[job_idx];
+			const CollisionPair* job_pairs = pass == 0 ? job->cell_pairs : job->oversized_pairs;
+			const i32 num_job_pairs = pass == 0 ? sb_count(job->cell_pairs) : sb_count(job->oversized_pairs);
+			for (i32 pair_idx = 0; pair_idx < num_job_pairs; ++pair_idx)
+			{
+				broad_phase_pair_set_add(&in_grid->pair_set, job_pairs[pair_idx].idx_a, job_pairs[pair_idx].idx_b);
+			}
+			num_found_pairs += num_job_pairs;
+		}
+	}
+
+	if (sb_count(in_grid->pair_set.pairs) > num_found_pairs)
+	{
+		// Walk backwards as removal swaps in the last pair
+		for (i32 pair_idx = sb_count(in_grid->pair_set.pairs) - 1; pair_idx >= 0; --pair_idx)
+		{
+			const CollisionPair pair = in_grid->pair_set.pairs[pair_idx];
+			if (!bounds_intersect(in_grid->bounds[pair.idx_a], in_grid->bounds[pair.idx_b]))
+			{
+				broad_phase_pair_set_remove(&in_grid->pair_set, pair.idx_a, pair.idx_b);
+			}
+		}
+	}
+}
@@ -244,12 +244,12 @@ void physics_body_render_data_create(
 	sbuffer(StaticVertex) vertices = NULL;
 	sbuffer(u32) indices = NULL;
 
-	switch(in_body->shape.type)
+	switch(in_body->shape->type)
 	{
 		case SHAPE_TYPE_SPHERE:
 		{
 			//FCS TODO: 1 UV Sphere	
-			append_uv_sphere(vec3_zero, in_body->shape.sphere.radius, 12, 12, &vertices, &indices);
+			append_uv_sphere(vec3_zero, in_body->shape->sphere.radius, 12, 12, &vertices, &indices);
 			break;
 		}
 		//case SHAPE_TYPE_CAPSULE:
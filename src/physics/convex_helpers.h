@@ -1,5 +1,7 @@
 #pragma once
 
+#include <string.h>
+
 #include "basic_types.h"
 #include "math/math_lib.h"
 
@@ -58,12 +60,84 @@ void bounds_expand_points(Bounds* in_bounds, const Vec3* in_points, const i32 in
 	}	
 }
 
+// 8 Bounds in SoA form, so one bounds can be tested against 8 others at once
+typedef struct Boundsx8
+{
+	Vec3x8 min;
+	Vec3x8 max;
+} Boundsx8;
+
+// Transposes up to 8 Bounds. Unused lanes hold empty bounds, which never intersect anything
+Boundsx8 bounds_x8_from_aos(const Bounds* in_bounds, const i32 in_num_bounds)
+{
+	assert(in_num_bounds <= 8);
+	const Bounds empty_bounds = bounds_init();
+
+	Boundsx8 out_bounds;
+	for (i32 lane = 0; lane < 8; ++lane)
+	{
+		const Bounds* bounds = lane < in_num_bounds ? &in_bounds[lane] : &empty_bounds;
+		vec3x8_set(&out_bounds.min, lane, bounds->min);
+		vec3x8_set(&out_bounds.max, lane, bounds->max);
+	}
+	return out_bounds;
+}
+
+// Returns a lane bitmask of which of in_wide_bounds intersect in_bounds. Matches bounds_intersect per lane
+i32 bounds_x8_intersect(const Boundsx8* in_wide_bounds, const Bounds in_bounds)
+{
+	const Vec3x8 other_min = vec3x8_splat(in_bounds.min);
+	const Vec3x8 other_max = vec3x8_splat(in_bounds.max);
+
+	// A lane is separated if it starts past other's max or ends before other's min on any axis
+	i32 separated_mask = 0;
+	separated_mask |= lanes_greater(in_wide_bounds->min.x, other_max.x, 8);
+	separated_mask |= lanes_greater(in_wide_bounds->min.y, other_max.y, 8);
+	separated_mask |= lanes_greater(in_wide_bounds->min.z, other_max.z, 8);
+	separated_mask |= lanes_greater(other_min.x, in_wide_bounds->max.x, 8);
+	separated_mask |= lanes_greater(other_min.y, in_wide_bounds->max.y, 8);
+	separated_mask |= lanes_greater(other_min.z, in_wide_bounds->max.z, 8);
+
+	return ~separated_mask & 0xFF;
+}
+
 void bounds_expand_bounds(Bounds* in_bounds, const Bounds* in_other_bounds)
 {
 	bounds_expand_point(in_bounds, in_other_bounds->min);
 	bounds_expand_point(in_bounds, in_other_bounds->max);
 }
 
+Bounds bounds_union(const Bounds a, const Bounds b)
+{
+	return (Bounds) {
+		.min = vec3_componentwise_min(a.min, b.min),
+		.max = vec3_componentwise_max(a.max, b.max),
+	};
+}
+
+// True if in_inner lies entirely within in_outer
+bool bounds_contains(const Bounds in_outer, const Bounds in_inner)
+{
+	return	in_outer.min.x <= in_inner.min.x && in_outer.min.y <= in_inner.min.y && in_outer.min.z <= in_inner.min.z
+		&&	in_outer.max.x >= in_inner.max.x && in_outer.max.y >= in_inner.max.y && in_outer.max.z >= in_inner.max.z;
+}
+
+// Grows in_bounds by in_margin on every side
+Bounds bounds_inflate(const Bounds in_bounds, const f32 in_margin)
+{
+	const Vec3 margin = vec3_new(in_margin, in_margin, in_margin);
+	return (Bounds) {
+		.min = vec3_sub(in_bounds.min, margin),
+		.max = vec3_add(in_bounds.max, margin),
+	};
+}
+
+f32 bounds_get_surface_area(const Bounds* in_bounds)
+{
+	const Vec3 extents = bounds_get_extents(in_bounds);
+	return 2.0f * (extents.x * extents.y + extents.y * extents.z + extents.z * extents.x);
+}
+
 /* ------------------------------------------------ Convex Helpers ------------------------------------------------ */
 
 i32 furthest_point_in_dir(const Vec3* in_points, const i32 in_num_points, const Vec3 in_dir)
@@ -98,7 +172,7 @@ f32 distance_from_line(const Vec3 in_a, const Vec3 in_b, const Vec3 in_pt)
 	return vec3_length(perpendicular);
 }
 
-Vec3 furthest_point_from_line(const Vec3* in_points, const i32 in_num_points, const Vec3 in_a, const Vec3 in_b)
+i32 furthest_point_from_line(const Vec3* in_points, const i32 in_num_points, const Vec3 in_a, const Vec3 in_b)
 {
 	assert(in_num_points > 0);
 
@@ -113,7 +187,7 @@ Vec3 furthest_point_from_line(const Vec3* in_points, const i32 in_num_points, co
 			max_dist = current_dist;
 		}
 	}
-	return in_points[max_idx];
+	return max_idx;
 }
 
 f32 distance_from_triangle(const Vec3 in_a, const Vec3 in_b, const Vec3 in_c, const Vec3 in_pt)
@@ -130,7 +204,7 @@ f32 distance_from_triangle(const Vec3 in_a, const Vec3 in_b, const Vec3 in_c, co
 	return dist;
 }
 
-Vec3 furthest_point_from_triangle(const Vec3* in_points, const i32 in_num_points, const Vec3 in_a, const Vec3 in_b, const Vec3 in_c)
+i32 furthest_point_from_triangle(const Vec3* in_points, const i32 in_num_points, const Vec3 in_a, const Vec3 in_b, const Vec3 in_c)
 {
 	assert(in_num_points > 0);
 
@@ -147,7 +221,7 @@ Vec3 furthest_point_from_triangle(const Vec3* in_points, const i32 in_num_points
 			max_dist_squared = current_dist_squared;
 		}
 	}
-	return in_points[max_idx];
+	return max_idx;
 }
 
 /* ------------------------------------------------ Convex Hull ------------------------------------------------ */
@@ -165,503 +239,448 @@ typedef struct ConvexHull
 	sbuffer(ConvexTri) tris;
 } ConvexHull;
 
-ConvexHull convex_hull_build_tetrahedron(const Vec3* in_points, const i32 in_num_points)
-{
-	Vec3 points[4];
+/* ------------------------------------------------ Quickhull ------------------------------------------------ */
 
-	// Point 0: furthest point in arbitrary direction
-	const i32 idx_0 = furthest_point_in_dir(in_points, in_num_points, vec3_new(1,0,0));
-	points[0] = in_points[idx_0];
+// Hulls are built with Quickhull on a half-edge mesh. Every point outside the hull sits on the conflict list of one face it's outside of,
+// so adding a point only touches the faces it can see and the points those faces held, rather than the whole hull and every remaining point
 
-	// Point 1: furthest point in direction opposite point[0]
-	const i32 idx_1 = furthest_point_in_dir(in_points, in_num_points, vec3_scale(points[0], -1.0f));
-	points[1] = in_points[idx_1];
-
-	// Point 2: furthest point from line formed by previous points 
-	points[2] = furthest_point_from_line(in_points, in_num_points, points[0], points[1]);
+typedef struct QuickhullHalfEdge
+{
+	i32 vertex;	// Point the edge starts at
+	i32 twin;	// The same edge, running the other way on the neighboring face
+	i32 next;	// Next edge counterclockwise around the face
+	i32 face;
+} QuickhullHalfEdge;
 
-	// Point 3: furthest point from triangle formed by previous points
-	points[3] = furthest_point_from_triangle(in_points, in_num_points, points[0], points[1], points[2]);
+typedef struct QuickhullFace
+{
+	i32 edge;			// Any of the face's three half-edges
+	Vec3 normal;		// Unit length, pointing out of the hull
+	f32 distance;		// A point's height above the face is dot(normal, point) - distance
+	i32 conflict_head;	// First point outside this face, continued through Quickhull.conflict_next. -1 when there are none
+	i32 visit_stamp;	// Matches Quickhull.visit_stamp once the current point has checked this face
+	bool is_visible;	// The current point is outside this face. Only meaningful with a matching visit_stamp
+	bool is_alive;		// Faces the hull has grown past stay in the mesh, but aren't part of it
+} QuickhullFace;
+
+typedef struct Quickhull
+{
+	const Vec3* points;
+	i32 num_points;
+	f32 epsilon;	// Points closer than this to a face's plane are treated as on it
+
+	sbuffer(QuickhullHalfEdge) edges;
+	sbuffer(QuickhullFace) faces;
+	sbuffer(i32) conflict_next;	// Per point
+
+	// Scratch reused by each point added
+	i32 visit_stamp;
+	sbuffer(i32) face_stack;
+	sbuffer(i32) visible_faces;
+	sbuffer(i32) horizon_edges;
+	sbuffer(i32) orphaned_points;
+	sbuffer(i32) new_faces;
+	sbuffer(i32) edge_from_eye;	// Per point. New edge running from the added point to this one, or -1
+	sbuffer(i32) edge_to_eye;	// Per point. New edge running from this point to the added one, or -1
+} Quickhull;
+
+static inline f32 quickhull_point_height(const Quickhull* in_quickhull, const i32 in_face_idx, const i32 in_point_idx)
+{
+	const QuickhullFace* face = &in_quickhull->faces[in_face_idx];
+	return vec3_dot(face->normal, in_quickhull->points[in_point_idx]) - face->distance;
+}
 
-	// Ensure CCW
-	if (distance_from_triangle(points[0], points[1], points[2], points[3]) > 0.f)
+// Adds the face a, b, c, counterclockwise seen from outside the hull. Its edges' twins are left for the caller to link
+static inline i32 quickhull_add_face(Quickhull* in_quickhull, const i32 in_a, const i32 in_b, const i32 in_c)
+{
+	const i32 face_idx = sb_count(in_quickhull->faces);
+	const i32 first_edge_idx = sb_count(in_quickhull->edges);
+	const i32 vertices[3] = { in_a, in_b, in_c };
+	for (i32 i = 0; i < 3; ++i)
 	{
-		SWAP(Vec3, points[0], points[1]);
+		sb_push(in_quickhull->edges, ((QuickhullHalfEdge) {
+			.vertex = vertices[i],
+			.twin = -1,
+			.next = first_edge_idx + (i + 1) % 3,
+			.face = face_idx,
+		}));
 	}
 
-	// Build up convex hull
-	ConvexHull out_hull = {
-		.points = NULL,
-		.tris = NULL,
-	};
-
-	// Add points
-	sb_push(out_hull.points, points[0]);
-	sb_push(out_hull.points, points[1]);
-	sb_push(out_hull.points, points[2]);
-	sb_push(out_hull.points, points[3]);
-
-	// Add tris
-	sb_push(out_hull.tris, ((ConvexTri) {
-		.a = 0,
-		.b = 1,
-		.c = 2,
-	}));
-	sb_push(out_hull.tris, ((ConvexTri) {
-		.a = 0,
-		.b = 2,
-		.c = 3,
+	const Vec3 a = in_quickhull->points[in_a];
+	const Vec3 normal = vec3_normalize(vec3_cross(vec3_sub(in_quickhull->points[in_b], a), vec3_sub(in_quickhull->points[in_c], a)));
+	sb_push(in_quickhull->faces, ((QuickhullFace) {
+		.edge = first_edge_idx,
+		.normal = normal,
+		.distance = vec3_dot(normal, a),
+		.conflict_head = -1,
+		.visit_stamp = 0,
+		.is_visible = false,
+		.is_alive = true,
 	}));
-	sb_push(out_hull.tris, ((ConvexTri) {
-		.a = 2,
-		.b = 1,
-		.c = 3,
-	}));
-	sb_push(out_hull.tris, ((ConvexTri) {
-		.a = 1,
-		.b = 0,
-		.c = 3,
-	}));
-
-	return out_hull;
+	return face_idx;
 }
 
-void convex_hull_remove_internal_points(ConvexHull* in_convex_hull, sbuffer(Vec3)* in_points)
+// Puts the point on the conflict list of whichever of in_face_indices it's furthest outside. Points inside all of them are dropped
+static inline void quickhull_assign_point(Quickhull* in_quickhull, const i32 in_point_idx, const i32* in_face_indices, const i32 in_num_faces)
 {
-	// Remove internal points
-	for (i32 i = 0; i < sb_count(*in_points); ++i)
+	i32 best_face_idx = -1;
+	f32 best_height = in_quickhull->epsilon;
+	for (i32 i = 0; i < in_num_faces; ++i)
 	{
-		const Vec3 point = (*in_points)[i];
-		bool is_external = false;
-		for (int t = 0; t < sb_count(in_convex_hull->tris); ++t)
+		const f32 height = quickhull_point_height(in_quickhull, in_face_indices[i], in_point_idx);
+		if (height > best_height)
 		{
-			const ConvexTri* tri = &in_convex_hull->tris[t];
-			const Vec3 a = in_convex_hull->points[tri->a];
-			const Vec3 b = in_convex_hull->points[tri->b];
-			const Vec3 c = in_convex_hull->points[tri->c];
-
-			if(distance_from_triangle(a,b,c, point) > 0.f)
-			{
-				is_external = true;
-				break;
-			}
-		}
-
-		if (!is_external)
-		{
-			sb_del(*in_points, i);
-			i -= 1;
+			best_height = height;
+			best_face_idx = in_face_indices[i];
 		}
 	}
 
-	// Remove points too close too hull points
-	for (i32 i = 0; i < sb_count(*in_points); ++i)
+	if (best_face_idx >= 0)
 	{
-		const Vec3 point = (*in_points)[i];
-		bool is_too_close = false;
-		for (i32 hull_pt_idx = 0; hull_pt_idx < sb_count(in_convex_hull->points); ++hull_pt_idx)
-		{
-			const Vec3 hull_point = in_convex_hull->points[hull_pt_idx];
-			const Vec3 ray = vec3_sub(hull_point, point);
-			if (vec3_length_squared(ray)  < (0.01f * 0.01f))
-			{
-				is_too_close = true;
-				break;
-			}
-		}
-
-		if (is_too_close)
-		{	
-			sb_del(*in_points, i);
-			i -= 1;
-		}
+		QuickhullFace* face = &in_quickhull->faces[best_face_idx];
+		in_quickhull->conflict_next[in_point_idx] = face->conflict_head;
+		face->conflict_head = in_point_idx;
 	}
 }
 
-typedef struct ConvexEdge
+// Starts the hull with a tetrahedron spanning the points as widely as the extreme points along a few directions allow
+static inline void quickhull_build_tetrahedron(Quickhull* in_quickhull)
 {
-	i32 a;
-	i32 b;
-} ConvexEdge;
+	const Vec3* points = in_quickhull->points;
+	const i32 num_points = in_quickhull->num_points;
 
-bool convex_edge_equals(const ConvexEdge lhs, const ConvexEdge rhs)
-{
-	return	(lhs.a == rhs.a && lhs.b == rhs.b) 
-		||	(lhs.a == rhs.b && lhs.b == rhs.a);
-}
+	i32 indices[4];
+	indices[0] = furthest_point_in_dir(points, num_points, vec3_new(1,0,0));
+	indices[1] = furthest_point_in_dir(points, num_points, vec3_scale(points[indices[0]], -1.0f));
+	indices[2] = furthest_point_from_line(points, num_points, points[indices[0]], points[indices[1]]);
+	indices[3] = furthest_point_from_triangle(points, num_points, points[indices[0]], points[indices[1]], points[indices[2]]);
 
-bool is_edge_unique(sbuffer(ConvexTri) in_tris, sbuffer(i32) in_facing_tri_idices, i32 in_ignore_tri, const ConvexEdge in_edge)
-{
-	for (i32 i = 0; i < sb_count(in_facing_tri_idices); ++i)
+	// Ensure CCW
+	if (distance_from_triangle(points[indices[0]], points[indices[1]], points[indices[2]], points[indices[3]]) > 0.f)
 	{
-		const i32 tri_idx = in_facing_tri_idices[i];
-		if (tri_idx == in_ignore_tri)
-		{
-			continue;
-		}
+		SWAP(i32, indices[0], indices[1]);
+	}
 
-		const ConvexTri tri = in_tris[tri_idx];
-		ConvexEdge edges[3] = {
-			{
-				.a = tri.a,
-				.b = tri.b,
-			},
-			{
-				.a = tri.b,
-				.b = tri.c,
-			},
-			{
-				.a = tri.c,
-				.b = tri.a,
-			},
-		};
+	const i32 face_vertices[4][3] = {
+		{ 0, 1, 2 },
+		{ 0, 2, 3 },
+		{ 2, 1, 3 },
+		{ 1, 0, 3 },
+	};
+	for (i32 face_idx = 0; face_idx < 4; ++face_idx)
+	{
+		quickhull_add_face(in_quickhull, indices[face_vertices[face_idx][0]], indices[face_vertices[face_idx][1]], indices[face_vertices[face_idx][2]]);
+	}
 
-		for (i32 e = 0; e < ARRAY_COUNT(edges); ++e)
+	// Twins run between the same two points in opposite directions
+	for (i32 edge_idx = 0; edge_idx < 12; ++edge_idx)
+	{
+		QuickhullHalfEdge* edge = &in_quickhull->edges[edge_idx];
+		const i32 edge_end = in_quickhull->edges[edge->next].vertex;
+		for (i32 other_idx = 0; other_idx < 12; ++other_idx)
 		{
-			if (convex_edge_equals(edges[e], in_edge))
+			const QuickhullHalfEdge* other = &in_quickhull->edges[other_idx];
+			if (other->vertex == edge_end && in_quickhull->edges[other->next].vertex == edge->vertex)
 			{
-				return false;
+				edge->twin = other_idx;
 			}
 		}
 	}
 
-	return true;
+	const i32 tetrahedron_faces[4] = { 0, 1, 2, 3 };
+	for (i32 point_idx = 0; point_idx < num_points; ++point_idx)
+	{
+		if (point_idx != indices[0] && point_idx != indices[1] && point_idx != indices[2] && point_idx != indices[3])
+		{
+			quickhull_assign_point(in_quickhull, point_idx, tetrahedron_faces, 4);
+		}
+	}
 }
 
-void convex_hull_add_point(ConvexHull* in_convex_hull, const Vec3 in_point)
+// Grows the hull out to the furthest point on in_face_idx's conflict list
+static inline void quickhull_add_furthest_point(Quickhull* in_quickhull, const i32 in_face_idx)
 {
-	// Find all triangles that face this point
-	sbuffer(i32) facing_tri_indices = NULL;
-	for (i32 i = sb_count(in_convex_hull->tris); i >= 0; --i)
+	i32 eye_idx = -1;
+	f32 max_height = -FLT_MAX;
+	for (i32 point_idx = in_quickhull->faces[in_face_idx].conflict_head; point_idx >= 0; point_idx = in_quickhull->conflict_next[point_idx])
 	{
-		const ConvexTri tri = in_convex_hull->tris[i];
-		const Vec3 a = in_convex_hull->points[tri.a];
-		const Vec3 b = in_convex_hull->points[tri.b];
-		const Vec3 c = in_convex_hull->points[tri.c];
-
-		if (distance_from_triangle(a,b,c,in_point) > 0.f)
+		const f32 height = quickhull_point_height(in_quickhull, in_face_idx, point_idx);
+		if (height > max_height)
 		{
-			sb_push(facing_tri_indices, i);
+			max_height = height;
+			eye_idx = point_idx;
 		}
 	}
 
-	// Find all edges unique to this tri. These will form the new triangles
-	sbuffer(ConvexEdge) unique_edges =  NULL;	
-	for (i32 i = 0; i < sb_count(facing_tri_indices); ++i)
+	// Flood out from the face to every connected face the eye point is outside of
+	const i32 visit_stamp = ++in_quickhull->visit_stamp;
+	sb_clear(in_quickhull->face_stack);
+	sb_clear(in_quickhull->visible_faces);
+	in_quickhull->faces[in_face_idx].visit_stamp = visit_stamp;
+	in_quickhull->faces[in_face_idx].is_visible = true;
+	sb_push(in_quickhull->face_stack, in_face_idx);
+	while (sb_count(in_quickhull->face_stack) > 0)
 	{
-		const i32 tri_idx = facing_tri_indices[i];
-		const ConvexTri tri = in_convex_hull->tris[tri_idx];
+		const i32 face_idx = sb_last(in_quickhull->face_stack);
+		sb_del(in_quickhull->face_stack, sb_count(in_quickhull->face_stack) - 1);
+		sb_push(in_quickhull->visible_faces, face_idx);
 
-		ConvexEdge edges[3] = {
-			{
-				.a = tri.a,
-				.b = tri.b,
-			},
-			{
-				.a = tri.b,
-				.b = tri.c,
-			},
-			{
-				.a = tri.c,
-				.b = tri.a,
-			},
-		};
-
-		for (i32 e = 0; e < ARRAY_COUNT(edges); ++e)
+		i32 edge_idx = in_quickhull->faces[face_idx].edge;
+		for (i32 i = 0; i < 3; ++i, edge_idx = in_quickhull->edges[edge_idx].next)
 		{
-			if (is_edge_unique(in_convex_hull->tris, facing_tri_indices, tri_idx, edges[e]))
+			const i32 neighbor_idx = in_quickhull->edges[in_quickhull->edges[edge_idx].twin].face;
+			QuickhullFace* neighbor = &in_quickhull->faces[neighbor_idx];
+			if (neighbor->visit_stamp != visit_stamp)
 			{
-				sb_push(unique_edges, edges[e]);
+				neighbor->visit_stamp = visit_stamp;
+				neighbor->is_visible = quickhull_point_height(in_quickhull, neighbor_idx, eye_idx) > in_quickhull->epsilon;
+				if (neighbor->is_visible)
+				{
+					sb_push(in_quickhull->face_stack, neighbor_idx);
+				}
 			}
 		}
 	}
 
-	// remove old facing tri indices
-	for (i32 i = 0; i < sb_count(facing_tri_indices); ++i)
+	// The horizon is every edge between a visible face and one that isn't. Visible faces leave the hull, and their points need new faces
+	sb_clear(in_quickhull->horizon_edges);
+	sb_clear(in_quickhull->orphaned_points);
+	for (i32 visible_idx = 0; visible_idx < sb_count(in_quickhull->visible_faces); ++visible_idx)
 	{
-		sb_del(in_convex_hull->tris, facing_tri_indices[i]);
-	}
-
-	// add the new point
-	sb_push(in_convex_hull->points, in_point);
-	i32 new_point_idx = sb_count(in_convex_hull->points) - 1;
-
-	// Add hull triangles for each unique edge
-	for (i32 i = 0; i < sb_count(unique_edges); ++i)
-	{
-		const ConvexEdge edge = unique_edges[i];
-		sb_push(in_convex_hull->tris, ((ConvexTri) {
-			.a = edge.a,
-			.b = edge.b,
-			.c = new_point_idx,
-		}));
-	}
-
-	sb_free(facing_tri_indices);
-	sb_free(unique_edges);
-}
+		QuickhullFace* face = &in_quickhull->faces[in_quickhull->visible_faces[visible_idx]];
+		face->is_alive = false;
 
-void convex_hull_remove_unreferenced_points(ConvexHull* in_convex_hull)
-{
-	for (i32 point_idx = 0; point_idx < sb_count(in_convex_hull->points); ++point_idx)
-	{
-		bool is_used = false;
-		for (i32 tri_idx = 0; tri_idx < sb_count(in_convex_hull->tris); ++tri_idx)
+		i32 edge_idx = face->edge;
+		for (i32 i = 0; i < 3; ++i, edge_idx = in_quickhull->edges[edge_idx].next)
 		{
-			ConvexTri tri = in_convex_hull->tris[tri_idx];
-			if (tri.a == point_idx || tri.b == point_idx || tri.c == point_idx)
+			if (!in_quickhull->faces[in_quickhull->edges[in_quickhull->edges[edge_idx].twin].face].is_visible)
 			{
-				is_used = true;
-				break;
+				sb_push(in_quickhull->horizon_edges, edge_idx);
 			}
 		}
 
-		if (is_used)
+		for (i32 point_idx = face->conflict_head; point_idx >= 0; point_idx = in_quickhull->conflict_next[point_idx])
 		{
-			continue;
-		}
-
-		for (i32 tri_idx = 0; tri_idx < sb_count(in_convex_hull->tris); ++tri_idx)
-		{
-			ConvexTri* tri = &in_convex_hull->tris[tri_idx];
-			if (tri->a > point_idx)
-			{
-				tri->a -= 1;
-			}
-
-			if (tri->b > point_idx)
+			if (point_idx != eye_idx)
 			{
-				tri->b -= 1;
+				sb_push(in_quickhull->orphaned_points, point_idx);
 			}
-
-			if (tri->c > point_idx)
-			{
-				tri->c -= 1;
-			}	
 		}
-
-		sb_del(in_convex_hull->points, point_idx);
-		point_idx -= 1;
+		face->conflict_head = -1;
 	}
-}
-
-void convex_hull_expand(ConvexHull* in_convex_hull, const Vec3* in_points, const i32 in_num_points)
-{
-	sbuffer(Vec3) external_points = NULL;
-	sb_append_array(external_points, in_points, in_num_points);
 
-	// Remove any internal points
-	convex_hull_remove_internal_points(in_convex_hull, &external_points);
-
-	while(sb_count(external_points) > 0)
+	// A fan of faces from each horizon edge to the eye point. Neighboring faces in the fan meet on the edge between the eye and their shared point
+	sb_clear(in_quickhull->new_faces);
+	for (i32 horizon_idx = 0; horizon_idx < sb_count(in_quickhull->horizon_edges); ++horizon_idx)
 	{
-		i32	point_idx = furthest_point_in_dir(external_points, sb_count(external_points), external_points[0]);
-		const Vec3 point = external_points[point_idx];
-
-		// Remove this element
-		sb_del(external_points, point_idx);
-
-		// Add this element to our hull
-		convex_hull_add_point(in_convex_hull, point);
+		const i32 horizon_edge_idx = in_quickhull->horizon_edges[horizon_idx];
+		const i32 a = in_quickhull->edges[horizon_edge_idx].vertex;
+		const i32 b = in_quickhull->edges[in_quickhull->edges[horizon_edge_idx].next].vertex;
+		const i32 face_idx = quickhull_add_face(in_quickhull, a, b, eye_idx);
+		sb_push(in_quickhull->new_faces, face_idx);
+
+		QuickhullHalfEdge* edges = in_quickhull->edges;
+		const i32 edge_a_b = edges[horizon_edge_idx].twin;
+		const i32 new_edge_a_b = in_quickhull->faces[face_idx].edge;
+		const i32 new_edge_b_eye = edges[new_edge_a_b].next;
+		const i32 new_edge_eye_a = edges[new_edge_b_eye].next;
+
+		edges[new_edge_a_b].twin = edge_a_b;
+		edges[edge_a_b].twin = new_edge_a_b;
+
+		if (in_quickhull->edge_from_eye[b] >= 0)
+		{
+			edges[new_edge_b_eye].twin = in_quickhull->edge_from_eye[b];
+			edges[in_quickhull->edge_from_eye[b]].twin = new_edge_b_eye;
+		}
+		else
+		{
+			in_quickhull->edge_to_eye[b] = new_edge_b_eye;
+		}
 
-		// Re-run internal point removal
-		convex_hull_remove_internal_points(in_convex_hull, &external_points);
+		if (in_quickhull->edge_to_eye[a] >= 0)
+		{
+			edges[new_edge_eye_a].twin = in_quickhull->edge_to_eye[a];
+			edges[in_quickhull->edge_to_eye[a]].twin = new_edge_eye_a;
+		}
+		else
+		{
+			in_quickhull->edge_from_eye[a] = new_edge_eye_a;
+		}
 	}
 
-	// Finall remove any points that are no longer referenced
-	convex_hull_remove_unreferenced_points(in_convex_hull);
+	for (i32 horizon_idx = 0; horizon_idx < sb_count(in_quickhull->horizon_edges); ++horizon_idx)
+	{
+		const i32 vertex = in_quickhull->edges[in_quickhull->horizon_edges[horizon_idx]].vertex;
+		in_quickhull->edge_from_eye[vertex] = -1;
+		in_quickhull->edge_to_eye[vertex] = -1;
+	}
 
-	sb_free(external_points);
+	for (i32 orphan_idx = 0; orphan_idx < sb_count(in_quickhull->orphaned_points); ++orphan_idx)
+	{
+		quickhull_assign_point(in_quickhull, in_quickhull->orphaned_points[orphan_idx], in_quickhull->new_faces, sb_count(in_quickhull->new_faces));
+	}
 }
 
 ConvexHull convex_hull_create(const Vec3* in_points, const i32 in_num_points)
 {
-	ConvexHull convex_hull = convex_hull_build_tetrahedron(in_points, in_num_points);	
+	assert(in_num_points >= 4);
 
-	convex_hull_expand(&convex_hull, in_points, in_num_points);
+	// Tolerance scales with the points' magnitude, as float error in a plane test does
+	Vec3 max_abs = vec3_zero;
+	for (i32 point_idx = 0; point_idx < in_num_points; ++point_idx)
+	{
+		max_abs = vec3_componentwise_max(max_abs, vec3_new(fabsf(in_points[point_idx].x), fabsf(in_points[point_idx].y), fabsf(in_points[point_idx].z)));
+	}
 
-	return convex_hull;
-}
+	Quickhull quickhull = {
+		.points = in_points,
+		.num_points = in_num_points,
+		.epsilon = 3.0f * FLT_EPSILON * (max_abs.x + max_abs.y + max_abs.z),
+	};
+	(void) sb_add(quickhull.conflict_next, in_num_points);
+	i32* edge_from_eye = sb_add(quickhull.edge_from_eye, in_num_points);
+	i32* edge_to_eye = sb_add(quickhull.edge_to_eye, in_num_points);
+	for (i32 point_idx = 0; point_idx < in_num_points; ++point_idx)
+	{
+		edge_from_eye[point_idx] = -1;
+		edge_to_eye[point_idx] = -1;
+	}
 
-bool convex_hull_is_point_external(const ConvexHull* in_convex_hull, const Vec3 in_point)
-{	
-	bool is_external = false;
-	for (i32 t = 0; t < sb_count(in_convex_hull->tris); ++t)
+	quickhull_build_tetrahedron(&quickhull);
+
+	// Faces are only ever added at the end, and points only ever move to new faces, so one pass reaches every point
+	for (i32 face_idx = 0; face_idx < sb_count(quickhull.faces); ++face_idx)
 	{
-		const ConvexTri tri = in_convex_hull->tris[t];
-		const Vec3 a = in_convex_hull->points[tri.a];
-		const Vec3 b = in_convex_hull->points[tri.b];	
-		const Vec3 c = in_convex_hull->points[tri.c];
-		if (distance_from_triangle(a, b, c, in_point) > 0.f)
+		if (quickhull.faces[face_idx].is_alive && quickhull.faces[face_idx].conflict_head >= 0)
 		{
-			is_external = true;
-			break;
+			quickhull_add_furthest_point(&quickhull, face_idx);
 		}
 	}
 
-	return is_external;
-}
-
-Vec3 convex_hull_calculate_center_of_mass_monte_carlo(const ConvexHull* in_convex_hull)
-{
-	const i32 num_samples = 10000;
-
-	Bounds bounds = bounds_init();
-	bounds_expand_points(&bounds, in_convex_hull->points, sb_count(in_convex_hull->points));
-
-	Vec3 bounds_dimensions = bounds_get_extents(&bounds);
-
-	Vec3 center_of_mass = vec3_zero;
-	i32 sample_count = 0;
+	// Keep the points the remaining faces use, in their original order
+	ConvexHull out_hull = {
+		.points = NULL,
+		.tris = NULL,
+	};
 
-	for (i32 i = 0; i < num_samples; ++i)
+	// edge_from_eye is all -1 again, and is reused to map input points to hull points. Used points are marked with 0 first
+	i32* hull_indices = quickhull.edge_from_eye;
+	for (i32 face_idx = 0; face_idx < sb_count(quickhull.faces); ++face_idx)
 	{
-		Vec3 point = vec3_new(
-			bounds.min.x + rand_f32(0.f, bounds_dimensions.x),
-			bounds.min.y + rand_f32(0.f, bounds_dimensions.y),
-			bounds.min.z + rand_f32(0.f, bounds_dimensions.z)
-		);
-
-		if (convex_hull_is_point_external(in_convex_hull, point))
+		const QuickhullFace* face = &quickhull.faces[face_idx];
+		if (face->is_alive)
 		{
-			continue;
+			const QuickhullHalfEdge* edge_a = &quickhull.edges[face->edge];
+			const QuickhullHalfEdge* edge_b = &quickhull.edges[edge_a->next];
+			const QuickhullHalfEdge* edge_c = &quickhull.edges[edge_b->next];
+			hull_indices[edge_a->vertex] = 0;
+			hull_indices[edge_b->vertex] = 0;
+			hull_indices[edge_c->vertex] = 0;
 		}
-
-		center_of_mass = vec3_add(center_of_mass, point);
-		sample_count += 1;
 	}
 
-	center_of_mass = vec3_scale(center_of_mass, 1.0 / (f32) sample_count);
-	return center_of_mass;
-}
-
-Mat3 convex_hull_calculate_inertia_tensor_monte_carlo(const ConvexHull* in_convex_hull)
-{
-	const i32 num_samples = 10000;
-
-	Bounds bounds = bounds_init();
-	bounds_expand_points(&bounds, in_convex_hull->points, sb_count(in_convex_hull->points));
-
-	Vec3 bounds_dimensions = bounds_get_extents(&bounds);
-
-	Mat3 inertia_tensor = mat3_zero;
-	i32 sample_count = 0;
-
-	for (i32 i = 0; i < num_samples; ++i)
+	for (i32 point_idx = 0; point_idx < in_num_points; ++point_idx)
 	{
-		Vec3 point = vec3_new(
-			bounds.min.x + rand_f32(0.f, bounds_dimensions.x),
-			bounds.min.y + rand_f32(0.f, bounds_dimensions.y),
-			bounds.min.z + rand_f32(0.f, bounds_dimensions.z)
-		);
-
-		if (convex_hull_is_point_external(in_convex_hull, point))
+		if (hull_indices[point_idx] == 0)
 		{
-			continue;
+			hull_indices[point_idx] = sb_count(out_hull.points);
+			sb_push(out_hull.points, in_points[point_idx]);
 		}
-
-		inertia_tensor.columns[0].x += point.y * point.y + point.z * point.z;
-		inertia_tensor.columns[1].y += point.z * point.z + point.x * point.x;
-		inertia_tensor.columns[2].z += point.x * point.x + point.y * point.y;
-
-		inertia_tensor.columns[0].y += -1.0f * point.x * point.y;
-		inertia_tensor.columns[0].z += -1.0f * point.x * point.z;
-		inertia_tensor.columns[1].z += -1.0f * point.y * point.z;
-
-		inertia_tensor.columns[1].x += -1.0f * point.x * point.y;
-		inertia_tensor.columns[2].x += -1.0f * point.x * point.z;
-		inertia_tensor.columns[2].y += -1.0f * point.y * point.z;
-
-		sample_count += 1;
 	}
 
-	inertia_tensor = mat3_mul_f32(inertia_tensor, 1.0 / (f32) sample_count);
-	return inertia_tensor;
-}
-
-Vec3 convex_hull_calculate_center_of_mass(const ConvexHull* in_convex_hull)
-{
-	const i32 num_samples = 100;
-
-	Bounds bounds = bounds_init();
-	bounds_expand_points(&bounds, in_convex_hull->points, sb_count(in_convex_hull->points));
+	for (i32 face_idx = 0; face_idx < sb_count(quickhull.faces); ++face_idx)
+	{
+		const QuickhullFace* face = &quickhull.faces[face_idx];
+		if (face->is_alive)
+		{
+			const QuickhullHalfEdge* edge_a = &quickhull.edges[face->edge];
+			const QuickhullHalfEdge* edge_b = &quickhull.edges[edge_a->next];
+			const QuickhullHalfEdge* edge_c = &quickhull.edges[edge_b->next];
+			sb_push(out_hull.tris, ((ConvexTri) {
+				.a = hull_indices[edge_a->vertex],
+				.b = hull_indices[edge_b->vertex],
+				.c = hull_indices[edge_c->vertex],
+			}));
+		}
+	}
 
-	Vec3 bounds_dimensions = bounds_get_extents(&bounds);
+	sb_free(quickhull.edges);
+	sb_free(quickhull.faces);
+	sb_free(quickhull.conflict_next);
+	sb_free(quickhull.face_stack);
+	sb_free(quickhull.visible_faces);
+	sb_free(quickhull.horizon_edges);
+	sb_free(quickhull.orphaned_points);
+	sb_free(quickhull.new_faces);
+	sb_free(quickhull.edge_from_eye);
+	sb_free(quickhull.edge_to_eye);
 
-	const f32 dx = bounds_dimensions.x / num_samples;
-	const f32 dy = bounds_dimensions.y / num_samples;
-	const f32 dz = bounds_dimensions.z / num_samples;
+	return out_hull;
+}
 
-	Vec3 center_of_mass = vec3_zero;
-	i32 sample_count = 0;
-	for (f32 x = bounds.min.x; x < bounds.max.x; x += dx)
+bool convex_hull_is_point_external(const ConvexHull* in_convex_hull, const Vec3 in_point)
+{	
+	bool is_external = false;
+	for (i32 t = 0; t < sb_count(in_convex_hull->tris); ++t)
 	{
-		for (f32 y = bounds.min.y; y < bounds.max.y; y += dy)
+		const ConvexTri tri = in_convex_hull->tris[t];
+		const Vec3 a = in_convex_hull->points[tri.a];
+		const Vec3 b = in_convex_hull->points[tri.b];	
+		const Vec3 c = in_convex_hull->points[tri.c];
+		if (distance_from_triangle(a, b, c, in_point) > 0.f)
 		{
-			for (f32 z = bounds.min.z; z < bounds.max.z; z += dz)
-			{
-				const Vec3 point = vec3_new(x,y,z);
-				if (convex_hull_is_point_external(in_convex_hull, point))
-				{
-					continue;
-				}
-
-				center_of_mass = vec3_add(center_of_mass, point);
-				sample_count += 1;
-			}
+			is_external = true;
+			break;
 		}
 	}
 
-	center_of_mass = vec3_scale(center_of_mass, 1.0 / (f32) sample_count);
-	return center_of_mass;
+	return is_external;
 }
 
-Mat3 convex_hull_calculate_inertia_tensor(const ConvexHull* in_convex_hull)
+// Exact volume, center of mass and inertia tensor of a solid hull of uniform density, by the divergence theorem
+// Each triangle and the origin form a tetrahedron whose integrals have closed forms. Triangles facing away from the origin
+// add and those facing it subtract, leaving just the hull. The inertia tensor is per unit mass, about the origin
+void convex_hull_calculate_mass_properties(const ConvexHull* in_convex_hull, f32* out_volume, Vec3* out_center_of_mass, Mat3* out_inertia_tensor)
 {
-	const i32 num_samples = 100;
+	f32 volume = 0.0f;
+	Vec3 first_moment = vec3_zero;
+	f32 xx = 0.0f, yy = 0.0f, zz = 0.0f;
+	f32 xy = 0.0f, xz = 0.0f, yz = 0.0f;
 
-	Bounds bounds = bounds_init();
-	bounds_expand_points(&bounds, in_convex_hull->points, sb_count(in_convex_hull->points));
-
-	Vec3 bounds_dimensions = bounds_get_extents(&bounds);
-
-	const f32 dx = bounds_dimensions.x / num_samples;
-	const f32 dy = bounds_dimensions.y / num_samples;
-	const f32 dz = bounds_dimensions.z / num_samples;
-
-	Mat3 inertia_tensor = mat3_zero;
-	i32 sample_count = 0;
-	for (f32 x = bounds.min.x; x < bounds.max.x; x += dx)
+	for (i32 tri_idx = 0; tri_idx < sb_count(in_convex_hull->tris); ++tri_idx)
 	{
-		for (f32 y = bounds.min.y; y < bounds.max.y; y += dy)
-		{
-			for (f32 z = bounds.min.z; z < bounds.max.z; z += dz)
-			{
-				const Vec3 point = vec3_new(x,y,z);
-				if (convex_hull_is_point_external(in_convex_hull, point))
-				{
-					continue;
-				}
-
-				inertia_tensor.columns[0].x += point.y * point.y + point.z * point.z;
-				inertia_tensor.columns[1].y += point.z * point.z + point.x * point.x;
-				inertia_tensor.columns[2].z += point.x * point.x + point.y * point.y;
-
-				inertia_tensor.columns[0].y += -1.0f * point.x * point.y;
-				inertia_tensor.columns[0].z += -1.0f * point.x * point.z;
-				inertia_tensor.columns[1].z += -1.0f * point.y * point.z;
-
-				inertia_tensor.columns[1].x += -1.0f * point.x * point.y;
-				inertia_tensor.columns[2].x += -1.0f * point.x * point.z;
-				inertia_tensor.columns[2].y += -1.0f * point.y * point.z;
-
-				sample_count += 1;
-			}
-		}
+		const ConvexTri tri = in_convex_hull->tris[tri_idx];
+		const Vec3 a = in_convex_hull->points[tri.a];
+		const Vec3 b = in_convex_hull->points[tri.b];
+		const Vec3 c = in_convex_hull->points[tri.c];
+		const Vec3 sum = vec3_add(a, vec3_add(b, c));
+
+		// Six times the tetrahedron's signed volume
+		const f32 det = vec3_dot(a, vec3_cross(b, c));
+		volume += det / 6.0f;
+		first_moment = vec3_add(first_moment, vec3_scale(sum, det / 24.0f));
+
+		// Integral of p * p^T over the tetrahedron: det / 120 * (a a^T + b b^T + c c^T + sum sum^T)
+		const f32 scale = det / 120.0f;
+		xx += scale * (a.x * a.x + b.x * b.x + c.x * c.x + sum.x * sum.x);
+		yy += scale * (a.y * a.y + b.y * b.y + c.y * c.y + sum.y * sum.y);
+		zz += scale * (a.z * a.z + b.z * b.z + c.z * c.z + sum.z * sum.z);
+		xy += scale * (a.x * a.y + b.x * b.y + c.x * c.y + sum.x * sum.y);
+		xz += scale * (a.x * a.z + b.x * b.z + c.x * c.z + sum.x * sum.z);
+		yz += scale * (a.y * a.z + b.y * b.z + c.y * c.z + sum.y * sum.z);
 	}
 
-	inertia_tensor = mat3_mul_f32(inertia_tensor, 1.0 / (f32) sample_count);
-	return inertia_tensor;
+	assert(volume > 0.0f);
+	const f32 inverse_volume = 1.0f / volume;
+
+	*out_volume = volume;
+	*out_center_of_mass = vec3_scale(first_moment, inverse_volume);
+	*out_inertia_tensor = (Mat3) {
+		.columns[0] = vec3_scale(vec3_new(yy + zz,	-xy,		-xz),		inverse_volume),
+		.columns[1] = vec3_scale(vec3_new(-xy,		xx + zz,	-yz),		inverse_volume),
+		.columns[2] = vec3_scale(vec3_new(-xz,		-yz,		xx + yy),	inverse_volume),
+	};
 }
 
 void convex_hull_destroy(ConvexHull* in_convex_hull)
@@ -1135,68 +1154,112 @@ Vec3 barycentric_coordinates(Vec3 s1, Vec3 s2, Vec3 s3, const Vec3 in_pt)
 	return lambdas;	
 }
 
-Vec3 triangle_normal_direction(const ConvexTri in_tri, const MinkowskiPoint* in_points, const i32 in_num_points)
+// EPA's polytope lives in fixed arrays, so one expansion never touches the heap and can run on any worker
+// Faces keep their normal and distance to the origin, so the closest face is one pass over floats,
+// and the horizon comes from hashing the directed edges of the faces a new point removes
+enum
 {
-	assert(in_tri.a < in_num_points);
-	assert(in_tri.b < in_num_points);
-	assert(in_tri.c < in_num_points);
-
-	const Vec3 a = in_points[in_tri.a].xyz;
-	const Vec3 b = in_points[in_tri.b].xyz;
-	const Vec3 c = in_points[in_tri.c].xyz;
-	const Vec3 ab = vec3_sub(b,a);
-	const Vec3 ac = vec3_sub(c,a);
-
-	const Vec3 normal = vec3_normalize(vec3_cross(ab,ac));
-	return normal;
-}
+	EPA_MAX_POINTS = 64,
+	EPA_MAX_FACES = 2 * EPA_MAX_POINTS,
+	EPA_EDGE_HASH_SIZE = 512,	// Power of two, larger than the 3 * EPA_MAX_FACES edges one expansion can remove
+};
 
-f32 signed_distance_to_triangle(const ConvexTri in_tri, const Vec3 in_test_point, const MinkowskiPoint* in_points, const i32 in_num_points)
+typedef struct EpaFace
 {
-	const Vec3 normal = triangle_normal_direction(in_tri, in_points, in_num_points);
-	const Vec3 a = in_points[in_tri.a].xyz;
-	const Vec3 a_to_test_point = vec3_sub(in_test_point, a);
-	const f32 dist = vec3_dot(normal, a_to_test_point);
-	return dist;
-}
+	i32 a;
+	i32 b;
+	i32 c;
+	Vec3 normal;	// Unit length, pointing out of the polytope
+	f32 distance;	// Signed distance from the origin to the face's plane
+} EpaFace;
 
-i32 closest_triangle(const ConvexTri* in_tris, const i32 in_num_tris, const MinkowskiPoint* in_points, const i32 in_num_points)
+typedef struct EpaEdgeHashEntry
 {
-	i32 idx = -1;
-	f32 min_dist_squared = 1e10;
-	for (i32 i = 0; i < in_num_tris; ++i)
+	i32 stamp;			// Entries from an earlier expansion don't match the polytope's edge_stamp, and count as empty
+	i32 a;
+	i32 b;
+	bool is_horizon;	// Cleared once the opposite edge is seen, as the edge is then between two removed faces
+} EpaEdgeHashEntry;
+
+typedef struct EpaPolytope
+{
+	MinkowskiPoint points[EPA_MAX_POINTS];
+	i32 num_points;
+
+	EpaFace faces[EPA_MAX_FACES];
+	i32 num_faces;
+
+	EpaEdgeHashEntry edge_hash[EPA_EDGE_HASH_SIZE];
+	i32 edge_slots[EPA_EDGE_HASH_SIZE];	// Slots filled by the current expansion, in order
+	i32 num_edge_slots;
+	i32 edge_stamp;
+
+	Vec3 center;	// Inside the polytope, used to keep new faces pointing outward
+} EpaPolytope;
+
+static inline EpaFace epa_face_create(const EpaPolytope* in_polytope, i32 in_a, i32 in_b, i32 in_c)
+{
+	const Vec3 a = in_polytope->points[in_a].xyz;
+	Vec3 normal = vec3_normalize(vec3_cross(vec3_sub(in_polytope->points[in_b].xyz, a), vec3_sub(in_polytope->points[in_c].xyz, a)));
+	if (vec3_dot(normal, vec3_sub(in_polytope->center, a)) > 0.0f)
 	{
-		const ConvexTri tri = in_tris[i];
-		const f32 dist = signed_distance_to_triangle(tri, vec3_zero, in_points, in_num_points);
-		const f32 dist_squared = dist * dist;
-		if (dist_squared < min_dist_squared)
-		{
-			idx = i;	
-			min_dist_squared = dist_squared;
-		}
+		SWAP(i32, in_b, in_c);
+		normal = vec3_negate(normal);
 	}
-	return idx;
+
+	return (EpaFace) {
+		.a = in_a,
+		.b = in_b,
+		.c = in_c,
+		.normal = normal,
+		.distance = vec3_dot(normal, a),
+	};
 }
 
-bool triangle_has_point(const Vec3 w, const ConvexTri* in_tris, const i32 in_num_tris, const MinkowskiPoint* in_points, const i32 in_num_points)
+void epa_polytope_init(EpaPolytope* out_polytope, const MinkowskiPoint in_simplex_points[4])
 {
-	const f32 epsilons = 0.001f * 0.001f;
+	out_polytope->num_points = 4;
+	out_polytope->num_faces = 0;
+	out_polytope->num_edge_slots = 0;
+	out_polytope->edge_stamp = 0;
+	memset(out_polytope->edge_hash, 0, sizeof(out_polytope->edge_hash));
 
-	for (i32 i = 0; i < in_num_tris; ++i)
+	out_polytope->center = vec3_zero;
+	for (i32 i = 0; i < 4; ++i)
 	{
-		const ConvexTri tri = in_tris[i];
+		out_polytope->points[i] = in_simplex_points[i];
+		out_polytope->center = vec3_add(out_polytope->center, in_simplex_points[i].xyz);
+	}
+	out_polytope->center = vec3_scale(out_polytope->center, 0.25f);
 
-		if (vec3_length_squared(vec3_sub(w, in_points[tri.a].xyz)) < epsilons)
-		{
-			return true;
-		}
+	for (i32 i = 0; i < 4; ++i)
+	{
+		out_polytope->faces[out_polytope->num_faces++] = epa_face_create(out_polytope, i, (i + 1) % 4, (i + 2) % 4);
+	}
+}
 
-		if (vec3_length_squared(vec3_sub(w, in_points[tri.b].xyz)) < epsilons)
+i32 epa_polytope_closest_face(const EpaPolytope* in_polytope)
+{
+	i32 idx = -1;
+	f32 min_distance = FLT_MAX;
+	for (i32 i = 0; i < in_polytope->num_faces; ++i)
+	{
+		const f32 distance = fabsf(in_polytope->faces[i].distance);
+		if (distance < min_distance)
 		{
-			return true;
+			idx = i;
+			min_distance = distance;
 		}
+	}
+	return idx;
+}
 
-		if (vec3_length_squared(vec3_sub(w, in_points[tri.c].xyz)) < epsilons)
+bool epa_polytope_has_point(const EpaPolytope* in_polytope, const Vec3 in_point)
+{
+	const f32 epsilon_squared = 0.001f * 0.001f;
+	for (i32 i = 0; i < in_polytope->num_points; ++i)
+	{
+		if (vec3_length_squared(vec3_sub(in_point, in_polytope->points[i].xyz)) < epsilon_squared)
 		{
 			return true;
 		}
@@ -1204,72 +1267,95 @@ bool triangle_has_point(const Vec3 w, const ConvexTri* in_tris, const i32 in_num
 	return false;
 }
 
-i32 remove_triangles_facing_point(const Vec3 pt, sbuffer(ConvexTri)* in_out_tris, const MinkowskiPoint* in_points, const i32 in_num_points)
+// Adds a removed face's edge. An edge whose reverse is already there is shared by two removed faces, so neither is on the horizon
+static inline void epa_polytope_add_removed_edge(EpaPolytope* in_polytope, const i32 in_a, const i32 in_b)
 {
-	i32 num_removed = 0;
-
-	for (i32 i = 0; i < sb_count(*in_out_tris); ++i)
-	{	
-		const ConvexTri tri = (*in_out_tris)[i];
-		if (signed_distance_to_triangle(tri, pt, in_points, in_num_points) > 0.f)
+	const i32 mask = EPA_EDGE_HASH_SIZE - 1;
+	const u32 reverse_hash = (u32) in_b * 73856093u ^ (u32) in_a * 19349663u;
+	for (i32 slot = reverse_hash & mask; in_polytope->edge_hash[slot].stamp == in_polytope->edge_stamp; slot = (slot + 1) & mask)
+	{
+		EpaEdgeHashEntry* entry = &in_polytope->edge_hash[slot];
+		if (entry->a == in_b && entry->b == in_a && entry->is_horizon)
 		{
-			sb_del(*in_out_tris, i);	
-			i -= 1;
-			num_removed += 1;
+			entry->is_horizon = false;
+			return;
 		}
 	}
-	return num_removed;
+
+	const u32 hash = (u32) in_a * 73856093u ^ (u32) in_b * 19349663u;
+	i32 slot = hash & mask;
+	while (in_polytope->edge_hash[slot].stamp == in_polytope->edge_stamp)
+	{
+		slot = (slot + 1) & mask;
+	}
+
+	assert(in_polytope->num_edge_slots < EPA_EDGE_HASH_SIZE);
+	in_polytope->edge_hash[slot] = (EpaEdgeHashEntry) {
+		.stamp = in_polytope->edge_stamp,
+		.a = in_a,
+		.b = in_b,
+		.is_horizon = true,
+	};
+	in_polytope->edge_slots[in_polytope->num_edge_slots++] = slot;
 }
 
-void find_dangling_edges(const ConvexTri* in_tris, const i32 in_num_tris, sbuffer(ConvexEdge)* out_dangling_edges)
+// Replaces the faces in_point can see with a fan of faces from the horizon to in_point
+// Returns false, leaving the polytope as it was, if no face can see in_point or the result wouldn't fit
+bool epa_polytope_expand(EpaPolytope* in_polytope, const MinkowskiPoint* in_point)
 {
-	assert(out_dangling_edges != NULL);
-	
-	// Reset out dangling edges
-	sb_free(*out_dangling_edges);
+	if (in_polytope->num_points >= EPA_MAX_POINTS)
+	{
+		return false;
+	}
 
-	sbuffer(ConvexEdge) out_edges = NULL;
+	// A new stamp empties the edge hash without clearing it
+	++in_polytope->edge_stamp;
+	in_polytope->num_edge_slots = 0;
 
-	for (i32 idx_1 = 0; idx_1 < in_num_tris; ++idx_1)
+	bool is_visible[EPA_MAX_FACES];
+	i32 num_visible = 0;
+	for (i32 i = 0; i < in_polytope->num_faces; ++i)
 	{
-		const ConvexTri tri_1 = in_tris[idx_1];
-		ConvexEdge edges_1[3] =
+		const EpaFace* face = &in_polytope->faces[i];
+		is_visible[i] = vec3_dot(face->normal, in_point->xyz) - face->distance > 0.0f;
+		if (is_visible[i])
 		{
-			{ .a = tri_1.a, .b = tri_1.b },
-			{ .a = tri_1.b, .b = tri_1.c },
-			{ .a = tri_1.c, .b = tri_1.a },
-		};
-
-		i32 counts[3] = {0,0,0};
+			++num_visible;
+			epa_polytope_add_removed_edge(in_polytope, face->a, face->b);
+			epa_polytope_add_removed_edge(in_polytope, face->b, face->c);
+			epa_polytope_add_removed_edge(in_polytope, face->c, face->a);
+		}
+	}
 
-		for (i32 idx_2 = 0; idx_2 < in_num_tris; ++idx_2)
-		{
-			if (idx_2 == idx_1) { continue; }
+	i32 num_horizon_edges = 0;
+	for (i32 i = 0; i < in_polytope->num_edge_slots; ++i)
+	{
+		num_horizon_edges += in_polytope->edge_hash[in_polytope->edge_slots[i]].is_horizon ? 1 : 0;
+	}
 
-			const ConvexTri tri_2 = in_tris[idx_2];
-			ConvexEdge edges_2[3] =
-			{
-				{ .a = tri_2.a, .b = tri_2.b },
-				{ .a = tri_2.b, .b = tri_2.c },
-				{ .a = tri_2.c, .b = tri_2.a },
-			};	
+	if (num_visible == 0 || num_horizon_edges == 0 || in_polytope->num_faces - num_visible + num_horizon_edges > EPA_MAX_FACES)
+	{
+		return false;
+	}
 
-			for (i32 edges_1_idx = 0; edges_1_idx < 3; ++edges_1_idx)
-			{
-				if (convex_edge_equals(edges_1[edges_1_idx], edges_2[0])) { counts[edges_1_idx] += 1; }
-				if (convex_edge_equals(edges_1[edges_1_idx], edges_2[1])) { counts[edges_1_idx] += 1; }
-				if (convex_edge_equals(edges_1[edges_1_idx], edges_2[2])) { counts[edges_1_idx] += 1; }
-			}	
+	// Swap-remove from the back, so every face moved into a removed slot has already been checked
+	for (i32 i = in_polytope->num_faces - 1; i >= 0; --i)
+	{
+		if (is_visible[i])
+		{
+			in_polytope->faces[i] = in_polytope->faces[--in_polytope->num_faces];
 		}
+	}
 
-		// An edge that isn't shared is dangling
-		for (i32 edges_1_idx = 0; edges_1_idx < 3; ++edges_1_idx)
+	const i32 new_idx = in_polytope->num_points++;
+	in_polytope->points[new_idx] = *in_point;
+	for (i32 i = 0; i < in_polytope->num_edge_slots; ++i)
+	{
+		const EpaEdgeHashEntry* entry = &in_polytope->edge_hash[in_polytope->edge_slots[i]];
+		if (entry->is_horizon)
 		{
-			if (counts[edges_1_idx] == 0)
-			{
-				sb_push(*out_dangling_edges, edges_1[edges_1_idx]);
-			}
-		}		
+			in_polytope->faces[in_polytope->num_faces++] = epa_face_create(in_polytope, new_idx, entry->a, entry->b);
+		}
 	}
+	return true;
 }
-
@@ -0,0 +1,187 @@
+#pragma once
+
+#include "basic_types.h"
+#include "math/basic_math.h"
+#include "memory/allocator.h"
+
+// Open addressing hash map from an unordered pair of body indices to an i32 value. Any other u64 key except PAIR_MAP_EMPTY_KEY works too
+// Linear probing with backward-shift deletion, so there are no tombstones and lookups stay short as pairs come and go
+
+enum { PAIR_MAP_MIN_CAPACITY = 64 };
+
+typedef struct PairMapEntry
+{
+	u64 key;	// PAIR_MAP_EMPTY_KEY for unused slots
+	i32 value;
+} PairMapEntry;
+
+typedef struct PairMap
+{
+	PairMapEntry* entries;
+	i32 capacity;	// Always a power of two
+	i32 count;
+} PairMap;
+
+#define PAIR_MAP_EMPTY_KEY UINT64_MAX
+
+// Order independent key: (a, b) and (b, a) map to the same entry
+static inline u64 pair_map_key(const i32 in_idx_a, const i32 in_idx_b)
+{
+	const u32 lo = (u32) MIN(in_idx_a, in_idx_b);
+	const u32 hi = (u32) MAX(in_idx_a, in_idx_b);
+	return ((u64) lo << 32) | (u64) hi;
+}
+
+static inline u32 pair_map_slot(const PairMap* in_map, const u64 in_key)
+{
+	// Fibonacci hashing spreads the sequential indices in each half of the key
+	return (u32) ((in_key * 0x9E3779B97F4A7C15ull) >> 32) & (u32) (in_map->capacity - 1);
+}
+
+void pair_map_init(PairMap* out_map)
+{
+	*out_map = (PairMap) {};
+}
+
+void pair_map_free(PairMap* in_map)
+{
+	FCS_MEM_FREE(in_map->entries);
+	*in_map = (PairMap) {};
+}
+
+void pair_map_clear(PairMap* in_map)
+{
+	for (i32 slot = 0; slot < in_map->capacity; ++slot)
+	{
+		in_map->entries[slot].key = PAIR_MAP_EMPTY_KEY;
+	}
+	in_map->count = 0;
+}
+
+// Returns a pointer to the value for in_key, or NULL if it isn't in the map. Invalidated by insert and remove
+i32* pair_map_find(const PairMap* in_map, const u64 in_key)
+{
+	if (in_map->count == 0)
+	{
+		return NULL;
+	}
+
+	const u32 mask = (u32) (in_map->capacity - 1);
+	for (u32 slot = pair_map_slot(in_map, in_key);; slot = (slot + 1) & mask)
+	{
+		PairMapEntry* entry = &in_map->entries[slot];
+		if (entry->key == in_key)
+		{
+			return &entry->value;
+		}
+		if (entry->key == PAIR_MAP_EMPTY_KEY)
+		{
+			return NULL;
+		}
+	}
+}
+
+void pair_map_grow(PairMap* in_map)
+{
+	PairMapEntry* old_entries = in_map->entries;
+	const i32 old_capacity = in_map->capacity;
+
+	in_map->capacity = MAX(old_capacity * 2, PAIR_MAP_MIN_CAPACITY);
+	in_map->entries = FCS_MEM_ALLOC(sizeof(PairMapEntry) * in_map->capacity);
+	in_map->count = 0;
+	pair_map_clear(in_map);
+
+	const u32 mask = (u32) (in_map->capacity - 1);
+	for (i32 old_slot = 0; old_slot < old_capacity; ++old_slot)
+	{
+		const PairMapEntry old_entry = old_entries[old_slot];
+		if (old_entry.key == PAIR_MAP_EMPTY_KEY)
+		{
+			continue;
+		}
+
+		u32 slot = pair_map_slot(in_map, old_entry.key);
+		while (in_map->entries[slot].key != PAIR_MAP_EMPTY_KEY)
+		{
+			slot = (slot + 1) & mask;
+		}
+		in_map->entries[slot] = old_entry;
+		in_map->count++;
+	}
+
+	FCS_MEM_FREE(old_entries);
+}
+
+// Inserts in_key with in_value. Returns false and leaves the existing value alone if in_key is already present
+bool pair_map_insert(PairMap* in_map, const u64 in_key, const i32 in_value)
+{
+	assert(in_key != PAIR_MAP_EMPTY_KEY);
+
+	// Keep the load factor at or below 1/2
+	if ((in_map->count + 1) * 2 > in_map->capacity)
+	{
+		pair_map_grow(in_map);
+	}
+
+	const u32 mask = (u32) (in_map->capacity - 1);
+	for (u32 slot = pair_map_slot(in_map, in_key);; slot = (slot + 1) & mask)
+	{
+		PairMapEntry* entry = &in_map->entries[slot];
+		if (entry->key == in_key)
+		{
+			return false;
+		}
+		if (entry->key == PAIR_MAP_EMPTY_KEY)
+		{
+			*entry = (PairMapEntry) {
+				.key = in_key,
+				.value = in_value,
+			};
+			in_map->count++;
+			return true;
+		}
+	}
+}
+
+// Removes in_key, writing its value to out_value if non-null. Returns false if in_key wasn't present
+bool pair_map_remove(PairMap* in_map, const u64 in_key, i32* out_value)
+{
+	if (in_map->count == 0)
+	{
+		return false;
+	}
+
+	const u32 mask = (u32) (in_map->capacity - 1);
+	u32 slot = pair_map_slot(in_map, in_key);
+	while (in_map->entries[slot].key != in_key)
+	{
+		if (in_map->entries[slot].key == PAIR_MAP_EMPTY_KEY)
+		{
+			return false;
+		}
+		slot = (slot + 1) & mask;
+	}
+
+	if (out_value)
+	{
+		*out_value = in_map->entries[slot].value;
+	}
+
+	// Backward-shift deletion: pull later entries of the probe run into the hole unless they'd move before their home slot
+	u32 hole = slot;
+	for (u32 next = (hole + 1) & mask; in_map->entries[next].key != PAIR_MAP_EMPTY_KEY; next = (next + 1) & mask)
+	{
+		const u32 home = pair_map_slot(in_map, in_map->entries[next].key);
+		const u32 distance_to_next = (next - home) & mask;
+		const u32 distance_to_hole = (hole - home) & mask;
+		if (distance_to_hole <= distance_to_next)
+		{
+			in_map->entries[hole] = in_map->entries[next];
+			hole = next;
+		}
+	}
+	in_map->entries[hole].key = PAIR_MAP_EMPTY_KEY;
+	in_map->count--;
+
+	return true;
+}
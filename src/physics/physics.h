@@ -4,9 +4,13 @@
 #include "math/math_lib.h"
 #include "stretchy_buffer.h"
 #include "physics/convex_helpers.h"
+#include "physics/broad_phase.h"
+#include "physics/pair_map.h"
+#include "physics/union_find.h"
 
 // Linear Complementary Problems
 #include "math/lcp.h"
+#include "math/jacobian.h"
 
 typedef enum ShapeType
 {
@@ -15,6 +19,9 @@ typedef enum ShapeType
 	SHAPE_TYPE_CONVEX,
 } ShapeType;
 
+// Not an enum member, so switches over ShapeType don't need a case for it
+#define SHAPE_TYPE_COUNT (SHAPE_TYPE_CONVEX + 1)
+
 typedef struct SphereShape
 {
 	f32 radius;
@@ -27,8 +34,46 @@ typedef struct BoxShape
 	Vec3 points[NUM_BOX_POINTS];
 	Bounds bounds;
 	Vec3 center_of_mass;
+	Mat3 inverse_inertia_tensor;	// Per unit mass, cached so solver steps don't invert the tensor
 } BoxShape;
 
+// Inertia tensor per unit mass about the origin
+Mat3 box_shape_get_inertia_tensor(const BoxShape* in_box)
+{
+	const f32 dx = in_box->bounds.max.x - in_box->bounds.min.x;
+	const f32 dy = in_box->bounds.max.y - in_box->bounds.min.y;
+	const f32 dz = in_box->bounds.max.z - in_box->bounds.min.z;
+
+	const f32 dx2 = dx * dx;
+	const f32 dy2 = dy * dy;
+	const f32 dz2 = dz * dz;
+
+	// Inertia tensor for box centered at (0,0,0)
+	Mat3 box_tensor = {
+		.d[0][0] = (dy2 + dz2) / 12.0f,
+		.d[1][1] = (dx2 + dz2) / 12.0f,
+		.d[2][2] = (dx2 + dy2) / 12.0f,
+	};
+
+	// Use parallel axis theorem to handle box not centered at origin
+	const Vec3 cm = vec3_new(
+		(in_box->bounds.max.x + in_box->bounds.min.x) * 0.5f,
+		(in_box->bounds.max.y + in_box->bounds.min.y) * 0.5f,
+		(in_box->bounds.max.z + in_box->bounds.min.z) * 0.5f
+	);
+
+	const Vec3 r = vec3_sub(vec3_zero, cm);
+	const f32 r_l2 = vec3_length_squared(r);
+
+	Mat3 pat_tensor = {
+		.columns[0] =	vec3_new(r_l2 - r.x * r.x,	-r.x * r.y,			-r.x * r.z),
+		.columns[1] =	vec3_new(-r.y * r.x, 		r_l2 - r.y * r.y,	-r.y * r.z),
+		.columns[2] =	vec3_new(-r.z * r.x, 		-r.z * r.y,			r_l2 - r.z * r.z)
+	};
+
+	return mat3_add_mat3(box_tensor, pat_tensor);
+}
+
 // creates a box from some arbitrary number of points by expanding a bounding box
 BoxShape box_shape_create(const Vec3 in_extents)
 {
@@ -53,7 +98,7 @@ BoxShape box_shape_create(const Vec3 in_extents)
 
 	const Vec3 center_of_mass = vec3_scale(vec3_add(bounds.min, bounds.max), 0.5f);
 	
-	return (BoxShape) {
+	BoxShape out_box = {
 		.points = {
 			vec3_new(bounds.min.x, bounds.min.y, bounds.min.z),
 			vec3_new(bounds.max.x, bounds.min.y, bounds.min.z),
@@ -68,39 +113,193 @@ BoxShape box_shape_create(const Vec3 in_extents)
 		.bounds = bounds,
 		.center_of_mass = center_of_mass,
 	};
+	out_box.inverse_inertia_tensor = optional_get(mat3_inverse(box_shape_get_inertia_tensor(&out_box)));
+	return out_box;
 }
 
+// Shared between every body using it, and freed once the last of them releases it
 typedef struct ConvexShape
 {
+	i32 ref_count;
 	ConvexHull hull;
+	i32* adjacency_offsets;	// Neighbors of hull point i are adjacency[adjacency_offsets[i]] up to adjacency[adjacency_offsets[i + 1]]
+	i32* adjacency;			// Hull points sharing an edge, so support queries can walk the hull instead of scanning every point
 	Bounds bounds;
 	Mat3 inertia_tensor;
+	Mat3 inverse_inertia_tensor;	// Cached so solver steps don't invert the tensor
 	Vec3 center_of_mass;
 } ConvexShape;
 
-#define USE_MONTE_CARLO_CALCULATION 1
-
-ConvexShape convex_shape_create(const Vec3* in_points, const i32 in_num_points)
+// Builds the hull of in_points and its mass properties. The caller holds the only reference
+ConvexShape* convex_shape_create(const Vec3* in_points, const i32 in_num_points)
 {
 	ConvexHull hull = convex_hull_create(in_points, in_num_points);
 
 	Bounds bounds = bounds_init();
 	bounds_expand_points(&bounds, in_points, in_num_points);
 
-	#if USE_MONTE_CARLO_CALCULATION
-	const Mat3 inertia_tensor = convex_hull_calculate_inertia_tensor_monte_carlo(&hull);
-	const Vec3 center_of_mass = convex_hull_calculate_center_of_mass_monte_carlo(&hull);
-	#else 
-	const Mat3 inertia_tensor = convex_hull_calculate_inertia_tensor(&hull);
-	const Vec3 center_of_mass = convex_hull_calculate_center_of_mass(&hull);
-	#endif // USE_MONTE_CARLO_CALCULATION
+	f32 volume;
+	Vec3 center_of_mass;
+	Mat3 inertia_tensor;
+	convex_hull_calculate_mass_properties(&hull, &volume, &center_of_mass, &inertia_tensor);
+
+	// Gather each hull point's neighbors across the triangles' edges, then pack them into one array
+	const i32 num_hull_points = sb_count(hull.points);
+	sbuffer(i32)* neighbors = FCS_MEM_ALLOC_ZEROED(sizeof(sbuffer(i32)) * num_hull_points);
+	for (i32 tri_idx = 0; tri_idx < sb_count(hull.tris); ++tri_idx)
+	{
+		const i32 tri_points[3] = { hull.tris[tri_idx].a, hull.tris[tri_idx].b, hull.tris[tri_idx].c };
+		for (i32 edge_idx = 0; edge_idx < 3; ++edge_idx)
+		{
+			const i32 point_idx = tri_points[edge_idx];
+			const i32 next_point_idx = tri_points[(edge_idx + 1) % 3];
+
+			// Each edge is seen from both of its triangles, in opposite directions. Only add it the first time
+			bool is_known = false;
+			for (i32 neighbor_idx = 0; neighbor_idx < sb_count(neighbors[point_idx]); ++neighbor_idx)
+			{
+				is_known |= neighbors[point_idx][neighbor_idx] == next_point_idx;
+			}
+			if (!is_known)
+			{
+				sb_push(neighbors[point_idx], next_point_idx);
+				sb_push(neighbors[next_point_idx], point_idx);
+			}
+		}
+	}
+
+	i32* adjacency_offsets = FCS_MEM_ALLOC(sizeof(i32) * (num_hull_points + 1));
+	adjacency_offsets[0] = 0;
+	for (i32 point_idx = 0; point_idx < num_hull_points; ++point_idx)
+	{
+		adjacency_offsets[point_idx + 1] = adjacency_offsets[point_idx] + sb_count(neighbors[point_idx]);
+	}
+
+	i32* adjacency = FCS_MEM_ALLOC(sizeof(i32) * MAX(adjacency_offsets[num_hull_points], 1));
+	for (i32 point_idx = 0; point_idx < num_hull_points; ++point_idx)
+	{
+		for (i32 neighbor_idx = 0; neighbor_idx < sb_count(neighbors[point_idx]); ++neighbor_idx)
+		{
+			adjacency[adjacency_offsets[point_idx] + neighbor_idx] = neighbors[point_idx][neighbor_idx];
+		}
+		sb_free(neighbors[point_idx]);
+	}
+	FCS_MEM_FREE(neighbors);
 
-	return (ConvexShape) {
+	ConvexShape* out_convex = FCS_MEM_ALLOC(sizeof(ConvexShape));
+	*out_convex = (ConvexShape) {
+		.ref_count = 1,
 		.hull = hull,
+		.adjacency_offsets = adjacency_offsets,
+		.adjacency = adjacency,
 		.bounds = bounds,
 		.inertia_tensor = inertia_tensor,
+		.inverse_inertia_tensor = optional_get(mat3_inverse(inertia_tensor)),
 		.center_of_mass = center_of_mass,
 	};
+	return out_convex;
+}
+
+ConvexShape* convex_shape_acquire(ConvexShape* in_convex)
+{
+	in_convex->ref_count += 1;
+	return in_convex;
+}
+
+void convex_shape_release(ConvexShape* in_convex)
+{
+	assert(in_convex->ref_count > 0);
+	in_convex->ref_count -= 1;
+	if (in_convex->ref_count == 0)
+	{
+		convex_hull_destroy(&in_convex->hull);
+		FCS_MEM_FREE(in_convex->adjacency_offsets);
+		FCS_MEM_FREE(in_convex->adjacency);
+		FCS_MEM_FREE(in_convex);
+	}
+}
+
+// Convex shapes by the points they were built from, so bodies sharing a mesh build its hull and mass properties once
+typedef struct ShapeLibraryEntry
+{
+	u64 hash;
+	i32 next_idx;	// Next entry with the same hash, or -1
+	sbuffer(Vec3) source_points;
+	ConvexShape* convex;	// The library holds a reference of its own, so unused shapes stay ready until the library is freed
+} ShapeLibraryEntry;
+
+typedef struct ShapeLibrary
+{
+	sbuffer(ShapeLibraryEntry) entries;
+	PairMap entry_indices;	// Hash -> index of the newest entry with that hash
+} ShapeLibrary;
+
+void shape_library_init(ShapeLibrary* out_shape_library)
+{
+	*out_shape_library = (ShapeLibrary) {};
+	pair_map_init(&out_shape_library->entry_indices);
+}
+
+void shape_library_free(ShapeLibrary* in_shape_library)
+{
+	for (i32 entry_idx = 0; entry_idx < sb_count(in_shape_library->entries); ++entry_idx)
+	{
+		ShapeLibraryEntry* entry = &in_shape_library->entries[entry_idx];
+		sb_free(entry->source_points);
+		convex_shape_release(entry->convex);
+	}
+	sb_free(in_shape_library->entries);
+	pair_map_free(&in_shape_library->entry_indices);
+}
+
+// FNV-1a over the points' bytes. Never PAIR_MAP_EMPTY_KEY, so it can key a PairMap
+static inline u64 shape_library_hash_points(const Vec3* in_points, const i32 in_num_points)
+{
+	const u8* bytes = (const u8*) in_points;
+	u64 hash = 14695981039346656037ull;
+	for (size_t byte_idx = 0; byte_idx < sizeof(Vec3) * in_num_points; ++byte_idx)
+	{
+		hash = (hash ^ bytes[byte_idx]) * 1099511628211ull;
+	}
+	return hash != PAIR_MAP_EMPTY_KEY ? hash : 0;
+}
+
+// Returns a new reference to the convex shape of in_points, building it the first time those points are seen
+ConvexShape* shape_library_get_convex(ShapeLibrary* in_shape_library, const Vec3* in_points, const i32 in_num_points)
+{
+	const u64 hash = shape_library_hash_points(in_points, in_num_points);
+
+	// Entries sharing a hash are chained, so a collision only costs a compare
+	i32* first_entry_idx = pair_map_find(&in_shape_library->entry_indices, hash);
+	for (i32 entry_idx = first_entry_idx ? *first_entry_idx : -1; entry_idx >= 0; entry_idx = in_shape_library->entries[entry_idx].next_idx)
+	{
+		const ShapeLibraryEntry* entry = &in_shape_library->entries[entry_idx];
+		if (	sb_count(entry->source_points) == in_num_points
+			&&	memcmp(entry->source_points, in_points, sizeof(Vec3) * in_num_points) == 0)
+		{
+			return convex_shape_acquire(entry->convex);
+		}
+	}
+
+	const i32 new_entry_idx = sb_count(in_shape_library->entries);
+	ShapeLibraryEntry new_entry = {
+		.hash = hash,
+		.next_idx = first_entry_idx ? *first_entry_idx : -1,
+		.source_points = NULL,
+		.convex = convex_shape_create(in_points, in_num_points),
+	};
+	sb_append_array(new_entry.source_points, in_points, in_num_points);
+	sb_push(in_shape_library->entries, new_entry);
+
+	if (first_entry_idx)
+	{
+		*first_entry_idx = new_entry_idx;
+	}
+	else
+	{
+		pair_map_insert(&in_shape_library->entry_indices, hash, new_entry_idx);
+	}
+	return convex_shape_acquire(new_entry.convex);
 }
 
 typedef struct Shape
@@ -110,11 +309,21 @@ typedef struct Shape
 	{
 		SphereShape sphere;
 		BoxShape box;
-		ConvexShape convex;
+		ConvexShape* convex;	// A reference owned by the shape
 	};
 } Shape;
 
-Mat3 shape_get_inertia_tensor_matrix(Shape* in_shape)
+// Drops the shape's reference to any data it shares with other shapes
+void shape_release(Shape* in_shape)
+{
+	if (in_shape->type == SHAPE_TYPE_CONVEX && in_shape->convex)
+	{
+		convex_shape_release(in_shape->convex);
+		in_shape->convex = NULL;
+	}
+}
+
+Mat3 shape_get_inertia_tensor_matrix(const Shape* in_shape)
 {
 	switch (in_shape->type)
 	{
@@ -133,62 +342,93 @@ Mat3 shape_get_inertia_tensor_matrix(Shape* in_shape)
 		}
 		case SHAPE_TYPE_BOX:
 		{	
-			const BoxShape box = in_shape->box;
-			const f32 dx = box.bounds.max.x - box.bounds.min.x;
-			const f32 dy = box.bounds.max.y - box.bounds.min.y;
-			const f32 dz = box.bounds.max.z - box.bounds.min.z;
-
-			const f32 dx2 = dx * dx;
-			const f32 dy2 = dy * dy;
-			const f32 dz2 = dz * dz;
-
-			// Inertia tensor for box centered at (0,0,0)
-			Mat3 box_tensor = {
-				.d[0][0] = (dy2 + dz2) / 12.0f,
-				.d[1][1] = (dx2 + dz2) / 12.0f,
-				.d[2][2] = (dx2 + dy2) / 12.0f,
-			};
-
-			// Use parallel axis theorem to handle box not centered at origin
-			const Vec3 cm = vec3_new(
-				(box.bounds.max.x + box.bounds.min.x) * 0.5f,
-				(box.bounds.max.y + box.bounds.min.y) * 0.5f,
-				(box.bounds.max.z + box.bounds.min.z) * 0.5f
-			);
-
-			const Vec3 r = vec3_sub(vec3_zero, cm);
-			const f32 r_l2 = vec3_length_squared(r);
+			return box_shape_get_inertia_tensor(&in_shape->box);
+		}
+		case SHAPE_TYPE_CONVEX:
+		{
+			return in_shape->convex->inertia_tensor;
+		}
+	}
+	assert(false);
+}
 
-			Mat3 pat_tensor = {
-				.columns[0] =	vec3_new(r_l2 - r.x * r.x,	r.x * r.y,			r.x * r.z),
-				.columns[1] =	vec3_new(r.y * r.x, 		r_l2 - r.y * r.y,	r.y * r.z),
-				.columns[2] =	vec3_new(r.z * r.x, 		r.z * r.y,			r_l2 - r.z * r.z)
+// Inverse of shape_get_inertia_tensor_matrix. Boxes and convex shapes cache it and spheres have a closed form, so nothing is inverted here
+Mat3 shape_get_inverse_inertia_tensor_matrix(const Shape* in_shape)
+{
+	switch (in_shape->type)
+	{
+		case SHAPE_TYPE_SPHERE:
+		{
+			const f32 sphere_radius = in_shape->sphere.radius;
+			const f32 inverse_tensor_value = 5.0f / (2.0f * sphere_radius * sphere_radius);
+			Mat3 inverse_sphere_tensor = {
+				.d[0][0] = inverse_tensor_value,
+				.d[1][1] = inverse_tensor_value,
+				.d[2][2] = inverse_tensor_value,
 			};
-
-			return mat3_add_mat3(box_tensor, pat_tensor);
+			return inverse_sphere_tensor;
+		}
+		case SHAPE_TYPE_BOX:
+		{
+			return in_shape->box.inverse_inertia_tensor;
 		}
 		case SHAPE_TYPE_CONVEX:
 		{
-			return in_shape->convex.inertia_tensor;
+			return in_shape->convex->inverse_inertia_tensor;
 		}
 	}
 	assert(false);
 }
 
+// State the step reads and writes for every body. Shapes and render-only data live in arrays parallel to PhysicsScene.bodies, keeping this small
 typedef struct PhysicsBody
 {
 	Vec3 position;
 	Quat orientation;
 	Vec3 linear_velocity;
 	Vec3 angular_velocity;
-	Shape shape;
+	const Shape* shape;	// For bodies in a scene, the body's entry in PhysicsScene.shapes
 	f32 inverse_mass;
 	f32 elasticity;
 	f32 friction;
 
+	f32 sleep_time;		// How long the body has been slower than the sleep thresholds
+	bool is_sleeping;	// Sleeping bodies aren't moved or tested against each other until something wakes them
+} PhysicsBody;
+
+// Per-body data only read when rendering
+typedef struct PhysicsBodyRenderData
+{
+	Vec3 previous_position;		// Pose at the start of the latest step, for interpolating between steps
+	Quat previous_orientation;
 	Vec3 debug_color;
+} PhysicsBodyRenderData;
 
-} PhysicsBody;
+// Everything needed to add a body to a PhysicsScene
+typedef struct PhysicsBodyCreateInfo
+{
+	Vec3 position;
+	Quat orientation;
+	Vec3 linear_velocity;
+	Vec3 angular_velocity;
+	Shape shape;
+	f32 inverse_mass;
+	f32 elasticity;
+	f32 friction;
+	bool is_sleeping;	// Starts the body asleep, until something touches it or it's woken
+	Vec3 debug_color;
+} PhysicsBodyCreateInfo;
+
+// Refers to a body in a PhysicsScene. Bodies are stored contiguously and move when the scene grows, so hold on to these rather than pointers
+// Bodies can't be removed from a scene, so a handle stays valid for the scene's lifetime and doesn't need a generation
+typedef struct PhysicsBodyHandle
+{
+	i32 idx;	// Index into PhysicsScene.bodies and its parallel arrays, which never changes once added
+} PhysicsBodyHandle;
+
+typedef struct PhysicsScene PhysicsScene;
+
+PhysicsBody* physics_scene_get_body(PhysicsScene* in_physics_scene, const PhysicsBodyHandle in_handle);
 
 typedef struct PhysicsContact
 {
@@ -201,61 +441,81 @@ typedef struct PhysicsContact
 	f32 separation_distance;
 	f32 time_of_impact;
 
-	PhysicsBody* body_a;
-	PhysicsBody* body_b;
+	PhysicsBodyHandle body_a;	// Set by the scene. Contact functions only see the bodies, which may be copies
+	PhysicsBodyHandle body_b;
+	u64 pair_id;	// pair_map_key of the two body indices. Breaks ties between contacts with the same time_of_impact
+	i32 pair_point_idx;	// Which of its pair's contacts this is, so contacts of one pair keep their order too
+	bool sub_step;	// Either body is fast, so this contact is resolved at its time_of_impact rather than by the solver
 } PhysicsContact;
 
 
+// Index of the hull point furthest along in_local_dir, found by walking from in_start_idx to whichever neighbor is further along
+// Every local maximum on a convex hull is a global one, so this visits a handful of points rather than all of them
+i32 convex_shape_support_index(const ConvexShape* in_convex, const Vec3 in_local_dir, const i32 in_start_idx)
+{
+	const Vec3* points = in_convex->hull.points;
+	assert(in_start_idx >= 0 && in_start_idx < sb_count(points));
+
+	i32 best_idx = in_start_idx;
+	f32 best_distance = vec3_dot(points[best_idx], in_local_dir);
+	bool is_improved = true;
+	while (is_improved)
+	{
+		is_improved = false;
+
+		const i32 current_idx = best_idx;
+		for (i32 adjacency_idx = in_convex->adjacency_offsets[current_idx]; adjacency_idx < in_convex->adjacency_offsets[current_idx + 1]; ++adjacency_idx)
+		{
+			const i32 neighbor_idx = in_convex->adjacency[adjacency_idx];
+			const f32 distance = vec3_dot(points[neighbor_idx], in_local_dir);
+			if (distance > best_distance)
+			{
+				best_distance = distance;
+				best_idx = neighbor_idx;
+				is_improved = true;
+			}
+		}
+	}
+
+	return best_idx;
+}
+
 // Returns point on a convex shape that's furthest in a particular direction
-Vec3 physics_body_support(const PhysicsBody* in_body, const Vec3 in_dir, const f32 in_bias)
+// in_dir is rotated into local space once, where boxes have a closed form and hulls are walked from *io_vertex_hint
+// io_vertex_hint is the hull point the search starts from, and receives the point found. Queries in similar directions, like those of one GJK run, then take only a step or two
+Vec3 physics_body_support_hinted(const PhysicsBody* in_body, const Vec3 in_dir, const f32 in_bias, i32* io_vertex_hint)
 {	
-	switch(in_body->shape.type)
+	switch(in_body->shape->type)
 	{
 		case SHAPE_TYPE_SPHERE:
 		{
-			const SphereShape* sphere = &in_body->shape.sphere;
+			const SphereShape* sphere = &in_body->shape->sphere;
 			return vec3_add(in_body->position, vec3_scale(in_dir, sphere->radius + in_bias));
 		}
 		case SHAPE_TYPE_BOX:
 		{
-			const BoxShape* box = &in_body->shape.box;
-			Vec3 max_point = vec3_add(quat_rotate_vec3(in_body->orientation, box->points[0]), in_body->position);
-			f32 max_distance = vec3_dot(in_dir, max_point);
-
-			for (i32 point_idx = 1; point_idx < NUM_BOX_POINTS; ++point_idx)
-			{
-				const Vec3 current_point = vec3_add(quat_rotate_vec3(in_body->orientation, box->points[point_idx]), in_body->position);
-				const f32 current_distance = vec3_dot(in_dir, current_point);
-				if (current_distance > max_distance)
-				{
-					max_point = current_point;
-					max_distance = current_distance;
-				}
-			}
+			const BoxShape* box = &in_body->shape->box;
+			const Vec3 local_dir = quat_rotate_vec3(quat_conjugate(in_body->orientation), in_dir);
+			const Vec3 local_point = vec3_new(
+				local_dir.x >= 0.0f ? box->bounds.max.x : box->bounds.min.x,
+				local_dir.y >= 0.0f ? box->bounds.max.y : box->bounds.min.y,
+				local_dir.z >= 0.0f ? box->bounds.max.z : box->bounds.min.z
+			);
+			const Vec3 max_point = vec3_add(quat_rotate_vec3(in_body->orientation, local_point), in_body->position);
 
 			Vec3 norm = vec3_scale(vec3_normalize(in_dir), in_bias);
 			return vec3_add(max_point, norm);	
 		}
 		case SHAPE_TYPE_CONVEX:
 		{
-			const ConvexShape* convex = &in_body->shape.convex;
-			const ConvexHull* hull = &convex->hull;	
-			i32 num_convex_points = sb_count(hull->points);
+			const ConvexShape* convex = in_body->shape->convex;
+			const i32 num_convex_points = sb_count(convex->hull.points);
 			assert(num_convex_points > 0);
 
-			Vec3 max_point = vec3_add(quat_rotate_vec3(in_body->orientation, hull->points[0]), in_body->position);
-			f32 max_distance = vec3_dot(in_dir, max_point);
-
-			for (i32 point_idx = 1; point_idx < num_convex_points; ++point_idx)
-			{
-				const Vec3 current_point = vec3_add(quat_rotate_vec3(in_body->orientation, hull->points[point_idx]), in_body->position);
-				const f32 current_distance = vec3_dot(in_dir, current_point);
-				if (current_distance > max_distance)
-				{
-					max_point = current_point;
-					max_distance = current_distance;
-				}
-			}
+			const Vec3 local_dir = quat_rotate_vec3(quat_conjugate(in_body->orientation), in_dir);
+			const i32 start_idx = (*io_vertex_hint >= 0 && *io_vertex_hint < num_convex_points) ? *io_vertex_hint : 0;
+			*io_vertex_hint = convex_shape_support_index(convex, local_dir, start_idx);
+			const Vec3 max_point = vec3_add(quat_rotate_vec3(in_body->orientation, convex->hull.points[*io_vertex_hint]), in_body->position);
 
 			Vec3 norm = vec3_scale(vec3_normalize(in_dir), in_bias);
 			return vec3_add(max_point, norm);	
@@ -266,18 +526,43 @@ Vec3 physics_body_support(const PhysicsBody* in_body, const Vec3 in_dir, const f
 	return vec3_zero;
 }
 
+// Returns point on a convex shape that's furthest in a particular direction
+Vec3 physics_body_support(const PhysicsBody* in_body, const Vec3 in_dir, const f32 in_bias)
+{
+	i32 vertex_hint = 0;
+	return physics_body_support_hinted(in_body, in_dir, in_bias, &vertex_hint);
+}
+
+// Hull points the previous support query on each body returned, carried between the queries of one GJK or EPA run
+typedef struct PhysicsSupportHint
+{
+	i32 vertex_a;
+	i32 vertex_b;
+} PhysicsSupportHint;
+
+// What the last narrowphase query of a body pair found, so the next one can start from it
+// Pairs rarely move much between steps, so the old axis is usually still separating, or close to the new closest points
+typedef struct PhysicsGjkCache
+{
+	u64 pair_id;
+	Vec3 separating_axis;				// Last normal from a to b, in a's local space so it turns with the pair
+	PhysicsSupportHint support_hint;	// Support points of the last simplex
+	bool is_valid;						// separating_axis has been set
+	bool is_active;						// The pair was passed to the narrowphase this update
+} PhysicsGjkCache;
+
 /** Calls physics_body_support on both bodies, storing the results as well as their difference */
-MinkowskiPoint physics_bodies_support(const PhysicsBody* in_body_a, const PhysicsBody* in_body_b, const Vec3 in_dir, const f32 in_bias)
+MinkowskiPoint physics_bodies_support(const PhysicsBody* in_body_a, const PhysicsBody* in_body_b, const Vec3 in_dir, const f32 in_bias, PhysicsSupportHint* io_hint)
 {
 	MinkowskiPoint out_point = {};
 
 	// Find point in body a furthest in dir
 	const Vec3 normalized_dir = vec3_normalize(in_dir);	
-	out_point.pt_a = physics_body_support(in_body_a, normalized_dir, in_bias);
+	out_point.pt_a = physics_body_support_hinted(in_body_a, normalized_dir, in_bias, &io_hint->vertex_a);
 
 	// Find point in body b furthest in dir
 	const Vec3 reversed_dir = vec3_scale(normalized_dir, -1.0f);
-	out_point.pt_b = physics_body_support(in_body_b, reversed_dir, in_bias);
+	out_point.pt_b = physics_body_support_hinted(in_body_b, reversed_dir, in_bias, &io_hint->vertex_b);
 
 	// xyz is minkowski sum point
 	out_point.xyz = vec3_sub(out_point.pt_a, out_point.pt_b);
@@ -290,138 +575,80 @@ f32 physics_bodies_epa_expand(
 	const PhysicsBody* in_body_b, 
 	const f32 in_bias, 
 	const MinkowskiPoint in_simplex_points[4],
+	PhysicsSupportHint* io_hint,
 	Vec3* out_point_on_a,
 	Vec3* out_point_on_b
 )
 {
-	sbuffer(MinkowskiPoint) points = NULL;
-	sbuffer(ConvexTri) tris = NULL;
-	sbuffer(ConvexEdge) dangling_edges = NULL;
-
-	// Add points from in_simplex_points and determine center
-	Vec3 center = vec3_zero;
-	for (i32 i = 0; i < 4; ++i)
-	{
-		sb_push(points, in_simplex_points[i]);
-		center = vec3_add(center, in_simplex_points[i].xyz);
-	}
-	center = vec3_scale(center, 0.25f);
-
-	// Build up triangles
-	for (i32 i = 0; i < 4; ++i)
-	{
-		const i32 j = (i + 1) % 4;	
-		const i32 k = (i + 2) % 4;
-
-		ConvexTri tri = {
-			.a = i,
-			.b = j,
-			.c = k,
-		};
-		
-		i32 unused_idx = (i + 3) % 4;
-
-		if (signed_distance_to_triangle(tri, points[unused_idx].xyz, points, sb_count(points)) > 0.0f)
-		{
-			SWAP(i32, tri.a, tri.b);
-		}
-
-		sb_push(tris, tri);
-	}
+	EpaPolytope polytope;
+	epa_polytope_init(&polytope, in_simplex_points);
 
 	// Expand the simplex to find the closest face of the CSO to the origin
 	while (1)
 	{
-		const i32 idx = closest_triangle(tris, sb_count(tris), points, sb_count(points));
-		const Vec3 normal = triangle_normal_direction(tris[idx], points, sb_count(points));
-		const MinkowskiPoint new_point = physics_bodies_support(in_body_a, in_body_b, normal, in_bias);
+		const EpaFace* face = &polytope.faces[epa_polytope_closest_face(&polytope)];
+		const MinkowskiPoint new_point = physics_bodies_support(in_body_a, in_body_b, face->normal, in_bias, io_hint);
 
 		// if w already exists, we can't expand further
-		if (triangle_has_point(new_point.xyz, tris, sb_count(tris), points, sb_count(points)))
-		{
-			break;	
-		}
-
-		// if distance isn't beyond origin, can't expand
-		if (signed_distance_to_triangle(tris[idx], new_point.xyz, points, sb_count(points)) <= 0.0f)
+		if (epa_polytope_has_point(&polytope, new_point.xyz))
 		{
 			break;
 		}
 
-		// Add new point
-		const i32 new_idx = sb_count(points);	
-		sb_push(points, new_point);
-
-		// Remove triangles that face this point
-		i32 num_removed = remove_triangles_facing_point(new_point.xyz, &tris, points, sb_count(points));
-		if (num_removed == 0)
+		// if distance isn't beyond origin, can't expand
+		if (vec3_dot(face->normal, new_point.xyz) - face->distance <= 0.0f)
 		{
 			break;
 		}
 
-		// Find dangling edges
-		find_dangling_edges(tris, sb_count(tris), &dangling_edges);
-		if (sb_count(dangling_edges) == 0)
+		if (!epa_polytope_expand(&polytope, &new_point))
 		{
 			break;
 		}
-
-		for (i32 i = 0; i < sb_count(dangling_edges); ++i)
-		{
-			const ConvexEdge edge = dangling_edges[i];
-
-			ConvexTri tri = {
-				.a = new_idx,
-				.b = edge.b,
-				.c = edge.a,
-			};
-
-			if (signed_distance_to_triangle(tri, center, points, sb_count(points)) > 0.0f)
-			{
-				SWAP(i32, tri.b, tri.c);
-			}
-
-			sb_push(tris, tri);
-		}
 	}
 
-	const i32 tri_idx = closest_triangle(tris, sb_count(tris), points, sb_count(points));
-	const ConvexTri tri = tris[tri_idx];
+	const EpaFace face = polytope.faces[epa_polytope_closest_face(&polytope)];
+	const MinkowskiPoint* points = polytope.points;
 
 	const Vec3 lambdas = barycentric_coordinates(
-		points[tri.a].xyz, 
-		points[tri.b].xyz, 
-		points[tri.c].xyz, 
+		points[face.a].xyz, 
+		points[face.b].xyz, 
+		points[face.c].xyz, 
 		vec3_zero
 	);
 
 	*out_point_on_a = vec3_add(
-		vec3_scale(points[tri.a].pt_a, lambdas.v[0]), 
+		vec3_scale(points[face.a].pt_a, lambdas.v[0]), 
 		vec3_add(
-			vec3_scale(points[tri.b].pt_a, lambdas.v[1]), 
-			vec3_scale(points[tri.c].pt_a, lambdas.v[2])
+			vec3_scale(points[face.b].pt_a, lambdas.v[1]), 
+			vec3_scale(points[face.c].pt_a, lambdas.v[2])
 		)
 	);
 
 	*out_point_on_b = vec3_add(
-		vec3_scale(points[tri.a].pt_b, lambdas.v[0]), 
+		vec3_scale(points[face.a].pt_b, lambdas.v[0]), 
 		vec3_add(
-			vec3_scale(points[tri.b].pt_b, lambdas.v[1]), 
-			vec3_scale(points[tri.c].pt_b, lambdas.v[2])
+			vec3_scale(points[face.b].pt_b, lambdas.v[1]), 
+			vec3_scale(points[face.c].pt_b, lambdas.v[2])
 		)
 	);
 
-	sb_free(points);
-	sb_free(tris);
-	sb_free(dangling_edges);
-
 	const Vec3 delta = vec3_sub(*out_point_on_b, *out_point_on_a);
 	return vec3_length(delta);
 }
 
 const i32 MAX_GJK_ITERATIONS = 64;
 
-bool physics_bodies_gjk_intersect(const PhysicsBody* in_body_a, const PhysicsBody* in_body_b, const f32 in_bias, Vec3* out_pt_on_a, Vec3* out_pt_on_b)
+// in_initial_dir is the first search direction, from a to b. A previous separating axis gets there in fewer iterations than an arbitrary one
+bool physics_bodies_gjk_intersect(
+	const PhysicsBody* in_body_a,
+	const PhysicsBody* in_body_b,
+	const f32 in_bias,
+	const Vec3 in_initial_dir,
+	PhysicsSupportHint* io_hint,
+	Vec3* out_pt_on_a,
+	Vec3* out_pt_on_b
+)
 {
 	assert(out_pt_on_a != NULL);
 	assert(out_pt_on_b != NULL);
@@ -430,7 +657,7 @@ bool physics_bodies_gjk_intersect(const PhysicsBody* in_body_a, const PhysicsBod
 
 	i32 num_points = 1;
 	MinkowskiPoint simplex_points[4] = {0};
-	simplex_points[0] = physics_bodies_support(in_body_a, in_body_b, vec3_new(1,1,1), 0.0f);
+	simplex_points[0] = physics_bodies_support(in_body_a, in_body_b, in_initial_dir, 0.0f, io_hint);
 
 	f32 closest_dist = 1e10f;
 	bool contains_origin = false;
@@ -444,7 +671,7 @@ bool physics_bodies_gjk_intersect(const PhysicsBody* in_body_a, const PhysicsBod
 			break;
 		}
 
-		MinkowskiPoint new_point = physics_bodies_support(in_body_a, in_body_b, new_dir, 0.0f);
+		MinkowskiPoint new_point = physics_bodies_support(in_body_a, in_body_b, new_dir, 0.0f, io_hint);
 
 		// if new point is same as previous, then we can't expand further
 		if (simplex_has_point(simplex_points, num_points, &new_point))
@@ -502,7 +729,7 @@ bool physics_bodies_gjk_intersect(const PhysicsBody* in_body_a, const PhysicsBod
 	if (num_points == 1)
 	{
 		const Vec3 search_dir = vec3_negate(simplex_points[0].xyz);
-		const MinkowskiPoint new_point = physics_bodies_support(in_body_a, in_body_b, search_dir, 0.0f);
+		const MinkowskiPoint new_point = physics_bodies_support(in_body_a, in_body_b, search_dir, 0.0f, io_hint);
 		simplex_points[num_points] = new_point;
 		num_points += 1;
 	}
@@ -514,7 +741,7 @@ bool physics_bodies_gjk_intersect(const PhysicsBody* in_body_a, const PhysicsBod
 		vec3_get_ortho(ab, &u, &v);
 
 		const Vec3 search_dir = u;
-		const MinkowskiPoint new_point = physics_bodies_support(in_body_a, in_body_b, search_dir, 0.0f);
+		const MinkowskiPoint new_point = physics_bodies_support(in_body_a, in_body_b, search_dir, 0.0f, io_hint);
 		simplex_points[num_points] = new_point;
 		num_points += 1;
 	}
@@ -526,7 +753,7 @@ bool physics_bodies_gjk_intersect(const PhysicsBody* in_body_a, const PhysicsBod
 		const Vec3 norm = vec3_cross(ab,ac);
 
 		const Vec3 search_dir = norm;
-		const MinkowskiPoint new_point = physics_bodies_support(in_body_a, in_body_b, search_dir, 0.0f);
+		const MinkowskiPoint new_point = physics_bodies_support(in_body_a, in_body_b, search_dir, 0.0f, io_hint);
 		simplex_points[num_points] = new_point;
 		num_points += 1;
 	}
@@ -550,12 +777,19 @@ bool physics_bodies_gjk_intersect(const PhysicsBody* in_body_a, const PhysicsBod
 		pt->xyz = vec3_sub(pt->pt_a, pt->pt_b);
 	}
 
-	physics_bodies_epa_expand(in_body_a, in_body_b, in_bias, simplex_points, out_pt_on_a, out_pt_on_b);
+	physics_bodies_epa_expand(in_body_a, in_body_b, in_bias, simplex_points, io_hint, out_pt_on_a, out_pt_on_b);
 
 	return true;
 }
 
-void physics_bodies_gjk_closest_points(const PhysicsBody* in_body_a, const PhysicsBody* in_body_b, Vec3* out_point_on_a, Vec3* out_point_on_b)
+void physics_bodies_gjk_closest_points(
+	const PhysicsBody* in_body_a,
+	const PhysicsBody* in_body_b,
+	const Vec3 in_initial_dir,
+	PhysicsSupportHint* io_hint,
+	Vec3* out_point_on_a,
+	Vec3* out_point_on_b
+)
 {
 	assert(out_point_on_a != NULL);
 	assert(out_point_on_b != NULL);
@@ -568,7 +802,7 @@ void physics_bodies_gjk_closest_points(const PhysicsBody* in_body_a, const Physi
 	i32 num_points = 1;
 	MinkowskiPoint simplex_points[4] = {0};
 
-	simplex_points[0] = physics_bodies_support(in_body_a, in_body_b, vec3_new(1,1,1), bias);
+	simplex_points[0] = physics_bodies_support(in_body_a, in_body_b, in_initial_dir, bias, io_hint);
 
 	Vec4 lambdas = vec4_new(1,0,0,0);
 	Vec3 new_dir = vec3_negate(simplex_points[0].xyz);
@@ -581,7 +815,7 @@ void physics_bodies_gjk_closest_points(const PhysicsBody* in_body_a, const Physi
 			break;
 		}
 
-		const MinkowskiPoint new_point = physics_bodies_support(in_body_a, in_body_b, new_dir, bias);
+		const MinkowskiPoint new_point = physics_bodies_support(in_body_a, in_body_b, new_dir, bias, io_hint);
 
 		// if the new point is the same as a previous point: break
 		if (simplex_has_point(simplex_points, num_points, &new_point))
@@ -620,7 +854,7 @@ void physics_bodies_gjk_closest_points(const PhysicsBody* in_body_a, const Physi
 
 f32 physics_body_get_max_linear_speed(const PhysicsBody* in_body, const Vec3 in_angular_velocity, const Vec3 in_dir)
 {
-	switch(in_body->shape.type)
+	switch(in_body->shape->type)
 	{
 		case SHAPE_TYPE_SPHERE:
 		{
@@ -628,7 +862,7 @@ f32 physics_body_get_max_linear_speed(const PhysicsBody* in_body, const Vec3 in_
 		}
 		case SHAPE_TYPE_BOX:
 		{
-			const BoxShape box = in_body->shape.box;
+			const BoxShape box = in_body->shape->box;
 			f32 max_speed = 0.f;
 			for (i32 i = 0; i < NUM_BOX_POINTS; ++i)
 			{
@@ -641,11 +875,11 @@ f32 physics_body_get_max_linear_speed(const PhysicsBody* in_body, const Vec3 in_
 		}
 		case SHAPE_TYPE_CONVEX:
 		{
-			const ConvexShape convex = in_body->shape.convex;
+			const ConvexShape* convex = in_body->shape->convex;
 			f32 max_speed = 0.f;
-			for (i32 i = 0; i < sb_count(convex.hull.points); ++i)
+			for (i32 i = 0; i < sb_count(convex->hull.points); ++i)
 			{
-				const Vec3 r = vec3_sub(convex.hull.points[i], convex.center_of_mass);
+				const Vec3 r = vec3_sub(convex->hull.points[i], convex->center_of_mass);
 				const Vec3 linear_velocity = vec3_cross(in_angular_velocity, r);
 				const f32 point_speed = vec3_dot(in_dir, linear_velocity);
 				if (point_speed > max_speed) { max_speed = point_speed; }
@@ -660,15 +894,42 @@ f32 physics_body_get_max_linear_speed(const PhysicsBody* in_body, const Vec3 in_
 	}
 }
 
+Affine3 physics_body_get_transform(const PhysicsBody* in_body)
+{
+	return affine3_from_quat_translation(in_body->orientation, in_body->position);
+}
+
+// World space bounds of in_local_bounds under in_transform. Projects the extents onto each world axis instead of transforming all 8 corners
+Bounds bounds_transform_affine(const Bounds in_local_bounds, const Affine3 in_transform)
+{
+	const Vec3 local_center = vec3_scale(vec3_add(in_local_bounds.min, in_local_bounds.max), 0.5f);
+	const Vec3 local_extents = vec3_scale(vec3_sub(in_local_bounds.max, in_local_bounds.min), 0.5f);
+
+	Vec3 world_extents = vec3_zero;
+	for (i32 col = 0; col < 3; ++col)
+	{
+		for (i32 row = 0; row < 3; ++row)
+		{
+			world_extents.v[row] += fabsf(in_transform.d[col][row]) * local_extents.v[col];
+		}
+	}
+
+	const Vec3 world_center = affine3_transform_point(in_transform, local_center);
+	return (Bounds) {
+		.min = vec3_sub(world_center, world_extents),
+		.max = vec3_add(world_center, world_extents),
+	};
+}
+
 Bounds physics_body_get_bounds(const PhysicsBody* in_body)
 {
 	Bounds out_bounds = bounds_init();
 
-	switch(in_body->shape.type)
+	switch(in_body->shape->type)
 	{
 		case SHAPE_TYPE_SPHERE:
 		{
-			const SphereShape sphere = in_body->shape.sphere;
+			const SphereShape sphere = in_body->shape->sphere;
 			const f32 radius = sphere.radius;
 			out_bounds = (Bounds) {
 				.min = vec3_sub(in_body->position, vec3_new(radius, radius, radius)),
@@ -678,50 +939,12 @@ Bounds physics_body_get_bounds(const PhysicsBody* in_body)
 		}
 		case SHAPE_TYPE_BOX:
 		{
-			//FCS TODO: bounds_to_world helper
-			const BoxShape box = in_body->shape.box;
-			Vec3 corners[NUM_BOX_POINTS] =
-			{
-				vec3_new(box.bounds.min.x, box.bounds.min.y, box.bounds.min.z),
-				vec3_new(box.bounds.min.x, box.bounds.min.y, box.bounds.max.z),
-				vec3_new(box.bounds.min.x, box.bounds.max.y, box.bounds.min.z),
-				vec3_new(box.bounds.max.x, box.bounds.min.y, box.bounds.min.z),
-
-				vec3_new(box.bounds.max.x, box.bounds.max.y, box.bounds.max.z),
-				vec3_new(box.bounds.max.x, box.bounds.max.y, box.bounds.min.z),
-				vec3_new(box.bounds.max.x, box.bounds.min.y, box.bounds.max.z),
-				vec3_new(box.bounds.min.x, box.bounds.max.y, box.bounds.max.z),
-			};
-
-			for (i32 i = 0; i < NUM_BOX_POINTS; ++i)
-			{
-				corners[i] = vec3_add(quat_rotate_vec3(in_body->orientation, corners[i]), in_body->position);
-				bounds_expand_point(&out_bounds, corners[i]);
-			}
+			out_bounds = bounds_transform_affine(in_body->shape->box.bounds, physics_body_get_transform(in_body));
 			break;
 		}
 		case SHAPE_TYPE_CONVEX:
 		{
-			//FCS TODO: bounds_to_world helper
-			const ConvexShape convex = in_body->shape.convex;
-			Vec3 corners[NUM_BOX_POINTS] =
-			{
-				vec3_new(convex.bounds.min.x, convex.bounds.min.y, convex.bounds.min.z),
-				vec3_new(convex.bounds.min.x, convex.bounds.min.y, convex.bounds.max.z),
-				vec3_new(convex.bounds.min.x, convex.bounds.max.y, convex.bounds.min.z),
-				vec3_new(convex.bounds.max.x, convex.bounds.min.y, convex.bounds.min.z),
-
-				vec3_new(convex.bounds.max.x, convex.bounds.max.y, convex.bounds.max.z),
-				vec3_new(convex.bounds.max.x, convex.bounds.max.y, convex.bounds.min.z),
-				vec3_new(convex.bounds.max.x, convex.bounds.min.y, convex.bounds.max.z),
-				vec3_new(convex.bounds.min.x, convex.bounds.max.y, convex.bounds.max.z),
-			};
-
-			for (i32 i = 0; i < NUM_BOX_POINTS; ++i)
-			{
-				corners[i] = vec3_add(quat_rotate_vec3(in_body->orientation, corners[i]), in_body->position);
-				bounds_expand_point(&out_bounds, corners[i]);
-			}
+			out_bounds = bounds_transform_affine(in_body->shape->convex->bounds, physics_body_get_transform(in_body));
 			break;
 		}
 		default:
@@ -740,17 +963,16 @@ Vec3 physics_body_local_to_world_space(const PhysicsBody* in_body, Vec3 in_body_
 	return translated;
 }
 
+// Bodies are rigid, so their transform is inverted by transposing its rotation
 Vec3 physics_body_world_to_local_space(const PhysicsBody* in_body, Vec3 in_world_point)
 {
-	Vec3 untranslated = vec3_sub(in_world_point, in_body->position);
-	Vec3 unrotated = quat_rotate_vec3(quat_inverse(in_body->orientation), untranslated);
-	return unrotated;
+	return affine3_transform_point(affine3_inverse_rigid(physics_body_get_transform(in_body)), in_world_point);
 }
 
-Vec3 physics_body_get_center_of_mass_world(const PhysicsBody* in_body)
+Vec3 physics_body_get_center_of_mass_local(const PhysicsBody* in_body)
 {
-	Vec3 local_space_center_of_mass = vec3_zero;;
-	switch (in_body->shape.type)
+	Vec3 local_space_center_of_mass = vec3_zero;
+	switch (in_body->shape->type)
 	{
 		case SHAPE_TYPE_SPHERE:			
 		{
@@ -759,22 +981,27 @@ Vec3 physics_body_get_center_of_mass_world(const PhysicsBody* in_body)
 		}
 		case SHAPE_TYPE_BOX:
 		{	
-			local_space_center_of_mass = in_body->shape.box.center_of_mass;
+			local_space_center_of_mass = in_body->shape->box.center_of_mass;
 			break;
 		}
 		case SHAPE_TYPE_CONVEX:
 		{
-			local_space_center_of_mass = in_body->shape.convex.center_of_mass;
+			local_space_center_of_mass = in_body->shape->convex->center_of_mass;
 			break;
 		}
 	}
 
-	return physics_body_local_to_world_space(in_body, local_space_center_of_mass);
+	return local_space_center_of_mass;
+}
+
+Vec3 physics_body_get_center_of_mass_world(const PhysicsBody* in_body)
+{
+	return physics_body_local_to_world_space(in_body, physics_body_get_center_of_mass_local(in_body));
 }
 
 Mat3 physics_body_get_inverse_inertia_tensor_local(PhysicsBody* in_body)
 {
-	Mat3 result = optional_get(mat3_inverse(shape_get_inertia_tensor_matrix(&in_body->shape)));
+	Mat3 result = shape_get_inverse_inertia_tensor_matrix(in_body->shape);
 	result = mat3_mul_f32(result, in_body->inverse_mass);
 	return result;
 }
@@ -803,6 +1030,17 @@ void physics_body_apply_impulse_linear(PhysicsBody* in_body, Vec3 in_impulse)
 	in_body->linear_velocity = vec3_add(in_body->linear_velocity, delta_linear_velocity);
 }
 
+// Clamp Angular Velocity to some max angular speed
+void physics_body_clamp_angular_velocity(PhysicsBody* in_body)
+{
+	const f32 max_angular_speed = 30.0f;
+	const f32 max_angular_speed_squared = max_angular_speed * max_angular_speed;
+	if (vec3_length_squared(in_body->angular_velocity) > max_angular_speed_squared)
+	{
+		in_body->angular_velocity = vec3_scale(vec3_normalize(in_body->angular_velocity), max_angular_speed);
+	}
+}
+
 void physics_body_apply_impulse_angular(PhysicsBody* in_body, Vec3 in_impulse)
 {	
 	if (in_body->inverse_mass <= 0.f) { return; }
@@ -812,13 +1050,7 @@ void physics_body_apply_impulse_angular(PhysicsBody* in_body, Vec3 in_impulse)
 	// Accumulate angular velocity
 	in_body->angular_velocity = vec3_add(in_body->angular_velocity, delta_angular_velocity);
 
-	// Clamp Angular Velocity to some max angular speed
-	const f32 max_angular_speed = 30.0f;
-	const f32 max_angular_speed_squared = max_angular_speed * max_angular_speed;
-	if (vec3_length_squared(in_body->angular_velocity) > max_angular_speed_squared)
-	{
-		in_body->angular_velocity = vec3_scale(vec3_normalize(in_body->angular_velocity), max_angular_speed);
-	}
+	physics_body_clamp_angular_velocity(in_body);
 }
 
 void physics_body_apply_impulse(PhysicsBody* in_body, Vec3 in_impulse, Vec3 in_location)
@@ -853,16 +1085,23 @@ void physics_body_update(PhysicsBody* in_body, f32 in_delta_time)
 		mat3_mul_mat3(
 			mat3_mul_mat3(
 				orientation_matrix, 
-				shape_get_inertia_tensor_matrix(&in_body->shape)
+				shape_get_inertia_tensor_matrix(in_body->shape)
+			),
+			mat3_transpose(orientation_matrix)	
+		);
+	// inverse(R * I * R^T) == R * inverse(I) * R^T, so the shape's cached inverse only needs rotating
+	Mat3 inverse_inertia_tensor = 
+		mat3_mul_mat3(
+			mat3_mul_mat3(
+				orientation_matrix, 
+				shape_get_inverse_inertia_tensor_matrix(in_body->shape)
 			),
 			mat3_transpose(orientation_matrix)	
 		);
-	optional(Mat3) inverse_inertia_tensor = mat3_inverse(inertia_tensor);
-	assert(optional_is_set(inverse_inertia_tensor));
 
 	// Compute torque alpha value
 	Vec3 alpha = mat3_mul_vec3(
-					optional_get(inverse_inertia_tensor),
+					inverse_inertia_tensor,
 					vec3_cross(
 						in_body->angular_velocity, 
 						mat3_mul_vec3(inertia_tensor, in_body->angular_velocity)
@@ -882,6 +1121,19 @@ void physics_body_update(PhysicsBody* in_body, f32 in_delta_time)
 	in_body->position = vec3_add(center_of_mass, quat_rotate_vec3(angular_velocity_quat, center_of_mass_to_position));
 }
 
+// Dynamic and not sleeping, so the body can move this step
+static inline bool physics_body_is_awake(const PhysicsBody* in_body)
+{
+	return in_body->inverse_mass > 0.f && !in_body->is_sleeping;
+}
+
+// Call after changing a body's velocity from outside the scene, so it doesn't stay asleep. physics_scene_set_body_pose wakes moved bodies
+void physics_body_wake(PhysicsBody* in_body)
+{
+	in_body->is_sleeping = false;
+	in_body->sleep_time = 0.0f;
+}
+
 bool ray_sphere_intersect(
 	const Vec3 in_ray_start, 
 	const Vec3 in_ray_dir, 
@@ -976,12 +1228,27 @@ bool physics_body_intersect_sphere_sphere(
 }
 
 // Checks collision at current point in time for two bodies
-bool physics_bodies_intersect(PhysicsBody* in_body_a, PhysicsBody* in_body_b, PhysicsContact* in_contact)
+// io_gjk_cache is optional. If valid, GJK starts from its axis and support points, and it gets the support points GJK ended on
+bool physics_bodies_intersect(PhysicsBody* in_body_a, PhysicsBody* in_body_b, PhysicsContact* in_contact, PhysicsGjkCache* io_gjk_cache)
 {
+	Vec3 initial_dir = vec3_new(1,1,1);
+	PhysicsSupportHint support_hint = {0};
+	if (io_gjk_cache && io_gjk_cache->is_valid)
+	{
+		initial_dir = quat_rotate_vec3(in_body_a->orientation, io_gjk_cache->separating_axis);
+		support_hint = io_gjk_cache->support_hint;
+	}
+
 	const f32 bias = 0.001f;
 	Vec3 pt_on_a;
 	Vec3 pt_on_b;
-	if (physics_bodies_gjk_intersect(in_body_a, in_body_b, bias, &pt_on_a, &pt_on_b))
+	const bool did_intersect = physics_bodies_gjk_intersect(in_body_a, in_body_b, bias, initial_dir, &support_hint, &pt_on_a, &pt_on_b);
+	if (io_gjk_cache)
+	{
+		io_gjk_cache->support_hint = support_hint;
+	}
+
+	if (did_intersect)
 	{
 		const Vec3 normal = vec3_normalize(vec3_sub(pt_on_b, pt_on_a));
 
@@ -992,33 +1259,35 @@ bool physics_bodies_intersect(PhysicsBody* in_body_a, PhysicsBody* in_body_b, Ph
 		in_contact->normal = normal;
 		in_contact->point_on_a_world = pt_on_a;
 		in_contact->point_on_b_world = pt_on_b;
-		in_contact->point_on_a_local = physics_body_world_to_local_space(in_contact->body_a, in_contact->point_on_a_world);
-		in_contact->point_on_b_local = physics_body_world_to_local_space(in_contact->body_b, in_contact->point_on_b_world);
+		in_contact->point_on_a_local = physics_body_world_to_local_space(in_body_a, in_contact->point_on_a_world);
+		in_contact->point_on_b_local = physics_body_world_to_local_space(in_body_b, in_contact->point_on_b_world);
 		in_contact->separation_distance = -vec3_length(vec3_sub(pt_on_a, pt_on_b));
 		return true;
 	}
 
-	physics_bodies_gjk_closest_points(in_body_a, in_body_b, &pt_on_a, &pt_on_b);	
+	physics_bodies_gjk_closest_points(in_body_a, in_body_b, initial_dir, &support_hint, &pt_on_a, &pt_on_b);
+	if (io_gjk_cache)
+	{
+		io_gjk_cache->support_hint = support_hint;
+	}
+
 	in_contact->point_on_a_world = pt_on_a;
 	in_contact->point_on_b_world = pt_on_b;
-	in_contact->point_on_a_local = physics_body_world_to_local_space(in_contact->body_a, in_contact->point_on_a_world);
-	in_contact->point_on_b_local = physics_body_world_to_local_space(in_contact->body_b, in_contact->point_on_b_world);	
+	in_contact->point_on_a_local = physics_body_world_to_local_space(in_body_a, in_contact->point_on_a_world);
+	in_contact->point_on_b_local = physics_body_world_to_local_space(in_body_b, in_contact->point_on_b_world);	
 	in_contact->separation_distance = vec3_length(vec3_sub(pt_on_a, pt_on_b));
 	return false;
 }
 
 bool physics_bodies_conservative_advance(PhysicsBody* in_body_a, PhysicsBody* in_body_b, const f32 in_delta_time, PhysicsContact* in_contact)
 {
-	in_contact->body_a = in_body_a;
-	in_contact->body_b = in_body_b;
-
 	f32 toi = 0.f;
 	i32 num_iterations = 0;
 
 	f32 dt = in_delta_time;
 	while (dt > 0.f)
 	{
-		const bool did_intersect = physics_bodies_intersect(in_body_a, in_body_b, in_contact);
+		const bool did_intersect = physics_bodies_intersect(in_body_a, in_body_b, in_contact, NULL);
 		if (did_intersect)
 		{
 			in_contact->time_of_impact = toi;
@@ -1065,20 +1334,17 @@ bool physics_bodies_conservative_advance(PhysicsBody* in_body_a, PhysicsBody* in
 // Checks for collisions over specified in_delta_time
 bool physics_bodies_intersect_dt(PhysicsBody* in_body_a, PhysicsBody* in_body_b, const f32 in_delta_time, PhysicsContact* in_contact)
 {
-	in_contact->body_a = in_body_a;
-	in_contact->body_b = in_body_b;
-
 	const Vec3 pos_a = in_body_a->position;
 	const Vec3 pos_b = in_body_b->position;
 
 	const Vec3 vel_a = in_body_a->linear_velocity;	
 	const Vec3 vel_b = in_body_b->linear_velocity;
 
-	if (	in_body_a->shape.type == SHAPE_TYPE_SPHERE
-		&&	in_body_b->shape.type == SHAPE_TYPE_SPHERE)
+	if (	in_body_a->shape->type == SHAPE_TYPE_SPHERE
+		&&	in_body_b->shape->type == SHAPE_TYPE_SPHERE)
 	{
-		const SphereShape* sphere_a = &in_body_a->shape.sphere;
-		const SphereShape* sphere_b = &in_body_b->shape.sphere;
+		const SphereShape* sphere_a = &in_body_a->shape->sphere;
+		const SphereShape* sphere_b = &in_body_b->shape->sphere;
 
 		if (physics_body_intersect_sphere_sphere(
 			sphere_a,
@@ -1098,8 +1364,8 @@ bool physics_bodies_intersect_dt(PhysicsBody* in_body_a, PhysicsBody* in_body_b,
 			physics_body_update(in_body_b, in_contact->time_of_impact);
 
 			// Compute local space points and normal
-			in_contact->point_on_a_local = physics_body_world_to_local_space(in_contact->body_a, in_contact->point_on_a_world);
-			in_contact->point_on_b_local = physics_body_world_to_local_space(in_contact->body_b, in_contact->point_on_b_world);
+			in_contact->point_on_a_local = physics_body_world_to_local_space(in_body_a, in_contact->point_on_a_world);
+			in_contact->point_on_b_local = physics_body_world_to_local_space(in_body_b, in_contact->point_on_b_world);
 			in_contact->normal = vec3_normalize(vec3_sub(in_body_a->position, in_body_b->position));
 			
 			// Roll back
@@ -1123,18 +1389,632 @@ bool physics_bodies_intersect_dt(PhysicsBody* in_body_a, PhysicsBody* in_body_b,
 	return false;
 }
 
-void physics_contact_resolve(PhysicsContact* in_contact)
-{
-	PhysicsBody* body_a = in_contact->body_a;
-	PhysicsBody* body_b = in_contact->body_b;
-	assert(body_a && body_b);
+// Contacts closer than this are kept even if the bodies aren't approaching, so resting contacts don't flicker on and off
+#define PHYSICS_SPECULATIVE_DISTANCE 0.02f
 
-	const Vec3 point_on_a = in_contact->point_on_a_world;
-	const Vec3 point_on_b = in_contact->point_on_b_world;
-	const f32 elasticity = body_a->elasticity * body_b->elasticity;
+// Penetration allowed before the solver pushes bodies apart. Keeps resting contacts touching so they aren't lost between steps
+#define PHYSICS_LINEAR_SLOP 0.005f
 
-	const f32 inverse_mass_a = body_a->inverse_mass;
-	const f32 inverse_mass_b = body_b->inverse_mass;
+// Fraction of a body's smallest half extent it can move in one step before it needs time of impact sub-stepping
+#define PHYSICS_FAST_BODY_MOTION_FRACTION 0.5f
+
+// True if in_body moves far enough this timestep that a contact found at the start of the step could miss a collision
+bool physics_body_is_fast(const PhysicsBody* in_body, const f32 in_delta_time)
+{
+	if (in_body->inverse_mass <= 0.f)
+	{
+		return false;
+	}
+
+	Bounds local_bounds = bounds_init();
+	switch (in_body->shape->type)
+	{
+		case SHAPE_TYPE_SPHERE:
+		{
+			const f32 radius = in_body->shape->sphere.radius;
+			local_bounds = (Bounds) {
+				.min = vec3_new(-radius, -radius, -radius),
+				.max = vec3_new(radius, radius, radius),
+			};
+			break;
+		}
+		case SHAPE_TYPE_BOX:
+		{
+			local_bounds = in_body->shape->box.bounds;
+			break;
+		}
+		case SHAPE_TYPE_CONVEX:
+		{
+			local_bounds = in_body->shape->convex->bounds;
+			break;
+		}
+	}
+
+	const Vec3 half_extents = vec3_scale(vec3_sub(local_bounds.max, local_bounds.min), 0.5f);
+	const f32 min_half_extent = MIN(half_extents.x, MIN(half_extents.y, half_extents.z));
+
+	// Upper bound on the distance from the center of mass to any point on the body, for the speed added by rotation
+	const Vec3 local_center = vec3_scale(vec3_add(local_bounds.min, local_bounds.max), 0.5f);
+	const f32 max_radius = vec3_length(vec3_sub(local_center, physics_body_get_center_of_mass_local(in_body))) + vec3_length(half_extents);
+
+	const f32 max_speed = vec3_length(in_body->linear_velocity) + vec3_length(in_body->angular_velocity) * max_radius;
+	return max_speed * in_delta_time > PHYSICS_FAST_BODY_MOTION_FRACTION * min_half_extent;
+}
+
+enum { PHYSICS_MANIFOLD_MAX_POINTS = 4 };
+
+// Largest area of a quad with corners p0..p3 in any order
+static inline f32 physics_manifold_get_area(const Vec3 p0, const Vec3 p1, const Vec3 p2, const Vec3 p3)
+{
+	const f32 area_0 = vec3_length_squared(vec3_cross(vec3_sub(p0, p1), vec3_sub(p2, p3)));
+	const f32 area_1 = vec3_length_squared(vec3_cross(vec3_sub(p0, p2), vec3_sub(p1, p3)));
+	const f32 area_2 = vec3_length_squared(vec3_cross(vec3_sub(p0, p3), vec3_sub(p1, p2)));
+	return MAX(area_0, MAX(area_1, area_2));
+}
+
+/* ------------------------------------------------ Contact Functions ------------------------------------------------ */
+
+// Finds contacts between two bodies at their current poses, with normals pointing from a to b
+// Writes at most PHYSICS_MANIFOLD_MAX_POINTS contacts separated by no more than in_max_distance, and returns how many it wrote
+typedef i32 (*PhysicsContactFunction)(PhysicsBody* in_body_a, PhysicsBody* in_body_b, const f32 in_max_distance, PhysicsGjkCache* io_gjk_cache, PhysicsContact* out_contacts);
+
+static inline void physics_contact_init(PhysicsContact* out_contact, PhysicsBody* in_body_a, PhysicsBody* in_body_b, const Vec3 in_point_on_a, const Vec3 in_point_on_b, const Vec3 in_normal)
+{
+	*out_contact = (PhysicsContact) {
+		.point_on_a_world = in_point_on_a,
+		.point_on_b_world = in_point_on_b,
+		.point_on_a_local = physics_body_world_to_local_space(in_body_a, in_point_on_a),
+		.point_on_b_local = physics_body_world_to_local_space(in_body_b, in_point_on_b),
+		.normal = in_normal,
+		.separation_distance = vec3_dot(vec3_sub(in_point_on_b, in_point_on_a), in_normal),
+	};
+}
+
+i32 physics_contacts_sphere_sphere(PhysicsBody* in_body_a, PhysicsBody* in_body_b, const f32 in_max_distance, PhysicsGjkCache* io_gjk_cache, PhysicsContact* out_contacts)
+{
+	(void) io_gjk_cache; // Closed form, so there's nothing to cache
+
+	const f32 radius_a = in_body_a->shape->sphere.radius;
+	const f32 radius_b = in_body_b->shape->sphere.radius;
+	const Vec3 a_to_b = vec3_sub(in_body_b->position, in_body_a->position);
+	const f32 distance = vec3_length(a_to_b);
+	if (distance - (radius_a + radius_b) > in_max_distance)
+	{
+		return 0;
+	}
+
+	const Vec3 normal = distance > FLT_EPSILON ? vec3_scale(a_to_b, 1.0f / distance) : vec3_new(0, 1, 0);
+	const Vec3 point_on_a = vec3_add(in_body_a->position, vec3_scale(normal, radius_a));
+	const Vec3 point_on_b = vec3_sub(in_body_b->position, vec3_scale(normal, radius_b));
+	physics_contact_init(&out_contacts[0], in_body_a, in_body_b, point_on_a, point_on_b, normal);
+	return 1;
+}
+
+// Closest point on the box to the sphere's center, found in the box's local space
+// A center inside the box is pushed out through whichever face is nearest
+i32 physics_contacts_sphere_box(PhysicsBody* in_body_a, PhysicsBody* in_body_b, const f32 in_max_distance, PhysicsGjkCache* io_gjk_cache, PhysicsContact* out_contacts)
+{
+	(void) io_gjk_cache; // Closed form, so there's nothing to cache
+
+	const f32 radius = in_body_a->shape->sphere.radius;
+	const Bounds box_bounds = in_body_b->shape->box.bounds;
+	const Vec3 center_local = physics_body_world_to_local_space(in_body_b, in_body_a->position);
+
+	Vec3 closest_local = vec3_new(
+		CLAMP(center_local.x, box_bounds.min.x, box_bounds.max.x),
+		CLAMP(center_local.y, box_bounds.min.y, box_bounds.max.y),
+		CLAMP(center_local.z, box_bounds.min.z, box_bounds.max.z)
+	);
+
+	Vec3 box_to_center_local = vec3_sub(center_local, closest_local);
+	f32 distance = vec3_length(box_to_center_local);
+	if (distance > FLT_EPSILON)
+	{
+		box_to_center_local = vec3_scale(box_to_center_local, 1.0f / distance);
+	}
+	else
+	{
+		f32 min_depth = FLT_MAX;
+		for (i32 axis = 0; axis < 3; ++axis)
+		{
+			const f32 depth_to_max = box_bounds.max.v[axis] - center_local.v[axis];
+			const f32 depth_to_min = center_local.v[axis] - box_bounds.min.v[axis];
+			const bool is_max_face = depth_to_max < depth_to_min;
+			const f32 depth = is_max_face ? depth_to_max : depth_to_min;
+			if (depth < min_depth)
+			{
+				min_depth = depth;
+				box_to_center_local = vec3_zero;
+				box_to_center_local.v[axis] = is_max_face ? 1.0f : -1.0f;
+				closest_local = center_local;
+				closest_local.v[axis] = is_max_face ? box_bounds.max.v[axis] : box_bounds.min.v[axis];
+			}
+		}
+		distance = -min_depth;
+	}
+
+	if (distance - radius > in_max_distance)
+	{
+		return 0;
+	}
+
+	const Vec3 normal = vec3_negate(quat_rotate_vec3(in_body_b->orientation, box_to_center_local));
+	const Vec3 point_on_a = vec3_add(in_body_a->position, vec3_scale(normal, radius));
+	const Vec3 point_on_b = physics_body_local_to_world_space(in_body_b, closest_local);
+	physics_contact_init(&out_contacts[0], in_body_a, in_body_b, point_on_a, point_on_b, normal);
+	return 1;
+}
+
+// Any two convex bodies, with GJK for the closest points and EPA for the penetration once they overlap
+i32 physics_contacts_convex_convex(PhysicsBody* in_body_a, PhysicsBody* in_body_b, const f32 in_max_distance, PhysicsGjkCache* io_gjk_cache, PhysicsContact* out_contacts)
+{
+	// The gap between the bodies' extents along any axis is a lower bound on their distance
+	if (io_gjk_cache && io_gjk_cache->is_valid)
+	{
+		const Vec3 axis = quat_rotate_vec3(in_body_a->orientation, io_gjk_cache->separating_axis);
+		const MinkowskiPoint support = physics_bodies_support(in_body_a, in_body_b, axis, 0.0f, &io_gjk_cache->support_hint);
+		if (-vec3_dot(support.xyz, vec3_normalize(axis)) > in_max_distance)
+		{
+			return 0;
+		}
+	}
+
+	PhysicsContact* contact = &out_contacts[0];
+	*contact = (PhysicsContact) {};
+	const bool did_intersect = physics_bodies_intersect(in_body_a, in_body_b, contact, io_gjk_cache);
+
+	// physics_bodies_intersect only sets a normal when the bodies overlap, and its sign isn't consistent, so rebuild it here
+	const Vec3 center_a_to_b = vec3_sub(physics_body_get_center_of_mass_world(in_body_b), physics_body_get_center_of_mass_world(in_body_a));
+	const Vec3 point_a_to_b = vec3_sub(contact->point_on_b_world, contact->point_on_a_world);
+	const f32 point_distance = vec3_length(point_a_to_b);
+	Vec3 normal = point_distance > FLT_EPSILON ? vec3_scale(point_a_to_b, 1.0f / point_distance) : vec3_normalize(center_a_to_b);
+	f32 separation = did_intersect ? -point_distance : point_distance;
+
+	// Closest points of bodies that are only just apart can be anywhere on the touching faces, so the direction between them is noise
+	// Pushing b into a lets EPA find the normal instead, and b's point is moved back with it
+	bool is_pushed_contact = false;
+	if (!did_intersect && point_distance < PHYSICS_LINEAR_SLOP)
+	{
+		PhysicsBody pushed_body_b = *in_body_b;
+		const Vec3 push = vec3_scale(vec3_normalize(center_a_to_b), -2.0f * PHYSICS_LINEAR_SLOP);
+		pushed_body_b.position = vec3_add(pushed_body_b.position, push);
+
+		PhysicsContact pushed_contact = {};
+		if (physics_bodies_intersect(in_body_a, &pushed_body_b, &pushed_contact, NULL))
+		{
+			contact->point_on_a_world = pushed_contact.point_on_a_world;
+			contact->point_on_b_world = vec3_sub(pushed_contact.point_on_b_world, push);
+			normal = pushed_contact.normal;
+			is_pushed_contact = true;
+		}
+	}
+
+	// Convex bodies always have their centers of mass on either side of the contact plane
+	if (vec3_dot(normal, center_a_to_b) < 0.0f)
+	{
+		normal = vec3_negate(normal);
+	}
+
+	if (is_pushed_contact)
+	{
+		separation = vec3_dot(vec3_sub(contact->point_on_b_world, contact->point_on_a_world), normal);
+	}
+
+	if (isnan(normal.x) || isnan(normal.y) || isnan(normal.z))
+	{
+		return 0;
+	}
+
+	if (io_gjk_cache)
+	{
+		io_gjk_cache->separating_axis = quat_rotate_vec3(quat_conjugate(in_body_a->orientation), normal);
+		io_gjk_cache->is_valid = true;
+	}
+
+	if (separation > in_max_distance)
+	{
+		return 0;
+	}
+
+	physics_contact_init(contact, in_body_a, in_body_b, contact->point_on_a_world, contact->point_on_b_world, normal);
+	contact->separation_distance = separation;
+	return 1;
+}
+
+// Closest point on the hull to the sphere's center, from GJK against the center alone
+// A center inside the hull has no closest point outside it, so that falls back to the general convex routine
+i32 physics_contacts_sphere_convex(PhysicsBody* in_body_a, PhysicsBody* in_body_b, const f32 in_max_distance, PhysicsGjkCache* io_gjk_cache, PhysicsContact* out_contacts)
+{
+	Shape center_shape = *in_body_a->shape;
+	center_shape.sphere.radius = 0.0f;
+	PhysicsBody center_body = *in_body_a;
+	center_body.shape = &center_shape;
+
+	Vec3 initial_dir = vec3_new(1,1,1);
+	PhysicsSupportHint support_hint = {0};
+	if (io_gjk_cache && io_gjk_cache->is_valid)
+	{
+		initial_dir = quat_rotate_vec3(in_body_a->orientation, io_gjk_cache->separating_axis);
+		support_hint = io_gjk_cache->support_hint;
+	}
+
+	Vec3 center;
+	Vec3 point_on_b;
+	physics_bodies_gjk_closest_points(&center_body, in_body_b, initial_dir, &support_hint, &center, &point_on_b);
+
+	const Vec3 center_to_b = vec3_sub(point_on_b, center);
+	const f32 distance = vec3_length(center_to_b);
+	if (distance < PHYSICS_LINEAR_SLOP)
+	{
+		return physics_contacts_convex_convex(in_body_a, in_body_b, in_max_distance, io_gjk_cache, out_contacts);
+	}
+
+	const Vec3 normal = vec3_scale(center_to_b, 1.0f / distance);
+	if (io_gjk_cache)
+	{
+		io_gjk_cache->separating_axis = quat_rotate_vec3(quat_conjugate(in_body_a->orientation), normal);
+		io_gjk_cache->support_hint = support_hint;
+		io_gjk_cache->is_valid = true;
+	}
+
+	const f32 radius = in_body_a->shape->sphere.radius;
+	if (distance - radius > in_max_distance)
+	{
+		return 0;
+	}
+
+	const Vec3 point_on_a = vec3_add(in_body_a->position, vec3_scale(normal, radius));
+	physics_contact_init(&out_contacts[0], in_body_a, in_body_b, point_on_a, point_on_b, normal);
+	return 1;
+}
+
+// A box body's world space center, axes and half extents
+typedef struct PhysicsOrientedBox
+{
+	Vec3 center;
+	Vec3 axes[3];
+	Vec3 half_extents;
+} PhysicsOrientedBox;
+
+static inline PhysicsOrientedBox physics_body_get_oriented_box(const PhysicsBody* in_body)
+{
+	const Bounds* bounds = &in_body->shape->box.bounds;
+	return (PhysicsOrientedBox) {
+		.center = physics_body_local_to_world_space(in_body, vec3_scale(vec3_add(bounds->min, bounds->max), 0.5f)),
+		.axes = {
+			quat_rotate_vec3(in_body->orientation, vec3_new(1, 0, 0)),
+			quat_rotate_vec3(in_body->orientation, vec3_new(0, 1, 0)),
+			quat_rotate_vec3(in_body->orientation, vec3_new(0, 0, 1)),
+		},
+		.half_extents = bounds_get_half_extents(bounds),
+	};
+}
+
+// Half the length of the box's shadow on in_axis
+static inline f32 physics_oriented_box_get_radius(const PhysicsOrientedBox* in_box, const Vec3 in_axis)
+{
+	return		in_box->half_extents.x * fabsf(vec3_dot(in_box->axes[0], in_axis))
+			+	in_box->half_extents.y * fabsf(vec3_dot(in_box->axes[1], in_axis))
+			+	in_box->half_extents.z * fabsf(vec3_dot(in_box->axes[2], in_axis));
+}
+
+// Sutherland-Hodgman: the part of a convex polygon where dot(point, in_plane_normal) <= in_plane_offset. Adds at most one point
+static inline i32 physics_clip_polygon(const Vec3* in_points, const i32 in_num_points, const Vec3 in_plane_normal, const f32 in_plane_offset, Vec3* out_points)
+{
+	i32 num_out_points = 0;
+	for (i32 point_idx = 0; point_idx < in_num_points; ++point_idx)
+	{
+		const Vec3 point = in_points[point_idx];
+		const Vec3 next_point = in_points[(point_idx + 1) % in_num_points];
+		const f32 distance = vec3_dot(point, in_plane_normal) - in_plane_offset;
+		const f32 next_distance = vec3_dot(next_point, in_plane_normal) - in_plane_offset;
+
+		if (distance <= 0.0f)
+		{
+			out_points[num_out_points++] = point;
+		}
+
+		if ((distance < 0.0f && next_distance > 0.0f) || (distance > 0.0f && next_distance < 0.0f))
+		{
+			const f32 t = distance / (distance - next_distance);
+			out_points[num_out_points++] = vec3_add(point, vec3_scale(vec3_sub(next_point, point), t));
+		}
+	}
+	return num_out_points;
+}
+
+// Keeps the deepest contact and the ones spanning the largest area, the same as a full manifold would
+static inline i32 physics_contacts_reduce(PhysicsContact* io_contacts, const i32 in_num_contacts)
+{
+	if (in_num_contacts <= PHYSICS_MANIFOLD_MAX_POINTS)
+	{
+		return in_num_contacts;
+	}
+
+	i32 kept[PHYSICS_MANIFOLD_MAX_POINTS] = {0};
+	for (i32 contact_idx = 1; contact_idx < in_num_contacts; ++contact_idx)
+	{
+		if (io_contacts[contact_idx].separation_distance < io_contacts[kept[0]].separation_distance)
+		{
+			kept[0] = contact_idx;
+		}
+	}
+
+	f32 best_scores[PHYSICS_MANIFOLD_MAX_POINTS] = { 0.0f, -1.0f, -1.0f, -1.0f };
+	for (i32 kept_idx = 1; kept_idx < PHYSICS_MANIFOLD_MAX_POINTS; ++kept_idx)
+	{
+		const Vec3 p0 = io_contacts[kept[0]].point_on_a_world;
+		const Vec3 p1 = io_contacts[kept[1]].point_on_a_world;
+		const Vec3 p2 = io_contacts[kept[2]].point_on_a_world;
+		for (i32 contact_idx = 0; contact_idx < in_num_contacts; ++contact_idx)
+		{
+			// Furthest from the deepest point, then the largest triangle, then the largest quad
+			const Vec3 point = io_contacts[contact_idx].point_on_a_world;
+			const f32 score	= kept_idx == 1 ? vec3_length_squared(vec3_sub(point, p0))
+							: kept_idx == 2 ? vec3_length_squared(vec3_cross(vec3_sub(p1, p0), vec3_sub(point, p0)))
+							: physics_manifold_get_area(p0, p1, p2, point);
+			if (score > best_scores[kept_idx])
+			{
+				best_scores[kept_idx] = score;
+				kept[kept_idx] = contact_idx;
+			}
+		}
+	}
+
+	PhysicsContact kept_contacts[PHYSICS_MANIFOLD_MAX_POINTS];
+	for (i32 kept_idx = 0; kept_idx < PHYSICS_MANIFOLD_MAX_POINTS; ++kept_idx)
+	{
+		kept_contacts[kept_idx] = io_contacts[kept[kept_idx]];
+	}
+	memcpy(io_contacts, kept_contacts, sizeof(kept_contacts));
+	return PHYSICS_MANIFOLD_MAX_POINTS;
+}
+
+// A face axis is only given up for one that separates the boxes by noticeably more, so resting contacts don't flip between features
+#define PHYSICS_SAT_RELATIVE_TOLERANCE 0.95f
+#define PHYSICS_SAT_ABSOLUTE_TOLERANCE 0.01f
+
+// Separating axis test over the 15 candidate axes. The axis of least penetration decides the contact:
+// a face clips the other box's most opposed face against its sides, giving the whole contact patch in one step, and an edge pair gives their closest points
+i32 physics_contacts_box_box(PhysicsBody* in_body_a, PhysicsBody* in_body_b, const f32 in_max_distance, PhysicsGjkCache* io_gjk_cache, PhysicsContact* out_contacts)
+{
+	const PhysicsOrientedBox box_a = physics_body_get_oriented_box(in_body_a);
+	const PhysicsOrientedBox box_b = physics_body_get_oriented_box(in_body_b);
+	const Vec3 a_to_b = vec3_sub(box_b.center, box_a.center);
+
+	// Face axes of a, then of b
+	f32 face_separations[2] = { -FLT_MAX, -FLT_MAX };
+	i32 face_axes[2] = { 0, 0 };
+	for (i32 box_idx = 0; box_idx < 2; ++box_idx)
+	{
+		const PhysicsOrientedBox* box = box_idx == 0 ? &box_a : &box_b;
+		for (i32 axis_idx = 0; axis_idx < 3; ++axis_idx)
+		{
+			const Vec3 axis = box->axes[axis_idx];
+			const f32 separation = fabsf(vec3_dot(a_to_b, axis)) - physics_oriented_box_get_radius(&box_a, axis) - physics_oriented_box_get_radius(&box_b, axis);
+			if (separation > in_max_distance)
+			{
+				return 0;
+			}
+
+			if (separation > face_separations[box_idx])
+			{
+				face_separations[box_idx] = separation;
+				face_axes[box_idx] = axis_idx;
+			}
+		}
+	}
+
+	// Edge pairs. Parallel edges give no axis, and are covered by the face axes
+	f32 edge_separation = -FLT_MAX;
+	i32 edge_axis_a = 0;
+	i32 edge_axis_b = 0;
+	Vec3 edge_normal = vec3_zero;
+	for (i32 axis_idx_a = 0; axis_idx_a < 3; ++axis_idx_a)
+	{
+		for (i32 axis_idx_b = 0; axis_idx_b < 3; ++axis_idx_b)
+		{
+			const Vec3 cross = vec3_cross(box_a.axes[axis_idx_a], box_b.axes[axis_idx_b]);
+			const f32 cross_length = vec3_length(cross);
+			if (cross_length < 1e-4f)
+			{
+				continue;
+			}
+
+			const Vec3 axis = vec3_scale(cross, 1.0f / cross_length);
+			const f32 separation = fabsf(vec3_dot(a_to_b, axis)) - physics_oriented_box_get_radius(&box_a, axis) - physics_oriented_box_get_radius(&box_b, axis);
+			if (separation > in_max_distance)
+			{
+				return 0;
+			}
+
+			if (separation > edge_separation)
+			{
+				edge_separation = separation;
+				edge_axis_a = axis_idx_a;
+				edge_axis_b = axis_idx_b;
+				edge_normal = axis;
+			}
+		}
+	}
+
+	const bool is_reference_b = face_separations[1] > PHYSICS_SAT_RELATIVE_TOLERANCE * face_separations[0] + PHYSICS_SAT_ABSOLUTE_TOLERANCE;
+	const f32 face_separation = is_reference_b ? face_separations[1] : face_separations[0];
+	if (edge_separation > PHYSICS_SAT_RELATIVE_TOLERANCE * face_separation + PHYSICS_SAT_ABSOLUTE_TOLERANCE)
+	{
+		// Closest points of the two edges furthest along the normal, on a towards b and on b towards a
+		const Vec3 normal = vec3_dot(edge_normal, a_to_b) < 0.0f ? vec3_negate(edge_normal) : edge_normal;
+
+		Vec3 edge_center_a = box_a.center;
+		Vec3 edge_center_b = box_b.center;
+		for (i32 axis_idx = 0; axis_idx < 3; ++axis_idx)
+		{
+			if (axis_idx != edge_axis_a)
+			{
+				const f32 sign = vec3_dot(box_a.axes[axis_idx], normal) > 0.0f ? 1.0f : -1.0f;
+				edge_center_a = vec3_add(edge_center_a, vec3_scale(box_a.axes[axis_idx], sign * box_a.half_extents.v[axis_idx]));
+			}
+			if (axis_idx != edge_axis_b)
+			{
+				const f32 sign = vec3_dot(box_b.axes[axis_idx], normal) > 0.0f ? -1.0f : 1.0f;
+				edge_center_b = vec3_add(edge_center_b, vec3_scale(box_b.axes[axis_idx], sign * box_b.half_extents.v[axis_idx]));
+			}
+		}
+
+		const Vec3 dir_a = box_a.axes[edge_axis_a];
+		const Vec3 dir_b = box_b.axes[edge_axis_b];
+		const Vec3 r = vec3_sub(edge_center_a, edge_center_b);
+		const f32 dir_dot = vec3_dot(dir_a, dir_b);
+		const f32 denominator = 1.0f - dir_dot * dir_dot;
+		const f32 t_a = CLAMP((dir_dot * vec3_dot(dir_b, r) - vec3_dot(dir_a, r)) / denominator, -box_a.half_extents.v[edge_axis_a], box_a.half_extents.v[edge_axis_a]);
+		const f32 t_b = CLAMP(vec3_dot(dir_b, r) + dir_dot * t_a, -box_b.half_extents.v[edge_axis_b], box_b.half_extents.v[edge_axis_b]);
+
+		const Vec3 point_on_a = vec3_add(edge_center_a, vec3_scale(dir_a, t_a));
+		const Vec3 point_on_b = vec3_add(edge_center_b, vec3_scale(dir_b, t_b));
+		physics_contact_init(&out_contacts[0], in_body_a, in_body_b, point_on_a, point_on_b, normal);
+		out_contacts[0].separation_distance = edge_separation;
+		return 1;
+	}
+
+	// The reference face is the face of the chosen axis that faces the other box
+	const PhysicsOrientedBox* reference_box = is_reference_b ? &box_b : &box_a;
+	const PhysicsOrientedBox* incident_box = is_reference_b ? &box_a : &box_b;
+	const i32 reference_axis_idx = is_reference_b ? face_axes[1] : face_axes[0];
+	const Vec3 reference_to_incident = is_reference_b ? vec3_negate(a_to_b) : a_to_b;
+	const Vec3 reference_axis = reference_box->axes[reference_axis_idx];
+	const Vec3 reference_normal = vec3_dot(reference_axis, reference_to_incident) < 0.0f ? vec3_negate(reference_axis) : reference_axis;
+	const Vec3 reference_center = vec3_add(reference_box->center, vec3_scale(reference_normal, reference_box->half_extents.v[reference_axis_idx]));
+
+	// The incident face is the other box's face most opposed to the reference normal
+	i32 incident_axis_idx = 0;
+	f32 max_alignment = -1.0f;
+	for (i32 axis_idx = 0; axis_idx < 3; ++axis_idx)
+	{
+		const f32 alignment = fabsf(vec3_dot(incident_box->axes[axis_idx], reference_normal));
+		if (alignment > max_alignment)
+		{
+			max_alignment = alignment;
+			incident_axis_idx = axis_idx;
+		}
+	}
+	const Vec3 incident_axis = incident_box->axes[incident_axis_idx];
+	const Vec3 incident_normal = vec3_dot(incident_axis, reference_normal) > 0.0f ? vec3_negate(incident_axis) : incident_axis;
+	const Vec3 incident_center = vec3_add(incident_box->center, vec3_scale(incident_normal, incident_box->half_extents.v[incident_axis_idx]));
+
+	const i32 incident_u = (incident_axis_idx + 1) % 3;
+	const i32 incident_v = (incident_axis_idx + 2) % 3;
+	const Vec3 u = vec3_scale(incident_box->axes[incident_u], incident_box->half_extents.v[incident_u]);
+	const Vec3 v = vec3_scale(incident_box->axes[incident_v], incident_box->half_extents.v[incident_v]);
+
+	enum { MAX_CLIPPED_POINTS = 8 };
+	Vec3 clip_buffers[2][MAX_CLIPPED_POINTS] = {
+		{
+			vec3_add(incident_center, vec3_add(u, v)),
+			vec3_add(incident_center, vec3_sub(u, v)),
+			vec3_sub(incident_center, vec3_add(u, v)),
+			vec3_sub(incident_center, vec3_sub(u, v)),
+		},
+	};
+	i32 num_points = 4;
+	i32 buffer_idx = 0;
+
+	// Clip against the four side planes of the reference face
+	for (i32 side_idx = 0; side_idx < 4 && num_points > 0; ++side_idx)
+	{
+		const i32 side_axis_idx = (reference_axis_idx + 1 + side_idx / 2) % 3;
+		const Vec3 side_normal = vec3_scale(reference_box->axes[side_axis_idx], side_idx % 2 == 0 ? 1.0f : -1.0f);
+		const f32 side_offset = vec3_dot(side_normal, reference_box->center) + reference_box->half_extents.v[side_axis_idx];
+		num_points = physics_clip_polygon(clip_buffers[buffer_idx], num_points, side_normal, side_offset, clip_buffers[1 - buffer_idx]);
+		buffer_idx = 1 - buffer_idx;
+	}
+
+	// Clipped points below the reference face, or close enough above it, are contacts. Their partners are on the reference face
+	i32 num_contacts = 0;
+	PhysicsContact contacts[MAX_CLIPPED_POINTS];
+	const Vec3 normal = is_reference_b ? vec3_negate(reference_normal) : reference_normal;
+	for (i32 point_idx = 0; point_idx < num_points; ++point_idx)
+	{
+		const Vec3 incident_point = clip_buffers[buffer_idx][point_idx];
+		const f32 depth = vec3_dot(vec3_sub(incident_point, reference_center), reference_normal);
+		if (depth > in_max_distance)
+		{
+			continue;
+		}
+
+		const Vec3 reference_point = vec3_sub(incident_point, vec3_scale(reference_normal, depth));
+		const Vec3 point_on_a = is_reference_b ? incident_point : reference_point;
+		const Vec3 point_on_b = is_reference_b ? reference_point : incident_point;
+		physics_contact_init(&contacts[num_contacts++], in_body_a, in_body_b, point_on_a, point_on_b, normal);
+	}
+
+	// Nothing survived clipping, which only happens around degenerate poses. The general routine still finds something there
+	if (num_contacts == 0)
+	{
+		return physics_contacts_convex_convex(in_body_a, in_body_b, in_max_distance, io_gjk_cache, out_contacts);
+	}
+
+	num_contacts = physics_contacts_reduce(contacts, num_contacts);
+	memcpy(out_contacts, contacts, sizeof(PhysicsContact) * num_contacts);
+	return num_contacts;
+}
+
+// Indexed by the shape types of body a and body b. Pairs without an entry are found with the bodies swapped
+// Only pairs without a closed form go through the general GJK and EPA routine
+const PhysicsContactFunction physics_contact_functions[SHAPE_TYPE_COUNT][SHAPE_TYPE_COUNT] = {
+	[SHAPE_TYPE_SPHERE] = {
+		[SHAPE_TYPE_SPHERE] = physics_contacts_sphere_sphere,
+		[SHAPE_TYPE_BOX] = physics_contacts_sphere_box,
+		[SHAPE_TYPE_CONVEX] = physics_contacts_sphere_convex,
+	},
+	[SHAPE_TYPE_BOX] = {
+		[SHAPE_TYPE_BOX] = physics_contacts_box_box,
+		[SHAPE_TYPE_CONVEX] = physics_contacts_convex_convex,
+	},
+	[SHAPE_TYPE_CONVEX] = {
+		[SHAPE_TYPE_CONVEX] = physics_contacts_convex_convex,
+	},
+};
+
+// Finds contacts between two bodies at their current poses, with normals pointing from a to b
+// Returns how many are within PHYSICS_SPECULATIVE_DISTANCE plus the distance they could close this timestep, at most PHYSICS_MANIFOLD_MAX_POINTS
+// io_gjk_cache is optional, and carries the pair's separating axis between steps. While that axis still separates the bodies by more than
+// the contact distance, pairs without a closed form are rejected with two support queries instead of GJK
+i32 physics_bodies_find_contacts(PhysicsBody* in_body_a, PhysicsBody* in_body_b, const f32 in_delta_time, PhysicsContact* out_contacts, PhysicsGjkCache* io_gjk_cache)
+{
+	const Vec3 relative_velocity = vec3_sub(in_body_a->linear_velocity, in_body_b->linear_velocity);
+	const f32 max_closing_distance = vec3_length(relative_velocity) * in_delta_time;
+	const f32 max_contact_distance = PHYSICS_SPECULATIVE_DISTANCE + max_closing_distance;
+
+	const PhysicsContactFunction contact_function = physics_contact_functions[in_body_a->shape->type][in_body_b->shape->type];
+	if (contact_function)
+	{
+		return contact_function(in_body_a, in_body_b, max_contact_distance, io_gjk_cache, out_contacts);
+	}
+
+	const PhysicsContactFunction swapped_contact_function = physics_contact_functions[in_body_b->shape->type][in_body_a->shape->type];
+	assert(swapped_contact_function);
+	const i32 num_contacts = swapped_contact_function(in_body_b, in_body_a, max_contact_distance, io_gjk_cache, out_contacts);
+	for (i32 contact_idx = 0; contact_idx < num_contacts; ++contact_idx)
+	{
+		PhysicsContact* contact = &out_contacts[contact_idx];
+		SWAP(Vec3, contact->point_on_a_world, contact->point_on_b_world);
+		SWAP(Vec3, contact->point_on_a_local, contact->point_on_b_local);
+		contact->normal = vec3_negate(contact->normal);
+	}
+	return num_contacts;
+}
+
+void physics_contact_resolve(PhysicsScene* scene, PhysicsContact* in_contact)
+{
+	PhysicsBody* body_a = physics_scene_get_body(scene, in_contact->body_a);
+	PhysicsBody* body_b = physics_scene_get_body(scene, in_contact->body_b);
+
+	const Vec3 point_on_a = in_contact->point_on_a_world;
+	const Vec3 point_on_b = in_contact->point_on_b_world;
+	const f32 elasticity = body_a->elasticity * body_b->elasticity;
+
+	const f32 inverse_mass_a = body_a->inverse_mass;
+	const f32 inverse_mass_b = body_b->inverse_mass;
 	const f32 inverse_mass_sum = inverse_mass_a + inverse_mass_b;
 	
 	const Mat3 inverse_inertia_tensor_a = physics_body_get_inverse_inertia_tensor_world(body_a);
@@ -1213,440 +2093,1520 @@ i32 physics_contact_compare(const void* in_a, const void* in_b)
 	const PhysicsContact* in_contact_a = (const PhysicsContact*) in_a;
 	const PhysicsContact* in_contact_b = (const PhysicsContact*) in_b;
 
+	// Contacts are ordered by time of impact, then pair id, so the order never depends on how contacts were gathered
 	const f32 toi_a = in_contact_a->time_of_impact;
 	const f32 toi_b = in_contact_b->time_of_impact;
-	return		toi_a < toi_b	? 	-1
-	  		:	toi_a == toi_b	?	0
-	  		: 						1;
+	if (toi_a != toi_b)
+	{
+		return toi_a < toi_b ? -1 : 1;
+	}
+
+	const u64 pair_id_a = in_contact_a->pair_id;
+	const u64 pair_id_b = in_contact_b->pair_id;
+	if (pair_id_a != pair_id_b)
+	{
+		return pair_id_a < pair_id_b ? -1 : 1;
+	}
+
+	return in_contact_a->pair_point_idx - in_contact_b->pair_point_idx;
 }
 
-typedef enum PhysicsConstraintType
-{
-	PHYSICS_CONSTRAINT_TYPE_DISTANCE,
-} PhysicsConstraintType;
+// Fraction of the remaining penetration corrected per step
+#define PHYSICS_BAUMGARTE 0.2f
+// Cap on the separating speed used to correct penetration, so deep overlaps don't explode apart
+#define PHYSICS_MAX_PENETRATION_CORRECTION_SPEED 4.0f
+// Contacts approaching slower than this don't bounce, which lets stacks come to rest
+#define PHYSICS_RESTITUTION_THRESHOLD 1.0f
 
-typedef struct PhysicsConstraintDistance
+enum
 {
-	MatMN jacobian;
-} PhysicsConstraintDistance;
-
-typedef struct PhysicsScene PhysicsScene;
+	PHYSICS_CONTACT_ROW_NORMAL,
+	PHYSICS_CONTACT_ROW_TANGENT_0,
+	PHYSICS_CONTACT_ROW_TANGENT_1,
+	PHYSICS_CONTACT_ROW_COUNT,
+};
+
+// Impulses from the last solve of one contact, to warm start the next one
+// Friction is kept as a vector in b's local space rather than per tangent row, since the tangent basis is rebuilt each step and can flip
+typedef struct PhysicsContactImpulseCache
+{
+	f32 normal_impulse;
+	Vec3 friction_impulse_local;
+} PhysicsContactImpulseCache;
 
-typedef struct PhysicsConstraint
+// Sequential impulse state for one contact: a non-penetration row along the normal and two friction rows
+typedef struct PhysicsContactConstraint
 {
-	PhysicsBody* body_a;
-	PhysicsBody* body_b;
+	PhysicsBodyHandle body_a;
+	PhysicsBodyHandle body_b;
 
-	Vec3 anchor_a;
-	Vec3 axis_a;
+	Jacobian1x12 jacobians[PHYSICS_CONTACT_ROW_COUNT];
+	Vec12 inverse_mass_jacobians[PHYSICS_CONTACT_ROW_COUNT];	// M^-1 * J^T, so applying an impulse is a scale and add
+	f32 masses[PHYSICS_CONTACT_ROW_COUNT];						// 1 / (J * M^-1 * J^T)
+	f32 impulses[PHYSICS_CONTACT_ROW_COUNT];					// Accumulated over iterations. Normal >= 0, tangents within the friction cone
 
-	Vec3 anchor_b;
-	Vec3 axis_b;
+	f32 bias;						// Added to the normal velocity. Positive lets a speculative gap close, negative pushes out of penetration
+	f32 friction;
+	f32 elasticity;
+	f32 relative_normal_velocity;	// Normal velocity before solving, which restitution reflects
 
-	PhysicsConstraintType type;
-	
-	union 
-	{
-		PhysicsConstraintDistance distance;
-	};	
-} PhysicsConstraint;
+	PhysicsContactImpulseCache* cached_impulses;	// Optional. Warm starts impulses, and receives them after solving
+} PhysicsContactConstraint;
 
-MatMN physics_constraint_get_inverse_mass_matrix(Arena* arena, const PhysicsConstraint* in_constraint)
+// Two unit vectors perpendicular to in_normal and each other
+static inline void physics_contact_get_tangents(const Vec3 in_normal, Vec3* out_tangent_0, Vec3* out_tangent_1)
 {
-	MatMN inv_mass_matrix = matmn_new(arena, 12, 12);
-	matmn_zero_in_place(&inv_mass_matrix);
+	// Cross with whichever axis is least aligned with the normal
+	*out_tangent_0 = fabsf(in_normal.x) >= 0.57735f
+		? vec3_normalize(vec3_new(in_normal.y, -in_normal.x, 0.0f))
+		: vec3_normalize(vec3_new(0.0f, in_normal.z, -in_normal.y));
+	*out_tangent_1 = vec3_cross(in_normal, *out_tangent_0);
+}
+
+static inline Vec12 physics_contact_constraint_get_velocities(PhysicsScene* scene, const PhysicsContactConstraint* in_constraint)
+{
+	const PhysicsBody* body_a = physics_scene_get_body(scene, in_constraint->body_a);
+	const PhysicsBody* body_b = physics_scene_get_body(scene, in_constraint->body_b);
+
+	return (Vec12) {
+		.linear_a = body_a->linear_velocity,
+		.angular_a = body_a->angular_velocity,
+		.linear_b = body_b->linear_velocity,
+		.angular_b = body_b->angular_velocity,
+	};
+}
+
+static inline void physics_contact_constraint_apply_impulse(PhysicsScene* scene, PhysicsContactConstraint* in_constraint, const i32 in_row, const f32 in_impulse)
+{
+	const Vec12 delta_velocity = vec12_scale(in_constraint->inverse_mass_jacobians[in_row], in_impulse);
+
+	// Static bodies are never written, so islands that share one can be solved concurrently
+	PhysicsBody* body_a = physics_scene_get_body(scene, in_constraint->body_a);
+	if (body_a->inverse_mass > 0.f)
+	{
+		body_a->linear_velocity = vec3_add(body_a->linear_velocity, delta_velocity.linear_a);
+		body_a->angular_velocity = vec3_add(body_a->angular_velocity, delta_velocity.angular_a);
+	}
+
+	PhysicsBody* body_b = physics_scene_get_body(scene, in_constraint->body_b);
+	if (body_b->inverse_mass > 0.f)
+	{
+		body_b->linear_velocity = vec3_add(body_b->linear_velocity, delta_velocity.linear_b);
+		body_b->angular_velocity = vec3_add(body_b->angular_velocity, delta_velocity.angular_b);
+	}
+}
+
+// Builds solver rows for in_contact, whose normal points from a to b. in_inverse_mass holds both bodies' world space inverse inertia
+void physics_contact_constraint_init(PhysicsScene* scene, PhysicsContactConstraint* out_constraint, const PhysicsContact* in_contact, const InverseMass12* in_inverse_mass, const f32 in_delta_time)
+{
+	const PhysicsBody* body_a = physics_scene_get_body(scene, in_contact->body_a);
+	const PhysicsBody* body_b = physics_scene_get_body(scene, in_contact->body_b);
+
+	*out_constraint = (PhysicsContactConstraint) {
+		.body_a = in_contact->body_a,
+		.body_b = in_contact->body_b,
+		.friction = body_a->friction * body_b->friction,
+		.elasticity = body_a->elasticity * body_b->elasticity,
+	};
+
+	const Vec3 ra = vec3_sub(in_contact->point_on_a_world, physics_body_get_center_of_mass_world(body_a));
+	const Vec3 rb = vec3_sub(in_contact->point_on_b_world, physics_body_get_center_of_mass_world(body_b));
+
+	Vec3 directions[PHYSICS_CONTACT_ROW_COUNT];
+	directions[PHYSICS_CONTACT_ROW_NORMAL] = in_contact->normal;
+	physics_contact_get_tangents(in_contact->normal, &directions[PHYSICS_CONTACT_ROW_TANGENT_0], &directions[PHYSICS_CONTACT_ROW_TANGENT_1]);
+
+	for (i32 row = 0; row < PHYSICS_CONTACT_ROW_COUNT; ++row)
+	{
+		// J * V is the velocity of b's contact point relative to a's along the row direction
+		const Vec3 direction = directions[row];
+		const Jacobian1x12 jacobian = {
+			.linear_a = vec3_negate(direction),
+			.angular_a = vec3_negate(vec3_cross(ra, direction)),
+			.linear_b = direction,
+			.angular_b = vec3_cross(rb, direction),
+		};
+		const f32 effective_mass = jacobian1x12_effective_mass(jacobian, in_inverse_mass);
+
+		out_constraint->jacobians[row] = jacobian;
+		out_constraint->inverse_mass_jacobians[row] = inverse_mass12_mul_vec12(in_inverse_mass, jacobian);
+		out_constraint->masses[row] = effective_mass > 0.0f ? 1.0f / effective_mass : 0.0f;
+	}
+
+	const f32 separation = in_contact->separation_distance;
+	if (separation > 0.0f)
+	{
+		// Speculative: allow the bodies to close the gap this step, but no further
+		out_constraint->bias = separation / in_delta_time;
+	}
+	else
+	{
+		const f32 correction_speed = PHYSICS_BAUMGARTE * MIN(separation + PHYSICS_LINEAR_SLOP, 0.0f) / in_delta_time;
+		out_constraint->bias = MAX(correction_speed, -PHYSICS_MAX_PENETRATION_CORRECTION_SPEED);
+	}
+
+	out_constraint->relative_normal_velocity = jacobian1x12_mul_vec12(out_constraint->jacobians[PHYSICS_CONTACT_ROW_NORMAL], physics_contact_constraint_get_velocities(scene, out_constraint));
+}
+
+// Applies the impulses cached from last step. Call once every constraint is initialized, so none sees another's warm start in its relative_normal_velocity
+void physics_contact_constraint_warm_start(PhysicsScene* scene, PhysicsContactConstraint* in_constraint)
+{
+	if (!in_constraint->cached_impulses)
+	{
+		return;
+	}
+
+	// Project last step's friction onto this step's tangents. Each row's linear_b is its unit direction
+	const PhysicsContactImpulseCache* cache = in_constraint->cached_impulses;
+	const Quat orientation_b = physics_scene_get_body(scene, in_constraint->body_b)->orientation;
+	const Vec3 friction_impulse = quat_rotate_vec3(orientation_b, cache->friction_impulse_local);
+	in_constraint->impulses[PHYSICS_CONTACT_ROW_NORMAL] = cache->normal_impulse;
+	for (i32 row = PHYSICS_CONTACT_ROW_TANGENT_0; row <= PHYSICS_CONTACT_ROW_TANGENT_1; ++row)
+	{
+		in_constraint->impulses[row] = vec3_dot(friction_impulse, in_constraint->jacobians[row].linear_b);
+	}
+
+	for (i32 row = 0; row < PHYSICS_CONTACT_ROW_COUNT; ++row)
+	{
+		physics_contact_constraint_apply_impulse(scene, in_constraint, row, in_constraint->impulses[row]);
+	}
+}
+
+// Saves the solved impulses for next step's warm start
+void physics_contact_constraint_store_impulses(PhysicsScene* scene, const PhysicsContactConstraint* in_constraint)
+{
+	PhysicsContactImpulseCache* cache = in_constraint->cached_impulses;
+	if (!cache)
+	{
+		return;
+	}
+
+	const Vec3 friction_impulse = vec3_add(
+		vec3_scale(in_constraint->jacobians[PHYSICS_CONTACT_ROW_TANGENT_0].linear_b, in_constraint->impulses[PHYSICS_CONTACT_ROW_TANGENT_0]),
+		vec3_scale(in_constraint->jacobians[PHYSICS_CONTACT_ROW_TANGENT_1].linear_b, in_constraint->impulses[PHYSICS_CONTACT_ROW_TANGENT_1])
+	);
+	cache->normal_impulse = in_constraint->impulses[PHYSICS_CONTACT_ROW_NORMAL];
+	const Quat orientation_b = physics_scene_get_body(scene, in_constraint->body_b)->orientation;
+	cache->friction_impulse_local = quat_rotate_vec3(quat_conjugate(orientation_b), friction_impulse);
+}
+
+// One sequential impulse iteration. Friction goes first so the normal row, which matters most, has the final say
+void physics_contact_constraint_solve(PhysicsScene* scene, PhysicsContactConstraint* in_constraint)
+{
+	const f32 max_friction_impulse = in_constraint->friction * in_constraint->impulses[PHYSICS_CONTACT_ROW_NORMAL];
+	for (i32 row = PHYSICS_CONTACT_ROW_TANGENT_0; row <= PHYSICS_CONTACT_ROW_TANGENT_1; ++row)
+	{
+		const f32 velocity = jacobian1x12_mul_vec12(in_constraint->jacobians[row], physics_contact_constraint_get_velocities(scene, in_constraint));
+		const f32 old_impulse = in_constraint->impulses[row];
+		const f32 new_impulse = CLAMP(old_impulse - velocity * in_constraint->masses[row], -max_friction_impulse, max_friction_impulse);
+		in_constraint->impulses[row] = new_impulse;
+		physics_contact_constraint_apply_impulse(scene, in_constraint, row, new_impulse - old_impulse);
+	}
+
+	{
+		const i32 row = PHYSICS_CONTACT_ROW_NORMAL;
+		const f32 velocity = jacobian1x12_mul_vec12(in_constraint->jacobians[row], physics_contact_constraint_get_velocities(scene, in_constraint));
+		const f32 old_impulse = in_constraint->impulses[row];
+		const f32 new_impulse = MAX(old_impulse - (velocity + in_constraint->bias) * in_constraint->masses[row], 0.0f);
+		in_constraint->impulses[row] = new_impulse;
+		physics_contact_constraint_apply_impulse(scene, in_constraint, row, new_impulse - old_impulse);
+	}
+}
+
+// Run once after the iterations: contacts that were hit hard enough bounce with their combined elasticity
+void physics_contact_constraint_apply_restitution(PhysicsScene* scene, PhysicsContactConstraint* in_constraint)
+{
+	if (	in_constraint->elasticity <= 0.0f
+		||	in_constraint->relative_normal_velocity > -PHYSICS_RESTITUTION_THRESHOLD
+		||	in_constraint->impulses[PHYSICS_CONTACT_ROW_NORMAL] <= 0.0f)
+	{
+		return;
+	}
+
+	const i32 row = PHYSICS_CONTACT_ROW_NORMAL;
+	const f32 target_velocity = -in_constraint->elasticity * in_constraint->relative_normal_velocity;
+	const f32 velocity = jacobian1x12_mul_vec12(in_constraint->jacobians[row], physics_contact_constraint_get_velocities(scene, in_constraint));
+	const f32 old_impulse = in_constraint->impulses[row];
+	const f32 new_impulse = MAX(old_impulse - (velocity - target_velocity) * in_constraint->masses[row], 0.0f);
+	in_constraint->impulses[row] = new_impulse;
+	physics_contact_constraint_apply_impulse(scene, in_constraint, row, new_impulse - old_impulse);
+}
+
+// Manifold points that separate or slide apart by more than this are dropped. New points this close to an old one replace it
+#define PHYSICS_CONTACT_BREAKING_DISTANCE 0.02f
+
+// Radians. Small enough that the corners found by tilting a body are still touching when it's level
+#define PHYSICS_MANIFOLD_PERTURBATION_ANGLE 0.02f
+
+typedef struct PhysicsManifoldPoint
+{
+	Vec3 point_on_a_local;
+	Vec3 point_on_b_local;
+	Vec3 normal_local;	// In b's local space, so it turns with b. Each point keeps the normal it was found with, which limits the damage of one bad normal
+	PhysicsContactImpulseCache impulses;	// From the last solve, to warm start the next one
+} PhysicsManifoldPoint;
+
+// Contact points between one pair of bodies, kept across steps. Box pairs find their whole contact patch each step
+// Other pairs find a single point per step, and the manifold builds up the rest. physics_manifold_add_perturbed_contacts fills in the corners of a new flat contact straight away
+typedef struct PhysicsManifold
+{
+	u64 pair_id;
+	i32 body_idx_a;	// Indices into PhysicsScene.bodies, in the order the points were found with
+	i32 body_idx_b;
+	PhysicsManifoldPoint points[PHYSICS_MANIFOLD_MAX_POINTS];
+	i32 num_points;
+	bool is_active;	// Set when a contact refreshes this manifold, or while neither body is awake. Inactive manifolds are removed at the end of the update
+} PhysicsManifold;
+
+// World space contact for one manifold point, with its separation measured along the point's normal. in_body_a and in_body_b are the manifold's bodies
+PhysicsContact physics_manifold_get_contact(const PhysicsManifold* in_manifold, const i32 in_point_idx, const PhysicsBody* in_body_a, const PhysicsBody* in_body_b)
+{
+	const PhysicsManifoldPoint* point = &in_manifold->points[in_point_idx];
+	const Vec3 point_on_a_world = physics_body_local_to_world_space(in_body_a, point->point_on_a_local);
+	const Vec3 point_on_b_world = physics_body_local_to_world_space(in_body_b, point->point_on_b_local);
+	const Vec3 normal = quat_rotate_vec3(in_body_b->orientation, point->normal_local);
+
+	return (PhysicsContact) {
+		.point_on_a_world = point_on_a_world,
+		.point_on_b_world = point_on_b_world,
+		.point_on_a_local = point->point_on_a_local,
+		.point_on_b_local = point->point_on_b_local,
+		.normal = normal,
+		.separation_distance = vec3_dot(vec3_sub(point_on_b_world, point_on_a_world), normal),
+		.body_a = { .idx = in_manifold->body_idx_a },
+		.body_b = { .idx = in_manifold->body_idx_b },
+		.pair_id = in_manifold->pair_id,
+	};
+}
+
+// Merges in_contact's point into the manifold. A full manifold keeps the deepest point and the largest area
+void physics_manifold_add_contact(PhysicsScene* scene, PhysicsManifold* in_manifold, const PhysicsContact* in_contact)
+{
+	const PhysicsBody* body_a = physics_scene_get_body(scene, in_contact->body_a);
+	const PhysicsBody* body_b = physics_scene_get_body(scene, in_contact->body_b);
+	const f32 breaking_distance_squared = PHYSICS_CONTACT_BREAKING_DISTANCE * PHYSICS_CONTACT_BREAKING_DISTANCE;
+
+	const PhysicsManifoldPoint new_point = {
+		.point_on_a_local = in_contact->point_on_a_local,
+		.point_on_b_local = in_contact->point_on_b_local,
+		.normal_local = quat_rotate_vec3(quat_inverse(body_b->orientation), in_contact->normal),
+	};
+
+	// A point close to an existing one is the same contact: move it, but keep its impulses
+	for (i32 point_idx = 0; point_idx < in_manifold->num_points; ++point_idx)
+	{
+		PhysicsManifoldPoint* point = &in_manifold->points[point_idx];
+		if (vec3_length_squared(vec3_sub(point->point_on_a_local, new_point.point_on_a_local)) < breaking_distance_squared)
+		{
+			point->point_on_a_local = new_point.point_on_a_local;
+			point->point_on_b_local = new_point.point_on_b_local;
+			point->normal_local = new_point.normal_local;
+			return;
+		}
+	}
+
+	if (in_manifold->num_points < PHYSICS_MANIFOLD_MAX_POINTS)
+	{
+		in_manifold->points[in_manifold->num_points++] = new_point;
+		return;
+	}
+
+	// Full: replace whichever point leaves the largest area. The deepest point is never replaced
+	i32 deepest_idx = 0;
+	f32 deepest_separation = FLT_MAX;
+	Vec3 points[PHYSICS_MANIFOLD_MAX_POINTS];
+	for (i32 point_idx = 0; point_idx < PHYSICS_MANIFOLD_MAX_POINTS; ++point_idx)
+	{
+		const PhysicsContact contact = physics_manifold_get_contact(in_manifold, point_idx, body_a, body_b);
+		points[point_idx] = contact.point_on_a_world;
+		if (contact.separation_distance < deepest_separation)
+		{
+			deepest_separation = contact.separation_distance;
+			deepest_idx = point_idx;
+		}
+	}
+
+	if (in_contact->separation_distance < deepest_separation)
+	{
+		deepest_idx = -1;
+	}
+
+	i32 replace_idx = -1;
+	f32 max_area = -1.0f;
+	for (i32 point_idx = 0; point_idx < PHYSICS_MANIFOLD_MAX_POINTS; ++point_idx)
+	{
+		if (point_idx == deepest_idx)
+		{
+			continue;
+		}
+
+		Vec3 candidate_points[PHYSICS_MANIFOLD_MAX_POINTS];
+		memcpy(candidate_points, points, sizeof(points));
+		candidate_points[point_idx] = in_contact->point_on_a_world;
+
+		const f32 area = physics_manifold_get_area(candidate_points[0], candidate_points[1], candidate_points[2], candidate_points[3]);
+		if (area > max_area)
+		{
+			max_area = area;
+			replace_idx = point_idx;
+		}
+	}
+
+	// The replaced point was carrying part of the load, so its impulses are a better warm start than zero
+	PhysicsManifoldPoint* replaced_point = &in_manifold->points[replace_idx];
+	replaced_point->point_on_a_local = new_point.point_on_a_local;
+	replaced_point->point_on_b_local = new_point.point_on_b_local;
+	replaced_point->normal_local = new_point.normal_local;
+}
+
+// Drops points the bodies have moved away from, then merges in_contact's point
+void physics_manifold_refresh(PhysicsScene* scene, PhysicsManifold* in_manifold, const PhysicsContact* in_contact)
+{
+	in_manifold->is_active = true;
+
+	const PhysicsBody* body_a = physics_scene_get_body(scene, in_contact->body_a);
+	const PhysicsBody* body_b = physics_scene_get_body(scene, in_contact->body_b);
+
+	const f32 breaking_distance_squared = PHYSICS_CONTACT_BREAKING_DISTANCE * PHYSICS_CONTACT_BREAKING_DISTANCE;
+
+	for (i32 point_idx = in_manifold->num_points - 1; point_idx >= 0; --point_idx)
+	{
+		const PhysicsContact contact = physics_manifold_get_contact(in_manifold, point_idx, body_a, body_b);
+		const Vec3 b_to_a = vec3_sub(contact.point_on_a_world, contact.point_on_b_world);
+		const Vec3 tangential_drift = vec3_sub(b_to_a, vec3_scale(contact.normal, -contact.separation_distance));
+		if (	contact.separation_distance > PHYSICS_CONTACT_BREAKING_DISTANCE
+			||	vec3_length_squared(tangential_drift) > breaking_distance_squared)
+		{
+			in_manifold->points[point_idx] = in_manifold->points[--in_manifold->num_points];
+		}
+	}
+
+	physics_manifold_add_contact(scene, in_manifold, in_contact);
+}
 
-	PhysicsBody* body_a = in_constraint->body_a;
-	PhysicsBody* body_b = in_constraint->body_b;
+// A box landing flat would otherwise balance on the narrowphase's single point until rocking uncovered its other corners
+// Tilting the smaller body slightly a few ways around the normal makes each of those corners its support point in turn
+void physics_manifold_add_perturbed_contacts(PhysicsScene* scene, PhysicsManifold* in_manifold, const PhysicsContact* in_contact)
+{
+	const PhysicsBody* body_a = physics_scene_get_body(scene, in_contact->body_a);
+	const PhysicsBody* body_b = physics_scene_get_body(scene, in_contact->body_b);
 
-	inv_mass_matrix.rows[0].data[0] = body_a->inverse_mass;
-	inv_mass_matrix.rows[1].data[1] = body_a->inverse_mass;
-	inv_mass_matrix.rows[2].data[2] = body_a->inverse_mass;
+	// Curved surfaces only touch at one point
+	if (	body_a->shape->type == SHAPE_TYPE_SPHERE
+		||	body_b->shape->type == SHAPE_TYPE_SPHERE)
+	{
+		return;
+	}
 
-	Mat3 inv_inertia_a = physics_body_get_inverse_inertia_tensor_world(body_a);
-	for (i32 i = 0; i < 3; ++i)
+	const Bounds bounds_a = physics_body_get_bounds(body_a);
+	const Bounds bounds_b = physics_body_get_bounds(body_b);
+	const bool perturb_a = vec3_length_squared(vec3_sub(bounds_a.max, bounds_a.min)) < vec3_length_squared(vec3_sub(bounds_b.max, bounds_b.min));
+
+	Vec3 tangent_0;
+	Vec3 tangent_1;
+	physics_contact_get_tangents(in_contact->normal, &tangent_0, &tangent_1);
+
+	for (i32 perturbation_idx = 0; perturbation_idx < PHYSICS_MANIFOLD_MAX_POINTS; ++perturbation_idx)
 	{
-		inv_mass_matrix.rows[3+i].data[3+0] = inv_inertia_a.columns[0].v[i];
-		inv_mass_matrix.rows[3+i].data[3+1] = inv_inertia_a.columns[1].v[i];
-		inv_mass_matrix.rows[3+i].data[3+2] = inv_inertia_a.columns[2].v[i];	
+		// Offset from the tangents so the tilt axis is less likely to line up with an edge, which would tie two corners
+		const f32 axis_angle = ((f32) perturbation_idx + 0.25f) * (PI / 2.0f);
+		const Vec3 axis = vec3_add(vec3_scale(tangent_0, cosf(axis_angle)), vec3_scale(tangent_1, sinf(axis_angle)));
+
+		PhysicsBody perturbed_body = perturb_a ? *body_a : *body_b;
+		perturbed_body.orientation = quat_normalize(quat_mul(quat_new(axis, PHYSICS_MANIFOLD_PERTURBATION_ANGLE), perturbed_body.orientation));
+
+		const Vec3 support_dir = perturb_a ? in_contact->normal : vec3_negate(in_contact->normal);
+		const Vec3 support_local = physics_body_world_to_local_space(&perturbed_body, physics_body_support(&perturbed_body, support_dir, 0.0f));
+
+		// The support point is on the body's surface, so it moves back with the body. The other point goes on the original contact plane
+		PhysicsContact contact = *in_contact;
+		if (perturb_a)
+		{
+			contact.point_on_a_local = support_local;
+			contact.point_on_a_world = physics_body_local_to_world_space(body_a, contact.point_on_a_local);
+			const f32 distance_to_plane = vec3_dot(vec3_sub(in_contact->point_on_b_world, contact.point_on_a_world), contact.normal);
+			contact.point_on_b_world = vec3_add(contact.point_on_a_world, vec3_scale(contact.normal, distance_to_plane));
+			contact.point_on_b_local = physics_body_world_to_local_space(body_b, contact.point_on_b_world);
+		}
+		else
+		{
+			contact.point_on_b_local = support_local;
+			contact.point_on_b_world = physics_body_local_to_world_space(body_b, contact.point_on_b_local);
+			const f32 distance_to_plane = vec3_dot(vec3_sub(contact.point_on_b_world, in_contact->point_on_a_world), contact.normal);
+			contact.point_on_a_world = vec3_sub(contact.point_on_b_world, vec3_scale(contact.normal, distance_to_plane));
+			contact.point_on_a_local = physics_body_world_to_local_space(body_a, contact.point_on_a_world);
+		}
+		contact.separation_distance = vec3_dot(vec3_sub(contact.point_on_b_world, contact.point_on_a_world), contact.normal);
+
+		// Away from a flat contact the corners found are nowhere near touching
+		if (contact.separation_distance > PHYSICS_CONTACT_BREAKING_DISTANCE)
+		{
+			continue;
+		}
+
+		physics_manifold_add_contact(scene, in_manifold, &contact);
 	}
+}
+
+typedef enum PhysicsConstraintType
+{
+	PHYSICS_CONSTRAINT_TYPE_DISTANCE,
+} PhysicsConstraintType;
+
+typedef struct PhysicsConstraintDistance
+{
+	Jacobian1x12 jacobian;
+	f32 cached_lambda; // Lambda from the previous solve, used to warm start the next one
+} PhysicsConstraintDistance;
 
-	inv_mass_matrix.rows[6].data[6] = body_b->inverse_mass;
-	inv_mass_matrix.rows[7].data[7] = body_b->inverse_mass;
-	inv_mass_matrix.rows[8].data[8] = body_b->inverse_mass;
+typedef struct PhysicsConstraint
+{
+	PhysicsBodyHandle body_a;
+	PhysicsBodyHandle body_b;
+
+	Vec3 anchor_a;
+	Vec3 axis_a;
 
-	Mat3 inv_inertia_b = physics_body_get_inverse_inertia_tensor_world(body_b);
-	for (i32 i = 0; i < 3; ++i)
+	Vec3 anchor_b;
+	Vec3 axis_b;
+
+	PhysicsConstraintType type;
+	
+	union 
+	{
+		PhysicsConstraintDistance distance;
+	};	
+} PhysicsConstraint;
+
+// Block-diagonal inverse mass of the constraint's two bodies
+InverseMass12 physics_constraint_get_inverse_mass(PhysicsScene* scene, const PhysicsConstraint* in_constraint)
+{
+	PhysicsBody* body_a = physics_scene_get_body(scene, in_constraint->body_a);
+	PhysicsBody* body_b = physics_scene_get_body(scene, in_constraint->body_b);
+
+	return (InverseMass12) {
+		.body_a = {
+			.inverse_mass = body_a->inverse_mass,
+			.inverse_inertia = physics_body_get_inverse_inertia_tensor_world(body_a),
+		},
+		.body_b = {
+			.inverse_mass = body_b->inverse_mass,
+			.inverse_inertia = physics_body_get_inverse_inertia_tensor_world(body_b),
+		},
+	};
+}
+
+// Returns the stacked velocities (linear a, angular a, linear b, angular b) of the constraint's two bodies
+Vec12 physics_constraint_get_velocities(PhysicsScene* scene, const PhysicsConstraint* in_constraint)
+{
+	PhysicsBody* body_a = physics_scene_get_body(scene, in_constraint->body_a);
+	PhysicsBody* body_b = physics_scene_get_body(scene, in_constraint->body_b);
+
+	return (Vec12) {
+		.linear_a = body_a->linear_velocity,
+		.angular_a = body_a->angular_velocity,
+		.linear_b = body_b->linear_velocity,
+		.angular_b = body_b->angular_velocity,
+	};
+}
+
+void physics_constraint_apply_impulses(PhysicsScene* scene, PhysicsConstraint* in_constraint, const Vec12 in_impulses)
+{
+	PhysicsBody* body_a = physics_scene_get_body(scene, in_constraint->body_a);
+	physics_body_apply_impulse_linear(body_a, in_impulses.linear_a);
+	physics_body_apply_impulse_angular(body_a, in_impulses.angular_a);
+
+	PhysicsBody* body_b = physics_scene_get_body(scene, in_constraint->body_b);
+	physics_body_apply_impulse_linear(body_b, in_impulses.linear_b);
+	physics_body_apply_impulse_angular(body_b, in_impulses.angular_b);
+}
+
+void physics_constraint_pre_solve(PhysicsScene* scene, PhysicsConstraint* in_constraint, const f32 in_delta_time)
+{
+	PhysicsBody* body_a = physics_scene_get_body(scene, in_constraint->body_a);
+	PhysicsBody* body_b = physics_scene_get_body(scene, in_constraint->body_b);
+
+	switch (in_constraint->type)
+	{
+		case PHYSICS_CONSTRAINT_TYPE_DISTANCE:
+		{
+			Jacobian1x12* jacobian = &in_constraint->distance.jacobian;
+
+			const Affine3 transform_a = physics_body_get_transform(body_a);
+			const Affine3 transform_b = physics_body_get_transform(body_b);
+			const Vec3 world_anchor_a = affine3_transform_point(transform_a, in_constraint->anchor_a);
+			const Vec3 world_anchor_b = affine3_transform_point(transform_b, in_constraint->anchor_b);
+			const Vec3 r = vec3_sub(world_anchor_b, world_anchor_a);
+			const Vec3 ra = vec3_sub(world_anchor_a, affine3_transform_point(transform_a, physics_body_get_center_of_mass_local(body_a)));
+			const Vec3 rb = vec3_sub(world_anchor_b, affine3_transform_point(transform_b, physics_body_get_center_of_mass_local(body_b)));
+			const Vec3 a = world_anchor_a;
+			const Vec3 b = world_anchor_b;
+
+			jacobian->linear_a = vec3_scale(vec3_sub(a,b), 2.0f);
+			jacobian->angular_a = vec3_cross(ra, jacobian->linear_a);
+			jacobian->linear_b = vec3_scale(vec3_sub(b,a), 2.0f);
+			jacobian->angular_b = vec3_cross(rb, jacobian->linear_b);
+
+			break;
+		}	
+		default:
+			break;
+	}
+}
+
+// Applies the impulse accumulated last step, so the iterations start near the answer
+void physics_constraint_warm_start(PhysicsScene* scene, PhysicsConstraint* in_constraint)
+{
+	switch (in_constraint->type)
+	{
+		case PHYSICS_CONSTRAINT_TYPE_DISTANCE:
+		{
+			const PhysicsConstraintDistance* distance = &in_constraint->distance;
+			physics_constraint_apply_impulses(scene, in_constraint, jacobian1x12_transpose_mul_f32(distance->jacobian, distance->cached_lambda));
+			break;
+		}
+		default:
+			break;
+	}
+}
+
+// One sequential impulse iteration. The applied lambda is accumulated for next step's warm start
+void physics_constraint_solve(PhysicsScene* scene, PhysicsConstraint* in_constraint)
+{
+	switch (in_constraint->type)
+	{
+		case PHYSICS_CONSTRAINT_TYPE_DISTANCE:
+		{
+			const Jacobian1x12 jacobian = in_constraint->distance.jacobian;
+			const InverseMass12 inverse_mass = physics_constraint_get_inverse_mass(scene, in_constraint);
+
+			// A single row is a 1x1 system, so lambda solves directly
+			const f32 effective_mass = jacobian1x12_effective_mass(jacobian, &inverse_mass);
+			if (effective_mass <= 0.0f)
+			{
+				break;
+			}
+
+			const f32 rhs = -jacobian1x12_mul_vec12(jacobian, physics_constraint_get_velocities(scene, in_constraint));
+			const f32 lambda = rhs / effective_mass;
+			physics_constraint_apply_impulses(scene, in_constraint, jacobian1x12_transpose_mul_f32(jacobian, lambda));
+			in_constraint->distance.cached_lambda += lambda;
+
+			break;
+		}	
+		default:
+			break;
+	}
+}
+
+void physics_constraint_post_solve(PhysicsScene* scene, PhysicsConstraint* in_constraint)
+{
+	(void) scene;
+
+	switch (in_constraint->type)
+	{
+		case PHYSICS_CONSTRAINT_TYPE_DISTANCE:
+		{
+			// Nothing to do	
+			break;
+		}	
+		default:
+			break;
+	}
+}
+
+typedef enum PhysicsBroadPhaseType
+{
+	PHYSICS_BROAD_PHASE_TYPE_SWEEP_AND_PRUNE,	// Best when bodies are of similar size
+	PHYSICS_BROAD_PHASE_TYPE_AABB_TREE,			// Handles a mix of large and small bodies, and skips bodies that stay within their fat bounds
+	PHYSICS_BROAD_PHASE_TYPE_SPATIAL_HASH_GRID,	// Best for many bodies around spatial_hash_grid.cell_size in extent. Uses task_system if set
+} PhysicsBroadPhaseType;
+
+typedef struct PhysicsNarrowPhaseJob
+{
+	PhysicsScene* scene;
+	const CollisionPair* pairs;	// Pairs[i] uses scene->gjk_caches[scene->pair_gjk_cache_indices[i]]
+	i32 pair_begin;
+	i32 pair_end;
+	f32 delta_time;
+	sbuffer(PhysicsContact) contacts;	// Contacts found by this job, reused across updates
+} PhysicsNarrowPhaseJob;
+
+enum { PHYSICS_NARROW_PHASE_MIN_PAIRS_PER_JOB = 16 };
+
+// Per body state for one step, indexed like PhysicsScene.bodies
+typedef struct PhysicsSolverBody
+{
+	LcpBodyInverseMass inverse_mass;	// World space, from the pose at the start of the step
+	f32 time;							// How far into the step the body has been integrated
+	bool is_fast;						// Sub-stepped through its time of impact contacts instead of using the solver
+	i32 island_idx;						// Index into PhysicsScene.islands, or -1 for static and sleeping bodies
+} PhysicsSolverBody;
+
+// Bodies linked by contacts and constraints. Islands share no dynamic bodies, so each is solved, and put to sleep, on its own
+typedef struct PhysicsIsland
+{
+	i32 contact_constraint_begin;	// Range in PhysicsScene.contact_constraints
+	i32 num_contact_constraints;
+	i32 constraint_begin;			// Range in PhysicsScene.island_constraint_indices
+	i32 num_constraints;
+	f32 min_sleep_time;				// Shortest sleep_time of the island's bodies
+} PhysicsIsland;
+
+typedef struct PhysicsSolverJob
+{
+	PhysicsScene* scene;
+	i32 island_begin;
+	i32 island_end;
+	f32 delta_time;
+} PhysicsSolverJob;
+
+enum { PHYSICS_SOLVER_MIN_CONSTRAINTS_PER_JOB = 64 };
+
+// Bodies slower than these for PHYSICS_TIME_TO_SLEEP seconds go to sleep once the rest of their island has too
+#define PHYSICS_SLEEP_LINEAR_VELOCITY 0.05f
+#define PHYSICS_SLEEP_ANGULAR_VELOCITY 0.05f
+#define PHYSICS_TIME_TO_SLEEP 0.5f
+
+typedef struct PhysicsScene
+{
+	sbuffer(PhysicsBody) bodies;		// Contiguous, so per-body loops walk memory in order. Refer to bodies by PhysicsBodyHandle
+	sbuffer(Shape) shapes;				// Parallel to bodies. Each body's shape points at its entry
+	sbuffer(PhysicsBodyRenderData) body_render_data;	// Parallel to bodies
+	sbuffer(PhysicsConstraint) constraints;
+	PhysicsBroadPhaseType broad_phase_type;	// Can be changed between updates
+	SweepAndPrune sweep_and_prune;
+	AabbTree aabb_tree;
+	SpatialHashGrid spatial_hash_grid;
+	TaskSystem* task_system;	// Optional. Not owned by the scene
+	sbuffer(PhysicsNarrowPhaseJob) narrow_phase_jobs;
+	sbuffer(PhysicsGjkCache) gjk_caches;						// Persist while their pair stays in the broadphase
+	PairMap gjk_cache_indices;									// Body pair to index in gjk_caches
+	sbuffer(i32) pair_gjk_cache_indices;						// Index in gjk_caches of each pair in the current narrowphase
+	i32 solver_iterations;
+	sbuffer(PhysicsSolverBody) solver_bodies;					// Reused across updates
+	sbuffer(PhysicsContactConstraint) contact_constraints;		// Reused across updates
+	sbuffer(PhysicsManifold) manifolds;							// Persist while their pair keeps finding contacts
+	PairMap manifold_indices;									// Body pair to index in manifolds
+	UnionFind island_union_find;								// Reused across updates
+	sbuffer(PhysicsIsland) islands;								// Awake islands of the current step
+	sbuffer(i32) island_constraint_indices;						// Indices into constraints, grouped by island
+	sbuffer(PhysicsSolverJob) solver_jobs;						// Reused across updates
+	f32 fixed_delta_time;		// Length of the steps taken by physics_scene_advance
+	i32 max_steps_per_advance;	// Frame time beyond this many steps is dropped, so a long frame can't snowball into longer ones
+	f32 accumulated_time;		// Frame time not yet simulated, always less than fixed_delta_time after an advance
+	f32 interpolation_alpha;	// accumulated_time as a fraction of a step, for physics_scene_get_body_interpolated_pose
+	Arena* arena;
+} PhysicsScene;
+
+void physics_scene_init(PhysicsScene* out_physics_scene)
+{
+	*out_physics_scene = (PhysicsScene) {
+		.bodies = NULL,
+		.broad_phase_type = PHYSICS_BROAD_PHASE_TYPE_AABB_TREE,
+		.solver_iterations = 6,
+		.fixed_delta_time = 1.0f / 60.0f,
+		.max_steps_per_advance = 4,
+		.arena = arena_create(&(ArenaDesc) {
+			.size = 64 KiB,
+			.allow_growth = true,
+		}),
+	};
+	sweep_and_prune_init(&out_physics_scene->sweep_and_prune);
+	aabb_tree_init(&out_physics_scene->aabb_tree);
+	spatial_hash_grid_init(&out_physics_scene->spatial_hash_grid, 16.0f);
+	pair_map_init(&out_physics_scene->manifold_indices);
+	pair_map_init(&out_physics_scene->gjk_cache_indices);
+	union_find_init(&out_physics_scene->island_union_find);
+}
+
+void physics_scene_destroy(PhysicsScene* in_physics_scene)
+{
+	for (i32 body_idx = 0; body_idx < sb_count(in_physics_scene->shapes); ++body_idx)
+	{
+		shape_release(&in_physics_scene->shapes[body_idx]);
+	}
+	sb_free(in_physics_scene->bodies);
+	sb_free(in_physics_scene->shapes);
+	sb_free(in_physics_scene->body_render_data);
+	sb_free(in_physics_scene->constraints);
+	sweep_and_prune_destroy(&in_physics_scene->sweep_and_prune);
+	aabb_tree_destroy(&in_physics_scene->aabb_tree);
+	spatial_hash_grid_destroy(&in_physics_scene->spatial_hash_grid);
+	for (i32 job_idx = 0; job_idx < sb_count(in_physics_scene->narrow_phase_jobs); ++job_idx)
+	{
+		sb_free(in_physics_scene->narrow_phase_jobs[job_idx].contacts);
+	}
+	sb_free(in_physics_scene->narrow_phase_jobs);
+	sb_free(in_physics_scene->solver_bodies);
+	sb_free(in_physics_scene->contact_constraints);
+	sb_free(in_physics_scene->manifolds);
+	pair_map_free(&in_physics_scene->manifold_indices);
+	sb_free(in_physics_scene->gjk_caches);
+	pair_map_free(&in_physics_scene->gjk_cache_indices);
+	sb_free(in_physics_scene->pair_gjk_cache_indices);
+	union_find_free(&in_physics_scene->island_union_find);
+	sb_free(in_physics_scene->islands);
+	sb_free(in_physics_scene->island_constraint_indices);
+	sb_free(in_physics_scene->solver_jobs);
+	arena_destroy(in_physics_scene->arena);
+}
+
+/*
+	Adds a body described by in_create_info to the scene, returning a handle to it.
+	The scene takes ownership of the passed-in data,
+	including the shape's reference to any shared shape data
+*/
+PhysicsBodyHandle physics_scene_add_body(PhysicsScene* in_physics_scene, const PhysicsBodyCreateInfo* in_create_info)
+{
+	const PhysicsBodyHandle handle = { .idx = sb_count(in_physics_scene->bodies) };
+
+	const Shape* old_shapes = in_physics_scene->shapes;
+	sb_push(in_physics_scene->shapes, in_create_info->shape);
+	if (in_physics_scene->shapes != old_shapes)
+	{
+		// Growing moved the shapes, so point the existing bodies at their new location
+		for (i32 body_idx = 0; body_idx < handle.idx; ++body_idx)
+		{
+			in_physics_scene->bodies[body_idx].shape = &in_physics_scene->shapes[body_idx];
+		}
+	}
+
+	sb_push(in_physics_scene->bodies, ((PhysicsBody) {
+		.position = in_create_info->position,
+		.orientation = in_create_info->orientation,
+		.linear_velocity = in_create_info->linear_velocity,
+		.angular_velocity = in_create_info->angular_velocity,
+		.shape = &in_physics_scene->shapes[handle.idx],
+		.inverse_mass = in_create_info->inverse_mass,
+		.elasticity = in_create_info->elasticity,
+		.friction = in_create_info->friction,
+		.is_sleeping = in_create_info->is_sleeping,
+	}));
+
+	sb_push(in_physics_scene->body_render_data, ((PhysicsBodyRenderData) {
+		.previous_position = in_create_info->position,
+		.previous_orientation = in_create_info->orientation,
+		.debug_color = in_create_info->debug_color,
+	}));
+
+	return handle;
+}
+
+// The returned pointer is only valid until the next body is added
+PhysicsBody* physics_scene_get_body(PhysicsScene* in_physics_scene, const PhysicsBodyHandle in_handle)
+{
+	assert(in_handle.idx >= 0 && in_handle.idx < sb_count(in_physics_scene->bodies));
+	return &in_physics_scene->bodies[in_handle.idx];
+}
+
+// Pose between the start and end of the latest step, with in_alpha of 0 giving the previous pose and 1 the current one
+void physics_scene_get_body_interpolated_pose(const PhysicsScene* in_physics_scene, const PhysicsBodyHandle in_handle, const f32 in_alpha, Vec3* out_position, Quat* out_orientation)
+{
+	assert(in_handle.idx >= 0 && in_handle.idx < sb_count(in_physics_scene->bodies));
+	const PhysicsBody* body = &in_physics_scene->bodies[in_handle.idx];
+	const PhysicsBodyRenderData* render_data = &in_physics_scene->body_render_data[in_handle.idx];
+	*out_position = vec3_lerp(in_alpha, render_data->previous_position, body->position);
+	*out_orientation = quat_nlerp(in_alpha, render_data->previous_orientation, body->orientation);
+}
+
+// Teleports the body. Sets the previous pose too, so rendering doesn't interpolate across the jump
+void physics_scene_set_body_pose(PhysicsScene* in_physics_scene, const PhysicsBodyHandle in_handle, const Vec3 in_position, const Quat in_orientation)
+{
+	PhysicsBody* body = physics_scene_get_body(in_physics_scene, in_handle);
+	body->position = in_position;
+	body->orientation = in_orientation;
+	physics_body_wake(body);
+
+	PhysicsBodyRenderData* render_data = &in_physics_scene->body_render_data[in_handle.idx];
+	render_data->previous_position = in_position;
+	render_data->previous_orientation = in_orientation;
+}
+
+void physics_scene_add_constraint(PhysicsScene* in_physics_scene, PhysicsConstraint* in_constraint)
+{
+	sb_push(in_physics_scene->constraints, *in_constraint);
+}
+
+PhysicsConstraint physics_constraint_distance_init(PhysicsScene* scene)
+{
+	return (PhysicsConstraint) {
+		.body_a = { .idx = -1 },
+		.body_b = { .idx = -1 },
+		.anchor_a = vec3_zero,
+		.axis_a = vec3_zero,
+		.anchor_b = vec3_zero,
+		.axis_b = vec3_zero,
+		.type = PHYSICS_CONSTRAINT_TYPE_DISTANCE,
+		.distance = {
+			.jacobian = vec12_zero,
+			.cached_lambda = 0.0f,
+		},
+	};
+}
+
+// Bounds used by the broadphase: the body's bounds swept by its velocity over this timestep, plus a small margin
+Bounds physics_body_get_broad_phase_bounds(const PhysicsBody* in_body, const f32 in_delta_time)
+{
+	Bounds bounds = physics_body_get_bounds(in_body);
+
+	// Expand bounds by position change this timestep
+	const Vec3 scaled_velocity = vec3_scale(in_body->linear_velocity, in_delta_time);
+	const Vec3 expanded_min = vec3_add(bounds.min, scaled_velocity);
+	const Vec3 expanded_max = vec3_add(bounds.max, scaled_velocity);
+	bounds_expand_point(&bounds, expanded_min);
+	bounds_expand_point(&bounds, expanded_max);
+
+	// Also expand so bodies within the speculative distance still pair up
+	const f32 epsilon = PHYSICS_SPECULATIVE_DISTANCE;
+	bounds_expand_point(&bounds, vec3_add(bounds.min, vec3_scale(vec3_new(-1,-1,-1), epsilon)));
+	bounds_expand_point(&bounds, vec3_add(bounds.max, vec3_scale(vec3_new( 1, 1, 1), epsilon)));
+
+	return bounds;
+}
+
+// Returns pairs of bodies whose broadphase bounds may overlap, using the scene's broad_phase_type. The returned buffer is owned by the scene and valid until the next call
+sbuffer(CollisionPair) physics_scene_broad_phase(PhysicsScene* in_physics_scene, f32 in_delta_time)
+{
+	const i32 num_bodies = sb_count(in_physics_scene->bodies);
+
+	Bounds* body_bounds = FCS_MEM_ALLOC(sizeof(Bounds) * MAX(num_bodies, 1));
+	for (i32 body_idx = 0; body_idx < num_bodies; ++body_idx)
+	{
+		body_bounds[body_idx] = physics_body_get_broad_phase_bounds(&in_physics_scene->bodies[body_idx], in_delta_time);
+	}
+
+	// Broadphases keep their pair sets across updates. Switching type leaves the others stale, and they catch up on their next update
+	BroadPhasePairSet* pair_set = NULL;
+	switch (in_physics_scene->broad_phase_type)
+	{
+		case PHYSICS_BROAD_PHASE_TYPE_SWEEP_AND_PRUNE:
+		{
+			// Sweep and Prune 3D. Only bodies that moved past each other cost anything beyond the O(n) refresh
+			sweep_and_prune_update(&in_physics_scene->sweep_and_prune, body_bounds, num_bodies);
+			pair_set = &in_physics_scene->sweep_and_prune.pair_set;
+			break;
+		}
+		case PHYSICS_BROAD_PHASE_TYPE_AABB_TREE:
+		{
+			// Pairs are of fattened bounds, so this may return a few extra pairs that the narrowphase rejects
+			aabb_tree_update(&in_physics_scene->aabb_tree, body_bounds, num_bodies);
+			pair_set = &in_physics_scene->aabb_tree.pair_set;
+			break;
+		}
+		case PHYSICS_BROAD_PHASE_TYPE_SPATIAL_HASH_GRID:
+		{
+			// Rebuilt from scratch each update, so cost doesn't depend on how much bodies moved
+			spatial_hash_grid_update(&in_physics_scene->spatial_hash_grid, body_bounds, num_bodies, in_physics_scene->task_system);
+			pair_set = &in_physics_scene->spatial_hash_grid.pair_set;
+			break;
+		}
+	}
+
+	FCS_MEM_FREE(body_bounds);
+
+	return pair_set->pairs;
+}
+
+// Tests one broadphase pair, returning how many contacts it wrote to out_contacts for bodies that may touch this timestep
+// Pairs with a fast body get a single time of impact contact. Others get up to PHYSICS_MANIFOLD_MAX_POINTS contacts at their current poses for the solver
+// Neither test modifies the scene beyond the pair's own io_gjk_cache, so pairs sharing a body can be tested concurrently
+i32 physics_scene_narrow_phase_pair(PhysicsScene* in_physics_scene, const CollisionPair in_pair, const f32 in_delta_time, PhysicsContact* out_contacts, PhysicsGjkCache* io_gjk_cache)
+{
+	PhysicsBody* body_a = &in_physics_scene->bodies[in_pair.idx_a];
+	PhysicsBody* body_b = &in_physics_scene->bodies[in_pair.idx_b];
+
+	// Static and sleeping bodies don't move, so a pair without an awake body has nothing new to find
+	if (!physics_body_is_awake(body_a) && !physics_body_is_awake(body_b))
+	{
+		return 0;
+	}
+
+	i32 num_contacts = 0;
+	const bool is_sub_step = physics_body_is_fast(body_a, in_delta_time) || physics_body_is_fast(body_b, in_delta_time);
+	if (is_sub_step)
+	{
+		// Intersection tests advance and rewind bodies, so this works on copies
+		PhysicsBody body_a_copy = *body_a;
+		PhysicsBody body_b_copy = *body_b;
+		out_contacts[0] = (PhysicsContact) {};
+		num_contacts = physics_bodies_intersect_dt(&body_a_copy, &body_b_copy, in_delta_time, &out_contacts[0]) ? 1 : 0;
+	}
+	else
+	{
+		num_contacts = physics_bodies_find_contacts(body_a, body_b, in_delta_time, out_contacts, io_gjk_cache);
+	}
+
+	for (i32 contact_idx = 0; contact_idx < num_contacts; ++contact_idx)
+	{
+		PhysicsContact* contact = &out_contacts[contact_idx];
+		contact->body_a = (PhysicsBodyHandle) { .idx = in_pair.idx_a };
+		contact->body_b = (PhysicsBodyHandle) { .idx = in_pair.idx_b };
+		contact->pair_id = pair_map_key(in_pair.idx_a, in_pair.idx_b);
+		contact->pair_point_idx = contact_idx;
+		contact->sub_step = is_sub_step;
+	}
+	return num_contacts;
+}
+
+void physics_narrow_phase_job_run(void* in_job)
+{
+	PhysicsNarrowPhaseJob* job = (PhysicsNarrowPhaseJob*) in_job;
+	sb_clear(job->contacts);
+
+	for (i32 pair_idx = job->pair_begin; pair_idx < job->pair_end; ++pair_idx)
+	{
+		PhysicsContact contacts[PHYSICS_MANIFOLD_MAX_POINTS];
+		PhysicsGjkCache* gjk_cache = &job->scene->gjk_caches[job->scene->pair_gjk_cache_indices[pair_idx]];
+		const i32 num_contacts = physics_scene_narrow_phase_pair(job->scene, job->pairs[pair_idx], job->delta_time, contacts, gjk_cache);
+		sb_append_array(job->contacts, contacts, num_contacts);
+	}
+}
+
+// Finds or creates the GJK cache of each pair, and removes those of pairs no longer in the broadphase
+// Done before the narrowphase jobs start, so each job only writes to the caches of its own pairs
+void physics_scene_update_gjk_caches(PhysicsScene* in_physics_scene, const CollisionPair* in_pairs, const i32 in_num_pairs)
+{
+	for (i32 cache_idx = 0; cache_idx < sb_count(in_physics_scene->gjk_caches); ++cache_idx)
+	{
+		in_physics_scene->gjk_caches[cache_idx].is_active = false;
+	}
+
+	for (i32 pair_idx = 0; pair_idx < in_num_pairs; ++pair_idx)
+	{
+		const u64 pair_id = pair_map_key(in_pairs[pair_idx].idx_a, in_pairs[pair_idx].idx_b);
+		const i32* existing_idx = pair_map_find(&in_physics_scene->gjk_cache_indices, pair_id);
+		if (existing_idx)
+		{
+			in_physics_scene->gjk_caches[*existing_idx].is_active = true;
+		}
+		else
+		{
+			pair_map_insert(&in_physics_scene->gjk_cache_indices, pair_id, sb_count(in_physics_scene->gjk_caches));
+			sb_push(in_physics_scene->gjk_caches, ((PhysicsGjkCache) {
+				.pair_id = pair_id,
+				.is_active = true,
+			}));
+		}
+	}
+
+	// Swap remove inactive caches, pointing the moved cache's map entry at its new slot
+	for (i32 cache_idx = sb_count(in_physics_scene->gjk_caches) - 1; cache_idx >= 0; --cache_idx)
+	{
+		if (in_physics_scene->gjk_caches[cache_idx].is_active)
+		{
+			continue;
+		}
+
+		pair_map_remove(&in_physics_scene->gjk_cache_indices, in_physics_scene->gjk_caches[cache_idx].pair_id, NULL);
+		const i32 last_idx = sb_count(in_physics_scene->gjk_caches) - 1;
+		if (cache_idx != last_idx)
+		{
+			in_physics_scene->gjk_caches[cache_idx] = in_physics_scene->gjk_caches[last_idx];
+			*pair_map_find(&in_physics_scene->gjk_cache_indices, in_physics_scene->gjk_caches[cache_idx].pair_id) = cache_idx;
+		}
+		sb_del(in_physics_scene->gjk_caches, last_idx);
+	}
+
+	sb_clear(in_physics_scene->pair_gjk_cache_indices);
+	for (i32 pair_idx = 0; pair_idx < in_num_pairs; ++pair_idx)
+	{
+		const u64 pair_id = pair_map_key(in_pairs[pair_idx].idx_a, in_pairs[pair_idx].idx_b);
+		sb_push(in_physics_scene->pair_gjk_cache_indices, *pair_map_find(&in_physics_scene->gjk_cache_indices, pair_id));
+	}
+}
+
+// Tests all broadphase pairs, split into contiguous ranges across the scene's task_system if it has one
+// Returns contacts sorted by time of impact then pair id, so the result is the same however many threads ran it. Caller frees the result
+sbuffer(PhysicsContact) physics_scene_narrow_phase(PhysicsScene* in_physics_scene, const CollisionPair* in_pairs, const i32 in_num_pairs, const f32 in_delta_time)
+{
+	physics_scene_update_gjk_caches(in_physics_scene, in_pairs, in_num_pairs);
+
+	TaskSystem* task_system = in_physics_scene->task_system;
+	const i32 max_jobs = task_system ? task_system_num_threads(task_system) + 1 : 1;
+	const i32 num_jobs = CLAMP(in_num_pairs / PHYSICS_NARROW_PHASE_MIN_PAIRS_PER_JOB, 1, max_jobs);
+	while (sb_count(in_physics_scene->narrow_phase_jobs) < num_jobs)
+	{
+		sb_push(in_physics_scene->narrow_phase_jobs, (PhysicsNarrowPhaseJob) {});
+	}
+
+	for (i32 job_idx = 0; job_idx < num_jobs; ++job_idx)
+	{
+		PhysicsNarrowPhaseJob* job = &in_physics_scene->narrow_phase_jobs[job_idx];
+		job->scene = in_physics_scene;
+		job->pairs = in_pairs;
+		job->pair_begin = (in_num_pairs * job_idx) / num_jobs;
+		job->pair_end = (in_num_pairs * (job_idx + 1)) / num_jobs;
+		job->delta_time = in_delta_time;
+	}
+
+	if (num_jobs > 1)
+	{
+		sbuffer(Task*) tasks = NULL;
+		for (i32 job_idx = 1; job_idx < num_jobs; ++job_idx)
+		{
+			sb_push(tasks, task_system_add_task(task_system, &(TaskDesc) {
+				.task_function = physics_narrow_phase_job_run,
+				.argument = &in_physics_scene->narrow_phase_jobs[job_idx],
+			}));
+		}
+		physics_narrow_phase_job_run(&in_physics_scene->narrow_phase_jobs[0]);
+		task_system_wait_tasks(task_system, tasks);
+	}
+	else
+	{
+		physics_narrow_phase_job_run(&in_physics_scene->narrow_phase_jobs[0]);
+	}
+
+	// Merge per-job buffers
+	sbuffer(PhysicsContact) contacts = NULL;
+	for (i32 job_idx = 0; job_idx < num_jobs; ++job_idx)
+	{
+		const PhysicsNarrowPhaseJob* job = &in_physics_scene->narrow_phase_jobs[job_idx];
+		if (sb_count(job->contacts) > 0)
+		{
+			sb_append_array(contacts, job->contacts, sb_count(job->contacts));
+		}
+	}
+
+	// Sort contacts by time of impact. physics_contact_compare is a total order, so this doesn't depend on the merge order above
+	const i32 num_contacts = sb_count(contacts);
+	if (num_contacts > 1)
 	{
-		inv_mass_matrix.rows[9+i].data[9+0] = inv_inertia_b.columns[0].v[i];
-		inv_mass_matrix.rows[9+i].data[9+1] = inv_inertia_b.columns[1].v[i];
-		inv_mass_matrix.rows[9+i].data[9+2] = inv_inertia_b.columns[2].v[i];	
+		qsort(contacts, num_contacts, sizeof(PhysicsContact), physics_contact_compare);
 	}
 
-	return inv_mass_matrix;
+	return contacts;
 }
 
-VecN physics_constraint_get_velocities(Arena* arena, const PhysicsConstraint* in_constraint)
+// Refreshes the manifold of each pair with a solver contact, and removes manifolds of pairs that no longer have one
+// Pairs the narrowphase skipped because neither body is awake keep their manifolds, ready for when they wake
+void physics_scene_update_manifolds(PhysicsScene* in_physics_scene, const PhysicsContact* in_contacts, const i32 in_num_contacts)
 {
-	VecN velocities = vecn_new(arena, 12);
+	for (i32 manifold_idx = 0; manifold_idx < sb_count(in_physics_scene->manifolds); ++manifold_idx)
+	{
+		PhysicsManifold* manifold = &in_physics_scene->manifolds[manifold_idx];
+		manifold->is_active = !physics_body_is_awake(&in_physics_scene->bodies[manifold->body_idx_a])
+						   && !physics_body_is_awake(&in_physics_scene->bodies[manifold->body_idx_b]);
+	}
 
-	PhysicsBody* body_a = in_constraint->body_a;
-	PhysicsBody* body_b = in_constraint->body_b;
+	for (i32 contact_idx = 0; contact_idx < in_num_contacts; ++contact_idx)
+	{
+		const PhysicsContact* contact = &in_contacts[contact_idx];
+		if (contact->sub_step)
+		{
+			continue;
+		}
 
-	velocities.data[0]	= body_a->linear_velocity.x;
-	velocities.data[1]	= body_a->linear_velocity.y;
-	velocities.data[2]	= body_a->linear_velocity.z;
+		// The pair's bodies are in the same order every step, so manifold points stay on the right bodies
+		const i32* existing_idx = pair_map_find(&in_physics_scene->manifold_indices, contact->pair_id);
+		if (!existing_idx)
+		{
+			pair_map_insert(&in_physics_scene->manifold_indices, contact->pair_id, sb_count(in_physics_scene->manifolds));
+			sb_push(in_physics_scene->manifolds, ((PhysicsManifold) {
+				.pair_id = contact->pair_id,
+				.body_idx_a = contact->body_a.idx,
+				.body_idx_b = contact->body_b.idx,
+			}));
+		}
+		const i32 manifold_idx = existing_idx ? *existing_idx : sb_count(in_physics_scene->manifolds) - 1;
+		PhysicsManifold* manifold = &in_physics_scene->manifolds[manifold_idx];
 
-	velocities.data[3]	= body_a->angular_velocity.x;
-	velocities.data[4]	= body_a->angular_velocity.y;
-	velocities.data[5]	= body_a->angular_velocity.z;
+		// A pair's contacts are next to each other, so its first one drops the stale points before the rest are merged
+		if (contact->pair_point_idx == 0)
+		{
+			physics_manifold_refresh(in_physics_scene, manifold, contact);
+		}
+		else
+		{
+			physics_manifold_add_contact(in_physics_scene, manifold, contact);
+		}
 
-	velocities.data[6]	= body_b->linear_velocity.x;
-	velocities.data[7]	= body_b->linear_velocity.y;
-	velocities.data[8]	= body_b->linear_velocity.z;
+		if (manifold->num_points < PHYSICS_MANIFOLD_MAX_POINTS)
+		{
+			physics_manifold_add_perturbed_contacts(in_physics_scene, manifold, contact);
+		}
+	}
 
-	velocities.data[9]	= body_b->angular_velocity.x;
-	velocities.data[10]	= body_b->angular_velocity.y;
-	velocities.data[11]	= body_b->angular_velocity.z;
+	for (i32 manifold_idx = sb_count(in_physics_scene->manifolds) - 1; manifold_idx >= 0; --manifold_idx)
+	{
+		PhysicsManifold* manifold = &in_physics_scene->manifolds[manifold_idx];
+		if (manifold->is_active)
+		{
+			continue;
+		}
 
-	return velocities;
+		// Swap-remove, pointing the moved manifold's entry at its new index
+		pair_map_remove(&in_physics_scene->manifold_indices, manifold->pair_id, NULL);
+		const i32 last_idx = sb_count(in_physics_scene->manifolds) - 1;
+		if (manifold_idx != last_idx)
+		{
+			*manifold = in_physics_scene->manifolds[last_idx];
+			*pair_map_find(&in_physics_scene->manifold_indices, manifold->pair_id) = manifold_idx;
+		}
+		sb_del(in_physics_scene->manifolds, last_idx);
+	}
 }
 
-void physics_constraint_apply_impulses(PhysicsConstraint* in_constraint, const VecN* in_impulses)
+static inline void physics_scene_island_union(PhysicsScene* in_physics_scene, const i32 in_body_idx_a, const i32 in_body_idx_b)
 {
-	Vec3 force_internal_a	= vec3_zero;
-	Vec3 torque_internal_a	= vec3_zero;
-	Vec3 force_internal_b	= vec3_zero;
-	Vec3 torque_internal_b	= vec3_zero;
-
-	force_internal_a.v[0] = in_impulses->data[0];
-	force_internal_a.v[1] = in_impulses->data[1];	
-	force_internal_a.v[2] = in_impulses->data[2];
-
-	torque_internal_a.v[0] = in_impulses->data[3];
-	torque_internal_a.v[1] = in_impulses->data[4];	
-	torque_internal_a.v[2] = in_impulses->data[5];
-
-	force_internal_b.v[0] = in_impulses->data[6];
-	force_internal_b.v[1] = in_impulses->data[7];	
-	force_internal_b.v[2] = in_impulses->data[8];
-
-	torque_internal_b.v[0] = in_impulses->data[9];
-	torque_internal_b.v[1] = in_impulses->data[10];	
-	torque_internal_b.v[2] = in_impulses->data[11];
-
-	PhysicsBody* body_a = in_constraint->body_a;
-	physics_body_apply_impulse_linear(body_a, force_internal_a);	
-	physics_body_apply_impulse_angular(body_a, torque_internal_a);
+	if (	in_physics_scene->bodies[in_body_idx_a].inverse_mass > 0.f
+		&&	in_physics_scene->bodies[in_body_idx_b].inverse_mass > 0.f)
+	{
+		union_find_union(&in_physics_scene->island_union_find, in_body_idx_a, in_body_idx_b);
+	}
+}
 
-	PhysicsBody* body_b = in_constraint->body_b;
-	physics_body_apply_impulse_linear(body_b, force_internal_b);	
-	physics_body_apply_impulse_angular(body_b, torque_internal_b);
+// Island of a manifold or constraint: that of its dynamic body, or -1 if it's asleep
+static inline i32 physics_scene_get_pair_island(const PhysicsScene* in_physics_scene, const i32 in_body_idx_a, const i32 in_body_idx_b)
+{
+	const bool is_a_static = in_physics_scene->bodies[in_body_idx_a].inverse_mass <= 0.f;
+	return in_physics_scene->solver_bodies[is_a_static ? in_body_idx_b : in_body_idx_a].island_idx;
 }
 
-void physics_constraint_pre_solve(PhysicsScene* scene, PhysicsConstraint* in_constraint, const f32 in_delta_time)
+// Links dynamic bodies that share a manifold, a sub-stepped contact or a constraint into islands with a union-find
+// Static bodies link nothing, otherwise everything resting on the ground would be one island
+// Islands with an awake body in them are woken, so a body that touches a sleeping one wakes it and everything it rests on
+// Sleeping islands are left out of PhysicsScene.islands, which also gets each island's constraint counts
+void physics_scene_build_islands(PhysicsScene* in_physics_scene, const PhysicsContact* in_contacts, const i32 in_num_contacts)
 {
-	PhysicsBody* body_a = in_constraint->body_a;
-	PhysicsBody* body_b = in_constraint->body_b;
+	const i32 num_bodies = sb_count(in_physics_scene->bodies);
+	UnionFind* union_find = &in_physics_scene->island_union_find;
+	union_find_reset(union_find, num_bodies);
 
-	switch (in_constraint->type)
+	for (i32 manifold_idx = 0; manifold_idx < sb_count(in_physics_scene->manifolds); ++manifold_idx)
 	{
-		case PHYSICS_CONSTRAINT_TYPE_DISTANCE:
-		{
-			MatMN* jacobian = &in_constraint->distance.jacobian;
-
-			const Vec3 world_anchor_a = physics_body_local_to_world_space(body_a, in_constraint->anchor_a);
-			const Vec3 world_anchor_b = physics_body_local_to_world_space(body_b, in_constraint->anchor_b);
-			const Vec3 r = vec3_sub(world_anchor_b, world_anchor_a);
-			const Vec3 ra = vec3_sub(world_anchor_a, physics_body_get_center_of_mass_world(body_a));
-			const Vec3 rb = vec3_sub(world_anchor_b, physics_body_get_center_of_mass_world(body_b));
-			const Vec3 a = world_anchor_a;
-			const Vec3 b = world_anchor_b;
-
-			const Vec3 J1 = vec3_scale(vec3_sub(a,b), 2.0f);
-			jacobian->rows[0].data[0]	= J1.x;
-			jacobian->rows[0].data[1]	= J1.y;
-			jacobian->rows[0].data[2]	= J1.z;
-
-			const Vec3 J2 = vec3_cross(ra, J1);
-			jacobian->rows[0].data[3]	= J2.x;
-			jacobian->rows[0].data[4]	= J2.y;
-			jacobian->rows[0].data[5]	= J2.z;
-
-			const Vec3 J3 = vec3_scale(vec3_sub(b,a), 2.0f);
-			jacobian->rows[0].data[6]	= J3.x;
-			jacobian->rows[0].data[7]	= J3.y;
-			jacobian->rows[0].data[8]	= J3.z;
+		const PhysicsManifold* manifold = &in_physics_scene->manifolds[manifold_idx];
+		physics_scene_island_union(in_physics_scene, manifold->body_idx_a, manifold->body_idx_b);
+	}
 
-			const Vec3 J4 = vec3_cross(rb, J3);
-			jacobian->rows[0].data[9]	= J4.x;
-			jacobian->rows[0].data[10]	= J4.y;
-			jacobian->rows[0].data[11]	= J4.z;
+	for (i32 contact_idx = 0; contact_idx < in_num_contacts; ++contact_idx)
+	{
+		const PhysicsContact* contact = &in_contacts[contact_idx];
+		if (contact->sub_step)
+		{
+			physics_scene_island_union(in_physics_scene, (i32) (contact->pair_id >> 32), (i32) (contact->pair_id & 0xFFFFFFFF));
+		}
+	}
 
-			break;
-		}	
-		default:
-			break;
+	const i32 num_constraints = sb_count(in_physics_scene->constraints);
+	for (i32 constraint_idx = 0; constraint_idx < num_constraints; ++constraint_idx)
+	{
+		const PhysicsConstraint* constraint = &in_physics_scene->constraints[constraint_idx];
+		physics_scene_island_union(in_physics_scene, constraint->body_a.idx, constraint->body_b.idx);
 	}
-}
 
-void physics_constraint_solve(PhysicsScene* scene, PhysicsConstraint* in_constraint)
-{
-	PhysicsBody* body_a = in_constraint->body_a;
-	PhysicsBody* body_b = in_constraint->body_b;
+	// Number the islands with an awake body in them. Until every body has its island, a root's island_idx stands for its whole set
+	sb_clear(in_physics_scene->islands);
+	for (i32 body_idx = 0; body_idx < num_bodies; ++body_idx)
+	{
+		in_physics_scene->solver_bodies[body_idx].island_idx = -1;
+	}
 
-	switch (in_constraint->type)
+	for (i32 body_idx = 0; body_idx < num_bodies; ++body_idx)
 	{
-		case PHYSICS_CONSTRAINT_TYPE_DISTANCE:
+		if (!physics_body_is_awake(&in_physics_scene->bodies[body_idx]))
 		{
-			MatMN* jacobian = &in_constraint->distance.jacobian;
-			
-			Arena* arena = arena_create(&(ArenaDesc) {
-				.size = 4 KiB,
-				.allow_growth = true,
-			});
-
-			MatMN jacobian_transpose = matmn_transpose(arena, jacobian);
+			continue;
+		}
 
-			VecN q_dt = physics_constraint_get_velocities(arena, in_constraint);
-			MatMN inv_mass_matrix = physics_constraint_get_inverse_mass_matrix(arena, in_constraint);
+		PhysicsSolverBody* root_solver_body = &in_physics_scene->solver_bodies[union_find_find(union_find, body_idx)];
+		if (root_solver_body->island_idx < 0)
+		{
+			root_solver_body->island_idx = sb_count(in_physics_scene->islands);
+			sb_push(in_physics_scene->islands, ((PhysicsIsland) {
+				.min_sleep_time = FLT_MAX,
+			}));
+		}
+	}
 
-			MatMN j_inv_mass_matrix = matmn_mul_matmn(arena, jacobian, &inv_mass_matrix);
-			MatMN J_W_Jt = matmn_mul_matmn(arena, &j_inv_mass_matrix, &jacobian_transpose);
-			VecN j_q_dt = matmn_mul_vecn(arena, jacobian, &q_dt);
-			VecN rhs = vecn_scale(arena, &j_q_dt, -1.0f);
+	for (i32 body_idx = 0; body_idx < num_bodies; ++body_idx)
+	{
+		PhysicsBody* body = &in_physics_scene->bodies[body_idx];
+		if (body->inverse_mass <= 0.f)
+		{
+			continue;
+		}
 
-			MatN J_W_Jt_matn = matn_from_matmn(arena, &J_W_Jt);
-			VecN lambda_n = lcp_gauss_seidel(arena, &J_W_Jt_matn, &rhs);
-			VecN impulses = matmn_mul_vecn(arena, &jacobian_transpose, &lambda_n);
-			physics_constraint_apply_impulses(in_constraint, &impulses);
+		const i32 island_idx = in_physics_scene->solver_bodies[union_find_find(union_find, body_idx)].island_idx;
+		in_physics_scene->solver_bodies[body_idx].island_idx = island_idx;
+		if (island_idx >= 0 && body->is_sleeping)
+		{
+			physics_body_wake(body);
+		}
+	}
 
-			arena_destroy(arena);
+	// Count each island's constraints, then lay them out one island after another
+	PhysicsIsland* islands = in_physics_scene->islands;
+	const i32 num_islands = sb_count(islands);
+	for (i32 manifold_idx = 0; manifold_idx < sb_count(in_physics_scene->manifolds); ++manifold_idx)
+	{
+		const PhysicsManifold* manifold = &in_physics_scene->manifolds[manifold_idx];
+		const i32 island_idx = physics_scene_get_pair_island(in_physics_scene, manifold->body_idx_a, manifold->body_idx_b);
+		if (island_idx >= 0)
+		{
+			islands[island_idx].num_contact_constraints += manifold->num_points;
+		}
+	}
 
-			break;
-		}	
-		default:
-			break;
+	sb_clear(in_physics_scene->island_constraint_indices);
+	if (num_constraints > 0)
+	{
+		(void) sb_add(in_physics_scene->island_constraint_indices, num_constraints);
+	}
+	for (i32 constraint_idx = 0; constraint_idx < num_constraints; ++constraint_idx)
+	{
+		const PhysicsConstraint* constraint = &in_physics_scene->constraints[constraint_idx];
+		const i32 island_idx = physics_scene_get_pair_island(in_physics_scene, constraint->body_a.idx, constraint->body_b.idx);
+		in_physics_scene->island_constraint_indices[constraint_idx] = island_idx;
+		if (island_idx >= 0)
+		{
+			islands[island_idx].num_constraints++;
+		}
 	}
-}
 
-void physics_constraint_post_solve(PhysicsScene* scene, PhysicsConstraint* in_constraint)
-{
-	PhysicsBody* body_a = in_constraint->body_a;
-	PhysicsBody* body_b = in_constraint->body_b;
+	i32 contact_constraint_begin = 0;
+	i32 constraint_begin = 0;
+	for (i32 island_idx = 0; island_idx < num_islands; ++island_idx)
+	{
+		islands[island_idx].contact_constraint_begin = contact_constraint_begin;
+		islands[island_idx].constraint_begin = constraint_begin;
+		contact_constraint_begin += islands[island_idx].num_contact_constraints;
+		constraint_begin += islands[island_idx].num_constraints;
+	}
 
-	switch (in_constraint->type)
+	// island_constraint_indices held each constraint's island. Sort the constraint indices into island order, keeping their order within an island
+	sbuffer(i32) constraint_islands = NULL;
+	if (sb_count(in_physics_scene->island_constraint_indices) > 0)
 	{
-		case PHYSICS_CONSTRAINT_TYPE_DISTANCE:
+		sb_copy(constraint_islands, in_physics_scene->island_constraint_indices);
+	}
+	sb_clear(in_physics_scene->island_constraint_indices);
+	if (constraint_begin > 0)
+	{
+		(void) sb_add(in_physics_scene->island_constraint_indices, constraint_begin);
+	}
+	for (i32 island_idx = 0; island_idx < num_islands; ++island_idx)
+	{
+		islands[island_idx].num_constraints = 0;
+	}
+	for (i32 constraint_idx = 0; constraint_idx < num_constraints; ++constraint_idx)
+	{
+		const i32 island_idx = constraint_islands[constraint_idx];
+		if (island_idx >= 0)
 		{
-			// Nothing to do	
-			break;
-		}	
-		default:
-			break;
+			PhysicsIsland* island = &islands[island_idx];
+			in_physics_scene->island_constraint_indices[island->constraint_begin + island->num_constraints++] = constraint_idx;
+		}
 	}
+	sb_free(constraint_islands);
 }
 
-typedef struct PhysicsScene
-{
-	sbuffer(PhysicsBody*) bodies;
-	sbuffer(PhysicsConstraint) constraints;
-	Arena* arena;
-} PhysicsScene;
-
-void physics_scene_init(PhysicsScene* out_physics_scene)
+// Solves one island's contacts and constraints together with sequential impulses, warm started from last step's impulses
+void physics_scene_solve_island(PhysicsScene* in_physics_scene, const PhysicsIsland* in_island, const f32 in_delta_time)
 {
-	*out_physics_scene = (PhysicsScene) {
-		.bodies = NULL,
-		.arena = arena_create(&(ArenaDesc) {
-			.size = 64 KiB,
-			.allow_growth = true,
-		}),
-	};
-}
+	PhysicsContactConstraint* contact_constraints = &in_physics_scene->contact_constraints[in_island->contact_constraint_begin];
+	const i32 num_contact_constraints = in_island->num_contact_constraints;
+	const i32* constraint_indices = &in_physics_scene->island_constraint_indices[in_island->constraint_begin];
+	const i32 num_constraints = in_island->num_constraints;
 
-void physics_scene_destroy(PhysicsScene* in_physics_scene)
-{
-	for (i32 body_idx = 0; body_idx < sb_count(in_physics_scene->bodies); ++body_idx)
+	for (i32 contact_idx = 0; contact_idx < num_contact_constraints; ++contact_idx)
 	{
-		FCS_MEM_FREE(in_physics_scene->bodies[body_idx]);
+		physics_contact_constraint_warm_start(in_physics_scene, &contact_constraints[contact_idx]);
 	}
-	sb_free(in_physics_scene->bodies);
-	sb_free(in_physics_scene->constraints);
-	arena_destroy(in_physics_scene->arena);
-}
 
-PhysicsBody* physics_scene_add_body(PhysicsScene* in_physics_scene, const PhysicsBody* in_body)
-{
-	/*
-		Allocate our own body from passed-in data that we'll return. 
-		This is so the physics scene owns the body's allocation so we 
-		can reference them even as additional bodies are added.
-		This new body effectively takes ownership of the passed-in data
-	*/
-	PhysicsBody* new_body = FCS_MEM_ALLOC_ZEROED(sizeof(PhysicsBody));
+	for (i32 constraint_idx = 0; constraint_idx < num_constraints; ++constraint_idx)
+	{
+		PhysicsConstraint* constraint = &in_physics_scene->constraints[constraint_indices[constraint_idx]];
+		physics_constraint_pre_solve(in_physics_scene, constraint, in_delta_time);
+		physics_constraint_warm_start(in_physics_scene, constraint);
+	}
 
-	*new_body = *in_body;
-	sb_push(in_physics_scene->bodies, new_body);
+	for (i32 iteration = 0; iteration < in_physics_scene->solver_iterations; ++iteration)
+	{
+		for (i32 constraint_idx = 0; constraint_idx < num_constraints; ++constraint_idx)
+		{
+			physics_constraint_solve(in_physics_scene, &in_physics_scene->constraints[constraint_indices[constraint_idx]]);
+		}
 
-	return new_body;
-}
+		for (i32 contact_idx = 0; contact_idx < num_contact_constraints; ++contact_idx)
+		{
+			physics_contact_constraint_solve(in_physics_scene, &contact_constraints[contact_idx]);
+		}
+	}
 
-void physics_scene_add_constraint(PhysicsScene* in_physics_scene, PhysicsConstraint* in_constraint)
-{
-	sb_push(in_physics_scene->constraints, *in_constraint);
-}
+	for (i32 contact_idx = 0; contact_idx < num_contact_constraints; ++contact_idx)
+	{
+		PhysicsContactConstraint* constraint = &contact_constraints[contact_idx];
+		physics_contact_constraint_apply_restitution(in_physics_scene, constraint);
+		physics_contact_constraint_store_impulses(in_physics_scene, constraint);
+	}
 
-PhysicsConstraint physics_constraint_distance_init(PhysicsScene* scene)
-{
-	return (PhysicsConstraint) {
-		.body_a = NULL,
-		.body_b = NULL,
-		.anchor_a = vec3_zero,
-		.axis_a = vec3_zero,
-		.anchor_b = vec3_zero,
-		.axis_b = vec3_zero,
-		.type = PHYSICS_CONSTRAINT_TYPE_DISTANCE,
-		.distance = {
-			.jacobian = matmn_new(scene->arena, 1, 12),
-		},
-	};
+	for (i32 constraint_idx = 0; constraint_idx < num_constraints; ++constraint_idx)
+	{
+		physics_constraint_post_solve(in_physics_scene, &in_physics_scene->constraints[constraint_indices[constraint_idx]]);
+	}
 }
 
-typedef struct PseudoPhysicsBody
-{
-	i32 id;
-	f32 value;
-	bool is_min;
-} PseudoPhysicsBody;
-
-i32 pseudo_physics_body_compare(const void* a, const void* b)
+void physics_solver_job_run(void* in_job)
 {
-	const PseudoPhysicsBody* pseudo_body_a = (const PseudoPhysicsBody*) a;
-	const PseudoPhysicsBody* pseudo_body_b = (const PseudoPhysicsBody*) b;
-	return (pseudo_body_a->value < pseudo_body_b->value) ? -1 : 1;
+	PhysicsSolverJob* job = (PhysicsSolverJob*) in_job;
+	for (i32 island_idx = job->island_begin; island_idx < job->island_end; ++island_idx)
+	{
+		physics_scene_solve_island(job->scene, &job->scene->islands[island_idx], job->delta_time);
+	}
 }
 
-sbuffer(PseudoPhysicsBody) pseudo_physics_bodies_create_sorted(sbuffer(PhysicsBody*) in_bodies, const f32 in_delta_time)
+// Solves the manifolds and constraints of awake islands, changing only velocities. Sub-stepped contacts are resolved separately
+// Islands are split into contiguous ranges across the scene's task_system if it has one. Each island is solved the same way regardless
+void physics_scene_solve(PhysicsScene* in_physics_scene, const f32 in_delta_time)
 {
-	// Axis we project our min and max onto 
-	const Vec3 projection_axis = vec3_normalize(vec3_new(1,1,1));
+	PhysicsIsland* islands = in_physics_scene->islands;
+	const i32 num_islands = sb_count(islands);
 
-	const i32 num_bodies = sb_count(in_bodies);
-	const i32 num_pseudo_bodies = num_bodies * 2;
+	// Contact constraints for each manifold point, laid out by island in manifold order
+	i32 num_contact_constraints = 0;
+	for (i32 island_idx = 0; island_idx < num_islands; ++island_idx)
+	{
+		num_contact_constraints += islands[island_idx].num_contact_constraints;
+		islands[island_idx].num_contact_constraints = 0;
+	}
 
-	sbuffer(PseudoPhysicsBody) out_pseudo_bodies = NULL;
-	sb_reserve(out_pseudo_bodies, num_pseudo_bodies);
+	sb_clear(in_physics_scene->contact_constraints);
+	if (num_contact_constraints > 0)
+	{
+		(void) sb_add(in_physics_scene->contact_constraints, num_contact_constraints);
+	}
 
-	for (i32 body_idx = 0; body_idx < num_bodies; ++body_idx)
+	for (i32 manifold_idx = 0; manifold_idx < sb_count(in_physics_scene->manifolds); ++manifold_idx)
 	{
-		const PhysicsBody* body = in_bodies[body_idx];	
-		Bounds bounds = physics_body_get_bounds(body);
-
-		// Expand bounds by position change this timestep
-		const Vec3 scaled_velocity = vec3_scale(body->linear_velocity, in_delta_time);
-		const Vec3 expanded_min = vec3_add(bounds.min, scaled_velocity);
-		const Vec3 expanded_max = vec3_add(bounds.max, scaled_velocity);
-		bounds_expand_point(&bounds, expanded_min);
-		bounds_expand_point(&bounds, expanded_max);
-
-		// Also expand by some arbitrary extent to broader detection/rejection
-		const f32 epsilon = 0.01f;
-		bounds_expand_point(&bounds, vec3_add(bounds.min, vec3_scale(vec3_new(-1,-1,-1), epsilon)));
-		bounds_expand_point(&bounds, vec3_add(bounds.max, vec3_scale(vec3_new( 1, 1, 1), epsilon)));
-
-		// Create a min and max PseudoPhysicsBody by projecting the bounds min and max onto our 1D axis
-		PseudoPhysicsBody new_pseudo_body_min = {
-			.id = body_idx,
-			.value = vec3_dot(projection_axis, bounds.min),
-			.is_min = true,
-		};
-		sb_push(out_pseudo_bodies, new_pseudo_body_min);
+		PhysicsManifold* manifold = &in_physics_scene->manifolds[manifold_idx];
+		const i32 island_idx = physics_scene_get_pair_island(in_physics_scene, manifold->body_idx_a, manifold->body_idx_b);
+		if (island_idx < 0)
+		{
+			continue;
+		}
 
-		PseudoPhysicsBody new_pseudo_body_max = {
-			.id = body_idx,
-			.value = vec3_dot(projection_axis, bounds.max),
-			.is_min = false,
+		PhysicsBody* body_a = &in_physics_scene->bodies[manifold->body_idx_a];
+		PhysicsBody* body_b = &in_physics_scene->bodies[manifold->body_idx_b];
+		const InverseMass12 inverse_mass = {
+			.body_a = in_physics_scene->solver_bodies[manifold->body_idx_a].inverse_mass,
+			.body_b = in_physics_scene->solver_bodies[manifold->body_idx_b].inverse_mass,
 		};
-		sb_push(out_pseudo_bodies, new_pseudo_body_max);
+
+		PhysicsIsland* island = &islands[island_idx];
+		for (i32 point_idx = 0; point_idx < manifold->num_points; ++point_idx)
+		{
+			const PhysicsContact point_contact = physics_manifold_get_contact(manifold, point_idx, body_a, body_b);
+			PhysicsContactConstraint* constraint = &in_physics_scene->contact_constraints[island->contact_constraint_begin + island->num_contact_constraints++];
+			physics_contact_constraint_init(in_physics_scene, constraint, &point_contact, &inverse_mass, in_delta_time);
+			constraint->cached_impulses = &manifold->points[point_idx].impulses;
+		}
 	}
 
-	// Sort pseudo bodies by their value, which is dot(axis, bounds.min) or dot(axis, bounnds.max) for a body
-	qsort(out_pseudo_bodies, num_pseudo_bodies, sizeof(PseudoPhysicsBody), pseudo_physics_body_compare);
+	// Split islands into jobs of roughly equal constraint counts
+	const i32 num_rows = num_contact_constraints + sb_count(in_physics_scene->island_constraint_indices);
+	TaskSystem* task_system = in_physics_scene->task_system;
+	const i32 max_jobs = task_system ? MIN(task_system_num_threads(task_system) + 1, num_islands) : 1;
+	const i32 num_jobs = CLAMP(num_rows / PHYSICS_SOLVER_MIN_CONSTRAINTS_PER_JOB, 1, MAX(max_jobs, 1));
+	sb_clear(in_physics_scene->solver_jobs);
 
-	return out_pseudo_bodies;
-}
+	i32 island_idx = 0;
+	i32 rows_assigned = 0;
+	for (i32 job_idx = 0; job_idx < num_jobs; ++job_idx)
+	{
+		const i32 island_begin = island_idx;
+		const i32 rows_target = (i32) (((i64) num_rows * (job_idx + 1)) / num_jobs);
+		while (island_idx < num_islands && (rows_assigned < rows_target || job_idx == num_jobs - 1))
+		{
+			rows_assigned += islands[island_idx].num_contact_constraints + islands[island_idx].num_constraints;
+			++island_idx;
+		}
 
-typedef struct CollisionPair
-{
-	i32 idx_a;
-	i32 idx_b;
-} CollisionPair;
+		sb_push(in_physics_scene->solver_jobs, ((PhysicsSolverJob) {
+			.scene = in_physics_scene,
+			.island_begin = island_begin,
+			.island_end = island_idx,
+			.delta_time = in_delta_time,
+		}));
+	}
 
-bool collision_pair_equals(CollisionPair* in_lhs, CollisionPair* in_rhs)
-{
-	return	(		(in_lhs->idx_a == in_rhs->idx_a)
-				&&	(in_lhs->idx_b == in_rhs->idx_b))
-		||	(		(in_lhs->idx_a == in_rhs->idx_b)
-				&&	(in_lhs->idx_b == in_rhs->idx_a));
+	if (num_jobs > 1)
+	{
+		sbuffer(Task*) tasks = NULL;
+		for (i32 job_idx = 1; job_idx < num_jobs; ++job_idx)
+		{
+			sb_push(tasks, task_system_add_task(task_system, &(TaskDesc) {
+				.task_function = physics_solver_job_run,
+				.argument = &in_physics_scene->solver_jobs[job_idx],
+			}));
+		}
+		physics_solver_job_run(&in_physics_scene->solver_jobs[0]);
+		task_system_wait_tasks(task_system, tasks);
+	}
+	else
+	{
+		physics_solver_job_run(&in_physics_scene->solver_jobs[0]);
+	}
 }
 
-sbuffer(CollisionPair) physics_scene_broad_phase(PhysicsScene* in_physics_scene, f32 in_delta_time)
+// Bodies that stay slow long enough fall asleep, but only once the rest of their island is ready to, so a stack sleeps as one
+void physics_scene_update_sleep(PhysicsScene* in_physics_scene, const f32 in_delta_time)
 {
-	sbuffer(CollisionPair) out_collision_pairs = NULL;
+	const i32 num_bodies = sb_count(in_physics_scene->bodies);
+	const f32 linear_threshold_squared = PHYSICS_SLEEP_LINEAR_VELOCITY * PHYSICS_SLEEP_LINEAR_VELOCITY;
+	const f32 angular_threshold_squared = PHYSICS_SLEEP_ANGULAR_VELOCITY * PHYSICS_SLEEP_ANGULAR_VELOCITY;
 
-	// Sweep and Prune 1D
+	for (i32 body_idx = 0; body_idx < num_bodies; ++body_idx)
 	{
-		// Created sorted array of pseudo bodies. Bodies are sorted by their min and max projections onto a 1D axis
-		sbuffer(PseudoPhysicsBody) sorted_pseudo_bodies = pseudo_physics_bodies_create_sorted(in_physics_scene->bodies, in_delta_time);
-
-		const i32 num_pseudo_bodies = sb_count(sorted_pseudo_bodies);
-
-		// Build Collision Pairs from those pseudo bodies
-		for (i32 i = 0; i < num_pseudo_bodies; ++i)		
-		{	
-			PseudoPhysicsBody* pseudo_body_a = &sorted_pseudo_bodies[i];
-
-			// We only care about starting a search when we find a min point.
-			if (!pseudo_body_a->is_min) { continue; }
-
-			CollisionPair new_collision_pair = {
-				.idx_a = pseudo_body_a->id,
-			};
+		const i32 island_idx = in_physics_scene->solver_bodies[body_idx].island_idx;
+		if (island_idx < 0)
+		{
+			continue;
+		}
 
-			for (i32 j = i+1; j < num_pseudo_bodies; ++j)		
-			{
-				PseudoPhysicsBody* pseudo_body_b = &sorted_pseudo_bodies[j];
+		PhysicsBody* body = &in_physics_scene->bodies[body_idx];
+		const bool is_slow	=	vec3_length_squared(body->linear_velocity) < linear_threshold_squared
+							&&	vec3_length_squared(body->angular_velocity) < angular_threshold_squared;
+		body->sleep_time = is_slow ? body->sleep_time + in_delta_time : 0.0f;
 
-				// if we hit pseudo_body_a's own max, we stop looking
-				if(pseudo_body_b->id == pseudo_body_a->id) { break;}
+		PhysicsIsland* island = &in_physics_scene->islands[island_idx];
+		island->min_sleep_time = MIN(island->min_sleep_time, body->sleep_time);
+	}
 
-				// We only record a collision pair if we hit the MIN point of Body B	
-				if (!pseudo_body_b->is_min) { continue; }
-				
-				new_collision_pair.idx_b = pseudo_body_b->id;
-				sb_push(out_collision_pairs, new_collision_pair);
-			}
+	for (i32 body_idx = 0; body_idx < num_bodies; ++body_idx)
+	{
+		const i32 island_idx = in_physics_scene->solver_bodies[body_idx].island_idx;
+		if (island_idx < 0 || in_physics_scene->islands[island_idx].min_sleep_time < PHYSICS_TIME_TO_SLEEP)
+		{
+			continue;
 		}
 
-		// Free pseudo bodies
-		sb_free(sorted_pseudo_bodies);
+		PhysicsBody* body = &in_physics_scene->bodies[body_idx];
+		body->is_sleeping = true;
+		body->linear_velocity = vec3_zero;
+		body->angular_velocity = vec3_zero;
 	}
-
-	// return collision pairs
-	return out_collision_pairs;
 }
 
 void physics_scene_update(PhysicsScene* in_physics_scene, f32 in_delta_time)
 {
 	const i32 num_bodies = sb_count(in_physics_scene->bodies);
 
+	for (i32 body_idx = 0; body_idx < num_bodies; ++body_idx)
+	{
+		const PhysicsBody* body = &in_physics_scene->bodies[body_idx];
+		PhysicsBodyRenderData* render_data = &in_physics_scene->body_render_data[body_idx];
+		render_data->previous_position = body->position;
+		render_data->previous_orientation = body->orientation;
+	}
+
 	// Acceleration due to gravity
 	for (i32 body_idx = 0; body_idx < num_bodies; ++body_idx)
 	{
-		PhysicsBody* body = in_physics_scene->bodies[body_idx];
+		PhysicsBody* body = &in_physics_scene->bodies[body_idx];
 
-		if (body->inverse_mass > 0.f)
+		if (physics_body_is_awake(body))
 		{
 			f32 mass = 1.0f / body->inverse_mass;
 			Vec3 impulse_gravity = vec3_scale(vec3_new(0.f, -10.f, 0.f), mass * in_delta_time);
@@ -1664,105 +3624,97 @@ void physics_scene_update(PhysicsScene* in_physics_scene, f32 in_delta_time)
 	//printf("-------------------------------------------\n");
 
 	// Narrowphase
-	const i32 max_contacts = num_bodies * num_bodies;
-	sbuffer(PhysicsContact) contacts = NULL;
-	sb_reserve(contacts, max_contacts);
-
-	for (i32 pair_idx = 0; pair_idx < sb_count(collision_pairs); ++pair_idx)
-	{
-		CollisionPair* collision_pair = &collision_pairs[pair_idx];
-		PhysicsBody* body_a = in_physics_scene->bodies[collision_pair->idx_a];
-		PhysicsBody* body_b = in_physics_scene->bodies[collision_pair->idx_b];
-
-		// Skip if both bodies have zero mass
-		if (body_a->inverse_mass <= 0.f && body_b->inverse_mass <= 0.f)
-		{
-			continue;
-		}
-
-		PhysicsContact contact = {};
-		if (physics_bodies_intersect_dt(body_a, body_b, in_delta_time, &contact))
-		{
-			sb_push(contacts, contact);
-		}
-	}
+	sbuffer(PhysicsContact) contacts = physics_scene_narrow_phase(in_physics_scene, collision_pairs, sb_count(collision_pairs), in_delta_time);
 
-	// Done with collision pairs. Free them 
-	sb_free(collision_pairs);
-
-	// Sort contacts by time of impact
-	const i32 num_contacts = sb_count(contacts);
-	if (num_contacts > 1)
+	// Solver bodies
+	sb_clear(in_physics_scene->solver_bodies);
+	for (i32 body_idx = 0; body_idx < num_bodies; ++body_idx)
 	{
-		qsort(contacts, num_contacts, sizeof(PhysicsContact), physics_contact_compare);
+		PhysicsBody* body = &in_physics_scene->bodies[body_idx];
+		const bool is_static = body->inverse_mass <= 0.f;
+		sb_push(in_physics_scene->solver_bodies, ((PhysicsSolverBody) {
+			.inverse_mass = {
+				.inverse_mass = body->inverse_mass,
+				.inverse_inertia = is_static ? (Mat3) {} : physics_body_get_inverse_inertia_tensor_world(body),
+			},
+			.time = 0.0f,
+			.is_fast = physics_body_is_fast(body, in_delta_time),
+		}));
 	}
 
-	// Solve Constraints
+	// Solve contacts and constraints, one island at a time
+	physics_scene_update_manifolds(in_physics_scene, contacts, sb_count(contacts));
+	physics_scene_build_islands(in_physics_scene, contacts, sb_count(contacts));
+	physics_scene_solve(in_physics_scene, in_delta_time);
+	for (i32 body_idx = 0; body_idx < num_bodies; ++body_idx)
 	{
-		const i32 num_constraints = sb_count(in_physics_scene->constraints);
-		for (i32 constraint_idx = 0; constraint_idx < num_constraints; ++constraint_idx)
-		{
-			PhysicsConstraint* constraint = &in_physics_scene->constraints[constraint_idx];
-			physics_constraint_pre_solve(in_physics_scene, constraint, in_delta_time);					
-		}
-
-        const i32 max_iterations = 10;
-        for (i32 iteration = 0; iteration < max_iterations; ++iteration)
-        {
-            for (i32 constraint_idx = 0; constraint_idx < num_constraints; ++constraint_idx)
-            {		
-                PhysicsConstraint* constraint = &in_physics_scene->constraints[constraint_idx];
-                physics_constraint_solve(in_physics_scene, constraint);					
-            }
-        }
-
-		for (i32 constraint_idx = 0; constraint_idx < num_constraints; ++constraint_idx)
-		{		
-			PhysicsConstraint* constraint = &in_physics_scene->constraints[constraint_idx];
-			physics_constraint_post_solve(in_physics_scene, constraint);					
-		}
+		physics_body_clamp_angular_velocity(&in_physics_scene->bodies[body_idx]);
 	}
 
-	// peform physics body updates and contact resolution at each contact time of impact
-	f32 accumulated_delta_time = 0.f;
+	// Sub-step fast bodies through their contacts in time of impact order
+	// Only the fast bodies are advanced to each time of impact. A slow partner stays put, as it moves too little this step for that to matter
 	for (i32 contact_idx = 0; contact_idx < sb_count(contacts); ++contact_idx)
 	{
 		PhysicsContact* contact = &contacts[contact_idx];
-
-		const f32 contact_delta_time = contact->time_of_impact - accumulated_delta_time;
-
-		PhysicsBody* body_a = contact->body_a;
-		PhysicsBody* body_b = contact->body_b;
-
-		// Skip if both bodies have zero mass
-		if (body_a->inverse_mass <= 0.f && body_b->inverse_mass <= 0.f)
+		if (!contact->sub_step)
 		{
 			continue;
 		}
 
-		// Position Update up to time of impact
-		for (i32 body_idx = 0; body_idx < sb_count(in_physics_scene->bodies); ++body_idx)
+		const i32 contact_body_indices[2] = { (i32) (contact->pair_id >> 32), (i32) (contact->pair_id & 0xFFFFFFFF) };
+		for (i32 i = 0; i < 2; ++i)
 		{
-			PhysicsBody* body = in_physics_scene->bodies[body_idx];
-			physics_body_update(body, contact_delta_time);
+			PhysicsSolverBody* solver_body = &in_physics_scene->solver_bodies[contact_body_indices[i]];
+			if (solver_body->is_fast)
+			{
+				physics_body_update(&in_physics_scene->bodies[contact_body_indices[i]], contact->time_of_impact - solver_body->time);
+				solver_body->time = contact->time_of_impact;
+			}
 		}
 
-		physics_contact_resolve(contact);
-		accumulated_delta_time += contact_delta_time;
+		physics_contact_resolve(in_physics_scene, contact);
 	}
 
 	// Free contacts
 	sb_free(contacts);
 
-	// Update physics bodies for any remaining delta time
-	const f32 remaining_delta_time = in_delta_time - accumulated_delta_time;
-	if (remaining_delta_time > 0.0f)
+	// Integrate positions once, over whatever each body has left of the timestep
+	for (i32 body_idx = 0; body_idx < num_bodies; ++body_idx)
 	{
-		for (i32 body_idx = 0; body_idx < num_bodies; ++body_idx)
+		PhysicsBody* body = &in_physics_scene->bodies[body_idx];
+		const f32 remaining_delta_time = in_delta_time - in_physics_scene->solver_bodies[body_idx].time;
+		if (remaining_delta_time > 0.0f && !body->is_sleeping)
 		{
-			PhysicsBody* body = in_physics_scene->bodies[body_idx];
 			physics_body_update(body, remaining_delta_time);
 		}
 	}
+
+	physics_scene_update_sleep(in_physics_scene, in_delta_time);
 }
 
+// Simulates in_frame_delta_time in steps of fixed_delta_time, carrying the remainder over to the next frame
+// Fixed steps keep the simulation stable and its cost predictable regardless of frame rate. Returns the number of steps taken
+i32 physics_scene_advance(PhysicsScene* in_physics_scene, const f32 in_frame_delta_time)
+{
+	const f32 fixed_delta_time = in_physics_scene->fixed_delta_time;
+	assert(fixed_delta_time > 0.0f);
+
+	in_physics_scene->accumulated_time += in_frame_delta_time;
+
+	i32 num_steps = 0;
+	while (in_physics_scene->accumulated_time >= fixed_delta_time && num_steps < in_physics_scene->max_steps_per_advance)
+	{
+		physics_scene_update(in_physics_scene, fixed_delta_time);
+		in_physics_scene->accumulated_time -= fixed_delta_time;
+		++num_steps;
+	}
+
+	// Out of steps: let the simulation fall behind real time rather than spend ever longer catching up
+	if (in_physics_scene->accumulated_time >= fixed_delta_time)
+	{
+		in_physics_scene->accumulated_time = fmodf(in_physics_scene->accumulated_time, fixed_delta_time);
+	}
+
+	in_physics_scene->interpolation_alpha = in_physics_scene->accumulated_time / fixed_delta_time;
+	return num_steps;
+}
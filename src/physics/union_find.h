@@ -0,0 +1,85 @@
+#pragma once
+
+#include "basic_types.h"
+#include "stretchy_buffer.h"
+
+// Disjoint sets over the indices [0, count), used to group bodies into simulation islands
+// Union by size and path halving keep finds close to constant time
+
+typedef struct UnionFind
+{
+	sbuffer(i32) parents;	// Roots are their own parent
+	sbuffer(i32) sizes;		// Number of indices in the set. Only meaningful for roots
+} UnionFind;
+
+void union_find_init(UnionFind* out_union_find)
+{
+	*out_union_find = (UnionFind) {};
+}
+
+void union_find_free(UnionFind* in_union_find)
+{
+	sb_free(in_union_find->parents);
+	sb_free(in_union_find->sizes);
+	*in_union_find = (UnionFind) {};
+}
+
+// Puts each of in_count indices in a set of its own, reusing the existing storage
+void union_find_reset(UnionFind* in_union_find, const i32 in_count)
+{
+	sb_clear(in_union_find->parents);
+	sb_clear(in_union_find->sizes);
+	if (in_count <= 0)
+	{
+		return;
+	}
+
+	i32* parents = sb_add(in_union_find->parents, in_count);
+	i32* sizes = sb_add(in_union_find->sizes, in_count);
+	for (i32 idx = 0; idx < in_count; ++idx)
+	{
+		parents[idx] = idx;
+		sizes[idx] = 1;
+	}
+}
+
+i32 union_find_count(const UnionFind* in_union_find)
+{
+	return sb_count(in_union_find->parents);
+}
+
+// Returns the root of the set containing in_idx
+i32 union_find_find(UnionFind* in_union_find, i32 in_idx)
+{
+	i32* parents = in_union_find->parents;
+	while (parents[in_idx] != in_idx)
+	{
+		// Path halving: point every other index on the way up at its grandparent
+		parents[in_idx] = parents[parents[in_idx]];
+		in_idx = parents[in_idx];
+	}
+	return in_idx;
+}
+
+// Merges the sets containing in_idx_a and in_idx_b, returning the root of the merged set
+i32 union_find_union(UnionFind* in_union_find, const i32 in_idx_a, const i32 in_idx_b)
+{
+	i32 root_a = union_find_find(in_union_find, in_idx_a);
+	i32 root_b = union_find_find(in_union_find, in_idx_b);
+	if (root_a == root_b)
+	{
+		return root_a;
+	}
+
+	// The smaller set goes under the larger one, so trees stay shallow
+	if (in_union_find->sizes[root_a] < in_union_find->sizes[root_b])
+	{
+		const i32 temp = root_a;
+		root_a = root_b;
+		root_b = temp;
+	}
+
+	in_union_find->parents[root_b] = root_a;
+	in_union_find->sizes[root_a] += in_union_find->sizes[root_b];
+	return root_a;
+}
@@ -16,6 +16,7 @@
 #define sb_reserve stb_sb_reserve
 #define sb_copy stb_sb_copy
 #define sb_append_array stb_sb_append_array
+#define sb_clear stb_sb_clear
 
 #define sb_del  stb_sb_del
 #define sb_deln stb_sb_deln
@@ -53,6 +54,10 @@
      stb__sbn(a) += (count))
 // END FCS: append array operation
 
+// BEGIN FCS: clear operation. Keeps the allocation so the buffer can be refilled without growing
+#define stb_sb_clear(a) do { if (a) stb__sbn(a) = 0; } while (0)
+// END FCS: clear operation
+
 #define stb__sbraw(a) ((int*) (void*) (a) -2) // actual start of mem_alloc'd data (the two integers described below)
 #define stb__sbm(a)   stb__sbraw(a)[0] // array capacity
 #define stb__sbn(a)   stb__sbraw(a)[1] // array count
@@ -1,4 +1,6 @@
-#include "app/app.h"
+#pragma once
+
+#include "threading/threading.h"
 #include "stretchy_buffer.h"
 #include "memory/allocator.h"
 
@@ -100,6 +102,12 @@ void task_system_shutdown(TaskSystem* in_task_system)
 	{
 		app_thread_kill(&in_task_system->threads[thread_idx]);
 	}
+
+	// Wait for cancelled threads to finish unwinding before destroying the semaphore they may be blocked on
+	for (i32 thread_idx = 0; thread_idx < sb_count(in_task_system->threads); ++thread_idx)
+	{
+		app_thread_join(&in_task_system->threads[thread_idx]);
+	}
 	sb_free(in_task_system->threads);
 
 	app_semaphore_destroy(&in_task_system->pending_tasks_semaphore);
@@ -4,21 +4,51 @@
 #include "math/quat.h"
 #include "math/conversions.h"
 #include "math/trs.h"
+#include "math/affine.h"
+#include "math/vec_wide.h"
 #include "basic_types.h"
 #include "stdio.h"
 #include "stretchy_buffer.h"
+#include "physics/convex_helpers.h"
+#include "physics/broad_phase.h"
+#include "physics/physics.h"
 #include "math/lcp.h"
+#include "math/jacobian.h"
 #include "memory/arena.h"
 
 bool test_mat3_inverse();
 bool test_mat4_inverse();
 bool test_mat4_decompose();
 bool test_quat_mat_conversions();
+bool test_affine3();
+bool test_approx_math();
+bool test_simd_matches_scalar();
+bool test_math_array_kernels();
+bool test_vec_wide();
 bool test_stretchy_buffer();
 bool test_matn_mul_matn();
 bool test_matmn_mul_matmn();
+bool test_matmn_blocked_and_strided();
 bool test_matn_from_matmn();
 bool test_lcp_op_begin_end();
+bool test_lcp_projected_gauss_seidel();
+bool test_jacobian_fixed_size();
+bool test_pair_map();
+bool test_union_find();
+bool test_sweep_and_prune();
+bool test_aabb_tree();
+bool test_spatial_hash_grid();
+bool test_convex_hull();
+bool test_convex_shape();
+bool test_physics_support();
+bool test_physics_epa();
+bool test_physics_gjk_cache();
+bool test_physics_contact_functions();
+bool test_physics_narrow_phase_parallel();
+bool test_physics_solver();
+bool test_physics_manifolds();
+bool test_physics_sleeping();
+bool test_physics_fixed_step();
 bool test_arena_create_destroy();
 bool test_arena_alloc();
 bool test_arena_multiple_allocs();
@@ -34,11 +64,35 @@ int main()
 	success &= test_mat4_inverse();
 	success &= test_mat4_decompose();
 	success &= test_quat_mat_conversions();
+	success &= test_affine3();
+	success &= test_approx_math();
+	success &= test_simd_matches_scalar();
+	success &= test_math_array_kernels();
+	success &= test_vec_wide();
 	success &= test_stretchy_buffer();
 	success &= test_matn_mul_matn();
 	success &= test_matmn_mul_matmn();
+	success &= test_matmn_blocked_and_strided();
 	success &= test_matn_from_matmn();
 	success &= test_lcp_op_begin_end();
+	success &= test_lcp_projected_gauss_seidel();
+	success &= test_jacobian_fixed_size();
+	success &= test_pair_map();
+	success &= test_union_find();
+	success &= test_sweep_and_prune();
+	success &= test_aabb_tree();
+	success &= test_spatial_hash_grid();
+	success &= test_convex_hull();
+	success &= test_convex_shape();
+	success &= test_physics_support();
+	success &= test_physics_epa();
+	success &= test_physics_gjk_cache();
+	success &= test_physics_contact_functions();
+	success &= test_physics_narrow_phase_parallel();
+	success &= test_physics_solver();
+	success &= test_physics_manifolds();
+	success &= test_physics_sleeping();
+	success &= test_physics_fixed_step();
 	success &= test_arena_create_destroy();
 	success &= test_arena_alloc();
 	success &= test_arena_multiple_allocs();
@@ -156,6 +210,283 @@ bool test_quat_mat_conversions()
 	return result;
 }
 
+bool test_affine3()
+{
+	printf("  test_affine3... ");
+
+	const TRS trs_a = {
+		.scale = vec3_new(2.0f, 0.5f, 3.0f),
+		.rotation = quat_new(vec3_normalize(vec3_new(1.0f, 2.0f, -1.0f)), 0.7f),
+		.translation = vec3_new(4.0f, -1.0f, 2.5f),
+	};
+	const TRS trs_b = {
+		.scale = vec3_new(1.0f, 1.0f, 1.0f),
+		.rotation = quat_new(vec3_new(0.0f, 1.0f, 0.0f), -1.3f),
+		.translation = vec3_new(-3.0f, 0.0f, 7.0f),
+	};
+
+	// Conversions and composition match the equivalent Mat4 math
+	const Affine3 a = affine3_from_trs(trs_a);
+	const Affine3 b = affine3_from_trs(trs_b);
+	assert(mat4_nearly_equal(affine3_to_mat4(a), trs_to_mat4(trs_a)));
+	assert(affine3_nearly_equal(affine3_from_mat4(trs_to_mat4(trs_a)), a));
+	assert(mat4_nearly_equal(affine3_to_mat4(affine3_mul(a, b)), mat4_mul_mat4(trs_to_mat4(trs_a), trs_to_mat4(trs_b))));
+
+	const Vec3 point = vec3_new(0.3f, -2.0f, 1.5f);
+	const Vec4 expected_point = mat4_mul_vec4(trs_to_mat4(trs_a), vec4_new(point.x, point.y, point.z, 1.0f));
+	const Vec4 expected_vector = mat4_mul_vec4(trs_to_mat4(trs_a), vec4_new(point.x, point.y, point.z, 0.0f));
+	assert(vec3_nearly_equal(affine3_transform_point(a, point), vec4_xyz(expected_point)));
+	assert(vec3_nearly_equal(affine3_transform_vector(a, point), vec4_xyz(expected_vector)));
+
+	// General and rigid inverses
+	optional(Affine3) inverse_a = affine3_inverse(a);
+	assert(optional_is_set(inverse_a));
+	assert(affine3_nearly_equal(affine3_mul(a, optional_get(inverse_a)), affine3_identity));
+
+	const Affine3 rigid = affine3_from_quat_translation(trs_a.rotation, trs_a.translation);
+	assert(affine3_nearly_equal(affine3_mul(rigid, affine3_inverse_rigid(rigid)), affine3_identity));
+	assert(affine3_nearly_equal(affine3_inverse_rigid(rigid), optional_get(affine3_inverse(rigid))));
+
+	// mat4_inverse takes the affine fast path for TRS matrices, and agrees with the full adjoint inverse
+	const Mat4 trs_matrix = trs_to_mat4(trs_a);
+	assert(mat4_is_affine(trs_matrix));
+	optional(Mat4) inverse_matrix = mat4_inverse(trs_matrix);
+	assert(optional_is_set(inverse_matrix));
+	const Mat4 adjoint_inverse = mat4_mul_f32(mat4_adjoint(trs_matrix), 1.0f / mat4_determinant(trs_matrix));
+	assert(mat4_nearly_equal(optional_get(inverse_matrix), adjoint_inverse));
+	assert(mat4_nearly_equal(mat4_mul_mat4(trs_matrix, optional_get(inverse_matrix)), mat4_identity));
+
+	printf("PASSED\n");
+	return true;
+}
+
+bool test_approx_math()
+{
+	printf("  test_approx_math... ");
+
+	// Error bounds documented in basic_math.h
+	for (f64 x = 1e-6; x < 1e6; x *= 1.01)
+	{
+		const f32 value = (f32) x;
+		const f64 relative_error = fabs(f32_rsqrt_approx(value) * sqrt((f64) value) - 1.0);
+		assert(relative_error <= 3e-5);
+	}
+
+	for (f64 x = -1000.0; x <= 1000.0; x += 0.0137)
+	{
+		const f32 value = (f32) x;
+		f32 s, c;
+		f32_sincos_approx(value, &s, &c);
+		assert(fabs(s - sin((f64) value)) <= 2e-7);
+		assert(fabs(c - cos((f64) value)) <= 2e-7);
+		assert(f32_sin_approx(value) == s && f32_cos_approx(value) == c);
+	}
+
+	for (f64 angle = -PI; angle <= PI; angle += 0.0011)
+	{
+		for (f64 radius = 0.01; radius < 1000.0; radius *= 10.0)
+		{
+			const f32 y = (f32)(radius * sin(angle));
+			const f32 x = (f32)(radius * cos(angle));
+			assert(fabs(f32_atan2_approx(y, x) - atan2((f64) y, (f64) x)) <= 3e-6);
+		}
+	}
+	assert(f32_atan2_approx(0.0f, 0.0f) == 0.0f);
+
+	printf("PASSED\n");
+	return true;
+}
+
+bool test_simd_matches_scalar()
+{
+	printf("  test_simd_matches_scalar (%s)... ", math_simd_backend_name());
+
+	srand(1234);
+	for (i32 iteration = 0; iteration < 1000; ++iteration)
+	{
+		Mat4 a, b;
+		for (i32 col = 0; col < 4; ++col)
+		{
+			for (i32 row = 0; row < 4; ++row)
+			{
+				a.d[col][row] = rand_f32(-2.0f, 2.0f);
+				b.d[col][row] = rand_f32(-2.0f, 2.0f);
+			}
+		}
+		const Vec4 v = vec4_new(rand_f32(-2.0f, 2.0f), rand_f32(-2.0f, 2.0f), rand_f32(-2.0f, 2.0f), rand_f32(-2.0f, 2.0f));
+		const f32 t = rand_f32(0.0f, 1.0f);
+
+		assert(mat4_nearly_equal(mat4_mul_mat4(a, b), mat4_mul_mat4_scalar(a, b)));
+		assert(vec4_nearly_equal(mat4_mul_vec4(a, v), mat4_mul_vec4_scalar(a, v)));
+		assert(mat4_nearly_equal(mat4_lerp(t, a, b), mat4_lerp_scalar(t, a, b)));
+
+		const Vec4 w = vec4_new(rand_f32(-2.0f, 2.0f), rand_f32(-2.0f, 2.0f), rand_f32(-2.0f, 2.0f), rand_f32(-2.0f, 2.0f));
+		assert(vec4_equals(vec4_add(v, w), vec4_new(v.x + w.x, v.y + w.y, v.z + w.z, v.w + w.w)));
+		assert(vec4_equals(vec4_sub(v, w), vec4_new(v.x - w.x, v.y - w.y, v.z - w.z, v.w - w.w)));
+		assert(vec4_equals(vec4_scale(v, t), vec4_new(v.x * t, v.y * t, v.z * t, v.w * t)));
+		assert(vec4_equals(vec4_negate(v), vec4_new(-v.x, -v.y, -v.z, -v.w)));
+		assert(vec4_equals(vec4_componentwise_min(v, w), vec4_new(MIN(v.x, w.x), MIN(v.y, w.y), MIN(v.z, w.z), MIN(v.w, w.w))));
+		assert(vec4_equals(vec4_componentwise_max(v, w), vec4_new(MAX(v.x, w.x), MAX(v.y, w.y), MAX(v.z, w.z), MAX(v.w, w.w))));
+		assert(f32_nearly_equal(vec4_dot(v, w), v.x * w.x + v.y * w.y + v.z * w.z + v.w * w.w));
+		assert(vec4_nearly_equal(vec4_lerp(t, v, w), vec4_add(vec4_scale(v, 1.0f - t), vec4_scale(w, t))));
+
+		const Vec3 axis = vec3_new(rand_f32(-1.0f, 1.0f), rand_f32(-1.0f, 1.0f), rand_f32(-1.0f, 1.0f) + 2.0f);
+		const Quat q = quat_normalize(quat_new(vec3_normalize(axis), rand_f32(-M_PI, M_PI)));
+		const Vec3 p = vec4_xyz(v);
+		assert(vec3_nearly_equal(quat_rotate_vec3(q, p), quat_rotate_vec3_scalar(q, p)));
+
+		const TRS trs = {
+			.scale = vec3_new(rand_f32(0.1f, 2.0f), rand_f32(0.1f, 2.0f), rand_f32(0.1f, 2.0f)),
+			.rotation = q,
+			.translation = p,
+		};
+		const Mat4 composed = mat4_mul_mat4_scalar(mat4_mul_mat4_scalar(mat4_scale(trs.scale), quat_to_mat4(trs.rotation)), mat4_translation(trs.translation));
+		assert(mat4_nearly_equal(trs_to_mat4(trs), composed));
+	}
+
+	printf("PASSED\n");
+	return true;
+}
+
+bool test_math_array_kernels()
+{
+	printf("  test_math_array_kernels... ");
+
+	// Odd, and above MAT4_ARRAY_STREAMING_MIN_COUNT, so the streaming store path and the scalar tails of the 4-wide loops run too
+	enum { NUM_ELEMENTS = 67 };
+	Mat4 a[NUM_ELEMENTS], b[NUM_ELEMENTS], results[NUM_ELEMENTS];
+	TRS transforms[NUM_ELEMENTS];
+	Vec3 points[NUM_ELEMENTS];
+
+	srand(4321);
+	for (i32 idx = 0; idx < NUM_ELEMENTS; ++idx)
+	{
+		for (i32 col = 0; col < 4; ++col)
+		{
+			for (i32 row = 0; row < 4; ++row)
+			{
+				a[idx].d[col][row] = rand_f32(-2.0f, 2.0f);
+				b[idx].d[col][row] = rand_f32(-2.0f, 2.0f);
+			}
+		}
+		points[idx] = vec3_new(rand_f32(-5.0f, 5.0f), rand_f32(-5.0f, 5.0f), rand_f32(-5.0f, 5.0f));
+		transforms[idx] = (TRS) {
+			.scale = vec3_new(rand_f32(0.1f, 2.0f), rand_f32(0.1f, 2.0f), rand_f32(0.1f, 2.0f)),
+			.rotation = quat_new(vec3_normalize(vec3_new(1.0f, rand_f32(-1.0f, 1.0f), rand_f32(-1.0f, 1.0f))), rand_f32(-M_PI, M_PI)),
+			.translation = points[idx],
+		};
+	}
+
+	const i32 lerp_counts[] = { 5, NUM_ELEMENTS };
+	for (i32 count_idx = 0; count_idx < (i32) ARRAY_COUNT(lerp_counts); ++count_idx)
+	{
+		mat4_lerp_array(0.3f, a, b, results, lerp_counts[count_idx]);
+		for (i32 idx = 0; idx < lerp_counts[count_idx]; ++idx)
+		{
+			assert(mat4_nearly_equal(results[idx], mat4_lerp(0.3f, a[idx], b[idx])));
+		}
+	}
+
+	trs_to_mat4_array(transforms, results, NUM_ELEMENTS);
+	for (i32 idx = 0; idx < NUM_ELEMENTS; ++idx)
+	{
+		assert(mat4_nearly_equal(results[idx], trs_to_mat4(transforms[idx])));
+	}
+
+	printf("PASSED\n");
+	return true;
+}
+
+bool test_vec_wide()
+{
+	printf("  test_vec_wide... ");
+
+	enum { NUM_POINTS = 29 };
+	Vec3 points[NUM_POINTS];
+	srand(99);
+	for (i32 idx = 0; idx < NUM_POINTS; ++idx)
+	{
+		points[idx] = vec3_new(rand_f32(-5.0f, 5.0f), rand_f32(-5.0f, 5.0f), rand_f32(-5.0f, 5.0f));
+	}
+
+	Vec3x8 wide_points[4];
+	assert(vec3x8_count_for(NUM_POINTS) == 4);
+	vec3x8_from_aos(points, NUM_POINTS, wide_points);
+
+	// Lane-wise ops match their Vec3 equivalents
+	const Vec3x8 a = wide_points[0];
+	const Vec3x8 b = wide_points[1];
+	const Vec3x8 cross = vec3x8_cross(a, b);
+	const Vec3x8 min = vec3x8_min(a, b);
+	const Vec3x8 max = vec3x8_max(a, b);
+	const Vec1x8 dot = vec3x8_dot(a, b);
+	const i32 mask = vec1x8_greater(vec3x8_dot_vec3(&a, vec3_new(1, 0, 0)), vec3x8_dot_vec3(&b, vec3_new(1, 0, 0)));
+	const Vec3x8 selected = vec3x8_select(mask, a, b);
+	for (i32 lane = 0; lane < 8; ++lane)
+	{
+		const Vec3 pa = points[lane];
+		const Vec3 pb = points[8 + lane];
+		assert(vec3_nearly_equal(vec3x8_get(&cross, lane), vec3_cross(pa, pb)));
+		assert(vec3_nearly_equal(vec3x8_get(&min, lane), vec3_componentwise_min(pa, pb)));
+		assert(vec3_nearly_equal(vec3x8_get(&max, lane), vec3_componentwise_max(pa, pb)));
+		assert(f32_nearly_equal(dot.v[lane], vec3_dot(pa, pb)));
+		assert(((mask >> lane) & 1) == (pa.x > pb.x));
+		assert(vec3_nearly_equal(vec3x8_get(&selected, lane), pa.x > pb.x ? pa : pb));
+	}
+
+	Vec3x4 a4, b4;
+	vec3x4_from_aos(points, 4, &a4);
+	vec3x4_from_aos(points + 4, 4, &b4);
+	const Vec3x4 cross4 = vec3x4_cross(a4, b4);
+	const Vec1x4 dot4 = vec3x4_dot(a4, b4);
+	for (i32 lane = 0; lane < 4; ++lane)
+	{
+		assert(vec3_nearly_equal(vec3x4_get(&cross4, lane), vec3_cross(points[lane], points[4 + lane])));
+		assert(f32_nearly_equal(dot4.v[lane], vec3_dot(points[lane], points[4 + lane])));
+	}
+
+	// Support search matches a brute force search over the AoS points
+	for (i32 dir_idx = 0; dir_idx < 100; ++dir_idx)
+	{
+		const Vec3 dir = vec3_new(rand_f32(-1.0f, 1.0f), rand_f32(-1.0f, 1.0f), rand_f32(-1.0f, 1.0f));
+		i32 expected_idx = 0;
+		for (i32 idx = 1; idx < NUM_POINTS; ++idx)
+		{
+			if (vec3_dot(points[idx], dir) > vec3_dot(points[expected_idx], dir))
+			{
+				expected_idx = idx;
+			}
+		}
+		assert(vec3x8_array_support_index(wide_points, NUM_POINTS, dir) == expected_idx);
+	}
+
+	// Wide bounds test matches bounds_intersect
+	Bounds bounds[7];
+	for (i32 idx = 0; idx < 7; ++idx)
+	{
+		bounds[idx] = bounds_init();
+		bounds_expand_point(&bounds[idx], points[idx]);
+		bounds_expand_point(&bounds[idx], points[idx + 7]);
+	}
+	const Boundsx8 wide_bounds = bounds_x8_from_aos(bounds, 7);
+	for (i32 idx = 0; idx < NUM_POINTS - 1; ++idx)
+	{
+		Bounds query = bounds_init();
+		bounds_expand_point(&query, points[idx]);
+		bounds_expand_point(&query, points[idx + 1]);
+
+		const i32 intersect_mask = bounds_x8_intersect(&wide_bounds, query);
+		for (i32 lane = 0; lane < 7; ++lane)
+		{
+			assert(((intersect_mask >> lane) & 1) == bounds_intersect(bounds[lane], query));
+		}
+		assert((intersect_mask & 0x80) == 0);
+	}
+
+	printf("PASSED\n");
+	return true;
+}
+
 bool test_stretchy_buffer()
 {
 	printf("  test_stretchy_buffer... ");
@@ -226,18 +557,18 @@ bool test_matn_mul_matn()
     // A*B = [[1*5+2*7, 1*6+2*8],[3*5+4*7, 3*6+4*8]]
     //      = [[19,22],[43,50]]
     MatN A = matn_new(arena, 2);
-    A.rows[0].data[0] = 1.0f; A.rows[0].data[1] = 2.0f;
-    A.rows[1].data[0] = 3.0f; A.rows[1].data[1] = 4.0f;
+    MATN_AT(&A, 0, 0) = 1.0f; MATN_AT(&A, 0, 1) = 2.0f;
+    MATN_AT(&A, 1, 0) = 3.0f; MATN_AT(&A, 1, 1) = 4.0f;
 
     MatN B = matn_new(arena, 2);
-    B.rows[0].data[0] = 5.0f; B.rows[0].data[1] = 6.0f;
-    B.rows[1].data[0] = 7.0f; B.rows[1].data[1] = 8.0f;
+    MATN_AT(&B, 0, 0) = 5.0f; MATN_AT(&B, 0, 1) = 6.0f;
+    MATN_AT(&B, 1, 0) = 7.0f; MATN_AT(&B, 1, 1) = 8.0f;
 
     MatN C = matn_mul_matn(arena, &A, &B);
-    assert(f32_nearly_equal(C.rows[0].data[0], 19.0f));
-    assert(f32_nearly_equal(C.rows[0].data[1], 22.0f));
-    assert(f32_nearly_equal(C.rows[1].data[0], 43.0f));
-    assert(f32_nearly_equal(C.rows[1].data[1], 50.0f));
+    assert(f32_nearly_equal(MATN_AT(&C, 0, 0), 19.0f));
+    assert(f32_nearly_equal(MATN_AT(&C, 0, 1), 22.0f));
+    assert(f32_nearly_equal(MATN_AT(&C, 1, 0), 43.0f));
+    assert(f32_nearly_equal(MATN_AT(&C, 1, 1), 50.0f));
 
 	arena_destroy(arena);
 
@@ -439,20 +770,83 @@ bool test_matmn_mul_matmn()
 	// A*B = [[1*7+2*9+3*11, 1*8+2*10+3*12],[4*7+5*9+6*11, 4*8+5*10+6*12]]
 	//      = [[58,64],[139,154]]
 	MatMN A = matmn_new(arena, 2, 3);
-	A.rows[0].data[0] = 1.0f; A.rows[0].data[1] = 2.0f; A.rows[0].data[2] = 3.0f;
-	A.rows[1].data[0] = 4.0f; A.rows[1].data[1] = 5.0f; A.rows[1].data[2] = 6.0f;
+	MATMN_AT(&A, 0, 0) = 1.0f; MATMN_AT(&A, 0, 1) = 2.0f; MATMN_AT(&A, 0, 2) = 3.0f;
+	MATMN_AT(&A, 1, 0) = 4.0f; MATMN_AT(&A, 1, 1) = 5.0f; MATMN_AT(&A, 1, 2) = 6.0f;
 
 	MatMN B = matmn_new(arena, 3, 2);
-	B.rows[0].data[0] = 7.0f;  B.rows[0].data[1] = 8.0f;
-	B.rows[1].data[0] = 9.0f;  B.rows[1].data[1] = 10.0f;
-	B.rows[2].data[0] = 11.0f; B.rows[2].data[1] = 12.0f;
+	MATMN_AT(&B, 0, 0) = 7.0f;  MATMN_AT(&B, 0, 1) = 8.0f;
+	MATMN_AT(&B, 1, 0) = 9.0f;  MATMN_AT(&B, 1, 1) = 10.0f;
+	MATMN_AT(&B, 2, 0) = 11.0f; MATMN_AT(&B, 2, 1) = 12.0f;
 
 	MatMN C = matmn_mul_matmn(arena, &A, &B);
 	assert(C.m == 2 && C.n == 2);
-	assert(f32_nearly_equal(C.rows[0].data[0], 58.0f));
-	assert(f32_nearly_equal(C.rows[0].data[1], 64.0f));
-	assert(f32_nearly_equal(C.rows[1].data[0], 139.0f));
-	assert(f32_nearly_equal(C.rows[1].data[1], 154.0f));
+	assert(f32_nearly_equal(MATMN_AT(&C, 0, 0), 58.0f));
+	assert(f32_nearly_equal(MATMN_AT(&C, 0, 1), 64.0f));
+	assert(f32_nearly_equal(MATMN_AT(&C, 1, 0), 139.0f));
+	assert(f32_nearly_equal(MATMN_AT(&C, 1, 1), 154.0f));
+
+	arena_destroy(arena);
+
+	printf("PASSED\n");
+	return true;
+}
+
+bool test_matmn_blocked_and_strided()
+{
+	printf("  test_matmn_blocked_and_strided... ");
+
+	Arena* arena = arena_create(&default_arena_desc);
+
+	// Sizes that aren't multiples of the block size
+	const i32 M = 45, K = 70, N = 33;
+	MatMN A = matmn_new(arena, M, K);
+	MatMN B = matmn_new(arena, K, N);
+	srand(7);
+	for (i32 i = 0; i < M; ++i) { for (i32 k = 0; k < K; ++k) { MATMN_AT(&A, i, k) = rand_f32(-1.0f, 1.0f); } }
+	for (i32 k = 0; k < K; ++k) { for (i32 j = 0; j < N; ++j) { MATMN_AT(&B, k, j) = rand_f32(-1.0f, 1.0f); } }
+
+	MatMN C = matmn_mul_matmn(arena, &A, &B);
+	for (i32 i = 0; i < M; ++i)
+	{
+		for (i32 j = 0; j < N; ++j)
+		{
+			f32 expected = 0.0f;
+			for (i32 k = 0; k < K; ++k)
+			{
+				expected += MATMN_AT(&A, i, k) * MATMN_AT(&B, k, j);
+			}
+			assert(f32_nearly_equal(MATMN_AT(&C, i, j), expected));
+		}
+	}
+
+	// Multiply a 2x3 sub-block of A (via a strided view) into a strided stack buffer
+	f32 out_storage[2 * 8] = {0};
+	const MatMN A_block = matmn_view(&MATMN_AT(&A, 1, 2), 2, 3, A.stride);
+	const MatMN B_block = matmn_view(&MATMN_AT(&B, 4, 5), 3, 2, B.stride);
+	MatMN out_block = matmn_view(out_storage, 2, 2, 8);
+	matmn_mul_matmn_into(&A_block, &B_block, &out_block);
+	for (i32 i = 0; i < 2; ++i)
+	{
+		for (i32 j = 0; j < 2; ++j)
+		{
+			f32 expected = 0.0f;
+			for (i32 k = 0; k < 3; ++k)
+			{
+				expected += MATMN_AT(&A, 1 + i, 2 + k) * MATMN_AT(&B, 4 + k, 5 + j);
+			}
+			assert(f32_nearly_equal(MATMN_AT(&out_block, i, j), expected));
+		}
+	}
+
+	// Transposes
+	MatMN At = matmn_transpose(arena, &A);
+	assert(At.m == K && At.n == M);
+	assert(f32_nearly_equal(MATMN_AT(&At, 5, 3), MATMN_AT(&A, 3, 5)));
+
+	MatN square = matn_from_matmn(arena, &(MatMN) { .data = A.data, .m = 4, .n = 4, .stride = A.stride });
+	matn_transpose_in_place(&square);
+	assert(f32_nearly_equal(MATN_AT(&square, 1, 3), MATMN_AT(&A, 3, 1)));
+	assert(f32_nearly_equal(MATN_AT(&square, 2, 2), MATMN_AT(&A, 2, 2)));
 
 	arena_destroy(arena);
 
@@ -468,15 +862,15 @@ bool test_matn_from_matmn()
 
 	// Build a 2x2 MatMN with known values and verify MatN copy is correct
 	MatMN src = matmn_new(arena, 2, 2);
-	src.rows[0].data[0] = 3.0f; src.rows[0].data[1] = 7.0f;
-	src.rows[1].data[0] = 1.0f; src.rows[1].data[1] = 5.0f;
+	MATMN_AT(&src, 0, 0) = 3.0f; MATMN_AT(&src, 0, 1) = 7.0f;
+	MATMN_AT(&src, 1, 0) = 1.0f; MATMN_AT(&src, 1, 1) = 5.0f;
 
 	MatN dst = matn_from_matmn(arena, &src);
 	assert(matn_num_dims(&dst) == 2);
-	assert(f32_nearly_equal(dst.rows[0].data[0], 3.0f));
-	assert(f32_nearly_equal(dst.rows[0].data[1], 7.0f));
-	assert(f32_nearly_equal(dst.rows[1].data[0], 1.0f));
-	assert(f32_nearly_equal(dst.rows[1].data[1], 5.0f));
+	assert(f32_nearly_equal(MATN_AT(&dst, 0, 0), 3.0f));
+	assert(f32_nearly_equal(MATN_AT(&dst, 0, 1), 7.0f));
+	assert(f32_nearly_equal(MATN_AT(&dst, 1, 0), 1.0f));
+	assert(f32_nearly_equal(MATN_AT(&dst, 1, 1), 5.0f));
 
 	arena_destroy(arena);
 
@@ -507,22 +901,1624 @@ bool test_lcp_op_begin_end()
 	assert(f32_nearly_equal(d.data[2], 9.0f));
 
 	MatMN M1 = matmn_new(arena, 2, 3);
-	M1.rows[0].data[0] = 1.0f; M1.rows[0].data[1] = 0.0f; M1.rows[0].data[2] = 0.0f;
-	M1.rows[1].data[0] = 0.0f; M1.rows[1].data[1] = 1.0f; M1.rows[1].data[2] = 0.0f;
+	MATMN_AT(&M1, 0, 0) = 1.0f; MATMN_AT(&M1, 0, 1) = 0.0f; MATMN_AT(&M1, 0, 2) = 0.0f;
+	MATMN_AT(&M1, 1, 0) = 0.0f; MATMN_AT(&M1, 1, 1) = 1.0f; MATMN_AT(&M1, 1, 2) = 0.0f;
 
 	MatMN M2 = matmn_new(arena, 3, 2);
-	M2.rows[0].data[0] = 1.0f; M2.rows[0].data[1] = 2.0f;
-	M2.rows[1].data[0] = 3.0f; M2.rows[1].data[1] = 4.0f;
-	M2.rows[2].data[0] = 5.0f; M2.rows[2].data[1] = 6.0f;
+	MATMN_AT(&M2, 0, 0) = 1.0f; MATMN_AT(&M2, 0, 1) = 2.0f;
+	MATMN_AT(&M2, 1, 0) = 3.0f; MATMN_AT(&M2, 1, 1) = 4.0f;
+	MATMN_AT(&M2, 2, 0) = 5.0f; MATMN_AT(&M2, 2, 1) = 6.0f;
 
 	MatMN M3 = matmn_mul_matmn(arena, &M1, &M2);
-	assert(f32_nearly_equal(M3.rows[0].data[0], 1.0f));
-	assert(f32_nearly_equal(M3.rows[0].data[1], 2.0f));
-	assert(f32_nearly_equal(M3.rows[1].data[0], 3.0f));
-	assert(f32_nearly_equal(M3.rows[1].data[1], 4.0f));
+	assert(f32_nearly_equal(MATMN_AT(&M3, 0, 0), 1.0f));
+	assert(f32_nearly_equal(MATMN_AT(&M3, 0, 1), 2.0f));
+	assert(f32_nearly_equal(MATMN_AT(&M3, 1, 0), 3.0f));
+	assert(f32_nearly_equal(MATMN_AT(&M3, 1, 1), 4.0f));
+
+	arena_destroy(arena);
+
+	printf("PASSED\n");
+	return true;
+}
+
+bool test_lcp_projected_gauss_seidel()
+{
+	printf("  test_lcp_projected_gauss_seidel... ");
+
+	Arena* arena = arena_create(&default_arena_desc);
+
+	// Dense: [4 1; 1 3] * x = [1 2] has the solution x = (1/11, 7/11)
+	MatN A = matn_new(arena, 2);
+	MATN_AT(&A, 0, 0) = 4.0f; MATN_AT(&A, 0, 1) = 1.0f;
+	MATN_AT(&A, 1, 0) = 1.0f; MATN_AT(&A, 1, 1) = 3.0f;
+	VecN b = vecn_new(arena, 2);
+	b.data[0] = 1.0f; b.data[1] = 2.0f;
+
+	LcpSolveDesc desc = lcp_solve_desc_default;
+	desc.max_iterations = 50;
+	desc.tolerance = 1e-6f;
+
+	VecN lambda = vecn_new(arena, 2);
+	const i32 cold_iterations = lcp_projected_gauss_seidel(&A, &b, &desc, &lambda);
+	assert(cold_iterations < desc.max_iterations);
+	assert(f32_nearly_equal(lambda.data[0], 1.0f / 11.0f));
+	assert(f32_nearly_equal(lambda.data[1], 7.0f / 11.0f));
+
+	// Warm starting from the solution converges immediately
+	const i32 warm_iterations = lcp_projected_gauss_seidel(&A, &b, &desc, &lambda);
+	assert(warm_iterations == 1);
+
+	// Clamping row 1 to <= 0.5 gives x = (0.125, 0.5)
+	VecN upper_bounds = vecn_new(arena, 2);
+	upper_bounds.data[0] = FLT_MAX; upper_bounds.data[1] = 0.5f;
+	desc.upper_bounds = &upper_bounds;
+	vecn_zero_in_place(&lambda);
+	lcp_projected_gauss_seidel(&A, &b, &desc, &lambda);
+	assert(f32_nearly_equal(lambda.data[0], 0.125f));
+	assert(f32_nearly_equal(lambda.data[1], 0.5f));
+	desc.upper_bounds = NULL;
+
+	arena_destroy(arena);
+
+	printf("PASSED\n");
+	return true;
+}
+
+bool test_jacobian_fixed_size()
+{
+	printf("  test_jacobian_fixed_size... ");
+
+	Arena* arena = arena_create(&default_arena_desc);
+
+	// Symmetric, non-diagonal inverse inertia so every term of the 3x3 blocks is exercised
+	const Mat3 inertia_a = { .d = { { 2.0f, 0.1f, 0.2f }, { 0.1f, 1.5f, -0.3f }, { 0.2f, -0.3f, 1.0f } } };
+	const Mat3 inertia_b = { .d = { { 0.5f, -0.2f, 0.0f }, { -0.2f, 0.75f, 0.1f }, { 0.0f, 0.1f, 0.25f } } };
+	const InverseMass12 inverse_mass = {
+		.body_a = { .inverse_mass = 1.0f, .inverse_inertia = inertia_a },
+		.body_b = { .inverse_mass = 0.5f, .inverse_inertia = inertia_b },
+	};
+
+	Jacobian3x12 jacobian;
+	Vec12 velocities;
+	for (i32 i = 0; i < 12; ++i)
+	{
+		for (i32 row_idx = 0; row_idx < 3; ++row_idx)
+		{
+			jacobian.rows[row_idx].d[i] = rand_f32(-1.0f, 1.0f);
+		}
+		velocities.d[i] = rand_f32(-1.0f, 1.0f);
+	}
+
+	// Dense reference: J (3x12) * W (12x12) * J^T
+	MatMN J = matmn_new(arena, 3, 12);
+	for (i32 row_idx = 0; row_idx < 3; ++row_idx)
+	{
+		for (i32 i = 0; i < 12; ++i)
+		{
+			MATMN_AT(&J, row_idx, i) = jacobian.rows[row_idx].d[i];
+		}
+	}
+	MatMN W = matmn_new(arena, 12, 12);
+	matmn_zero_in_place(&W);
+	for (i32 i = 0; i < 3; ++i)
+	{
+		MATMN_AT(&W, i, i) = inverse_mass.body_a.inverse_mass;
+		MATMN_AT(&W, 6 + i, 6 + i) = inverse_mass.body_b.inverse_mass;
+		for (i32 j = 0; j < 3; ++j)
+		{
+			MATMN_AT(&W, 3 + i, 3 + j) = inertia_a.d[j][i];
+			MATMN_AT(&W, 9 + i, 9 + j) = inertia_b.d[j][i];
+		}
+	}
+	MatMN JW = matmn_mul_matmn(arena, &J, &W);
+	MatMN Jt = matmn_transpose(arena, &J);
+	MatMN JWJt = matmn_mul_matmn(arena, &JW, &Jt);
+
+	const Mat3 effective_mass = jacobian3x12_effective_mass(&jacobian, &inverse_mass);
+	for (i32 row_idx = 0; row_idx < 3; ++row_idx)
+	{
+		for (i32 col_idx = 0; col_idx < 3; ++col_idx)
+		{
+			assert(f32_nearly_equal(effective_mass.d[col_idx][row_idx], MATMN_AT(&JWJt, row_idx, col_idx)));
+		}
+	}
+	assert(f32_nearly_equal(jacobian1x12_effective_mass(jacobian.rows[0], &inverse_mass), MATMN_AT(&JWJt, 0, 0)));
+
+	// J * v and J^T * lambda
+	const Vec3 j_v = jacobian3x12_mul_vec12(&jacobian, velocities);
+	const Vec3 lambda = vec3_new(0.5f, -2.0f, 1.0f);
+	const Vec12 impulses = jacobian3x12_transpose_mul_vec3(&jacobian, lambda);
+	for (i32 row_idx = 0; row_idx < 3; ++row_idx)
+	{
+		assert(f32_nearly_equal(j_v.v[row_idx], f32_array_dot(matmn_row(&J, row_idx).data, velocities.d, 12)));
+	}
+	for (i32 i = 0; i < 12; ++i)
+	{
+		const f32 expected = MATMN_AT(&Jt, i, 0) * lambda.x + MATMN_AT(&Jt, i, 1) * lambda.y + MATMN_AT(&Jt, i, 2) * lambda.z;
+		assert(f32_nearly_equal(impulses.d[i], expected));
+	}
 
 	arena_destroy(arena);
 
 	printf("PASSED\n");
 	return true;
 }
+
+bool test_pair_map()
+{
+	printf("  test_pair_map... ");
+
+	// Random inserts and removes over a small key space, checked against a dense reference table
+	enum { NUM_IDS = 32 };
+	i32 reference[NUM_IDS][NUM_IDS];
+	for (i32 a = 0; a < NUM_IDS; ++a)
+	{
+		for (i32 b = 0; b < NUM_IDS; ++b)
+		{
+			reference[a][b] = -1;
+		}
+	}
+
+	PairMap map;
+	pair_map_init(&map);
+	assert(pair_map_find(&map, pair_map_key(0, 1)) == NULL);
+	assert(pair_map_key(3, 7) == pair_map_key(7, 3));
+
+	i32 reference_count = 0;
+	for (i32 op_idx = 0; op_idx < 20000; ++op_idx)
+	{
+		const i32 a = rand() % NUM_IDS;
+		const i32 b = rand() % NUM_IDS;
+		const i32 lo = MIN(a, b);
+		const i32 hi = MAX(a, b);
+		const u64 key = pair_map_key(a, b);
+
+		if (rand() % 3 != 0)
+		{
+			const bool inserted = pair_map_insert(&map, key, op_idx);
+			assert(inserted == (reference[lo][hi] < 0));
+			if (inserted)
+			{
+				reference[lo][hi] = op_idx;
+				reference_count++;
+			}
+		}
+		else
+		{
+			i32 removed_value = -1;
+			const bool removed = pair_map_remove(&map, key, &removed_value);
+			assert(removed == (reference[lo][hi] >= 0));
+			if (removed)
+			{
+				assert(removed_value == reference[lo][hi]);
+				reference[lo][hi] = -1;
+				reference_count--;
+			}
+		}
+		assert(map.count == reference_count);
+	}
+
+	for (i32 lo = 0; lo < NUM_IDS; ++lo)
+	{
+		for (i32 hi = lo; hi < NUM_IDS; ++hi)
+		{
+			const i32* value = pair_map_find(&map, pair_map_key(lo, hi));
+			assert((value == NULL) == (reference[lo][hi] < 0));
+			assert(value == NULL || *value == reference[lo][hi]);
+		}
+	}
+
+	pair_map_free(&map);
+
+	printf("PASSED\n");
+	return true;
+}
+
+bool test_union_find()
+{
+	printf("  test_union_find... ");
+
+	// Random unions checked against a brute force labelling, where a union relabels every member of one set
+	enum { NUM_INDICES = 64 };
+	i32 labels[NUM_INDICES];
+	for (i32 idx = 0; idx < NUM_INDICES; ++idx)
+	{
+		labels[idx] = idx;
+	}
+
+	UnionFind union_find;
+	union_find_init(&union_find);
+	union_find_reset(&union_find, NUM_INDICES);
+	assert(union_find_count(&union_find) == NUM_INDICES);
+
+	u32 rng_state = 12345;
+	for (i32 iteration = 0; iteration < 48; ++iteration)
+	{
+		rng_state = rng_state * 1664525u + 1013904223u;
+		const i32 idx_a = (i32) ((rng_state >> 8) % NUM_INDICES);
+		rng_state = rng_state * 1664525u + 1013904223u;
+		const i32 idx_b = (i32) ((rng_state >> 8) % NUM_INDICES);
+
+		const i32 root = union_find_union(&union_find, idx_a, idx_b);
+		assert(root == union_find_find(&union_find, idx_a));
+		assert(root == union_find_find(&union_find, idx_b));
+
+		const i32 old_label = labels[idx_b];
+		for (i32 idx = 0; idx < NUM_INDICES; ++idx)
+		{
+			if (labels[idx] == old_label)
+			{
+				labels[idx] = labels[idx_a];
+			}
+		}
+
+		for (i32 idx_x = 0; idx_x < NUM_INDICES; ++idx_x)
+		{
+			for (i32 idx_y = 0; idx_y < NUM_INDICES; ++idx_y)
+			{
+				const bool same_set = union_find_find(&union_find, idx_x) == union_find_find(&union_find, idx_y);
+				assert(same_set == (labels[idx_x] == labels[idx_y]));
+			}
+		}
+	}
+
+	// Resetting splits everything back into single index sets
+	union_find_reset(&union_find, 8);
+	assert(union_find_count(&union_find) == 8);
+	for (i32 idx = 0; idx < 8; ++idx)
+	{
+		assert(union_find_find(&union_find, idx) == idx);
+	}
+
+	union_find_free(&union_find);
+
+	printf("PASSED\n");
+	return true;
+}
+
+bool test_sweep_and_prune()
+{
+	printf("  test_sweep_and_prune... ");
+
+	enum { MAX_BODIES = 64 };
+	Bounds bounds[MAX_BODIES];
+	Vec3 velocities[MAX_BODIES];
+	bool was_overlapping[MAX_BODIES][MAX_BODIES] = {};
+
+	SweepAndPrune sap;
+	sweep_and_prune_init(&sap);
+
+	i32 num_bodies = 0;
+	for (i32 step = 0; step < 100; ++step)
+	{
+		// Add bodies over the first few steps to exercise insertion of new endpoints
+		while (num_bodies < MAX_BODIES && num_bodies < 16 * (step + 1))
+		{
+			const Vec3 center = vec3_new(rand_f32(-20.0f, 20.0f), rand_f32(-20.0f, 20.0f), rand_f32(-20.0f, 20.0f));
+			const Vec3 half_extents = vec3_new(rand_f32(0.5f, 4.0f), rand_f32(0.5f, 4.0f), rand_f32(0.5f, 4.0f));
+			bounds[num_bodies] = (Bounds) {
+				.min = vec3_sub(center, half_extents),
+				.max = vec3_add(center, half_extents),
+			};
+			velocities[num_bodies] = vec3_new(rand_f32(-1.0f, 1.0f), rand_f32(-1.0f, 1.0f), rand_f32(-1.0f, 1.0f));
+			num_bodies++;
+		}
+
+		// Only some bodies move each step
+		for (i32 body_idx = 0; body_idx < num_bodies; ++body_idx)
+		{
+			if (body_idx % 3 != step % 3)
+			{
+				bounds[body_idx].min = vec3_add(bounds[body_idx].min, velocities[body_idx]);
+				bounds[body_idx].max = vec3_add(bounds[body_idx].max, velocities[body_idx]);
+			}
+			if (fabsf(bounds[body_idx].min.x) > 30.0f || fabsf(bounds[body_idx].min.y) > 30.0f || fabsf(bounds[body_idx].min.z) > 30.0f)
+			{
+				velocities[body_idx] = vec3_negate(velocities[body_idx]);
+			}
+		}
+
+		sweep_and_prune_update(&sap, bounds, num_bodies);
+
+		// The pair set matches a brute force test
+		i32 num_expected_pairs = 0;
+		for (i32 a = 0; a < num_bodies; ++a)
+		{
+			for (i32 b = a + 1; b < num_bodies; ++b)
+			{
+				const bool overlapping = bounds_intersect(bounds[a], bounds[b]);
+				const i32* pair_idx = pair_map_find(&sap.pair_set.pair_indices, pair_map_key(a, b));
+				assert(overlapping == (pair_idx != NULL));
+				if (pair_idx)
+				{
+					assert(sap.pair_set.pairs[*pair_idx].idx_a == a && sap.pair_set.pairs[*pair_idx].idx_b == b);
+				}
+				num_expected_pairs += overlapping ? 1 : 0;
+			}
+		}
+		assert(sb_count(sap.pair_set.pairs) == num_expected_pairs);
+
+		// Events are exactly the changes since the previous step
+		for (i32 event_idx = 0; event_idx < sb_count(sap.pair_set.added_pairs); ++event_idx)
+		{
+			const CollisionPair pair = sap.pair_set.added_pairs[event_idx];
+			assert(!was_overlapping[pair.idx_a][pair.idx_b]);
+			was_overlapping[pair.idx_a][pair.idx_b] = true;
+		}
+		for (i32 event_idx = 0; event_idx < sb_count(sap.pair_set.removed_pairs); ++event_idx)
+		{
+			const CollisionPair pair = sap.pair_set.removed_pairs[event_idx];
+			assert(was_overlapping[pair.idx_a][pair.idx_b]);
+			was_overlapping[pair.idx_a][pair.idx_b] = false;
+		}
+		for (i32 a = 0; a < num_bodies; ++a)
+		{
+			for (i32 b = a + 1; b < num_bodies; ++b)
+			{
+				assert(was_overlapping[a][b] == bounds_intersect(bounds[a], bounds[b]));
+			}
+		}
+	}
+
+	sweep_and_prune_destroy(&sap);
+
+	printf("PASSED\n");
+	return true;
+}
+
+// Checks parent links, heights and that every node's bounds contain its children. Returns the number of leaves below in_node_idx
+static i32 test_aabb_tree_validate(const AabbTree* in_tree, const i32 in_node_idx)
+{
+	const AabbTreeNode* node = &in_tree->nodes[in_node_idx];
+	if (aabb_tree_node_is_leaf(node))
+	{
+		assert(node->height == 0);
+		assert(in_tree->body_leaves[node->body_idx] == in_node_idx);
+		return 1;
+	}
+
+	const AabbTreeNode* child_a = &in_tree->nodes[node->children[0]];
+	const AabbTreeNode* child_b = &in_tree->nodes[node->children[1]];
+	assert(child_a->parent == in_node_idx && child_b->parent == in_node_idx);
+	assert(node->height == 1 + MAX(child_a->height, child_b->height));
+	assert(bounds_contains(node->bounds, child_a->bounds) && bounds_contains(node->bounds, child_b->bounds));
+
+	return test_aabb_tree_validate(in_tree, node->children[0]) + test_aabb_tree_validate(in_tree, node->children[1]);
+}
+
+bool test_aabb_tree()
+{
+	printf("  test_aabb_tree... ");
+
+	enum { MAX_BODIES = 64 };
+	Bounds bounds[MAX_BODIES];
+	Vec3 velocities[MAX_BODIES];
+	bool was_paired[MAX_BODIES][MAX_BODIES] = {};
+
+	AabbTree tree;
+	aabb_tree_init(&tree);
+
+	i32 num_bodies = 0;
+	i32 num_reinserted = 0;
+	for (i32 step = 0; step < 100; ++step)
+	{
+		// One large body among many small ones, added over the first few steps
+		while (num_bodies < MAX_BODIES && num_bodies < 16 * (step + 1))
+		{
+			const Vec3 center = vec3_new(rand_f32(-20.0f, 20.0f), rand_f32(-20.0f, 20.0f), rand_f32(-20.0f, 20.0f));
+			const Vec3 half_extents = num_bodies == 0
+				? vec3_new(30.0f, 1.0f, 30.0f)
+				: vec3_new(rand_f32(0.5f, 2.0f), rand_f32(0.5f, 2.0f), rand_f32(0.5f, 2.0f));
+			bounds[num_bodies] = (Bounds) {
+				.min = vec3_sub(center, half_extents),
+				.max = vec3_add(center, half_extents),
+			};
+			velocities[num_bodies] = num_bodies == 0 ? vec3_zero : vec3_new(rand_f32(-0.3f, 0.3f), rand_f32(-0.3f, 0.3f), rand_f32(-0.3f, 0.3f));
+			num_bodies++;
+		}
+
+		for (i32 body_idx = 0; body_idx < num_bodies; ++body_idx)
+		{
+			bounds[body_idx].min = vec3_add(bounds[body_idx].min, velocities[body_idx]);
+			bounds[body_idx].max = vec3_add(bounds[body_idx].max, velocities[body_idx]);
+			if (fabsf(bounds[body_idx].min.x) > 30.0f || fabsf(bounds[body_idx].min.y) > 30.0f || fabsf(bounds[body_idx].min.z) > 30.0f)
+			{
+				velocities[body_idx] = vec3_negate(velocities[body_idx]);
+			}
+		}
+
+		const i32 num_existing_bodies = sb_count(tree.body_leaves);
+		aabb_tree_update(&tree, bounds, num_bodies);
+		num_reinserted += sb_count(tree.moved_bodies) - (num_bodies - num_existing_bodies);
+
+		assert(test_aabb_tree_validate(&tree, tree.root) == num_bodies);
+
+		// Rotations keep the tree within a small factor of the ideal log2(64) = 6 depth
+		assert(tree.nodes[tree.root].height <= 12);
+
+		// Fat bounds contain the real bounds, and the pair set is exactly the pairs of overlapping fat bounds
+		for (i32 a = 0; a < num_bodies; ++a)
+		{
+			const Bounds fat_a = tree.nodes[tree.body_leaves[a]].bounds;
+			assert(bounds_contains(fat_a, bounds[a]));
+			for (i32 b = a + 1; b < num_bodies; ++b)
+			{
+				const bool fat_overlapping = bounds_intersect(fat_a, tree.nodes[tree.body_leaves[b]].bounds);
+				const bool in_pair_set = pair_map_find(&tree.pair_set.pair_indices, pair_map_key(a, b)) != NULL;
+				assert(fat_overlapping == in_pair_set);
+				assert(in_pair_set || !bounds_intersect(bounds[a], bounds[b]));
+			}
+		}
+		assert(sb_count(tree.pair_set.pairs) == tree.pair_set.pair_indices.count);
+
+		// Events are exactly the changes since the previous step
+		for (i32 event_idx = 0; event_idx < sb_count(tree.pair_set.added_pairs); ++event_idx)
+		{
+			const CollisionPair pair = tree.pair_set.added_pairs[event_idx];
+			assert(!was_paired[pair.idx_a][pair.idx_b]);
+			was_paired[pair.idx_a][pair.idx_b] = true;
+		}
+		for (i32 event_idx = 0; event_idx < sb_count(tree.pair_set.removed_pairs); ++event_idx)
+		{
+			const CollisionPair pair = tree.pair_set.removed_pairs[event_idx];
+			assert(was_paired[pair.idx_a][pair.idx_b]);
+			was_paired[pair.idx_a][pair.idx_b] = false;
+		}
+		for (i32 pair_idx = 0; pair_idx < sb_count(tree.pair_set.pairs); ++pair_idx)
+		{
+			const CollisionPair pair = tree.pair_set.pairs[pair_idx];
+			assert(was_paired[pair.idx_a][pair.idx_b]);
+		}
+	}
+
+	// The fat margin means most steps don't reinsert a given body
+	assert(num_reinserted > 0 && num_reinserted < 100 * MAX_BODIES / 2);
+
+	aabb_tree_destroy(&tree);
+
+	printf("PASSED\n");
+	return true;
+}
+
+static Bounds test_random_bounds(const f32 in_range, const f32 in_min_half_extent, const f32 in_max_half_extent)
+{
+	const Vec3 center = vec3_new(rand_f32(-in_range, in_range), rand_f32(-in_range, in_range), rand_f32(-in_range, in_range));
+	const Vec3 half_extents = vec3_new(
+		rand_f32(in_min_half_extent, in_max_half_extent),
+		rand_f32(in_min_half_extent, in_max_half_extent),
+		rand_f32(in_min_half_extent, in_max_half_extent)
+	);
+	return (Bounds) {
+		.min = vec3_sub(center, half_extents),
+		.max = vec3_add(center, half_extents),
+	};
+}
+
+bool test_spatial_hash_grid()
+{
+	printf("  test_spatial_hash_grid... ");
+
+	enum { MAX_BODIES = 64 };
+	Bounds bounds[MAX_BODIES];
+	Vec3 velocities[MAX_BODIES];
+	bool was_overlapping[MAX_BODIES][MAX_BODIES] = {};
+
+	SpatialHashGrid grid;
+	spatial_hash_grid_init(&grid, 4.0f);
+
+	i32 num_bodies = 0;
+	for (i32 step = 0; step < 100; ++step)
+	{
+		// Mostly cell sized bodies, with some spanning several cells and a few too large for the grid
+		while (num_bodies < MAX_BODIES && num_bodies < 16 * (step + 1))
+		{
+			const f32 max_half_extent = num_bodies % 16 == 0 ? 12.0f : num_bodies % 4 == 0 ? 4.0f : 1.5f;
+			bounds[num_bodies] = test_random_bounds(20.0f, 0.5f, max_half_extent);
+			velocities[num_bodies] = vec3_new(rand_f32(-1.0f, 1.0f), rand_f32(-1.0f, 1.0f), rand_f32(-1.0f, 1.0f));
+			num_bodies++;
+		}
+
+		for (i32 body_idx = 0; body_idx < num_bodies; ++body_idx)
+		{
+			bounds[body_idx].min = vec3_add(bounds[body_idx].min, velocities[body_idx]);
+			bounds[body_idx].max = vec3_add(bounds[body_idx].max, velocities[body_idx]);
+			if (fabsf(bounds[body_idx].min.x) > 30.0f || fabsf(bounds[body_idx].min.y) > 30.0f || fabsf(bounds[body_idx].min.z) > 30.0f)
+			{
+				velocities[body_idx] = vec3_negate(velocities[body_idx]);
+			}
+		}
+
+		spatial_hash_grid_update(&grid, bounds, num_bodies, NULL);
+
+		// The pair set matches a brute force test
+		i32 num_expected_pairs = 0;
+		for (i32 a = 0; a < num_bodies; ++a)
+		{
+			for (i32 b = a + 1; b < num_bodies; ++b)
+			{
+				const bool overlapping = bounds_intersect(bounds[a], bounds[b]);
+				assert(overlapping == (pair_map_find(&grid.pair_set.pair_indices, pair_map_key(a, b)) != NULL));
+				num_expected_pairs += overlapping ? 1 : 0;
+			}
+		}
+		assert(sb_count(grid.pair_set.pairs) == num_expected_pairs);
+
+		// Events are exactly the changes since the previous step
+		for (i32 event_idx = 0; event_idx < sb_count(grid.pair_set.added_pairs); ++event_idx)
+		{
+			const CollisionPair pair = grid.pair_set.added_pairs[event_idx];
+			assert(!was_overlapping[pair.idx_a][pair.idx_b]);
+			was_overlapping[pair.idx_a][pair.idx_b] = true;
+		}
+		for (i32 event_idx = 0; event_idx < sb_count(grid.pair_set.removed_pairs); ++event_idx)
+		{
+			const CollisionPair pair = grid.pair_set.removed_pairs[event_idx];
+			assert(was_overlapping[pair.idx_a][pair.idx_b]);
+			was_overlapping[pair.idx_a][pair.idx_b] = false;
+		}
+	}
+	assert(sb_count(grid.oversized_bodies) > 0);
+
+	spatial_hash_grid_destroy(&grid);
+
+	// With enough bodies to split into several jobs, running them as tasks gives the same pairs in the same order
+	{
+		enum { NUM_LARGE_SCENE_BODIES = 4096 };
+		Bounds* large_scene_bounds = FCS_MEM_ALLOC(sizeof(Bounds) * NUM_LARGE_SCENE_BODIES);
+		for (i32 body_idx = 0; body_idx < NUM_LARGE_SCENE_BODIES; ++body_idx)
+		{
+			large_scene_bounds[body_idx] = test_random_bounds(100.0f, 0.5f, body_idx < 4 ? 200.0f : 2.0f);
+		}
+
+		TaskSystem task_system;
+		task_system_init(&task_system);
+
+		SpatialHashGrid serial_grid;
+		spatial_hash_grid_init(&serial_grid, 4.0f);
+		spatial_hash_grid_update(&serial_grid, large_scene_bounds, NUM_LARGE_SCENE_BODIES, NULL);
+
+		SpatialHashGrid parallel_grid;
+		spatial_hash_grid_init(&parallel_grid, 4.0f);
+		spatial_hash_grid_update(&parallel_grid, large_scene_bounds, NUM_LARGE_SCENE_BODIES, &task_system);
+
+		assert(sb_count(serial_grid.pair_set.pairs) > 0);
+		assert(sb_count(serial_grid.oversized_bodies) == 4);
+		assert(sb_count(serial_grid.pair_set.pairs) == sb_count(parallel_grid.pair_set.pairs));
+		for (i32 pair_idx = 0; pair_idx < sb_count(serial_grid.pair_set.pairs); ++pair_idx)
+		{
+			assert(collision_pair_equals(&serial_grid.pair_set.pairs[pair_idx], &parallel_grid.pair_set.pairs[pair_idx]));
+		}
+
+		spatial_hash_grid_destroy(&serial_grid);
+		spatial_hash_grid_destroy(&parallel_grid);
+		task_system_shutdown(&task_system);
+		FCS_MEM_FREE(large_scene_bounds);
+	}
+
+	printf("PASSED\n");
+	return true;
+}
+
+// Stack of spheres and boxes falling onto a static floor
+static void test_physics_scene_populate(PhysicsScene* in_physics_scene)
+{
+	for (i32 body_idx = 0; body_idx < 48; ++body_idx)
+	{
+		const Vec3 position = vec3_new((f32) (body_idx % 4) * 3.0f, 2.0f + (f32) (body_idx / 4) * 2.5f, (f32) ((body_idx / 2) % 3) * 3.0f);
+		PhysicsBodyCreateInfo body = {
+			.position = position,
+			.orientation = quat_identity,
+			.linear_velocity = vec3_new(0.0f, -5.0f, 0.0f),
+			.inverse_mass = 1.0f,
+			.elasticity = 0.5f,
+			.friction = 0.5f,
+		};
+		if (body_idx % 2 == 0)
+		{
+			body.shape = (Shape) {
+				.type = SHAPE_TYPE_SPHERE,
+				.sphere = { .radius = 1.0f },
+			};
+		}
+		else
+		{
+			body.shape = (Shape) {
+				.type = SHAPE_TYPE_BOX,
+				.box = box_shape_create(vec3_new(1.0f, 1.0f, 1.0f)),
+			};
+		}
+		physics_scene_add_body(in_physics_scene, &body);
+	}
+
+	physics_scene_add_body(in_physics_scene, &(PhysicsBodyCreateInfo) {
+		.position = vec3_new(0.0f, -10.0f, 0.0f),
+		.orientation = quat_identity,
+		.shape = {
+			.type = SHAPE_TYPE_BOX,
+			.box = box_shape_create(vec3_new(100.0f, 10.0f, 100.0f)),
+		},
+		.inverse_mass = 0.0f,
+		.elasticity = 0.5f,
+		.friction = 0.5f,
+	});
+}
+
+// Every input point is inside every face, and every edge is shared with exactly one other face, running the other way
+static void test_convex_hull_check(const ConvexHull* in_hull, const Vec3* in_points, const i32 in_num_points)
+{
+	const i32 num_hull_points = sb_count(in_hull->points);
+	const i32 num_tris = sb_count(in_hull->tris);
+	assert(num_tris == 2 * num_hull_points - 4);
+
+	for (i32 tri_idx = 0; tri_idx < num_tris; ++tri_idx)
+	{
+		const ConvexTri tri = in_hull->tris[tri_idx];
+		const Vec3 a = in_hull->points[tri.a];
+		const Vec3 b = in_hull->points[tri.b];
+		const Vec3 c = in_hull->points[tri.c];
+		for (i32 point_idx = 0; point_idx < in_num_points; ++point_idx)
+		{
+			assert(distance_from_triangle(a, b, c, in_points[point_idx]) < 1e-4f);
+		}
+
+		const i32 tri_points[3] = { tri.a, tri.b, tri.c };
+		for (i32 edge_idx = 0; edge_idx < 3; ++edge_idx)
+		{
+			const i32 edge_start = tri_points[edge_idx];
+			const i32 edge_end = tri_points[(edge_idx + 1) % 3];
+			i32 num_twins = 0;
+			for (i32 other_idx = 0; other_idx < num_tris; ++other_idx)
+			{
+				const ConvexTri other = in_hull->tris[other_idx];
+				num_twins += (other.a == edge_end && other.b == edge_start) ? 1 : 0;
+				num_twins += (other.b == edge_end && other.c == edge_start) ? 1 : 0;
+				num_twins += (other.c == edge_end && other.a == edge_start) ? 1 : 0;
+			}
+			assert(num_twins == 1);
+		}
+	}
+}
+
+bool test_convex_hull()
+{
+	printf("  test_convex_hull... ");
+
+	// A grid filling a box: points on its faces and edges are on the hull's planes, so only the corners are kept
+	{
+		sbuffer(Vec3) points = NULL;
+		for (i32 x = 0; x < 5; ++x)
+		{
+			for (i32 y = 0; y < 5; ++y)
+			{
+				for (i32 z = 0; z < 5; ++z)
+				{
+					sb_push(points, vec3_new((f32) x - 2.0f, (f32) y * 0.5f, (f32) z * 3.0f));
+				}
+			}
+		}
+
+		ConvexHull hull = convex_hull_create(points, sb_count(points));
+		assert(sb_count(hull.points) == 8);
+		assert(sb_count(hull.tris) == 12);
+		test_convex_hull_check(&hull, points, sb_count(points));
+
+		convex_hull_destroy(&hull);
+		sb_free(points);
+	}
+
+	// Thousands of points in and on a sphere, as an imported mesh's vertices would be. Those on the sphere are all on the hull
+	{
+		srand(2468);
+		const i32 num_surface_points = 2000;
+		sbuffer(Vec3) points = NULL;
+		for (i32 point_idx = 0; point_idx < 4000; ++point_idx)
+		{
+			const Vec3 dir = vec3_normalize(vec3_new(rand_f32(-1.0f, 1.0f), rand_f32(-1.0f, 1.0f), rand_f32(-1.0f, 1.0f)));
+			const f32 radius = point_idx < num_surface_points ? 5.0f : rand_f32(0.0f, 4.9f);
+			sb_push(points, vec3_scale(dir, radius));
+		}
+
+		ConvexHull hull = convex_hull_create(points, sb_count(points));
+		assert(sb_count(hull.points) == num_surface_points);
+		test_convex_hull_check(&hull, points, sb_count(points));
+
+		convex_hull_destroy(&hull);
+		sb_free(points);
+	}
+
+	printf("PASSED\n");
+	return true;
+}
+
+bool test_convex_shape()
+{
+	printf("  test_convex_shape... ");
+
+	// A hull of a box's corners has the box's exact mass properties, off center too
+	const Vec3 half_extents = vec3_new(1.0f, 0.5f, 2.0f);
+	const Vec3 offset = vec3_new(0.5f, -1.0f, 0.25f);
+	Vec3 box_points[8];
+	for (i32 corner_idx = 0; corner_idx < 8; ++corner_idx)
+	{
+		const Vec3 corner = vec3_new(
+			corner_idx & 1 ? half_extents.x : -half_extents.x,
+			corner_idx & 2 ? half_extents.y : -half_extents.y,
+			corner_idx & 4 ? half_extents.z : -half_extents.z
+		);
+		box_points[corner_idx] = vec3_add(corner, offset);
+	}
+
+	ConvexShape* convex = convex_shape_create(box_points, ARRAY_COUNT(box_points));
+	assert(vec3_nearly_equal(convex->center_of_mass, offset));
+
+	Shape box_shape = {
+		.type = SHAPE_TYPE_BOX,
+		.box = box_shape_create(half_extents),
+	};
+	box_shape.box.bounds.min = vec3_add(box_shape.box.bounds.min, offset);
+	box_shape.box.bounds.max = vec3_add(box_shape.box.bounds.max, offset);
+	const Mat3 box_inertia_tensor = shape_get_inertia_tensor_matrix(&box_shape);
+	for (i32 column = 0; column < 3; ++column)
+	{
+		assert(vec3_nearly_equal(convex->inertia_tensor.columns[column], box_inertia_tensor.columns[column]));
+	}
+
+	// A tetrahedron's center of mass is the average of its corners
+	const Vec3 tetrahedron_points[] = {
+		vec3_new(0.0f, 0.0f, 0.0f), vec3_new(3.0f, 0.0f, 0.0f), vec3_new(0.0f, 2.0f, 0.0f), vec3_new(1.0f, 1.0f, 4.0f),
+	};
+	ConvexShape* tetrahedron = convex_shape_create(tetrahedron_points, ARRAY_COUNT(tetrahedron_points));
+	assert(vec3_nearly_equal(tetrahedron->center_of_mass, vec3_new(1.0f, 0.75f, 1.0f)));
+	convex_shape_release(tetrahedron);
+
+	// The library builds each set of points once, and hands out references to it
+	ShapeLibrary shape_library;
+	shape_library_init(&shape_library);
+
+	ConvexShape* library_convex = shape_library_get_convex(&shape_library, box_points, ARRAY_COUNT(box_points));
+	assert(library_convex != convex);
+	assert(library_convex->ref_count == 2);
+	assert(shape_library_get_convex(&shape_library, box_points, ARRAY_COUNT(box_points)) == library_convex);
+	assert(library_convex->ref_count == 3);
+	assert(vec3_nearly_equal(library_convex->center_of_mass, convex->center_of_mass));
+
+	ConvexShape* library_tetrahedron = shape_library_get_convex(&shape_library, tetrahedron_points, ARRAY_COUNT(tetrahedron_points));
+	assert(library_tetrahedron != library_convex);
+	assert(sb_count(shape_library.entries) == 2);
+	assert(shape_library.entry_indices.count == 2);
+
+	// Bodies added to a scene hand it their shape's reference, which the scene releases when destroyed
+	PhysicsScene physics_scene;
+	physics_scene_init(&physics_scene);
+	for (i32 body_idx = 0; body_idx < 2; ++body_idx)
+	{
+		physics_scene_add_body(&physics_scene, &(PhysicsBodyCreateInfo) {
+			.position = vec3_new(5.0f * (f32) body_idx, 0.0f, 0.0f),
+			.orientation = quat_identity,
+			.shape = {
+				.type = SHAPE_TYPE_CONVEX,
+				.convex = body_idx == 0 ? library_convex : convex_shape_acquire(library_convex),
+			},
+			.inverse_mass = 1.0f,
+		});
+	}
+	assert(library_convex->ref_count == 4);
+	physics_scene_destroy(&physics_scene);
+	assert(library_convex->ref_count == 2);
+
+	convex_shape_release(library_convex);
+	convex_shape_release(library_tetrahedron);
+	shape_library_free(&shape_library);
+	convex_shape_release(convex);
+
+	printf("PASSED\n");
+	return true;
+}
+
+bool test_physics_support()
+{
+	printf("  test_physics_support... ");
+
+	// A hull around random points, with some of them well inside it
+	enum { NUM_POINTS = 64 };
+	Vec3 points[NUM_POINTS];
+	u32 rng_state = 777;
+	for (i32 point_idx = 0; point_idx < NUM_POINTS; ++point_idx)
+	{
+		f32 coords[3];
+		for (i32 axis = 0; axis < 3; ++axis)
+		{
+			rng_state = rng_state * 1664525u + 1013904223u;
+			coords[axis] = ((f32) (rng_state >> 8) / (f32) (1 << 24)) * 2.0f - 1.0f;
+		}
+		const Vec3 dir = vec3_normalize(vec3_new(coords[0], coords[1], coords[2]));
+		points[point_idx] = vec3_scale(dir, point_idx % 4 == 0 ? 0.5f : 2.0f);
+	}
+
+	ConvexShape* convex = convex_shape_create(points, NUM_POINTS);
+	const Vec3* hull_points = convex->hull.points;
+	const i32 num_hull_points = sb_count(hull_points);
+
+	PhysicsBody convex_body = {
+		.position = vec3_new(1.0f, 2.0f, 3.0f),
+		.orientation = quat_normalize(quat_new(vec3_new(1.0f, 2.0f, -1.0f), 0.7f)),
+		.shape = &(Shape) {
+			.type = SHAPE_TYPE_CONVEX,
+			.convex = convex,
+		},
+	};
+	PhysicsBody box_body = {
+		.position = vec3_new(-1.0f, 0.5f, 2.0f),
+		.orientation = quat_normalize(quat_new(vec3_new(0.0f, 1.0f, 1.0f), -1.1f)),
+		.shape = &(Shape) {
+			.type = SHAPE_TYPE_BOX,
+			.box = box_shape_create(vec3_new(1.0f, 0.5f, 2.0f)),
+		},
+	};
+
+	// Walking the hull from any start point, and the box's closed form, reach as far as a scan over every point
+	for (i32 dir_idx = 0; dir_idx < 200; ++dir_idx)
+	{
+		const f32 theta = (f32) dir_idx * 0.61803f * 2.0f * PI;
+		const f32 z = 1.0f - 2.0f * ((f32) dir_idx + 0.5f) / 200.0f;
+		const f32 r = sqrtf(1.0f - z * z);
+		const Vec3 dir = vec3_new(r * cosf(theta), r * sinf(theta), z);
+
+		f32 max_distance = -FLT_MAX;
+		for (i32 point_idx = 0; point_idx < num_hull_points; ++point_idx)
+		{
+			const Vec3 world_point = physics_body_local_to_world_space(&convex_body, hull_points[point_idx]);
+			max_distance = MAX(max_distance, vec3_dot(world_point, dir));
+		}
+
+		for (i32 start_idx = 0; start_idx < num_hull_points; start_idx += 7)
+		{
+			i32 vertex_hint = start_idx;
+			const Vec3 support = physics_body_support_hinted(&convex_body, dir, 0.0f, &vertex_hint);
+			assert(fabsf(vec3_dot(support, dir) - max_distance) < 1e-4f);
+			assert(vec3_nearly_equal(support, physics_body_local_to_world_space(&convex_body, hull_points[vertex_hint])));
+		}
+
+		f32 box_max_distance = -FLT_MAX;
+		for (i32 point_idx = 0; point_idx < NUM_BOX_POINTS; ++point_idx)
+		{
+			const Vec3 world_point = physics_body_local_to_world_space(&box_body, box_body.shape->box.points[point_idx]);
+			box_max_distance = MAX(box_max_distance, vec3_dot(world_point, dir));
+		}
+		assert(fabsf(vec3_dot(physics_body_support(&box_body, dir, 0.0f), dir) - box_max_distance) < 1e-4f);
+	}
+
+	// Cached inverse inertia tensors match the tensors they invert
+	const Shape sphere_shape = { .type = SHAPE_TYPE_SPHERE, .sphere = { .radius = 1.5f } };
+	const Shape* inertia_shapes[] = { convex_body.shape, box_body.shape, &sphere_shape };
+	for (i32 shape_idx = 0; shape_idx < (i32) ARRAY_COUNT(inertia_shapes); ++shape_idx)
+	{
+		const Mat3 product = mat3_mul_mat3(shape_get_inertia_tensor_matrix(inertia_shapes[shape_idx]), shape_get_inverse_inertia_tensor_matrix(inertia_shapes[shape_idx]));
+		assert(mat3_nearly_equal(product, mat3_identity));
+	}
+
+	convex_shape_release(convex);
+
+	printf("PASSED\n");
+	return true;
+}
+
+bool test_physics_epa()
+{
+	printf("  test_physics_epa... ");
+
+	// Expanding a small tetrahedron by points on a sphere keeps a closed, convex polytope, with the tetrahedron buried inside it
+	const MinkowskiPoint simplex_points[4] = {
+		{ .xyz = vec3_new( 0.3f,  0.3f,  0.3f) },
+		{ .xyz = vec3_new(-0.3f, -0.3f,  0.3f) },
+		{ .xyz = vec3_new(-0.3f,  0.3f, -0.3f) },
+		{ .xyz = vec3_new( 0.3f, -0.3f, -0.3f) },
+	};
+
+	EpaPolytope polytope;
+	epa_polytope_init(&polytope, simplex_points);
+	assert(polytope.num_faces == 4);
+
+	const i32 num_sphere_points = EPA_MAX_POINTS - 4;
+	for (i32 point_idx = 0; point_idx < num_sphere_points; ++point_idx)
+	{
+		// Fibonacci sphere
+		const f32 y = 1.0f - 2.0f * ((f32) point_idx + 0.5f) / (f32) num_sphere_points;
+		const f32 radius = sqrtf(1.0f - y * y);
+		const f32 angle = (f32) point_idx * PI * (3.0f - sqrtf(5.0f));
+		const MinkowskiPoint point = { .xyz = vec3_new(radius * cosf(angle), y, radius * sinf(angle)) };
+		assert(epa_polytope_expand(&polytope, &point));
+	}
+
+	// A full polytope refuses more points, and is left as it was
+	const MinkowskiPoint extra_point = { .xyz = vec3_new(2.0f, 0.0f, 0.0f) };
+	assert(!epa_polytope_expand(&polytope, &extra_point));
+
+	// Every face of a closed triangle mesh has three edges, each shared with one other face: F = 2V - 4
+	assert(polytope.num_points == EPA_MAX_POINTS);
+	assert(polytope.num_faces == 2 * num_sphere_points - 4);
+	for (i32 face_idx = 0; face_idx < polytope.num_faces; ++face_idx)
+	{
+		const EpaFace* face = &polytope.faces[face_idx];
+		assert(face->a >= 4 && face->b >= 4 && face->c >= 4);
+		assert(face->distance > 0.0f);
+		for (i32 point_idx = 0; point_idx < polytope.num_points; ++point_idx)
+		{
+			assert(vec3_dot(face->normal, polytope.points[point_idx].xyz) - face->distance < 1e-4f);
+		}
+	}
+
+	// The closest face of a polytope around the unit sphere is nearly a unit distance away
+	const EpaFace* closest_face = &polytope.faces[epa_polytope_closest_face(&polytope)];
+	assert(closest_face->distance > 0.9f && closest_face->distance < 1.0f);
+
+	printf("PASSED\n");
+	return true;
+}
+
+bool test_physics_gjk_cache()
+{
+	printf("  test_physics_gjk_cache... ");
+
+	// A spinning box passes by two hulls, and contacts found with a cache carried between steps match those found from scratch
+	// Box pairs have their own routine that doesn't use the cache, so the first hull is a box's corners
+	const Vec3 cube_points[] = {
+		vec3_new(-1.0f, -1.0f, -1.0f), vec3_new( 1.0f, -1.0f, -1.0f), vec3_new(-1.0f,  1.0f, -1.0f), vec3_new( 1.0f,  1.0f, -1.0f),
+		vec3_new(-1.0f, -1.0f,  1.0f), vec3_new( 1.0f, -1.0f,  1.0f), vec3_new(-1.0f,  1.0f,  1.0f), vec3_new( 1.0f,  1.0f,  1.0f),
+	};
+	const Vec3 hull_points[] = {
+		vec3_new( 1.0f,  0.0f,  0.0f), vec3_new(-1.0f,  0.0f,  0.0f),
+		vec3_new( 0.0f,  1.5f,  0.0f), vec3_new( 0.0f, -1.5f,  0.0f),
+		vec3_new( 0.0f,  0.0f,  1.0f), vec3_new( 0.0f,  0.0f, -1.0f),
+	};
+	const Shape shapes[] = {
+		{
+			.type = SHAPE_TYPE_CONVEX,
+			.convex = convex_shape_create(cube_points, ARRAY_COUNT(cube_points)),
+		},
+		{
+			.type = SHAPE_TYPE_CONVEX,
+			.convex = convex_shape_create(hull_points, ARRAY_COUNT(hull_points)),
+		},
+	};
+
+	for (i32 shape_idx = 0; shape_idx < (i32) ARRAY_COUNT(shapes); ++shape_idx)
+	{
+		PhysicsBody body_a = {
+			.position = vec3_zero,
+			.orientation = quat_identity,
+			.shape = &shapes[shape_idx],
+		};
+		PhysicsBody body_b = {
+			.orientation = quat_identity,
+			.shape = &(Shape) {
+				.type = SHAPE_TYPE_BOX,
+				.box = box_shape_create(vec3_new(0.5f, 0.5f, 0.5f)),
+			},
+		};
+
+		PhysicsGjkCache gjk_cache = {};
+		i32 num_contacts = 0;
+		for (i32 step = 0; step < 240; ++step)
+		{
+			const f32 t = (f32) step / 240.0f;
+			body_b.position = vec3_new(4.0f - 8.0f * t, 0.3f, 0.2f);
+			body_b.orientation = quat_normalize(quat_new(vec3_new(0.3f, 1.0f, 0.2f), 6.0f * t));
+			body_a.orientation = quat_normalize(quat_new(vec3_new(0.0f, 1.0f, 0.0f), 2.0f * t));
+
+			PhysicsContact cached_contacts[PHYSICS_MANIFOLD_MAX_POINTS];
+			PhysicsContact contacts[PHYSICS_MANIFOLD_MAX_POINTS];
+			const i32 num_cached_contacts = physics_bodies_find_contacts(&body_a, &body_b, 1.0f / 60.0f, cached_contacts, &gjk_cache);
+			const i32 num_step_contacts = physics_bodies_find_contacts(&body_a, &body_b, 1.0f / 60.0f, contacts, NULL);
+			assert(num_cached_contacts == num_step_contacts);
+			if (num_step_contacts > 0)
+			{
+				assert(fabsf(cached_contacts[0].separation_distance - contacts[0].separation_distance) < 1e-3f);
+				++num_contacts;
+			}
+		}
+		assert(gjk_cache.is_valid);
+		assert(num_contacts > 0 && num_contacts < 240);
+	}
+
+	for (i32 shape_idx = 0; shape_idx < (i32) ARRAY_COUNT(shapes); ++shape_idx)
+	{
+		convex_shape_release(shapes[shape_idx].convex);
+	}
+
+	// The scene keeps one cache per broadphase pair, and drops it once the pair separates
+	PhysicsScene physics_scene;
+	physics_scene_init(&physics_scene);
+	const PhysicsBodyHandle falling_box_handle = physics_scene_add_body(&physics_scene, &(PhysicsBodyCreateInfo) {
+		.position = vec3_new(0.0f, 1.5f, 0.0f),
+		.orientation = quat_identity,
+		.shape = {
+			.type = SHAPE_TYPE_BOX,
+			.box = box_shape_create(vec3_new(1.0f, 1.0f, 1.0f)),
+		},
+		.inverse_mass = 1.0f,
+		.elasticity = 0.5f,
+		.friction = 0.5f,
+	});
+	physics_scene_add_body(&physics_scene, &(PhysicsBodyCreateInfo) {
+		.position = vec3_new(0.0f, -10.0f, 0.0f),
+		.orientation = quat_identity,
+		.shape = {
+			.type = SHAPE_TYPE_BOX,
+			.box = box_shape_create(vec3_new(100.0f, 10.0f, 100.0f)),
+		},
+		.inverse_mass = 0.0f,
+		.elasticity = 0.5f,
+		.friction = 0.5f,
+	});
+
+	physics_scene_update(&physics_scene, 1.0f / 60.0f);
+	assert(sb_count(physics_scene.gjk_caches) == 1);
+	assert(physics_scene.gjk_caches[0].pair_id == pair_map_key(0, 1));
+
+	const PhysicsBody* falling_box = physics_scene_get_body(&physics_scene, falling_box_handle);
+	physics_scene_set_body_pose(&physics_scene, falling_box_handle, vec3_add(falling_box->position, vec3_new(0.0f, 50.0f, 0.0f)), falling_box->orientation);
+	physics_scene_update(&physics_scene, 1.0f / 60.0f);
+	assert(sb_count(physics_scene.gjk_caches) == 0);
+	assert(physics_scene.gjk_cache_indices.count == 0);
+
+	physics_scene_destroy(&physics_scene);
+
+	printf("PASSED\n");
+	return true;
+}
+
+bool test_physics_contact_functions()
+{
+	printf("  test_physics_contact_functions... ");
+
+	const Vec3 up = vec3_new(0.0f, 1.0f, 0.0f);
+	const Shape box_shape = {
+		.type = SHAPE_TYPE_BOX,
+		.box = box_shape_create(vec3_new(1.0f, 1.0f, 1.0f)),
+	};
+	const Shape sphere_shape = {
+		.type = SHAPE_TYPE_SPHERE,
+		.sphere = { .radius = 0.5f },
+	};
+	PhysicsContact contacts[PHYSICS_MANIFOLD_MAX_POINTS];
+
+	// Bodies at rest, so contacts are found out to PHYSICS_SPECULATIVE_DISTANCE
+
+	// Sphere above a box, then with its center inside it. Normals point from a to b whichever order the bodies are in
+	{
+		PhysicsBody sphere = {
+			.position = vec3_new(0.2f, 1.51f, 0.0f),
+			.orientation = quat_identity,
+			.shape = &sphere_shape,
+		};
+		PhysicsBody box = {
+			.position = vec3_zero,
+			.orientation = quat_identity,
+			.shape = &box_shape,
+		};
+
+		assert(physics_bodies_find_contacts(&sphere, &box, 0.0f, contacts, NULL) == 1);
+		assert(vec3_nearly_equal(contacts[0].normal, vec3_negate(up)));
+		assert(f32_nearly_equal(contacts[0].separation_distance, 0.01f));
+		assert(vec3_nearly_equal(contacts[0].point_on_b_world, vec3_new(0.2f, 1.0f, 0.0f)));
+
+		assert(physics_bodies_find_contacts(&box, &sphere, 0.0f, contacts, NULL) == 1);
+		assert(vec3_nearly_equal(contacts[0].normal, up));
+		assert(vec3_nearly_equal(contacts[0].point_on_a_local, physics_body_world_to_local_space(&box, contacts[0].point_on_a_world)));
+		assert(vec3_nearly_equal(contacts[0].point_on_a_world, vec3_new(0.2f, 1.0f, 0.0f)));
+
+		sphere.position = vec3_new(0.1f, 0.8f, 0.0f);
+		assert(physics_bodies_find_contacts(&sphere, &box, 0.0f, contacts, NULL) == 1);
+		assert(vec3_nearly_equal(contacts[0].normal, vec3_negate(up)));
+		assert(f32_nearly_equal(contacts[0].separation_distance, -0.7f));
+
+		sphere.position = vec3_new(0.0f, 2.0f, 0.0f);
+		assert(physics_bodies_find_contacts(&sphere, &box, 0.0f, contacts, NULL) == 0);
+	}
+
+	// A box resting on a rotated box gets its whole face as contacts in one step
+	{
+		PhysicsBody box_a = {
+			.position = vec3_new(0.3f, 1.99f, 0.2f),
+			.orientation = quat_new(up, 0.4f),
+			.shape = &box_shape,
+		};
+		PhysicsBody box_b = {
+			.position = vec3_zero,
+			.orientation = quat_new(up, 1.1f),
+			.shape = &(Shape) {
+				.type = SHAPE_TYPE_BOX,
+				.box = box_shape_create(vec3_new(4.0f, 1.0f, 4.0f)),
+			},
+		};
+
+		assert(physics_bodies_find_contacts(&box_a, &box_b, 0.0f, contacts, NULL) == 4);
+		for (i32 contact_idx = 0; contact_idx < 4; ++contact_idx)
+		{
+			assert(vec3_nearly_equal(contacts[contact_idx].normal, vec3_negate(up)));
+			assert(f32_nearly_equal(contacts[contact_idx].separation_distance, -0.01f));
+			assert(f32_nearly_equal(contacts[contact_idx].point_on_b_world.y, 1.0f));
+		}
+		assert(physics_manifold_get_area(contacts[0].point_on_a_world, contacts[1].point_on_a_world, contacts[2].point_on_a_world, contacts[3].point_on_a_world) > 15.0f);
+
+		// Hanging over an edge clips the face to the part over the other box
+		box_a.position = vec3_new(0.0f, 1.99f, 0.0f);
+		box_a.orientation = quat_identity;
+		box_b.orientation = quat_identity;
+		box_b.position = vec3_new(4.5f, 0.0f, 0.0f);
+		assert(physics_bodies_find_contacts(&box_a, &box_b, 0.0f, contacts, NULL) == 4);
+		for (i32 contact_idx = 0; contact_idx < 4; ++contact_idx)
+		{
+			assert(contacts[contact_idx].point_on_a_world.x > 0.5f - 1e-4f);
+		}
+
+		// Crossed edges touch at a single point
+		box_a.position = vec3_new(0.0f, 2.0f * sqrtf(2.0f) + 0.005f, 0.0f);
+		box_a.orientation = quat_new(vec3_new(1.0f, 0.0f, 0.0f), PI / 4.0f);
+		box_b.position = vec3_zero;
+		box_b.orientation = quat_new(vec3_new(0.0f, 0.0f, 1.0f), PI / 4.0f);
+		box_b.shape = &box_shape;
+		const Vec3 edge_point = vec3_new(0.0f, sqrtf(2.0f), 0.0f);
+		assert(physics_bodies_find_contacts(&box_a, &box_b, 0.0f, contacts, NULL) == 1);
+		assert(vec3_nearly_equal(contacts[0].normal, vec3_negate(up)));
+		assert(f32_nearly_equal(contacts[0].separation_distance, 0.005f));
+		assert(vec3_nearly_equal(contacts[0].point_on_b_world, edge_point));
+
+		box_a.position.y += PHYSICS_SPECULATIVE_DISTANCE;
+		assert(physics_bodies_find_contacts(&box_a, &box_b, 0.0f, contacts, NULL) == 0);
+	}
+
+	// Sphere against a hull agrees with the general routine, up to the bias EPA adds to overlapping bodies
+	{
+		const Vec3 hull_points[] = {
+			vec3_new( 1.0f,  0.0f,  0.0f), vec3_new(-1.0f,  0.0f,  0.0f),
+			vec3_new( 0.0f,  1.5f,  0.0f), vec3_new( 0.0f, -1.5f,  0.0f),
+			vec3_new( 0.0f,  0.0f,  1.0f), vec3_new( 0.0f,  0.0f, -1.0f),
+		};
+		Shape hull_shape = {
+			.type = SHAPE_TYPE_CONVEX,
+			.convex = convex_shape_create(hull_points, ARRAY_COUNT(hull_points)),
+		};
+		PhysicsBody hull = {
+			.position = vec3_zero,
+			.orientation = quat_new(vec3_new(0.3f, 1.0f, 0.2f), 0.7f),
+			.shape = &hull_shape,
+		};
+		PhysicsBody sphere = {
+			.orientation = quat_identity,
+			.shape = &sphere_shape,
+		};
+
+		for (i32 step = 0; step < 16; ++step)
+		{
+			const f32 angle = (f32) step * (PI / 8.0f);
+			sphere.position = vec3_new(1.2f * cosf(angle), 0.4f, 1.2f * sinf(angle));
+
+			PhysicsContact general_contacts[PHYSICS_MANIFOLD_MAX_POINTS];
+			assert(physics_contacts_sphere_convex(&sphere, &hull, 1.0f, NULL, contacts) == 1);
+			assert(physics_contacts_convex_convex(&sphere, &hull, 1.0f, NULL, general_contacts) == 1);
+			assert(fabsf(contacts[0].separation_distance - general_contacts[0].separation_distance) < 1e-2f);
+			assert(vec3_length(vec3_sub(contacts[0].point_on_b_world, general_contacts[0].point_on_b_world)) < 1e-2f);
+		}
+
+		shape_release(&hull_shape);
+	}
+
+	printf("PASSED\n");
+	return true;
+}
+
+bool test_physics_narrow_phase_parallel()
+{
+	printf("  test_physics_narrow_phase_parallel... ");
+
+	TaskSystem task_system;
+	task_system_init(&task_system);
+
+	PhysicsScene serial_scene;
+	physics_scene_init(&serial_scene);
+	test_physics_scene_populate(&serial_scene);
+
+	PhysicsScene parallel_scene;
+	physics_scene_init(&parallel_scene);
+	parallel_scene.task_system = &task_system;
+	test_physics_scene_populate(&parallel_scene);
+
+	const f32 delta_time = 1.0f / 60.0f;
+	i32 num_contacts_seen = 0;
+	for (i32 step = 0; step < 60; ++step)
+	{
+		// The narrowphase leaves bodies untouched, and finds the same contacts in the same order either way
+		const i32 num_bodies = sb_count(serial_scene.bodies);
+		PhysicsBody* bodies_before = FCS_MEM_ALLOC(sizeof(PhysicsBody) * num_bodies);
+		for (i32 body_idx = 0; body_idx < num_bodies; ++body_idx)
+		{
+			bodies_before[body_idx] = serial_scene.bodies[body_idx];
+		}
+
+		sbuffer(CollisionPair) pairs = physics_scene_broad_phase(&serial_scene, delta_time);
+		sbuffer(PhysicsContact) serial_contacts = physics_scene_narrow_phase(&serial_scene, pairs, sb_count(pairs), delta_time);
+		sbuffer(PhysicsContact) parallel_contacts = physics_scene_narrow_phase(&parallel_scene, pairs, sb_count(pairs), delta_time);
+
+		for (i32 body_idx = 0; body_idx < num_bodies; ++body_idx)
+		{
+			assert(memcmp(&bodies_before[body_idx], &serial_scene.bodies[body_idx], sizeof(PhysicsBody)) == 0);
+		}
+
+		assert(sb_count(serial_contacts) == sb_count(parallel_contacts));
+		for (i32 contact_idx = 0; contact_idx < sb_count(serial_contacts); ++contact_idx)
+		{
+			const PhysicsContact* serial_contact = &serial_contacts[contact_idx];
+			const PhysicsContact* parallel_contact = &parallel_contacts[contact_idx];
+			assert(serial_contact->pair_id == parallel_contact->pair_id);
+			assert(serial_contact->body_a.idx == parallel_contact->body_a.idx);
+			assert(memcmp(&serial_contact->point_on_a_world, &parallel_contact->point_on_a_world, sizeof(Vec3)) == 0);
+			assert(memcmp(&serial_contact->normal, &parallel_contact->normal, sizeof(Vec3)) == 0);
+			assert(serial_contact->time_of_impact == parallel_contact->time_of_impact);
+		}
+		num_contacts_seen += sb_count(serial_contacts);
+
+		sb_free(serial_contacts);
+		sb_free(parallel_contacts);
+		FCS_MEM_FREE(bodies_before);
+
+		// Full steps stay bit-identical too
+		physics_scene_update(&serial_scene, delta_time);
+		physics_scene_update(&parallel_scene, delta_time);
+		for (i32 body_idx = 0; body_idx < num_bodies; ++body_idx)
+		{
+			const PhysicsBody* serial_body = &serial_scene.bodies[body_idx];
+			const PhysicsBody* parallel_body = &parallel_scene.bodies[body_idx];
+			assert(memcmp(&serial_body->position, &parallel_body->position, sizeof(Vec3)) == 0);
+			assert(memcmp(&serial_body->orientation, &parallel_body->orientation, sizeof(Quat)) == 0);
+			assert(memcmp(&serial_body->linear_velocity, &parallel_body->linear_velocity, sizeof(Vec3)) == 0);
+			assert(memcmp(&serial_body->angular_velocity, &parallel_body->angular_velocity, sizeof(Vec3)) == 0);
+		}
+	}
+	assert(num_contacts_seen > 0);
+
+	physics_scene_destroy(&serial_scene);
+	physics_scene_destroy(&parallel_scene);
+	task_system_shutdown(&task_system);
+
+	printf("PASSED\n");
+	return true;
+}
+
+bool test_physics_solver()
+{
+	printf("  test_physics_solver... ");
+
+	const f32 delta_time = 1.0f / 60.0f;
+
+	{	// A sphere dropped onto the floor stops bouncing and rests on it
+		PhysicsScene physics_scene;
+		physics_scene_init(&physics_scene);
+		const PhysicsBodyHandle sphere_handle = physics_scene_add_body(&physics_scene, &(PhysicsBodyCreateInfo) {
+			.position = vec3_new(0.0f, 3.0f, 0.0f),
+			.orientation = quat_identity,
+			.shape = {
+				.type = SHAPE_TYPE_SPHERE,
+				.sphere = { .radius = 1.0f },
+			},
+			.inverse_mass = 1.0f,
+			.elasticity = 0.5f,
+			.friction = 0.5f,
+		});
+		physics_scene_add_body(&physics_scene, &(PhysicsBodyCreateInfo) {
+			.position = vec3_new(0.0f, -10.0f, 0.0f),
+			.orientation = quat_identity,
+			.shape = {
+				.type = SHAPE_TYPE_BOX,
+				.box = box_shape_create(vec3_new(100.0f, 10.0f, 100.0f)),
+			},
+			.inverse_mass = 0.0f,
+			.elasticity = 0.5f,
+			.friction = 0.5f,
+		});
+		const PhysicsBody* sphere = physics_scene_get_body(&physics_scene, sphere_handle);
+
+		for (i32 step = 0; step < 180; ++step)
+		{
+			physics_scene_update(&physics_scene, delta_time);
+		}
+		assert(fabsf(sphere->position.y - 1.0f) < 0.02f);
+		assert(fabsf(sphere->linear_velocity.y) < 0.05f);
+
+		physics_scene_destroy(&physics_scene);
+	}
+
+	{	// A fast sphere is sub-stepped to its time of impact rather than tunnelling through a thin wall
+		PhysicsScene physics_scene;
+		physics_scene_init(&physics_scene);
+		const PhysicsBodyHandle sphere_handle = physics_scene_add_body(&physics_scene, &(PhysicsBodyCreateInfo) {
+			.position = vec3_new(0.0f, 0.0f, 0.0f),
+			.orientation = quat_identity,
+			.linear_velocity = vec3_new(300.0f, 0.0f, 0.0f),
+			.shape = {
+				.type = SHAPE_TYPE_SPHERE,
+				.sphere = { .radius = 0.5f },
+			},
+			.inverse_mass = 1.0f,
+			.elasticity = 0.5f,
+			.friction = 0.5f,
+		});
+		physics_scene_add_body(&physics_scene, &(PhysicsBodyCreateInfo) {
+			.position = vec3_new(12.0f, 0.0f, 0.0f),
+			.orientation = quat_identity,
+			.shape = {
+				.type = SHAPE_TYPE_BOX,
+				.box = box_shape_create(vec3_new(0.1f, 50.0f, 50.0f)),
+			},
+			.inverse_mass = 0.0f,
+			.elasticity = 0.5f,
+			.friction = 0.5f,
+		});
+		const PhysicsBody* sphere = physics_scene_get_body(&physics_scene, sphere_handle);
+		assert(physics_body_is_fast(sphere, delta_time));
+
+		for (i32 step = 0; step < 10; ++step)
+		{
+			physics_scene_update(&physics_scene, delta_time);
+			assert(sphere->position.x < 12.0f);
+		}
+		assert(sphere->linear_velocity.x < 0.0f);
+
+		physics_scene_destroy(&physics_scene);
+	}
+
+	printf("PASSED\n");
+	return true;
+}
+
+bool test_physics_manifolds()
+{
+	printf("  test_physics_manifolds... ");
+
+	// A stack of boxes on a static floor, solved with the default (low) iteration count
+	PhysicsScene physics_scene;
+	physics_scene_init(&physics_scene);
+
+	enum { NUM_STACKED_BOXES = 4 };
+	PhysicsBodyHandle boxes[NUM_STACKED_BOXES];
+	for (i32 box_idx = 0; box_idx < NUM_STACKED_BOXES; ++box_idx)
+	{
+		boxes[box_idx] = physics_scene_add_body(&physics_scene, &(PhysicsBodyCreateInfo) {
+			.position = vec3_new(0.0f, 1.0f + (f32) box_idx * 2.05f, 0.0f),
+			.orientation = quat_identity,
+			.shape = {
+				.type = SHAPE_TYPE_BOX,
+				.box = box_shape_create(vec3_new(1.0f, 1.0f, 1.0f)),
+			},
+			.inverse_mass = 1.0f,
+			.elasticity = 0.25f,
+			.friction = 0.5f,
+		});
+	}
+	physics_scene_add_body(&physics_scene, &(PhysicsBodyCreateInfo) {
+		.position = vec3_new(0.0f, -10.0f, 0.0f),
+		.orientation = quat_identity,
+		.shape = {
+			.type = SHAPE_TYPE_BOX,
+			.box = box_shape_create(vec3_new(100.0f, 10.0f, 100.0f)),
+		},
+		.inverse_mass = 0.0f,
+		.elasticity = 0.25f,
+		.friction = 0.5f,
+	});
+
+	const f32 delta_time = 1.0f / 60.0f;
+	for (i32 step = 0; step < 240; ++step)
+	{
+		physics_scene_update(&physics_scene, delta_time);
+	}
+
+	// Each box rests on the one below through a full manifold, and the stack has settled
+	assert(sb_count(physics_scene.manifolds) == NUM_STACKED_BOXES);
+	assert(physics_scene.manifold_indices.count == NUM_STACKED_BOXES);
+	for (i32 manifold_idx = 0; manifold_idx < sb_count(physics_scene.manifolds); ++manifold_idx)
+	{
+		const PhysicsManifold* manifold = &physics_scene.manifolds[manifold_idx];
+		assert(manifold->num_points == PHYSICS_MANIFOLD_MAX_POINTS);
+		assert(*pair_map_find(&physics_scene.manifold_indices, manifold->pair_id) == manifold_idx);
+	}
+
+	for (i32 box_idx = 0; box_idx < NUM_STACKED_BOXES; ++box_idx)
+	{
+		const PhysicsBody* box = physics_scene_get_body(&physics_scene, boxes[box_idx]);
+		assert(fabsf(box->position.y - (1.0f + (f32) box_idx * 2.0f)) < 0.05f);
+		assert(fabsf(box->position.x) < 0.05f && fabsf(box->position.z) < 0.05f);
+		assert(vec3_length(box->linear_velocity) < 0.01f);
+		assert(vec3_length(box->angular_velocity) < 0.01f);
+	}
+
+	// Lifting the top box away drops its manifold
+	const PhysicsBody* top_box = physics_scene_get_body(&physics_scene, boxes[NUM_STACKED_BOXES - 1]);
+	physics_scene_set_body_pose(&physics_scene, boxes[NUM_STACKED_BOXES - 1], vec3_add(top_box->position, vec3_new(0.0f, 10.0f, 0.0f)), top_box->orientation);
+	physics_scene_update(&physics_scene, delta_time);
+	assert(sb_count(physics_scene.manifolds) == NUM_STACKED_BOXES - 1);
+	assert(physics_scene.manifold_indices.count == NUM_STACKED_BOXES - 1);
+
+	physics_scene_destroy(&physics_scene);
+
+	printf("PASSED\n");
+	return true;
+}
+
+bool test_physics_sleeping()
+{
+	printf("  test_physics_sleeping... ");
+
+	// A stack of two boxes and a lone box on a static floor, with a small box held asleep in the air above the stack
+	PhysicsScene physics_scene;
+	physics_scene_init(&physics_scene);
+
+	const Shape box_shape = {
+		.type = SHAPE_TYPE_BOX,
+		.box = box_shape_create(vec3_new(1.0f, 1.0f, 1.0f)),
+	};
+	const PhysicsBodyHandle stack_bottom_handle = physics_scene_add_body(&physics_scene, &(PhysicsBodyCreateInfo) {
+		.position = vec3_new(0.0f, 1.0f, 0.0f),
+		.orientation = quat_identity,
+		.shape = box_shape,
+		.inverse_mass = 1.0f,
+		.elasticity = 0.25f,
+		.friction = 0.5f,
+	});
+	const PhysicsBodyHandle stack_top_handle = physics_scene_add_body(&physics_scene, &(PhysicsBodyCreateInfo) {
+		.position = vec3_new(0.0f, 3.05f, 0.0f),
+		.orientation = quat_identity,
+		.shape = box_shape,
+		.inverse_mass = 1.0f,
+		.elasticity = 0.25f,
+		.friction = 0.5f,
+	});
+	const PhysicsBodyHandle lone_box_handle = physics_scene_add_body(&physics_scene, &(PhysicsBodyCreateInfo) {
+		.position = vec3_new(20.0f, 1.0f, 0.0f),
+		.orientation = quat_identity,
+		.shape = box_shape,
+		.inverse_mass = 1.0f,
+		.elasticity = 0.25f,
+		.friction = 0.5f,
+	});
+	const PhysicsBodyHandle falling_box_handle = physics_scene_add_body(&physics_scene, &(PhysicsBodyCreateInfo) {
+		.position = vec3_new(0.0f, 6.5f, 0.0f),
+		.orientation = quat_identity,
+		.shape = {
+			.type = SHAPE_TYPE_BOX,
+			.box = box_shape_create(vec3_new(0.5f, 0.5f, 0.5f)),
+		},
+		.inverse_mass = 1.0f,
+		.elasticity = 0.25f,
+		.friction = 0.5f,
+		.is_sleeping = true,
+	});
+	const PhysicsBodyHandle floor_handle = physics_scene_add_body(&physics_scene, &(PhysicsBodyCreateInfo) {
+		.position = vec3_new(0.0f, -10.0f, 0.0f),
+		.orientation = quat_identity,
+		.shape = {
+			.type = SHAPE_TYPE_BOX,
+			.box = box_shape_create(vec3_new(100.0f, 10.0f, 100.0f)),
+		},
+		.inverse_mass = 0.0f,
+		.elasticity = 0.25f,
+		.friction = 0.5f,
+	});
+
+	// Handles stay valid as bodies are added, but pointers are only taken once the scene is done growing
+	PhysicsBody* stack_bottom = physics_scene_get_body(&physics_scene, stack_bottom_handle);
+	PhysicsBody* stack_top = physics_scene_get_body(&physics_scene, stack_top_handle);
+	PhysicsBody* lone_box = physics_scene_get_body(&physics_scene, lone_box_handle);
+	PhysicsBody* falling_box = physics_scene_get_body(&physics_scene, falling_box_handle);
+	PhysicsBody* floor = physics_scene_get_body(&physics_scene, floor_handle);
+	assert(stack_bottom_handle.idx == 0 && floor_handle.idx == 4);
+	assert(floor == &physics_scene.bodies[floor_handle.idx]);
+
+	// The boxes settle and fall asleep in islands of their own
+	const f32 delta_time = 1.0f / 60.0f;
+	for (i32 step = 0; step < 120; ++step)
+	{
+		physics_scene_update(&physics_scene, delta_time);
+	}
+	assert(stack_bottom->is_sleeping && stack_top->is_sleeping && lone_box->is_sleeping);
+	assert(!floor->is_sleeping);
+	assert(sb_count(physics_scene.islands) == 0);
+	assert(sb_count(physics_scene.manifolds) == 3);
+
+	// Sleeping bodies stay exactly where they are, even without anything under them
+	const Vec3 falling_box_position = falling_box->position;
+	physics_scene_update(&physics_scene, delta_time);
+	assert(memcmp(&falling_box->position, &falling_box_position, sizeof(Vec3)) == 0);
+
+	// Once woken, the small box falls onto the stack and wakes both of its boxes, but not the lone box
+	physics_body_wake(falling_box);
+	assert(physics_body_is_awake(falling_box));
+	bool is_stack_woken = false;
+	for (i32 step = 0; step < 240 && !is_stack_woken; ++step)
+	{
+		physics_scene_update(&physics_scene, delta_time);
+		is_stack_woken = !stack_bottom->is_sleeping && !stack_top->is_sleeping;
+		assert(stack_bottom->is_sleeping == stack_top->is_sleeping);
+	}
+	assert(is_stack_woken);
+	assert(lone_box->is_sleeping);
+
+	// Everything settles back to sleep, leaving no islands to solve
+	for (i32 step = 0; step < 300; ++step)
+	{
+		physics_scene_update(&physics_scene, delta_time);
+	}
+	assert(stack_bottom->is_sleeping && stack_top->is_sleeping && lone_box->is_sleeping && falling_box->is_sleeping);
+	assert(sb_count(physics_scene.islands) == 0);
+	assert(fabsf(stack_top->position.y - 3.0f) < 0.1f);
+
+	physics_scene_destroy(&physics_scene);
+
+	printf("PASSED\n");
+	return true;
+}
+
+bool test_physics_fixed_step()
+{
+	printf("  test_physics_fixed_step... ");
+
+	// A single falling sphere, advanced by a frame time that isn't a multiple of the fixed step
+	PhysicsScene physics_scene;
+	physics_scene_init(&physics_scene);
+	physics_scene.fixed_delta_time = 1.0f / 60.0f;
+	physics_scene.max_steps_per_advance = 4;
+
+	const PhysicsBodyHandle sphere_handle = physics_scene_add_body(&physics_scene, &(PhysicsBodyCreateInfo) {
+		.position = vec3_new(0.0f, 10.0f, 0.0f),
+		.orientation = quat_identity,
+		.shape = {
+			.type = SHAPE_TYPE_SPHERE,
+			.sphere = { .radius = 0.5f },
+		},
+		.inverse_mass = 1.0f,
+		.elasticity = 0.5f,
+		.friction = 0.5f,
+	});
+	const PhysicsBody* sphere = physics_scene_get_body(&physics_scene, sphere_handle);
+
+	// Before any step, the interpolated pose is the initial one
+	Vec3 render_position;
+	Quat render_orientation;
+	physics_scene_get_body_interpolated_pose(&physics_scene, sphere_handle, 0.5f, &render_position, &render_orientation);
+	assert(vec3_nearly_equal(render_position, sphere->position));
+
+	// A frame shorter than a step only accumulates time
+	assert(physics_scene_advance(&physics_scene, 1.0f / 120.0f) == 0);
+	assert(sphere->position.y == 10.0f);
+	assert(f32_nearly_equal(physics_scene.interpolation_alpha, 0.5f));
+
+	// Completing the step takes it, leaving nothing over
+	assert(physics_scene_advance(&physics_scene, 1.0f / 120.0f) == 1);
+	assert(sphere->position.y < 10.0f);
+	assert(physics_scene.accumulated_time < physics_scene.fixed_delta_time);
+
+	// The interpolated pose lies between the previous and current poses
+	physics_scene_advance(&physics_scene, 1.5f / 60.0f);
+	assert(f32_nearly_equal(physics_scene.interpolation_alpha, 0.5f));
+	physics_scene_get_body_interpolated_pose(&physics_scene, sphere_handle, physics_scene.interpolation_alpha, &render_position, &render_orientation);
+	const Vec3 previous_position = physics_scene.body_render_data[sphere_handle.idx].previous_position;
+	assert(render_position.y < previous_position.y && render_position.y > sphere->position.y);
+	assert(f32_nearly_equal(render_position.y, 0.5f * (previous_position.y + sphere->position.y)));
+
+	// A long frame is capped at the step budget, and the time it couldn't simulate is dropped
+	assert(physics_scene_advance(&physics_scene, 1.0f) == physics_scene.max_steps_per_advance);
+	assert(physics_scene.accumulated_time < physics_scene.fixed_delta_time);
+	assert(physics_scene.interpolation_alpha >= 0.0f && physics_scene.interpolation_alpha < 1.0f);
+
+	// Teleporting sets both poses, so the interpolated pose doesn't sweep across the jump
+	const Vec3 teleport_position = vec3_new(5.0f, 20.0f, 0.0f);
+	physics_scene_set_body_pose(&physics_scene, sphere_handle, teleport_position, quat_identity);
+	physics_scene_get_body_interpolated_pose(&physics_scene, sphere_handle, physics_scene.interpolation_alpha, &render_position, &render_orientation);
+	assert(vec3_nearly_equal(render_position, teleport_position));
+
+	physics_scene_destroy(&physics_scene);
+
+	printf("PASSED\n");
+	return true;
+}
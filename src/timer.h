@@ -1,3 +1,5 @@
+#pragma once
+
 #include "basic_types.h"
 
 #if defined(_WIN32)
@@ -38,6 +40,11 @@ double time_seconds(u64 in_time)
     return (double)in_time / g_performance_frequency;
 }
 
+double time_nanoseconds(u64 in_time)
+{
+    return time_seconds(in_time) * 1e9;
+}
+
 #elif defined(__APPLE__)
 
 #include "mach/mach_time.h"
@@ -60,4 +67,31 @@ double time_seconds(u64 in_time)
 	return _mac_time_nanoseconds(in_time) / 1e9;
 }
 
+double time_nanoseconds(u64 in_time)
+{
+	return _mac_time_nanoseconds(in_time);
+}
+
+#else // POSIX
+
+#include <time.h>
+
+// Monotonic clock in nanoseconds
+u64 time_now()
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (u64)now.tv_sec * 1000000000ULL + (u64)now.tv_nsec;
+}
+
+double time_nanoseconds(u64 in_time)
+{
+	return (double)in_time;
+}
+
+double time_seconds(u64 in_time)
+{
+	return (double)in_time / 1e9;
+}
+
 #endif